@@ -1,5 +1,8 @@
 ﻿#include "CliManager.h"
 #include "save/ChunkSaveManager.h"
+#include "chunk/ChunkWorkerPool.h"
+#include "chunk/ChunkPipelineBench.h"
+#include "generate/TerrainGenerator.h"
 #include "Data.h"
 #include "RuntimeConfig.h"
 #include "Shader.h"
@@ -84,6 +87,26 @@ void CliManager::parseCmdline(int argc, char* argv[]) {
                 m_cmdline.winPosX = std::atoi(argv[++i]);
                 m_cmdline.winPosY = std::atoi(argv[++i]);
             }
+        } else if (arg == "--compact-world") {
+            if (i + 1 < argc) m_cmdline.compactWorld = argv[++i];
+        } else if (arg == "--bench-noise") {
+            m_cmdline.benchNoiseChunks = 1024;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                m_cmdline.benchNoiseChunks = std::atoi(argv[++i]);
+            }
+        } else if (arg == "--bench-light") {
+            m_cmdline.benchLightRounds = 200;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                m_cmdline.benchLightRounds = std::atoi(argv[++i]);
+            }
+        } else if (arg == "--bench-pipeline") {
+            m_cmdline.benchPipelineRadius = 8;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                m_cmdline.benchPipelineRadius = std::atoi(argv[++i]);
+                if (i + 1 < argc && argv[i + 1][0] != '-') {
+                    m_cmdline.benchPipelineSeed = std::strtoull(argv[++i], nullptr, 10);
+                }
+            }
         } else if (arg == "--rebuild-shaders") {
             // 强制重编着色器：忽略并删除磁盘缓存，从源码重编后重写缓存（覆盖配置文件）
             Shader::setForceRecompile(true);
@@ -369,6 +392,24 @@ namespace {
 }
 
 int CliManager::run() {
+    // 离线整理存档：不建窗口、不进游戏
+    if (!m_cmdline.compactWorld.empty()) {
+        return ChunkSaveManager::compactWorld(m_cmdline.compactWorld) >= 0 ? 0 : -1;
+    }
+    // 地形噪声基准：同样不建窗口
+    if (m_cmdline.benchNoiseChunks > 0) {
+        return TerrainGenerator::runNoiseBenchmark(m_cmdline.benchNoiseChunks, TerrainParams{}.seed);
+    }
+    // 光照 BFS 基准（旧浮点实现 vs LightBfs 内核）
+    if (m_cmdline.benchLightRounds > 0) {
+        return ChunkPipelineBench::runLight(m_cmdline.benchLightRounds);
+    }
+    // chunk 流水线基准（生成 → 切片 → 可见面 → 光照 → 序列化），无 GPU 的 CI 机器也能跑
+    if (m_cmdline.benchPipelineRadius >= 0) {
+        const uint64_t seed = m_cmdline.benchPipelineSeed ? m_cmdline.benchPipelineSeed : TerrainParams{}.seed;
+        return ChunkPipelineBench::run(m_cmdline.benchPipelineRadius, seed);
+    }
+
     if (!initPersistentContext()) {
         std::cerr << "[CLI] Failed to init persistent GL context" << std::endl;
         return -1;
@@ -11,6 +11,11 @@ struct CmdlineArgs {
     std::string worldName;
     int winPosX = -1;
     int winPosY = -1;
+    std::string compactWorld;   // --compact-world <name>：只整理该世界的 region 文件后退出
+    int benchNoiseChunks = 0;   // --bench-noise [N]：跑 N 个 chunk 的地形噪声基准后退出（默认 1024）
+    int benchLightRounds = 0;   // --bench-light [N]：3×3 萤石密集区块的光照 BFS 基准跑 N 轮后退出（默认 200）
+    int benchPipelineRadius = -1;   // --bench-pipeline [R] [seed]：无头跑半径 R 的 chunk 流水线基准后退出（默认 8）
+    uint64_t benchPipelineSeed = 0; // 0 = 用 TerrainParams 默认种子
 };
 
 struct SessionConfig {
@@ -1,5 +1,6 @@
 ﻿#include "Player.h"
 #include "chunk/ChunkManager.h"
+#include "chunk/WorldView.h"
 #include "save/ChunkSaveManager.h"
 #include "render/RenderSystem.h"
 #include "UI/UIManager.h"
@@ -120,10 +121,11 @@ void Player::placeOnGround(ChunkManager& chunkManager) {
     float searchDistance = 10.0f; // 最大搜索距离
     glm::vec3 playerBottom = playerAABB.min;
 
+    WorldView view(chunkManager);
     for (float y = playerBottom.y; y > playerBottom.y - searchDistance; y -= 0.1f) {
         // 检查玩家脚底位置的方块
         glm::ivec3 blockPos = worldToBlockCoord(glm::vec3(m_position.x, y, m_position.z));
-        BlockType blockType = chunkManager.getBlockAt(blockPos).type();
+        BlockType blockType = view.get(blockPos).type();
 
         if (blockType != BLOCK_AIR) {
             // 找到地面，将玩家放置在地面上方
@@ -171,7 +173,7 @@ void Player::setVelocity(const glm::vec3& velocity) {
 
 // ==================== 碰撞检测核心算法 ====================
 
-void Player::getAllCollisions(ChunkManager& chunkManager, std::vector<CollisionResult>& collisions) const {
+void Player::getAllCollisions(WorldView& view, std::vector<CollisionResult>& collisions) const {
     AABB playerAABB = getAABB();
 
     glm::ivec3 minBlock, maxBlock;
@@ -182,8 +184,8 @@ void Player::getAllCollisions(ChunkManager& chunkManager, std::vector<CollisionR
     for (int x = minBlock.x; x <= maxBlock.x; x++) {
         for (int y = minBlock.y; y <= maxBlock.y; y++) {
             for (int z = minBlock.z; z <= maxBlock.z; z++) {
+                if (view.get(x, y, z).type() == BLOCK_AIR) continue;
                 glm::ivec3 blockPos(x, y, z);
-                if (chunkManager.getBlockAt(blockPos).type() == BLOCK_AIR) continue;
 
                 CollisionResult collision = calculateBlockCollision(playerAABB, blockPos);
                 if (collision.collided) {
@@ -196,7 +198,7 @@ void Player::getAllCollisions(ChunkManager& chunkManager, std::vector<CollisionR
 
 // 分轴移动：沿单个轴移动并解算碰撞
 // axis: 0=X, 1=Y, 2=Z
-void Player::moveAxis(int axis, float displacement, ChunkManager& chunkManager) {
+void Player::moveAxis(int axis, float displacement, WorldView& view) {
     if (glm::abs(displacement) < 1e-7f) return;
 
     // 应用位移
@@ -210,8 +212,8 @@ void Player::moveAxis(int axis, float displacement, ChunkManager& chunkManager)
     for (int bx = minBlock.x; bx <= maxBlock.x; bx++) {
         for (int by = minBlock.y; by <= maxBlock.y; by++) {
             for (int bz = minBlock.z; bz <= maxBlock.z; bz++) {
+                if (view.get(bx, by, bz).type() == BLOCK_AIR) continue;
                 glm::ivec3 blockPos(bx, by, bz);
-                if (chunkManager.getBlockAt(blockPos).type() == BLOCK_AIR) continue;
 
                 AABB blockAABB = getBlockAABB(blockPos);
                 // 重新获取当前玩家AABB（位置可能已被之前的block修正）
@@ -499,10 +501,12 @@ void Player::updatePhysics(float deltaTime, ChunkManager& chunkManager) {
         dy = std::min(dy, -GROUND_STICK);
     }
 
-    // Y轴优先（重力/着地），然后水平轴
-    moveAxis(1, dy, chunkManager);
-    moveAxis(0, dx, chunkManager);
-    moveAxis(2, dz, chunkManager);
+    // Y轴优先（重力/着地），然后水平轴；三轴共用一个 WorldView，
+    // 玩家包围盒通常只落在 1~2 个区块内，后续查询全部命中缓存
+    WorldView view(chunkManager);
+    moveAxis(1, dy, view);
+    moveAxis(0, dx, view);
+    moveAxis(2, dz, view);
 
     // ---- 6. 更新摄像机 ----
     updateCameraPosition();
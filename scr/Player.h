@@ -16,6 +16,7 @@
 
 // 前向声明
 class ChunkManager;
+class WorldView;
 class RenderSystem;
 class DroppedItemManager;
 struct PlayerSaveData;
@@ -332,8 +333,9 @@ private:
     void updateViewBob(float deltaTime);
 
     // 碰撞检测 - 分轴移动+碰撞解算
-    void getAllCollisions(ChunkManager& chunkManager, std::vector<CollisionResult>& collisions) const;
-    void moveAxis(int axis, float displacement, ChunkManager& chunkManager);
+    // 方块查询统一走 WorldView：一帧三次分轴移动共享同一份区块缓存
+    void getAllCollisions(WorldView& view, std::vector<CollisionResult>& collisions) const;
+    void moveAxis(int axis, float displacement, WorldView& view);
 
     // 方块交互处理
     void handleBlockInteraction(ChunkManager& chunkManager);
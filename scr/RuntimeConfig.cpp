@@ -86,8 +86,10 @@ void RuntimeConfig::loadFrom(const std::string& path) {
 
     if (root.isMember("render_radius")) renderRadius = root["render_radius"].asInt();
     if (root.isMember("max_inflight_requests")) maxInflightRequests = root["max_inflight_requests"].asInt();
-    if (root.isMember("max_uploads_per_frame")) maxUploadsPerFrame = root["max_uploads_per_frame"].asInt();
+    if (root.isMember("integration_budget_ms")) integrationBudgetMs = (float)root["integration_budget_ms"].asDouble();
     if (root.isMember("worker_threads")) workerThreads = root["worker_threads"].asInt();
+    if (root.isMember("max_concurrent_light_jobs")) maxConcurrentLightJobs = root["max_concurrent_light_jobs"].asInt();
+    if (root.isMember("greedy_meshing")) greedyMeshing = root["greedy_meshing"].asBool();
     if (root.isMember("vertical_cull_ratio")) verticalCullRatio = (float)root["vertical_cull_ratio"].asDouble();
     if (root.isMember("print_profile_every_second")) printProfileEverySecond = root["print_profile_every_second"].asBool();
     if (root.isMember("profile_detailed")) profileDetailed = root["profile_detailed"].asBool();
@@ -121,6 +123,7 @@ void RuntimeConfig::loadFrom(const std::string& path) {
     if (root.isMember("view_bob_run_scale")) viewBobRunScale = (float)root["view_bob_run_scale"].asDouble();
     if (root.isMember("disable_ime")) disableIme = root["disable_ime"].asBool();
     if (root.isMember("net_send_rate")) netSendRate = (float)root["net_send_rate"].asDouble();
+    if (root.isMember("net_tick_rate")) netTickRate = (float)root["net_tick_rate"].asDouble();
     if (root.isMember("net_interp_delay")) netInterpDelay = (float)root["net_interp_delay"].asDouble();
 
     std::cout << "[RuntimeConfig] loaded from " << path
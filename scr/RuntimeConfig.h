@@ -10,8 +10,15 @@ public:
 
     int renderRadius = 8;                // 渲染半径（chunk），视野内加载 (2r+1)^2 个 chunk
     int maxInflightRequests = 32;        // 同时投递的最大 build 任务数，超过则暂停请求新 chunk
-    int maxUploadsPerFrame = 8;          // 每帧最多上传多少个脏 section 到 GPU
+    // 主线程每帧集成预算（毫秒）：Task 1/2/3 结果集成 + 脏 section 上传 GPU 共用，
+    // 按自测的单项耗时尽量填满；近处 chunk 优先。每阶段每帧至少处理一项。
+    float integrationBudgetMs = 4.0f;
     int workerThreads = 0;               // 0 = 由 hardware_concurrency 自动决定
+    int maxConcurrentLightJobs = 0;      // 同时跑光照 BFS(Task 3) 的 worker 上限；0 = 自动（worker 数的一半，至少 1）
+
+    // 贪心合并网格：worker 把同平面、同纹理/朝向的相邻面合并成矩形，arena 实例数与顶点量成倍下降。
+    // 方块编辑时被命中的矩形会就地拆回单位面，不影响增量上传。关掉 = 回到每面一个实例。
+    bool greedyMeshing = true;
 
     // 下方 section 剔除：maxDownSections = renderRadius × verticalCullRatio
     // 例：8×0.5=4 → 相机所在 section 向下 4 个以外的不渲染。0 或负值 = 不限制
@@ -105,6 +112,9 @@ public:
     // netSendRate：本地玩家位置/朝向/运动的网络发送频率（Hz，与帧率解耦）。太高浪费带宽、
     //   让接收端插值缓冲跨度过短；太低则每步位移大、外推更频繁。25 是较稳的默认。
     float netSendRate = 25.0f;
+    // netTickRate：服务端固定同步 tick（Hz）。移动快照与通用属性只在 tick 上打包发出，
+    //   两 tick 之间多次采样只发最新；与帧率解耦，32 人时带宽可控。
+    float netTickRate = 30.0f;
     // netInterpDelay：远程玩家渲染落后最新快照的时间（秒），在真实快照间夹住做插值。
     //   调大更抗网络抖动/丢包但对端显示更"过去"；约 2~3 个发送间隔为宜。
     float netInterpDelay = 0.10f;
@@ -905,19 +905,23 @@ void World::setupDroppedItemNetworking() {
         [this](NetMsgType t, MemoryStream& p) { handleGameMessage(t, p); });
 
     if (m_netMode == NetMode::Host) {
-        // 服务端权威：生成/销毁广播给所有客户端
-        m_droppedItems->setServerCallbacks(
-            [this](const DroppedItem& it) {
-                MemoryStream s;
+        // 服务端权威：SPAWN 由 NetDroppedSync 在 item 进入各 peer 兴趣范围时单发
+        // （晚加入的玩家也能收到场上已有的掉落物）；销毁广播给所有客户端
+        m_netManager->getDroppedSync().setSpawnWriter(
+            [](MemoryStream& s, const DroppedItemStore& items, size_t i) {
+                const ItemStack& st = items.stack[i];
+                const glm::vec3& pos = items.pos[i];
                 s.writePod((uint8_t)NetObjType::DroppedItem);
-                s.writePod(it.netId);
-                s.writeString(it.stack.def ? it.stack.def->id : std::string());
-                s.writePod((uint16_t)it.stack.count);
-                s.writePod((uint16_t)it.stack.durability);
-                s.writePod(it.pos.x); s.writePod(it.pos.y); s.writePod(it.pos.z);
-                m_netManager->broadcast(NetMsgType::SPAWN_OBJECT, s, true);
-            },
+                s.writePod(items.netId[i]);
+                s.writeString(st.def ? st.def->id : std::string());
+                s.writePod((uint16_t)st.count);
+                s.writePod((uint16_t)st.durability);
+                s.writePod(pos.x); s.writePod(pos.y); s.writePod(pos.z);
+            });
+        m_droppedItems->setServerCallbacks(
+            nullptr,
             [this](uint16_t netId) {
+                m_netManager->getDroppedSync().onItemDespawned(netId);
                 MemoryStream s;
                 s.writePod(netId);
                 m_netManager->broadcast(NetMsgType::DESTROY_OBJECT, s, true);
@@ -963,15 +967,11 @@ void World::handleGameMessage(NetMsgType type, MemoryStream& payload) {
         m_droppedItems->netDespawn(netId);
         break;
     }
-    case NetMsgType::DROPPED_SYNC: {  // 客户端：批量位置/数量
-        uint16_t n = payload.readPod<uint16_t>();
-        for (uint16_t i = 0; i < n; ++i) {
-            uint16_t netId = payload.readPod<uint16_t>();
-            glm::vec3 pos;
-            pos.x = payload.readPod<float>(); pos.y = payload.readPod<float>(); pos.z = payload.readPod<float>();
-            uint16_t count = payload.readPod<uint16_t>();
-            m_droppedItems->netApply(netId, pos, (int)count);
-        }
+    case NetMsgType::DROPPED_SYNC: {  // 客户端：增量位置/数量
+        m_netManager->getDroppedSync().onSync(payload,
+            [this](uint16_t netId, const glm::vec3* pos, int count) {
+                return m_droppedItems->netApply(netId, pos, count);
+            });
         break;
     }
     case NetMsgType::DROP_REQUEST: {  // 服务端：客户端请求生成，权威落地
@@ -994,15 +994,8 @@ void World::handleGameMessage(NetMsgType type, MemoryStream& payload) {
 
 void World::broadcastDroppedSync() {
     if (!m_netManager || m_netMode != NetMode::Host || !m_droppedItems) return;
-    const auto& items = m_droppedItems->items();
-    MemoryStream s;
-    s.writePod((uint16_t)items.size());
-    for (const auto& it : items) {
-        s.writePod(it.netId);
-        s.writePod(it.pos.x); s.writePod(it.pos.y); s.writePod(it.pos.z);
-        s.writePod((uint16_t)it.stack.count);
-    }
-    m_netManager->broadcast(NetMsgType::DROPPED_SYNC, s, false);  // 高频走不可靠
+    // 每个 peer 只收其附近、且相对已确认状态有变化的掉落物（高频走不可靠）
+    m_netManager->getDroppedSync().broadcast(m_droppedItems->items());
 }
 
 // 把 0-24 浮点世界时间格式化成 "HH:MM"。
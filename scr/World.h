@@ -102,7 +102,7 @@ private:
     // 掉落物网络同步（需求 3）
     void setupDroppedItemNetworking();               // run() 里按 netMode 接线
     void handleGameMessage(NetMsgType type, MemoryStream& payload);  // 分派 SPAWN/DESTROY/DROPPED_SYNC/DROP_REQUEST
-    void broadcastDroppedSync();                     // Host 定时批量同步位置/数量
+    void broadcastDroppedSync();                     // Host 定时按 peer 增量同步位置/数量
     float m_droppedSyncTimer = 0.0f;                 // DROPPED_SYNC 节流计时
 
     // 本地玩家位置/朝向/运动的网络发送节流：用墙钟累加器按固定频率发（与帧率解耦，
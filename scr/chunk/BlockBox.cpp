@@ -0,0 +1,276 @@
+﻿#include "BlockBox.h"
+#include <cassert>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+
+std::atomic<int64_t> BlockBox::s_totalBytes{ 0 };
+std::atomic<int> BlockBox::s_storageCount[BlockBox::STORAGE_COUNT];
+
+BlockBox::BlockBox() {
+    // 默认整段空气：SINGLE 形态，不分配任何堆内存
+    s_storageCount[m_storage].fetch_add(1, std::memory_order_relaxed);
+    refreshAccounting();
+}
+
+BlockBox::~BlockBox() {
+    s_storageCount[m_storage].fetch_sub(1, std::memory_order_relaxed);
+    s_totalBytes.fetch_sub((int64_t)m_accountedBytes, std::memory_order_relaxed);
+}
+
+size_t BlockBox::memoryBytes() const {
+    return sizeof(BlockBox)
+        + m_palette.capacity() * sizeof(BlockState)
+        + m_indices.capacity()
+        + (m_raw ? VOLUME * sizeof(BlockState) : 0);
+}
+
+void BlockBox::refreshAccounting() {
+    size_t now = memoryBytes();
+    if (now == m_accountedBytes) return;
+    s_totalBytes.fetch_add((int64_t)now - (int64_t)m_accountedBytes, std::memory_order_relaxed);
+    m_accountedBytes = now;
+}
+
+void BlockBox::switchStorage(Storage to) {
+    if (to == m_storage) return;
+    s_storageCount[m_storage].fetch_sub(1, std::memory_order_relaxed);
+    s_storageCount[to].fetch_add(1, std::memory_order_relaxed);
+    m_storage = to;
+}
+
+int BlockBox::paletteIndexOf(BlockState s) const {
+    for (size_t k = 0; k < m_palette.size(); ++k) {
+        if (m_palette[k] == s) return (int)k;
+    }
+    return -1;
+}
+
+void BlockBox::promote() {
+    if (m_storage == STORAGE_PALETTE4) {
+        // 4 bit → 8 bit：下标逐格拆开，调色板原样保留
+        std::vector<uint8_t> wide(VOLUME);
+        for (int i = 0; i < VOLUME; ++i) {
+            wide[i] = uint8_t((m_indices[i >> 1] >> ((i & 1) << 2)) & 0xFu);
+        }
+        m_indices.swap(wide);
+        m_palette.reserve(256);
+        switchStorage(STORAGE_PALETTE8);
+        refreshAccounting();
+    } else if (m_storage == STORAGE_PALETTE8) {
+        rawData();
+    }
+}
+
+void BlockBox::set(int i, BlockState s) {
+    assert(!m_shared && "写共享哨兵前必须先 cloneMutable");
+    switch (m_storage) {
+    case STORAGE_RAW:
+        m_raw[i] = s;
+        return;
+    case STORAGE_SINGLE:
+        if (s == m_single) return;
+        // 第一次出现第二种 state：升成 4 bit 调色板，原值占下标 0
+        m_palette.reserve(16);
+        m_palette.push_back(m_single);
+        m_indices.assign(VOLUME / 2, 0);
+        switchStorage(STORAGE_PALETTE4);
+        break;
+    default:
+        break;
+    }
+
+    int k = paletteIndexOf(s);
+    if (k < 0) {
+        size_t cap = (m_storage == STORAGE_PALETTE4) ? 16 : 256;
+        if (m_palette.size() >= cap) {
+            promote();
+            if (m_storage == STORAGE_RAW) {
+                m_raw[i] = s;
+                return;
+            }
+        }
+        k = (int)m_palette.size();
+        m_palette.push_back(s);
+    }
+
+    if (m_storage == STORAGE_PALETTE4) {
+        uint8_t& b = m_indices[i >> 1];
+        int shift = (i & 1) << 2;
+        b = uint8_t((b & ~(0xFu << shift)) | (uint32_t(k) << shift));
+    } else {
+        m_indices[i] = uint8_t(k);
+    }
+    refreshAccounting();
+}
+
+void BlockBox::copyTo(BlockState* out) const {
+    switch (m_storage) {
+    case STORAGE_SINGLE:
+        std::fill(out, out + VOLUME, m_single);
+        break;
+    case STORAGE_PALETTE4:
+        for (int i = 0; i < VOLUME; i += 2) {
+            uint8_t b = m_indices[i >> 1];
+            out[i]     = m_palette[b & 0xFu];
+            out[i + 1] = m_palette[b >> 4];
+        }
+        break;
+    case STORAGE_PALETTE8:
+        for (int i = 0; i < VOLUME; ++i) out[i] = m_palette[m_indices[i]];
+        break;
+    default:
+        std::memcpy(out, m_raw.get(), VOLUME * sizeof(BlockState));
+        break;
+    }
+}
+
+BlockState* BlockBox::rawData() {
+    assert(!m_shared && "写共享哨兵前必须先 cloneMutable");
+    if (m_storage != STORAGE_RAW) {
+        auto raw = std::make_unique<BlockState[]>(VOLUME);
+        copyTo(raw.get());
+        m_raw = std::move(raw);
+        std::vector<BlockState>().swap(m_palette);
+        std::vector<uint8_t>().swap(m_indices);
+        switchStorage(STORAGE_RAW);
+        refreshAccounting();
+    }
+    return m_raw.get();
+}
+
+void BlockBox::assign(const BlockState* src) {
+    assert(!m_shared && "写共享哨兵前必须先 cloneMutable");
+    // 统计不同 state 个数（超过 256 即放弃调色板）。BlockState 只有 16 bit，
+    // 用线程局部的 65536 项直查表代替哈希；用完只把碰过的项清回 -1。
+    thread_local std::vector<int16_t> lookup(65536, -1);
+    std::vector<BlockState> palette;
+    palette.reserve(16);
+    bool overflow = false;
+    for (int i = 0; i < VOLUME; ++i) {
+        int16_t& slot = lookup[src[i].bits];
+        if (slot >= 0) continue;
+        if (palette.size() == 256) { overflow = true; break; }
+        slot = (int16_t)palette.size();
+        palette.push_back(src[i]);
+    }
+
+    std::vector<uint8_t> indices;
+    Storage target;
+    if (overflow) {
+        target = STORAGE_RAW;
+    } else if (palette.size() == 1) {
+        target = STORAGE_SINGLE;
+    } else if (palette.size() <= 16) {
+        target = STORAGE_PALETTE4;
+        indices.assign(VOLUME / 2, 0);
+        for (int i = 0; i < VOLUME; i += 2) {
+            indices[i >> 1] = uint8_t(lookup[src[i].bits] | (lookup[src[i + 1].bits] << 4));
+        }
+    } else {
+        target = STORAGE_PALETTE8;
+        indices.resize(VOLUME);
+        for (int i = 0; i < VOLUME; ++i) indices[i] = uint8_t(lookup[src[i].bits]);
+    }
+    for (const BlockState& p : palette) lookup[p.bits] = -1;
+
+    if (target == STORAGE_RAW) {
+        if (!m_raw) m_raw = std::make_unique<BlockState[]>(VOLUME);
+        std::memcpy(m_raw.get(), src, VOLUME * sizeof(BlockState));
+        std::vector<BlockState>().swap(m_palette);
+        std::vector<uint8_t>().swap(m_indices);
+    } else {
+        m_raw.reset();
+        if (target == STORAGE_SINGLE) {
+            m_single = palette[0];
+            std::vector<BlockState>().swap(m_palette);
+            std::vector<uint8_t>().swap(m_indices);
+        } else {
+            palette.shrink_to_fit();
+            m_palette = std::move(palette);
+            m_indices = std::move(indices);
+        }
+    }
+    switchStorage(target);
+    refreshAccounting();
+}
+
+bool BlockBox::isUniform(BlockState* value) const {
+    if (m_storage == STORAGE_SINGLE) {
+        if (value) *value = m_single;
+        return true;
+    }
+    // 调色板只增不减，可能残留已不用的项 → 逐格比对
+    BlockState first = get(0);
+    for (int i = 1; i < VOLUME; ++i) {
+        if (!(get(i) == first)) return false;
+    }
+    if (value) *value = first;
+    return true;
+}
+
+// ── 共享只读哨兵 ──────────────────────────────────────────────────────
+
+namespace {
+    // 每种 state 一个哨兵，建了就不删；只在 Task 1 切分 / COW 降级时查表，锁开销可忽略
+    std::mutex& sentinelMutex() {
+        static std::mutex m;
+        return m;
+    }
+    std::unordered_map<uint16_t, std::shared_ptr<BlockBox>>& sentinelTable() {
+        static std::unordered_map<uint16_t, std::shared_ptr<BlockBox>> t;
+        return t;
+    }
+}
+
+std::shared_ptr<BlockBox> BlockBox::sharedUniform(BlockState s) {
+    // 同一线程连续切分的 section 多半是同一种 state（空气），先查线程局部的上一次命中
+    thread_local std::shared_ptr<BlockBox> lastHit;
+    if (lastHit && lastHit->m_single == s) return lastHit;
+
+    std::lock_guard<std::mutex> lk(sentinelMutex());
+    auto& slot = sentinelTable()[s.bits];
+    if (!slot) {
+        auto box = std::make_shared<BlockBox>();
+        box->m_single = s;      // 新建即 SINGLE 形态，直接填值
+        box->m_shared = true;
+        slot = std::move(box);
+    }
+    lastHit = slot;
+    return slot;
+}
+
+int BlockBox::sharedUniformCount() {
+    std::lock_guard<std::mutex> lk(sentinelMutex());
+    return (int)sentinelTable().size();
+}
+
+std::shared_ptr<BlockBox> BlockBox::snapshotOf(const std::shared_ptr<BlockBox>& box) {
+    if (!box || box->m_shared) return box;
+    auto snap = std::make_shared<BlockBox>();
+    {
+        std::shared_lock<std::shared_mutex> lk(box->mutex);
+        snap->m_single = box->m_single;
+        snap->m_palette = box->m_palette;
+        snap->m_indices = box->m_indices;
+        if (box->m_raw) {
+            snap->m_raw = std::make_unique<BlockState[]>(VOLUME);
+            std::memcpy(snap->m_raw.get(), box->m_raw.get(), VOLUME * sizeof(BlockState));
+        }
+        snap->switchStorage(box->m_storage);
+    }
+    snap->refreshAccounting();
+    return snap;
+}
+
+std::shared_ptr<BlockBox> BlockBox::cloneMutable() const {
+    auto box = std::make_shared<BlockBox>();
+    if (m_storage == STORAGE_SINGLE) {
+        box->m_single = m_single;
+        return box;
+    }
+    BlockState tmp[VOLUME];
+    copyTo(tmp);
+    box->assign(tmp);
+    return box;
+}
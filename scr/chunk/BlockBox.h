@@ -3,6 +3,7 @@
 #include "ChunkDimensions.h"
 #include "../light/LightSource.h"
 #include <array>
+#include <atomic>
 #include <shared_mutex>
 #include <memory>
 #include <vector>
@@ -22,22 +23,118 @@
 //
 // 生命周期：shared_ptr 的引用计数保证 —— 即使邻居 chunk 在 worker 读边界期间被卸载，
 // worker 持有的那份 shared_ptr 也会让 BlockBox 存活到读取结束，不会悬挂。
+//
+// 调色板压缩存储：自然地形里绝大多数 section 要么整段空气/石头，要么只有个位数种方块，
+// 平铺 4096×BlockState（8KB）非常浪费。BlockBox 按内容选最紧凑的形态：
+//   STORAGE_SINGLE   —— 整段同一个 state，只存 1 个值（全空气/全石头）
+//   STORAGE_PALETTE4 —— ≤16 种 state，调色板 + 每格 4 bit 下标（2KB）
+//   STORAGE_PALETTE8 —— ≤256 种 state，调色板 + 每格 8 bit 下标（4KB）
+//   STORAGE_RAW      —— 平铺数组（8KB），rawData() 的惰性展开目标
+// set() 在调色板装不下时自动升级（只升不降）；assign() 整段重写时重新挑最小形态。
+// 读写锁语义不变：get/copyTo 与读同级（持读锁或主线程串行），set/assign/rawData 与写同级（持写锁或尚未共享）。
+// 形态切换会换掉 / 释放调色板与下标缓冲，worker 线程因此【不能】免锁读私有 box：
+// 要么每次读持 lockShared()（短读，如 Task 2 拷边界层），要么先用 snapshotOf 在读锁下
+// 复制出私有快照再免锁反复读（长读，如光照 BFS），不把锁握满整个任务。
+//
+// 共享只读哨兵：整段同一个 state 的 section（地形 y≈60 以上的全空气段占一个 chunk 的大半）
+// 不再各自分配 box，而是共用 sharedUniform(state) 返回的同一个不可变 box。
+//  - 哨兵永不被写：set/assign/rawData 之前调用方必须先 cloneMutable() 换成私有 box（写时复制），
+//    见 Section::setBlock / Section::writeAllBlocks / ChunkManager::applyBlockChange。
+//  - 因为不可变，读哨兵不需要锁；lockShared() 对哨兵返回未上锁的 guard，
+//    避免所有 worker 抢同一把 shared_mutex。
 struct BlockBox {
     // section 体积：16×16×16 = 4096
     static constexpr int VOLUME = ChunkConstants::CHUNK_WIDTH *
                                   ChunkConstants::SECTION_HEIGHT *
                                   ChunkConstants::CHUNK_DEPTH;
 
-    std::array<BlockState, VOLUME> blocks;
+    enum Storage : uint8_t {
+        STORAGE_SINGLE   = 0,
+        STORAGE_PALETTE4 = 1,
+        STORAGE_PALETTE8 = 2,
+        STORAGE_RAW      = 3,
+        STORAGE_COUNT
+    };
+
     mutable std::shared_mutex mutex;
 
-    BlockBox() { blocks.fill(BlockState{}); }
+    BlockBox();
+    ~BlockBox();
 
     // 禁止拷贝 / 移动（shared_mutex 已删除这些操作，这里显式声明以表意）
     BlockBox(const BlockBox&) = delete;
     BlockBox& operator=(const BlockBox&) = delete;
     BlockBox(BlockBox&&) = delete;
     BlockBox& operator=(BlockBox&&) = delete;
+
+    // 单格读：i = (y*D+z)*W+x
+    BlockState get(int i) const {
+        switch (m_storage) {
+        case STORAGE_SINGLE:   return m_single;
+        case STORAGE_PALETTE4: return m_palette[(m_indices[i >> 1] >> ((i & 1) << 2)) & 0xFu];
+        case STORAGE_PALETTE8: return m_palette[m_indices[i]];
+        default:               return m_raw[i];
+        }
+    }
+    // 单格写：调色板装不下时升级形态（SINGLE → P4 → P8 → RAW）
+    void set(int i, BlockState s);
+
+    // 解码整段 VOLUME 个 state 到 out（布局同 get 的下标）
+    void copyTo(BlockState* out) const;
+    // 用一段 VOLUME 个 state 整体重写，并挑选能容纳它的最紧凑形态
+    void assign(const BlockState* src);
+
+    // 惰性展开为 RAW 并返回裸数组指针，供批量写入（Section::stateData 的实现）。
+    // 展开后保持 RAW，直到下一次 assign 重新压缩。
+    BlockState* rawData();
+
+    // 整段是否同一个 state（SINGLE 形态 O(1) 判定）；是则写入 *value
+    bool isUniform(BlockState* value = nullptr) const;
+
+    // ── 共享只读哨兵 ──
+    // 返回内容为整段 s 的全局共享 box（同一个 state 只建一次，进程内常驻）
+    static std::shared_ptr<BlockBox> sharedUniform(BlockState s);
+    // 是否为 sharedUniform 产出的不可变哨兵
+    bool isShared() const { return m_shared; }
+    // 是否为整段空气的哨兵（Task 2 / 网络序列化据此整段跳过）
+    bool isSharedAir() const { return m_shared && m_single.type() == BLOCK_AIR; }
+    // 写时复制：返回一份内容相同、可写的私有 box（调用方持读锁或主线程串行）
+    std::shared_ptr<BlockBox> cloneMutable() const;
+    // 读快照：持读锁按原形态复制一份私有 box（调色板 / 下标 / 平铺数组直接拷贝，不重新压缩）。
+    // 哨兵不可变，直接返回自身；box 为空返回空。
+    static std::shared_ptr<BlockBox> snapshotOf(const std::shared_ptr<BlockBox>& box);
+    // 读锁：哨兵不可变，返回不持锁的 guard；普通 box 持 mutex 读锁
+    std::shared_lock<std::shared_mutex> lockShared() const {
+        return m_shared ? std::shared_lock<std::shared_mutex>(mutex, std::defer_lock)
+                        : std::shared_lock<std::shared_mutex>(mutex);
+    }
+
+    Storage storage() const { return m_storage; }
+    // 本 box 方块数据占用的堆内存 + 自身大小（字节）
+    size_t memoryBytes() const;
+
+    // ── 全局内存统计（所有存活 BlockBox 汇总，供 ChunkManager::printStats）──
+    static int64_t totalMemoryBytes() { return s_totalBytes.load(std::memory_order_relaxed); }
+    static int liveCount(Storage s) { return s_storageCount[s].load(std::memory_order_relaxed); }
+    // 已建的共享哨兵个数（每种 state 一个）
+    static int sharedUniformCount();
+
+private:
+    void switchStorage(Storage to);   // 只改形态标记 + 计数，数据由调用方搬
+    void refreshAccounting();         // memoryBytes 变化后同步全局字节数
+    void promote();                   // 升一级形态（保持内容不变）
+    int  paletteIndexOf(BlockState s) const;
+
+    Storage m_storage = STORAGE_SINGLE;
+    BlockState m_single{};
+    std::vector<BlockState> m_palette;   // P4 / P8：下标 → state
+    std::vector<uint8_t> m_indices;      // P4：VOLUME/2 字节（低 4 bit 存偶数格）；P8：VOLUME 字节
+    std::unique_ptr<BlockState[]> m_raw; // RAW
+    size_t m_accountedBytes = 0;
+    bool m_shared = false;               // sharedUniform 哨兵：不可写，读免锁
+
+    static std::atomic<int64_t> s_totalBytes;
+    static std::atomic<int> s_storageCount[STORAGE_COUNT];
 };
 
 // 一个 chunk 的全部 section BlockBox（每 section 一个，含数据 + 锁）。
@@ -46,12 +143,22 @@ using ChunkBoxes = std::array<std::shared_ptr<BlockBox>,
 
 constexpr int CHUNK_SECTION_COUNT = ChunkConstants::CHUNK_HEIGHT / ChunkConstants::SECTION_HEIGHT;
 
+// 对 [syMin, syMax] 内的 section 逐个取读快照（每个 box 只在复制期间持读锁），区间外留空。
+// worker 长时间读多个 box 时用：之后只读 out，主线程随时可以改原 box。
+inline void snapshotChunkBoxes(const ChunkBoxes& in, ChunkBoxes& out,
+                               int syMin = 0, int syMax = CHUNK_SECTION_COUNT - 1) {
+    for (int sy = 0; sy < CHUNK_SECTION_COUNT; ++sy) {
+        out[sy] = (sy >= syMin && sy <= syMax) ? BlockBox::snapshotOf(in[sy]) : nullptr;
+    }
+}
+
 // 一个 chunk 的 per-section 光源位置缓存（shared_ptr 共享，uint16_t 压缩坐标）
 using ChunkLightSources = std::array<std::shared_ptr<std::vector<uint16_t>>, CHUNK_SECTION_COUNT>;
 
 // 把一段「整 chunk 连续 buffer」（地形生成器 / 存档 / 网络反序列化的布局
 // (worldY*DEPTH+z)*WIDTH+x）切分为 CHUNK_SECTION_COUNT 个 section BlockBox，
 // 同时扫描每 section 的发光方块，产出 per-section 光源位置缓存。
+// 整段同一 state 的 section 直接引用 BlockBox::sharedUniform 哨兵，不新建 box。
 // 不加锁：调用时 box 都是新建、尚未对外共享。
 inline void splitChunkBufferToBoxes(
     const BlockState* src,
@@ -62,23 +169,32 @@ inline void splitChunkBufferToBoxes(
     constexpr int D = ChunkConstants::CHUNK_DEPTH;
     constexpr int SEC_H = ChunkConstants::SECTION_HEIGHT;
     constexpr int SEC_COUNT = CHUNK_SECTION_COUNT;
+    BlockState dst[BlockBox::VOLUME];
     for (int sy = 0; sy < SEC_COUNT; ++sy) {
-        auto box = std::make_shared<BlockBox>();
-        auto srcList = std::make_shared<std::vector<uint16_t>>();
-        BlockState* dst = box->blocks.data();
+        std::shared_ptr<std::vector<uint16_t>> srcList;
+        const BlockState first = src[sy * SEC_H * D * W];
+        bool uniform = true;
         for (int y = 0; y < SEC_H; ++y) {
             int worldY = sy * SEC_H + y;
             for (int z = 0; z < D; ++z) {
                 for (int x = 0; x < W; ++x) {
                     BlockState state = src[(worldY * D + z) * W + x];
                     dst[(y * D + z) * W + x] = state;
+                    uniform = uniform && state == first;
                     if (isEmissive(state.type())) {
+                        if (!srcList) srcList = std::make_shared<std::vector<uint16_t>>();
                         srcList->push_back(packChunkLightPos(x, worldY, z));
                     }
                 }
             }
         }
-        out[sy] = std::move(box);
-        outLightSources[sy] = srcList->empty() ? nullptr : std::move(srcList);
+        if (uniform) {
+            out[sy] = BlockBox::sharedUniform(first);
+        } else {
+            auto box = std::make_shared<BlockBox>();
+            box->assign(dst);   // 挑最紧凑形态
+            out[sy] = std::move(box);
+        }
+        outLightSources[sy] = std::move(srcList);
     }
 }
@@ -158,7 +158,9 @@ namespace std {
 //     bit  8  localZ (0..15)
 //     bit 12  faceIndex (0..5)        —— 世界空间的面
 //     bit 15  orient (方块朝向)        —— 来自 BlockState.orient
-//     bit 19  reserved (13 bit)
+//     bit 19  quadW-1 (4 bit)         —— 贪心合并矩形宽（沿面局部 X 轴），单位面为 0
+//     bit 23  quadH-1 (4 bit)         —— 贪心合并矩形高（沿面局部 Y 轴），单位面为 0
+//     bit 27  reserved (5 bit)
 //   blockType    (16-bit)
 //   textureLayer (16-bit)
 //
@@ -190,6 +192,19 @@ struct InstanceData {
     static constexpr uint8_t   unpackY(uint32_t p)     noexcept { return  uint8_t((p >> 4) & 0xFu); }
     static constexpr uint8_t   unpackZ(uint32_t p)     noexcept { return  uint8_t((p >> 8) & 0xFu); }
     static constexpr BlockFace unpackFace(uint32_t p)  noexcept { return BlockFace((p >> 12) & 0x7u); }
+
+    // 合并矩形尺寸（Section::mergeCoplanarFaces 写入）。(x,y,z) 是矩形"锚点格"——
+    // 面局部坐标系（faceMatrices）下最小角所在的那一格；着色器把单位 quad 沿局部 X 拉伸 w 格、
+    // 沿局部 Y 拉伸 h 格，UV 同步放大，靠纹理数组的 GL_REPEAT 平铺。
+    static constexpr uint32_t QUAD_SIZE_MASK = 0xFFu << 19;
+    static constexpr uint32_t withQuadSize(uint32_t p, int w, int h) noexcept {
+        return (p & ~QUAD_SIZE_MASK)
+             | (uint32_t((w - 1) & 0xF) << 19)
+             | (uint32_t((h - 1) & 0xF) << 23);
+    }
+    static constexpr int  unpackQuadW(uint32_t p)  noexcept { return int((p >> 19) & 0xFu) + 1; }
+    static constexpr int  unpackQuadH(uint32_t p)  noexcept { return int((p >> 23) & 0xFu) + 1; }
+    static constexpr bool isMergedQuad(uint32_t p) noexcept { return (p & QUAD_SIZE_MASK) != 0; }
 };
 static_assert(sizeof(InstanceData) == 8, "InstanceData must be 8 bytes for tight GPU packing");
 
@@ -2,6 +2,7 @@
 #include <iostream>
 #include <algorithm>
 #include <cstring>
+#include <iterator>
 
 ChunkArena::ChunkArena() = default;
 
@@ -10,29 +11,96 @@ ChunkArena::~ChunkArena() {
 }
 
 uint32_t ChunkArena::oversizeTarget(uint32_t needed) {
-    uint32_t target = needed + needed / 2;
+    uint32_t target = needed + needed / 4;
     if (target > MAX_SLOT_INSTANCES) target = MAX_SLOT_INSTANCES;
     return target;
 }
 
+uint32_t ChunkArena::classCapacity(int cls) {
+    uint32_t base = MIN_CLASS_INSTANCES << (cls / 2);
+    return (cls & 1) ? base + base / 2 : base;
+}
+
+int ChunkArena::classFor(uint32_t instances) {
+    for (int cls = 0; cls < SIZE_CLASS_COUNT; ++cls) {
+        if (classCapacity(cls) >= instances) return cls;
+    }
+    return -1;
+}
+
 bool ChunkArena::initialize(uint32_t initialInstances) {
     if (m_vbo != 0) return true;
     if (initialInstances == 0) initialInstances = 1u << 16;
 
-    glGenBuffers(1, &m_vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-    glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(initialInstances) * sizeof(InstanceData),
-        nullptr, GL_DYNAMIC_DRAW);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    if (!initStaging()) {
+        std::cerr << "ChunkArena: persistent staging unavailable, falling back to glBufferSubData\n";
+    }
+    m_vbo = createVBO(initialInstances);
 
     m_capacity = initialInstances;
     m_cursor = 0;
     m_inUse = 0;
+    m_holeInstances = 0;
+    for (auto& list : m_classFree) list.clear();
     m_freeIntervals.clear();
+    m_freeBySize.clear();
+    m_compacting = false;
+    return true;
+}
+
+bool ChunkArena::initStaging() {
+    if (!GLEW_ARB_buffer_storage) return false;
+
+    const GLsizeiptr total = GLsizeiptr(STAGING_REGION_BYTES) * STAGING_REGION_COUNT;
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glGenBuffers(1, &m_staging);
+    glBindBuffer(GL_COPY_READ_BUFFER, m_staging);
+    glBufferStorage(GL_COPY_READ_BUFFER, total, nullptr, flags);
+    m_stagingPtr = static_cast<uint8_t*>(glMapBufferRange(GL_COPY_READ_BUFFER, 0, total, flags));
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    if (!m_stagingPtr) {
+        glDeleteBuffers(1, &m_staging);
+        m_staging = 0;
+        return false;
+    }
+    m_region = 0;
+    m_regionHead = 0;
+    m_pendingCopies.reserve(1024);
     return true;
 }
 
+GLuint ChunkArena::createVBO(uint32_t capacity) {
+    GLuint vbo = 0;
+    glGenBuffers(1, &vbo);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, vbo);
+    const GLsizeiptr bytes = GLsizeiptr(capacity) * sizeof(InstanceData);
+    if (m_stagingPtr) {
+        // 不可变存储：CPU 只经 staging 间接写入，驱动可放心放进显存。
+        // 保留 DYNAMIC_STORAGE_BIT 让 glBufferSubData 兜底路径仍然可用。
+        glBufferStorage(GL_COPY_WRITE_BUFFER, bytes, nullptr, GL_DYNAMIC_STORAGE_BIT);
+    } else {
+        glBufferData(GL_COPY_WRITE_BUFFER, bytes, nullptr, GL_DYNAMIC_DRAW);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    return vbo;
+}
+
 void ChunkArena::shutdown() {
+    m_pendingCopies.clear();
+    for (GLsync& f : m_regionFence) {
+        if (f) { glDeleteSync(f); f = nullptr; }
+    }
+    reapRetired(true);
+    if (m_staging) {
+        glBindBuffer(GL_COPY_READ_BUFFER, m_staging);
+        glUnmapBuffer(GL_COPY_READ_BUFFER);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glDeleteBuffers(1, &m_staging);
+        m_staging = 0;
+        m_stagingPtr = nullptr;
+    }
+    m_region = 0;
+    m_regionHead = 0;
     if (m_vbo) {
         glDeleteBuffers(1, &m_vbo);
         m_vbo = 0;
@@ -40,7 +108,11 @@ void ChunkArena::shutdown() {
     m_capacity = 0;
     m_cursor = 0;
     m_inUse = 0;
+    m_holeInstances = 0;
+    for (auto& list : m_classFree) list.clear();
     m_freeIntervals.clear();
+    m_freeBySize.clear();
+    m_compacting = false;
 }
 
 ChunkArena::Slot ChunkArena::allocate(uint32_t requestedInstances) {
@@ -52,74 +124,122 @@ ChunkArena::Slot ChunkArena::allocate(uint32_t requestedInstances) {
         return slot;
     }
 
-    uint32_t target = oversizeTarget(requestedInstances);
-
-    // ── 1. 区间空闲表 best-fit 搜索 ──
-    // 找 >= target 的最小空闲区间；没有则退而求 >= requestedInstances
-    auto tryAllocFromFree = [&](uint32_t minSize) -> bool {
-        // 线性扫描找 best-fit。区间数量通常很少（< 100），
-        // alloc/free 不在热路径上，O(n) 足够。
-        auto bestIt = m_freeIntervals.end();
-        for (auto it = m_freeIntervals.begin(); it != m_freeIntervals.end(); ++it) {
-            if (it->second >= minSize) {
-                if (bestIt == m_freeIntervals.end() || it->second < bestIt->second) {
-                    bestIt = it;
-                    if (it->second == minSize) break; // 精确匹配，已最优
-                }
-            }
-        }
-        if (bestIt == m_freeIntervals.end()) return false;
-
-        uint32_t off = bestIt->first;
-        uint32_t size = bestIt->second;
-        m_freeIntervals.erase(bestIt);
-
-        uint32_t allocSize = (size >= target) ? target : size;
-        if (size > allocSize) {
-            // 拆分：剩余部分放回空闲表
-            m_freeIntervals[off + allocSize] = size - allocSize;
-        }
-
-        slot.offset = off;
-        slot.capacity = allocSize;
-        slot.count = 0;
-        m_inUse += allocSize;
-        return true;
-    };
-
-    // 先尝试 oversize target
-    if (tryAllocFromFree(target)) return slot;
+    const int wantCls = classFor(oversizeTarget(requestedInstances));
+    const int minCls = classFor(requestedInstances);
 
-    // target 不够时退而求 requestedInstances
-    if (target > requestedInstances && tryAllocFromFree(requestedInstances)) return slot;
+    // ── 1. 空闲块：先带余量的档，不行退到刚好够用的档 ──
+    uint32_t off = 0;
+    int cls = wantCls;
+    bool found = takeFree(classCapacity(cls), off);
+    if (!found && minCls < wantCls) {
+        cls = minCls;
+        found = takeFree(classCapacity(cls), off);
+    }
 
     // ── 2. 从 cursor 切一块 ──
-    if (m_cursor + target > m_capacity) {
-        uint32_t newCap = std::max(m_capacity * 2, m_capacity + target);
-        if (!grow(newCap)) {
-            std::cerr << "ChunkArena: grow failed (cap=" << m_capacity << ", need=" << target << ")\n";
-            return Slot{};
+    if (!found) {
+        cls = wantCls;
+        uint32_t target = classCapacity(cls);
+        if (m_cursor + target > m_capacity) {
+            uint32_t newCap = std::max(m_capacity * 2, m_capacity + target);
+            if (!grow(newCap)) {
+                std::cerr << "ChunkArena: grow failed (cap=" << m_capacity << ", need=" << target << ")\n";
+                return Slot{};
+            }
         }
+        off = m_cursor;
+        m_cursor += target;
     }
-    slot.offset = m_cursor;
-    slot.capacity = target;
+
+    slot.offset = off;
+    slot.capacity = classCapacity(cls);
     slot.count = 0;
-    m_cursor += target;
-    m_inUse += target;
+    m_inUse += slot.capacity;
     return slot;
 }
 
 void ChunkArena::free(const Slot& slot) {
     if (!slot.valid()) return;
 
-    uint32_t off = slot.offset;
-    uint32_t size = slot.capacity;
+    if (m_inUse >= slot.capacity) {
+        m_inUse -= slot.capacity;
+    } else {
+        m_inUse = 0;
+    }
+
+    // 同档空闲链未满 → 直接压栈，下次同档申请 O(1) 复用。
+    // 整理期间、或块贴着 cursor（可以直接退回未切区）时走大块树合并。
+    int cls = classFor(slot.capacity);
+    if (!m_compacting && cls >= 0 && classCapacity(cls) == slot.capacity
+        && m_classFree[cls].size() < CLASS_CACHE_LIMIT
+        && slot.offset + slot.capacity != m_cursor) {
+        m_classFree[cls].push_back(slot.offset);
+        m_holeInstances += slot.capacity;
+        return;
+    }
+    insertFreeBlock(slot.offset, slot.capacity);
+}
+
+bool ChunkArena::takeFree(uint32_t capacity, uint32_t& outOffset) {
+    int cls = classFor(capacity);
+    if (cls >= 0 && !m_classFree[cls].empty()) {
+        outOffset = m_classFree[cls].back();
+        m_classFree[cls].pop_back();
+        m_holeInstances -= capacity;
+        return true;
+    }
+
+    // 大块树 best-fit：>= capacity 的最小块，O(log n)
+    auto it = m_freeBySize.lower_bound({ capacity, 0u });
+    if (it == m_freeBySize.end()) return false;
+    uint32_t off = it->second;
+    uint32_t size = it->first;
+    eraseFreeBlock(m_freeIntervals.find(off));
+    if (size > capacity) addFreeInterval(off + capacity, size - capacity);
+    outOffset = off;
+    return true;
+}
+
+bool ChunkArena::takeFreeBelow(uint32_t capacity, uint32_t limit, uint32_t& outOffset) {
+    // 同档空闲链里地址最低的（整理期间链已清空，这里只是兜底）
+    int cls = classFor(capacity);
+    if (cls >= 0 && classCapacity(cls) == capacity) {
+        auto& list = m_classFree[cls];
+        size_t best = list.size();
+        for (size_t i = 0; i < list.size(); ++i) {
+            if (list[i] + capacity <= limit && (best == list.size() || list[i] < list[best])) best = i;
+        }
+        if (best != list.size()) {
+            outOffset = list[best];
+            list[best] = list.back();
+            list.pop_back();
+            m_holeInstances -= capacity;
+            return true;
+        }
+    }
+
+    // 大块树按地址 first-fit：尽量往低处搬，高处才能连成一片退回 cursor
+    for (auto it = m_freeIntervals.begin();
+         it != m_freeIntervals.end() && it->first + capacity <= limit; ++it) {
+        if (it->second < capacity) continue;
+        uint32_t off = it->first;
+        uint32_t size = it->second;
+        eraseFreeBlock(it);
+        if (size > capacity) addFreeInterval(off + capacity, size - capacity);
+        outOffset = off;
+        return true;
+    }
+    return false;
+}
+
+void ChunkArena::insertFreeBlock(uint32_t offset, uint32_t size) {
+    uint32_t off = offset;
 
     // ── 与后继空闲区间合并 ──
     auto next = m_freeIntervals.lower_bound(off);
     if (next != m_freeIntervals.end() && next->first == off + size) {
         size += next->second;
-        m_freeIntervals.erase(next);
+        eraseFreeBlock(next);
     }
 
     // ── 与前驱空闲区间合并 ──
@@ -129,19 +249,144 @@ void ChunkArena::free(const Slot& slot) {
         if (prev->first + prev->second == off) {
             off = prev->first;
             size += prev->second;
-            m_freeIntervals.erase(prev);
+            eraseFreeBlock(prev);
         }
     }
 
-    m_freeIntervals[off] = size;
+    // ── 贴着 cursor → 退回未切区 ──
+    if (off + size == m_cursor) {
+        m_cursor = off;
+        absorbTailBlocks();
+        return;
+    }
+    addFreeInterval(off, size);
+}
 
-    if (m_inUse >= slot.capacity) {
-        m_inUse -= slot.capacity;
-    } else {
-        m_inUse = 0;
+void ChunkArena::absorbTailBlocks() {
+    for (;;) {
+        // 大块树里地址最高的区间
+        if (!m_freeIntervals.empty()) {
+            auto last = std::prev(m_freeIntervals.end());
+            if (last->first + last->second == m_cursor) {
+                m_cursor = last->first;
+                eraseFreeBlock(last);
+                continue;
+            }
+        }
+        // 档链里的块（每档至多 CLASS_CACHE_LIMIT 个，只在 cursor 回退时扫）
+        bool absorbed = false;
+        for (int cls = 0; cls < SIZE_CLASS_COUNT && !absorbed; ++cls) {
+            const uint32_t cap = classCapacity(cls);
+            auto& list = m_classFree[cls];
+            for (size_t i = 0; i < list.size(); ++i) {
+                if (list[i] + cap != m_cursor) continue;
+                m_cursor = list[i];
+                list[i] = list.back();
+                list.pop_back();
+                m_holeInstances -= cap;
+                absorbed = true;
+                break;
+            }
+        }
+        if (!absorbed) return;
     }
 }
 
+void ChunkArena::addFreeInterval(uint32_t offset, uint32_t size) {
+    m_freeIntervals[offset] = size;
+    m_freeBySize.insert({ size, offset });
+    m_holeInstances += size;
+}
+
+void ChunkArena::eraseFreeBlock(std::map<uint32_t, uint32_t>::iterator it) {
+    m_freeBySize.erase({ it->second, it->first });
+    m_holeInstances -= it->second;
+    m_freeIntervals.erase(it);
+}
+
+float ChunkArena::fragmentation() const {
+    if (m_holeInstances == 0) return 0.0f;
+    uint32_t largestHole = m_freeBySize.empty() ? 0 : m_freeBySize.rbegin()->first;
+    for (int cls = SIZE_CLASS_COUNT - 1; cls >= 0; --cls) {
+        if (!m_classFree[cls].empty()) {
+            largestHole = std::max(largestHole, classCapacity(cls));
+            break;
+        }
+    }
+    return 1.0f - float(largestHole) / float(m_holeInstances);
+}
+
+bool ChunkArena::wantsCompaction() const {
+    if (m_compacting
+        || m_holeInstances < COMPACT_MIN_HOLES
+        || float(m_holeInstances) <= float(m_cursor) * COMPACT_HOLE_RATIO)
+        return false;
+    // 滞回：上一轮一个 slot 都没搬动（空洞放不下任何活 slot）时，等空洞量或已切区变化够大再试，
+    // 否则每帧都会重新收集候选、把档链倒进大块树，然后原样结束
+    if (m_lastPassStuck) {
+        const uint32_t dh = m_holeInstances > m_lastPassHoles
+            ? m_holeInstances - m_lastPassHoles : m_lastPassHoles - m_holeInstances;
+        const uint32_t dc = m_cursor > m_lastPassCursor
+            ? m_cursor - m_lastPassCursor : m_lastPassCursor - m_cursor;
+        if (dh < COMPACT_RETRY_DELTA && dc < COMPACT_RETRY_DELTA) return false;
+    }
+    return true;
+}
+
+void ChunkArena::beginCompaction() {
+    // 档链里的块彼此可能相邻，全部倒进大块树才能合并出大空洞
+    for (int cls = 0; cls < SIZE_CLASS_COUNT; ++cls) {
+        const uint32_t cap = classCapacity(cls);
+        for (uint32_t off : m_classFree[cls]) {
+            m_holeInstances -= cap;
+            insertFreeBlock(off, cap);
+        }
+        m_classFree[cls].clear();
+    }
+    m_compacting = true;
+    m_passStartMoved = m_compactMovedSlots;
+}
+
+void ChunkArena::endCompaction() {
+    m_compacting = false;
+    m_lastPassStuck = m_compactMovedSlots == m_passStartMoved;
+    m_lastPassHoles = m_holeInstances;
+    m_lastPassCursor = m_cursor;
+}
+
+ChunkArena::Slot ChunkArena::relocate(const Slot& slot) {
+    if (!slot.valid()) return Slot{};
+
+    // 排队中的 staging 拷贝可能还写向旧位置，先落地再整体搬
+    flushUploads();
+
+    uint32_t newOff = 0;
+    if (!takeFreeBelow(slot.capacity, slot.offset, newOff)) return Slot{};
+
+    if (slot.count > 0) {
+        // 同一 buffer 内不重叠区间的拷贝，GL 命令流保证排在此前的写入和绘制之后
+        glBindBuffer(GL_COPY_READ_BUFFER, m_vbo);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, m_vbo);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+            GLintptr(slot.offset) * sizeof(InstanceData),
+            GLintptr(newOff) * sizeof(InstanceData),
+            GLsizeiptr(slot.count) * sizeof(InstanceData));
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+
+    Slot moved;
+    moved.offset = newOff;
+    moved.capacity = slot.capacity;
+    moved.count = slot.count;
+    m_inUse += slot.capacity;
+    free(slot);
+
+    ++m_compactMovedSlots;
+    m_compactMovedInstances += slot.count;
+    return moved;
+}
+
 void ChunkArena::upload(Slot& slot, const InstanceData* data, uint32_t count) {
     if (!slot.valid() || count == 0) {
         slot.count = 0;
@@ -151,12 +396,8 @@ void ChunkArena::upload(Slot& slot, const InstanceData* data, uint32_t count) {
         std::cerr << "ChunkArena::upload count > capacity (" << count << " > " << slot.capacity << ")\n";
         count = slot.capacity;
     }
-    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-    glBufferSubData(GL_ARRAY_BUFFER,
-        GLintptr(slot.offset) * sizeof(InstanceData),
-        GLsizeiptr(count) * sizeof(InstanceData),
-        data);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    writeRange(slot.offset * (uint32_t)sizeof(InstanceData), data,
+        count * (uint32_t)sizeof(InstanceData));
     slot.count = count;
 }
 
@@ -170,57 +411,34 @@ void ChunkArena::patch(Slot& slot, const InstanceData* data,
         return;
     }
 
-    // 找出 dirty index 的 [minIdx, maxIdx]，map 这段范围一次写完
-    uint32_t minIdx = indices[0];
-    uint32_t maxIdx = indices[0];
-    for (uint32_t i = 1; i < indexCount; ++i) {
-        uint32_t v = indices[i];
-        if (v < minIdx) minIdx = v;
-        if (v > maxIdx) maxIdx = v;
-    }
-    if (maxIdx >= slot.capacity) {
-        std::cerr << "ChunkArena::patch index " << maxIdx
-                  << " >= capacity " << slot.capacity << std::endl;
-        return;
-    }
-
-    GLintptr off = (GLintptr(slot.offset) + GLintptr(minIdx)) * (GLintptr)sizeof(InstanceData);
-    GLsizeiptr len = (GLsizeiptr)(maxIdx - minIdx + 1) * (GLsizeiptr)sizeof(InstanceData);
-
-    // 两种 glMapBufferRange 策略对比（切换此 bool 即可）
-    constexpr bool USE_INVALIDATE_RANGE = true;
+    // 排序去重后切 run：同一帧里同一个下标可能被多次标脏（拆分 + 复用槽）
+    m_patchScratch.assign(indices, indices + indexCount);
+    std::sort(m_patchScratch.begin(), m_patchScratch.end());
+    m_patchScratch.erase(std::unique(m_patchScratch.begin(), m_patchScratch.end()), m_patchScratch.end());
 
-    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-
-    GLbitfield mapFlags = GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
-    if (USE_INVALIDATE_RANGE) {
-        mapFlags |= GL_MAP_INVALIDATE_RANGE_BIT;
-    }
-
-    void* ptr = glMapBufferRange(GL_ARRAY_BUFFER, off, len, mapFlags);
-    if (!ptr) {
-        std::cerr << "ChunkArena::patch glMapBufferRange failed (off=" << off
-                  << " len=" << len << " flags=" << mapFlags << ")\n";
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    const uint32_t maxIdx = m_patchScratch.back();
+    if (maxIdx >= newCount) {
+        std::cerr << "ChunkArena::patch index " << maxIdx
+                  << " >= count " << newCount << std::endl;
         return;
     }
 
-    if (USE_INVALIDATE_RANGE) {
-        // 临时内存未初始化 → memcpy 填满整个 [minIdx, maxIdx] 范围
-        uint32_t rangeCount = maxIdx - minIdx + 1;
-        std::memcpy(ptr, data + minIdx, rangeCount * sizeof(InstanceData));
-    } else {
-        // 直接映射 VBO 真实页 → 稀疏写入，只改脏位置
-        InstanceData* dst = reinterpret_cast<InstanceData*>(ptr);
-        for (uint32_t i = 0; i < indexCount; ++i) {
-            uint32_t idx = indices[i];
-            if (idx >= slot.capacity) continue;
-            dst[idx - minIdx] = data[idx];
+    auto emitRun = [&](uint32_t first, uint32_t last) {
+        writeRange((slot.offset + first) * (uint32_t)sizeof(InstanceData), data + first,
+            (last - first + 1) * (uint32_t)sizeof(InstanceData));
+    };
+    uint32_t runFirst = m_patchScratch[0];
+    uint32_t runLast = runFirst;
+    for (size_t i = 1; i < m_patchScratch.size(); ++i) {
+        uint32_t v = m_patchScratch[i];
+        if (v - runLast <= PATCH_GAP_MERGE + 1) {
+            runLast = v;
+        } else {
+            emitRun(runFirst, runLast);
+            runFirst = runLast = v;
         }
     }
-
-    glUnmapBuffer(GL_ARRAY_BUFFER);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    emitRun(runFirst, runLast);
 
     slot.count = newCount;
 }
@@ -239,49 +457,155 @@ ChunkArena::Slot ChunkArena::reupload(Slot oldSlot, const InstanceData* data, ui
 bool ChunkArena::grow(uint32_t newCapacity) {
     if (newCapacity <= m_capacity) return true;
 
-    GLuint newVBO = 0;
-    glGenBuffers(1, &newVBO);
-    glBindBuffer(GL_ARRAY_BUFFER, newVBO);
-    glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(newCapacity) * sizeof(InstanceData),
-        nullptr, GL_DYNAMIC_DRAW);
+    // 已排队的拷贝命令目标是旧 VBO，先落地，下面的整体搬迁才能带上它们
+    flushUploads();
 
-    if (m_vbo && m_capacity > 0) {
-        // 已使用的部分（[0, m_cursor)）拷贝过来。
+    GLuint newVBO = createVBO(newCapacity);
+
+    if (m_vbo && m_cursor > 0) {
+        // 只搬已切出的部分 [0, m_cursor)，[m_cursor, m_capacity) 从未写过。
         // 空闲区间表中的 offset 都在 cursor 之前，仍然有效。
+        // 纯 GPU 侧拷贝，CPU 不等待；旧 VBO 可能还被上一帧的 draw 引用，挂 fence 延迟删除。
         glBindBuffer(GL_COPY_READ_BUFFER, m_vbo);
         glBindBuffer(GL_COPY_WRITE_BUFFER, newVBO);
         glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
-            0, 0, GLsizeiptr(m_capacity) * sizeof(InstanceData));
+            0, 0, GLsizeiptr(m_cursor) * sizeof(InstanceData));
         glBindBuffer(GL_COPY_READ_BUFFER, 0);
         glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
-        glDeleteBuffers(1, &m_vbo);
     }
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    if (m_vbo) {
+        m_retired.push_back({ m_vbo, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) });
+    }
 
     m_vbo = newVBO;
     m_capacity = newCapacity;
+    ++m_growCount;
     return true;
 }
 
+void ChunkArena::writeRange(uint32_t dstByte, const void* src, uint32_t bytes) {
+    if (bytes == 0) return;
+    m_stats.bytes += bytes;
+
+    if (!m_stagingPtr) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, m_vbo);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, GLintptr(dstByte), GLsizeiptr(bytes), src);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        return;
+    }
+
+    // 当前段放不下 → 提前提交并换段（bytes 不超过单 slot 上限，新段一定放得下）
+    if (m_regionHead + bytes > STAGING_REGION_BYTES) flushUploads();
+    // 新段首次写入：等它上一轮的拷贝命令被 GPU 消费完
+    if (m_regionHead == 0) waitRegion(m_region);
+
+    const uint32_t srcByte = m_region * STAGING_REGION_BYTES + m_regionHead;
+    std::memcpy(m_stagingPtr + srcByte, src, bytes);
+    m_regionHead += bytes;
+
+    // 与上一条命令首尾相接（整段 upload 或相邻 run）→ 合并成一条
+    if (!m_pendingCopies.empty()) {
+        CopyCmd& last = m_pendingCopies.back();
+        if (last.src + last.len == srcByte && last.dst + last.len == dstByte) {
+            last.len += bytes;
+            return;
+        }
+    }
+    m_pendingCopies.push_back({ srcByte, dstByte, bytes });
+}
+
+void ChunkArena::flushUploads() {
+    reapRetired(false);
+    if (m_pendingCopies.empty()) return;
+
+    glBindBuffer(GL_COPY_READ_BUFFER, m_staging);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_vbo);
+    for (const CopyCmd& c : m_pendingCopies) {
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+            GLintptr(c.src), GLintptr(c.dst), GLsizeiptr(c.len));
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    m_stats.copies += (uint32_t)m_pendingCopies.size();
+    m_pendingCopies.clear();
+
+    // 本段的读取命令都已入队 → 打 fence，轮到下一段
+    m_regionFence[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_region = (m_region + 1) % STAGING_REGION_COUNT;
+    m_regionHead = 0;
+}
+
+void ChunkArena::waitRegion(uint32_t region) {
+    GLsync& fence = m_regionFence[region];
+    if (!fence) return;
+    // 先零超时探一次：正常情况下 GPU 早已消费完两帧前的拷贝，不计入停顿
+    GLenum r = glClientWaitSync(fence, 0, 0);
+    if (r == GL_TIMEOUT_EXPIRED) {
+        ++m_stats.ringStalls;
+        do {
+            r = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+        } while (r == GL_TIMEOUT_EXPIRED);
+    }
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+void ChunkArena::reapRetired(bool force) {
+    for (size_t i = 0; i < m_retired.size();) {
+        RetiredBuffer& rb = m_retired[i];
+        if (!force) {
+            GLenum r = glClientWaitSync(rb.fence, 0, 0);
+            if (r == GL_TIMEOUT_EXPIRED) { ++i; continue; }
+        }
+        glDeleteSync(rb.fence);
+        glDeleteBuffers(1, &rb.buffer);
+        rb = m_retired.back();
+        m_retired.pop_back();
+    }
+}
+
+ChunkArena::UploadStats ChunkArena::takeUploadStats() {
+    UploadStats s = m_stats;
+    m_stats = UploadStats{};
+    return s;
+}
+
 int ChunkArena::getFreeBlockCount() const {
-    return (int)m_freeIntervals.size();
+    size_t n = m_freeIntervals.size();
+    for (const auto& list : m_classFree) n += list.size();
+    return (int)n;
 }
 
 uint32_t ChunkArena::getLargestFreeBlock() const {
     uint32_t best = (m_cursor < m_capacity) ? (m_capacity - m_cursor) : 0;
-    for (const auto& kv : m_freeIntervals) {
-        if (kv.second > best) best = kv.second;
+    if (!m_freeBySize.empty()) best = std::max(best, m_freeBySize.rbegin()->first);
+    for (int cls = SIZE_CLASS_COUNT - 1; cls >= 0; --cls) {
+        if (!m_classFree[cls].empty()) {
+            best = std::max(best, classCapacity(cls));
+            break;
+        }
     }
     return best;
 }
 
 void ChunkArena::dumpClassStats(std::ostream& os) const {
-    os << "Arena free intervals(" << m_freeIntervals.size() << "):";
+    os << "Arena classes(cached free):";
+    for (int cls = 0; cls < SIZE_CLASS_COUNT; ++cls) {
+        if (m_classFree[cls].empty()) continue;
+        os << " " << classCapacity(cls) << "x" << m_classFree[cls].size();
+    }
+    os << " | tree(" << m_freeIntervals.size() << "):";
     int count = 0;
     for (const auto& kv : m_freeIntervals) {
         os << " [" << kv.first << "+" << kv.second << "]";
         if (++count >= 12) { os << " ..."; break; }
     }
-    os << " cursor=" << m_cursor << "/" << m_capacity
-       << " inUse=" << m_inUse;
+    os << " | cursor=" << m_cursor << "/" << m_capacity
+       << " inUse=" << m_inUse
+       << " holes=" << m_holeInstances
+       << " frag=" << int(fragmentation() * 100.0f + 0.5f) << "%"
+       << " tail=" << (m_capacity - m_cursor)
+       << " | compacted=" << m_compactMovedSlots << " slots/" << m_compactMovedInstances << " inst"
+       << " grows=" << m_growCount
+       << (m_compacting ? " (compacting)" : "");
 }
@@ -3,16 +3,27 @@
 #include "BlockType.h"
 #include <vector>
 #include <map>
+#include <set>
 #include <cstdint>
 #include <ostream>
 
 // GPU 端的"段式"实例缓冲：所有 section 的 InstanceData 共用一块大 VBO，
 // 每个 section 占据其中一段 slot（offset, capacity）。
 //
-// 使用区间空闲表（std::map<offset, size>）管理空闲块：
-//  - allocate: best-fit 搜索，大块自动拆分为小块
-//  - free: 自动与相邻空闲块合并，避免碎片化
-//  - 首次分配时按 1.5x 预留，减少 grow 频率
+// 分配器是分级（size class）+ 大块树的组合：
+//  - slot 容量只取 SIZE_CLASS_COUNT 个档位（64 起，每个 2 的幂区间再对半分一档：64/96/128/192/…/8192/12288），
+//    申请量先留 25% 余量再向上取档，平均预留约 1.5x，与旧版 oversize 相当
+//  - 每档一条空闲链（offset 栈），同档释放/申请 O(1) 精确复用
+//  - 档链满了或正在整理时，释放的块进"大块树"：按 offset 的 map（合并相邻）+ 按 (size, offset) 的 set（O(log n) best-fit）；
+//    合并后贴着 m_cursor 的块直接退回未切区（cursor 回退后新贴上的档链 / 树中块也一并退回）
+//  - 碎片整理（relocate）由 ChunkManager 逐帧驱动：把高地址的活 slot 用 glCopyBufferSubData 搬进低地址空洞，
+//    每帧限量，几帧内收拢，避免长时间运行后只能 grow
+//
+// 上传走持久映射的 staging 环（ARB_buffer_storage，PERSISTENT | COHERENT）：
+//  - upload/patch 只把数据 memcpy 进环并记一条 (src, dst, len) 拷贝命令，不碰 GL map/unmap
+//  - flushUploads() 每帧一次把攒下的命令批量 glCopyBufferSubData 到 VBO，然后给该区域打 fence
+//  - 环分 STAGING_REGION_COUNT 段轮转；写某段前等它上一轮的 fence（正常情况下早已 signaled）
+// 驱动不支持 buffer storage 时退回 glBufferSubData 直传。
 class ChunkArena {
 public:
     struct Slot {
@@ -29,12 +40,13 @@ public:
     void shutdown();
 
     // 申请一段空间。requestedInstances 为真实需要的实例数；
-    // 内部会 oversize 1.5x 提供缓冲。
+    // 内部留 25% 余量后向上取到 size class，slot.capacity 即该档容量。
     Slot allocate(uint32_t requestedInstances);
 
     void free(const Slot& slot);
 
     // 上传到 slot。data 长度为 count，必须 <= slot.capacity
+    // 数据立即拷进 staging 环，GPU 侧拷贝在 flushUploads() 时才提交。
     void upload(Slot& slot, const InstanceData* data, uint32_t count);
 
     // count <= slot.capacity 时原地 upload；否则 free 旧 slot，分配新 slot。
@@ -45,17 +57,45 @@ public:
     // - indices 是相对 slot 内（0-based）的下标列表
     // - newCount 表示更新后 slot 的有效实例数（必须 <= slot.capacity）
     //
-    // 实现策略：单次 glMapBufferRange 覆盖 [minIdx, maxIdx] 范围，
-    // 配 GL_MAP_UNSYNCHRONIZED_BIT，跳过驱动同步等待。
-    // 调用方需保证：上一帧 GPU 已经画完这些位置（每帧帧首调用即可满足）。
+    // 实现策略：indices 排序后切成连续 run（间隔 <= PATCH_GAP_MERGE 的 run 合并），
+    // 每个 run 拷进 staging 环并生成一条拷贝命令 —— 开销正比于改动字节数。
     void patch(Slot& slot, const InstanceData* data,
                const uint32_t* indices, uint32_t indexCount,
                uint32_t newCount);
 
+    // 提交本帧攒下的所有拷贝命令（staging → VBO）。
+    // 每帧 upload pass 之后、绘制之前调用一次；没有待提交命令时为空操作。
+    void flushUploads();
+
+    // 每帧上传统计（取出后清零），供 Profiler 计数
+    struct UploadStats {
+        uint64_t bytes = 0;        // 拷进 staging 的字节数
+        uint32_t copies = 0;       // glCopyBufferSubData 次数（相邻命令已合并）
+        uint32_t ringStalls = 0;   // 写入前 fence 尚未 signaled、需要真等待的次数
+    };
+    UploadStats takeUploadStats();
+    bool isPersistentStaging() const { return m_stagingPtr != nullptr; }
+
     GLuint getVBO() const { return m_vbo; }
     uint32_t getCapacity() const { return m_capacity; }
     uint32_t getInUse() const { return m_inUse; }
 
+    // ── 碎片整理（增量，调用方逐帧驱动）──
+    // 空洞：[0, m_cursor) 内的空闲实例数（档链 + 大块树），不含尾部未切区
+    uint32_t getHoleInstances() const { return m_holeInstances; }
+    // 碎片率 = 1 - 最大空洞 / 空洞总量；0 = 无空洞或空洞是一整块
+    float fragmentation() const;
+    // 空洞超过已切区的 COMPACT_HOLE_RATIO 且绝对量达到 COMPACT_MIN_HOLES 时建议整理；
+    // 上一轮没搬动任何 slot 时，要等空洞量或 cursor 变化超过 COMPACT_RETRY_DELTA 才再建议
+    bool wantsCompaction() const;
+    // 整理开始：档链全部倒进大块树合并；整理期间释放一律进树
+    void beginCompaction();
+    void endCompaction();
+    bool isCompacting() const { return m_compacting; }
+    // 把 slot 原样（同容量、同 count）搬到 offset 更低的空闲处，GPU 侧拷贝，旧 slot 释放。
+    // 找不到更低的位置时返回无效 slot，原 slot 不变。
+    Slot relocate(const Slot& slot);
+
     // 调试统计
     int getFreeBlockCount() const;
     uint32_t getLargestFreeBlock() const;
@@ -65,20 +105,92 @@ public:
     // 但最坏情况是棋盘格地形，普通游戏中不会出现）。
     static constexpr uint32_t MAX_SLOT_INSTANCES = 12288;
 
+    // size class：64 * {1, 1.5, 2, 3, 4, …}，最后一档正好是 MAX_SLOT_INSTANCES
+    static constexpr int SIZE_CLASS_COUNT = 16;
+    static constexpr uint32_t MIN_CLASS_INSTANCES = 64;
+    // 每档空闲链最多缓存的块数，超出的释放进大块树参与合并
+    static constexpr uint32_t CLASS_CACHE_LIMIT = 32;
+    static constexpr float COMPACT_HOLE_RATIO = 0.25f;
+    static constexpr uint32_t COMPACT_MIN_HOLES = 1u << 16;
+    static constexpr uint32_t COMPACT_RETRY_DELTA = COMPACT_MIN_HOLES / 4;
+
+    // staging 环：3 段轮转（CPU 写当前段时，GPU 最多还在读前两帧的段）。
+    // 单段 4MB ≈ 50 万实例，远大于单个 slot 上限（12288 * 8B = 96KB），一帧写满时提前 flush。
+    static constexpr uint32_t STAGING_REGION_COUNT = 3;
+    static constexpr uint32_t STAGING_REGION_BYTES = 4u << 20;
+    // patch 时两个脏 run 相隔不超过此实例数就合并成一条拷贝（多拷几十字节比多一条命令便宜）
+    static constexpr uint32_t PATCH_GAP_MERGE = 8;
+
 private:
-    // VBO 总容量不足时扩容。
+    // VBO 总容量不足时扩容。GPU 侧只拷 [0, m_cursor)，旧 VBO 挂 fence 延迟删除。
     bool grow(uint32_t newCapacity);
 
-    // oversize 1.5x，上限 MAX_SLOT_INSTANCES
+    // 25% 余量，上限 MAX_SLOT_INSTANCES
     static uint32_t oversizeTarget(uint32_t needed);
+    // 容量 >= instances 的最小档位；超过 MAX_SLOT_INSTANCES 返回 -1
+    static int classFor(uint32_t instances);
+    static uint32_t classCapacity(int cls);
+
+    // 从档链 / 大块树取 capacity 大小的块（不动 cursor）
+    bool takeFree(uint32_t capacity, uint32_t& outOffset);
+    // 取 offset + capacity <= limit 的最低地址块（relocate 用，first-fit by address）
+    bool takeFreeBelow(uint32_t capacity, uint32_t limit, uint32_t& outOffset);
+    // 大块树：插入并与前后合并；贴着 cursor 时退回未切区
+    void insertFreeBlock(uint32_t offset, uint32_t size);
+    // cursor 回退后，把恰好贴着新 cursor 的空闲块（树或档链）逐个并回未切区
+    void absorbTailBlocks();
+    // 不合并地挂进大块树（调用方保证两侧不是空闲块）
+    void addFreeInterval(uint32_t offset, uint32_t size);
+    void eraseFreeBlock(std::map<uint32_t, uint32_t>::iterator it);
+
+    bool initStaging();
+    GLuint createVBO(uint32_t capacity);
+    // 把 [src, src+bytes) 写到 VBO 的 dstByte 处：有 staging 则入环 + 记命令，否则 glBufferSubData
+    void writeRange(uint32_t dstByte, const void* src, uint32_t bytes);
+    void waitRegion(uint32_t region);
+    void reapRetired(bool force);
+
+    struct CopyCmd {
+        uint32_t src;              // staging 内字节偏移
+        uint32_t dst;              // VBO 内字节偏移
+        uint32_t len;
+    };
+    struct RetiredBuffer {
+        GLuint buffer;
+        GLsync fence;
+    };
+
+    GLuint m_staging = 0;
+    uint8_t* m_stagingPtr = nullptr;                   // 持久映射基址，nullptr = 不支持，走直传
+    GLsync m_regionFence[STAGING_REGION_COUNT] = {};
+    uint32_t m_region = 0;                             // 当前写入段
+    uint32_t m_regionHead = 0;                         // 当前段内已写字节
+    std::vector<CopyCmd> m_pendingCopies;
+    std::vector<uint32_t> m_patchScratch;              // patch 排序用，复用避免每次分配
+    std::vector<RetiredBuffer> m_retired;              // grow 换下的旧 VBO，等 GPU 用完再删
+    UploadStats m_stats;
 
     GLuint m_vbo = 0;
     uint32_t m_capacity = 0;       // VBO 总容量（实例）
     uint32_t m_cursor = 0;         // 未切区起点：[m_cursor, m_capacity) 是从未分配过的空间
     uint32_t m_inUse = 0;          // 已分配的总容量
+    uint32_t m_holeInstances = 0;  // [0, m_cursor) 内空闲实例总数
+
+    // 每档空闲链：offset 栈
+    std::vector<uint32_t> m_classFree[SIZE_CLASS_COUNT];
 
-    // 空闲区间表：offset → size，按 offset 排序
-    // allocate: best-fit（选 >= 需求的最小区间），大块拆分
-    // free: 插入后自动与前后相邻空闲区间合并
+    // 大块树：offset → size（合并相邻用）+ (size, offset)（best-fit 用），两者同步维护
     std::map<uint32_t, uint32_t> m_freeIntervals;
+    std::set<std::pair<uint32_t, uint32_t>> m_freeBySize;
+
+    bool m_compacting = false;
+    // 滞回（wantsCompaction）：上一轮结束时的状态
+    bool m_lastPassStuck = false;      // 上一轮一个 slot 都没搬动
+    uint32_t m_lastPassHoles = 0;
+    uint32_t m_lastPassCursor = 0;
+    uint64_t m_passStartMoved = 0;     // 本轮开始时的 m_compactMovedSlots
+    // 累计统计（dumpClassStats）
+    uint64_t m_compactMovedSlots = 0;
+    uint64_t m_compactMovedInstances = 0;
+    uint32_t m_growCount = 0;
 };
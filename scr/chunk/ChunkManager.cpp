@@ -77,16 +77,8 @@ ChunkManager::~ChunkManager() {
     m_arena.shutdown();
 }
 
-SectionKey ChunkManager::makeSectionKey(int chunkX, int chunkZ, int sectionY) {
-    uint64_t ux = (uint32_t)chunkX & 0xFFFFFFu;
-    uint64_t uz = (uint32_t)chunkZ & 0xFFFFFFu;
-    uint64_t uy = (uint32_t)sectionY & 0xFFu;
-    return (ux << 32) | (uz << 8) | uy;
-}
-
 void ChunkManager::initialize(int renderRadius, const glm::vec3& cameraPos) {
     m_renderRadius = renderRadius;
-    m_maxUploadsPerFrame = RuntimeConfig::get().maxUploadsPerFrame;
     m_maxInflightRequests = RuntimeConfig::get().maxInflightRequests;
     m_autoSaveIntervalSec = RuntimeConfig::get().autoSaveIntervalSec;
     m_retainMargin = RuntimeConfig::get().retainMarginChunks;
@@ -130,7 +122,12 @@ void ChunkManager::initialize(int renderRadius, const glm::vec3& cameraPos) {
         int hw = (int)std::thread::hardware_concurrency();
         n = std::max(2, std::min(8, hw - 2));
     }
+    m_workerPool.setGreedyMeshing(RuntimeConfig::get().greedyMeshing);
+    int lightJobs = RuntimeConfig::get().maxConcurrentLightJobs;
+    if (lightJobs <= 0) lightJobs = std::max(1, n / 2);
+    m_workerPool.setMaxConcurrentLightJobs(lightJobs);
     m_workerPool.start(m_generator.get(), n);
+    syncWorkerPriorities();
 
     updateActiveChunks(cameraPos);
 }
@@ -144,9 +141,32 @@ void ChunkManager::update(std::shared_ptr<Camera> camera) {
     );
     if (cameraChunk != m_currentCenterChunk) {
         m_currentCenterChunk = cameraChunk;
+        m_pendingResortMask = 0x7;  // 待集成队列按新相机位置重排
+        syncWorkerPriorities();
         updateActiveChunks(m_camera->Position);
         m_needChunkScan = true;
     }
+    // 加载中心（Host + 远程玩家）可能由 setLoadCenters 改动，这里统一同步给调度器
+    syncWorkerPriorities();
+
+    // 调度器丢弃的任务（已跑出所有中心的 retain 半径）：清掉 in-flight 标记，
+    // 之后若重新进入范围，requestMissingChunks / checkAndSubmitMesh 会照常重新投递。
+    {
+        std::vector<CancelledChunkJob> cancelled;
+        m_workerPool.drainCancelled(cancelled);
+        for (const auto& c : cancelled) {
+            ChunkKey key = chunkPosToKey(c.pos);
+            if (c.isMesh) m_meshInFlight.erase(key);
+            else m_inFlight.erase(key);
+        }
+        if (!cancelled.empty()) Profiler::addCounter("pool.cancelled", (int64_t)cancelled.size());
+        int64_t steals = m_workerPool.takeStealCount();
+        if (steals > 0) Profiler::addCounter("pool.steals", steals);
+        // Task 3 吞吐：本帧完成数 + 排队深度
+        int64_t lightBuilt = m_workerPool.takeLightBuiltCount();
+        if (lightBuilt > 0) Profiler::addCounter("pool.lightBuilt", lightBuilt);
+        Profiler::addCounter("pool.lightQueue", (int64_t)m_workerPool.lightQueuedCount());
+    }
 
     float camDist = glm::distance(m_lastVisCameraPos, m_camera->Position);
     float YawDelta = std::abs(m_lastVisCameraYaw - m_camera->Yaw);
@@ -159,6 +179,9 @@ void ChunkManager::update(std::shared_ptr<Camera> camera) {
         ++m_visGeneration;
     }
 
+    // 本帧集成预算（Task 1/2/3 结果 + rebuildDrawCommands 里的 GPU 上传共用）
+    m_integrationBudget.beginFrame(RuntimeConfig::get().integrationBudgetMs);
+
     // Task 1 集成：block data 进入 BLOCK_READY，通知邻居，触发 Task 2 检查
     integrateBlockData();
     // Task 2 集成：mesh 结果进入 m_loadedChunks
@@ -183,6 +206,9 @@ void ChunkManager::update(std::shared_ptr<Camera> camera) {
             doAutoSave();
             m_autoSaveTimer = 0.0f;
         }
+        Profiler::addCounter("save.pending", (int64_t)m_saveManager->pendingSaveCount());
+        int64_t prefetched = m_saveManager->takePrefetchedBytes();
+        if (prefetched > 0) Profiler::addCounter("save.prefetchKB", prefetched / 1024);
 
         // 远距离卸载降频：每 UNLOAD_CHECK_INTERVAL_SEC 扫一次即可，
         // chunk 不会在一帧内从渲染半径冲到卸载半径外（边界在 render+UNLOAD_MARGIN 之外）。
@@ -218,9 +244,9 @@ Chunk* ChunkManager::getChunkAnyState(const glm::ivec2& chunkPos) {
 // 取某个 chunk 的 16 个 section BlockBox（数据 + 锁），填入 out（每个 shared_ptr +1 引用）。
 // LOADED 从各 Section 取，BLOCK_READY 从 entry 取 —— 两者都是【同一份】数据源（无第二份快照）。
 // 找到返回 true。out 里持有 shared_ptr 即保证 box 在调用方使用期间不被释放。
-bool ChunkManager::getChunkBoxes(const glm::ivec2& chunkPos, ChunkBoxes& out) {
+bool ChunkManager::getChunkBoxes(const glm::ivec2& chunkPos, ChunkBoxes& out, bool includeBlockReady) {
     ChunkKey key = chunkPosToKey(chunkPos);
-    auto itBR = m_blockReady.find(key);
+    auto itBR = includeBlockReady ? m_blockReady.find(key) : m_blockReady.end();
     if (itBR != m_blockReady.end()) {
         out = itBR->second.boxes;  // 拷 shared_ptr 数组，引用计数 +1
         return true;
@@ -305,9 +331,17 @@ void ChunkManager::printStats() const {
     std::cout << "Visible Instances: " << m_visibleInstanceCount << std::endl;
     std::cout << "InFlight: " << m_inFlight.size()
         << " / WorkerPending: " << m_workerPool.pendingCount() << std::endl;
+    std::cout << "BlockBox Memory: " << (BlockBox::totalMemoryBytes() / 1024) << " KB"
+        << " | single=" << BlockBox::liveCount(BlockBox::STORAGE_SINGLE)
+        << " p4=" << BlockBox::liveCount(BlockBox::STORAGE_PALETTE4)
+        << " p8=" << BlockBox::liveCount(BlockBox::STORAGE_PALETTE8)
+        << " raw=" << BlockBox::liveCount(BlockBox::STORAGE_RAW)
+        << " sharedUniform=" << BlockBox::sharedUniformCount() << std::endl;
     std::cout << "Arena: " << m_arena.getInUse() << " / " << m_arena.getCapacity()
         << " | freeBlocks=" << m_arena.getFreeBlockCount()
         << " largestFree=" << m_arena.getLargestFreeBlock() << std::endl;
+    m_arena.dumpClassStats(std::cout);
+    std::cout << std::endl;
     std::cout << "===========================" << std::endl;
 }
 
@@ -330,6 +364,49 @@ bool ChunkManager::isWithinEvictRadius(const glm::ivec2& chunkPos,
     return dx <= r && dz <= r;
 }
 
+void ChunkManager::syncWorkerPriorities() {
+    // 与 isDataRelevant 同一套中心：m_loadCenters 为空则退化为本机相机中心 + m_renderRadius
+    std::vector<LoadCenter> centers = m_loadCenters;
+    if (centers.empty()) centers.push_back({ m_currentCenterChunk, m_renderRadius });
+    if (centers == m_priorityCenters) return;
+    prefetchAroundCenters(m_priorityCenters, centers);
+    m_priorityCenters = centers;
+
+    std::vector<ChunkJobCenter> jobCenters;
+    jobCenters.reserve(centers.size());
+    for (const auto& c : centers) jobCenters.push_back({ c.center, c.radius });
+    // 取消半径与 requestMissingChunks 踢在途请求的标准一致：render + retain
+    m_workerPool.setPriorityCenters(std::move(jobCenters), m_retainMargin);
+}
+
+void ChunkManager::prefetchAroundCenters(const std::vector<LoadCenter>& prev,
+                                         const std::vector<LoadCenter>& cur) {
+    if (!m_saveManager || m_networkClient) return;
+
+    std::vector<glm::ivec2> want;
+    for (size_t i = 0; i < cur.size(); ++i) {
+        const LoadCenter& c = cur[i];
+        // 移动方向：与上次同序号的中心比（Host 在前、远程玩家顺序稳定）；新出现的中心不外推
+        glm::ivec2 lead(0);
+        if (i < prev.size()) {
+            glm::ivec2 d = c.center - prev[i].center;
+            lead = glm::ivec2((d.x > 0) - (d.x < 0), (d.y > 0) - (d.y < 0)) * PREFETCH_LEAD;
+        }
+        glm::ivec2 pc = c.center + lead;
+        int r = c.radius + DATA_MARGIN;
+        for (int dx = -r; dx <= r; ++dx) {
+            for (int dz = -r; dz <= r; ++dz) {
+                glm::ivec2 pos(pc.x + dx, pc.y + dz);
+                if (getChunk(pos)) continue;
+                ChunkKey key = chunkPosToKey(pos);
+                if (m_blockReady.count(key) || m_inFlight.count(key)) continue;
+                want.push_back(pos);
+            }
+        }
+    }
+    if (!want.empty()) m_saveManager->prefetchChunks(want);
+}
+
 bool ChunkManager::isDataRelevant(const glm::ivec2& chunkPos, int margin) const {
     // 加载中心为空（客户端/单机）→ 退化为只看本机相机中心 + 渲染半径
     if (m_loadCenters.empty()) {
@@ -547,6 +624,22 @@ void ChunkManager::submitNetworkChunkImport(int chunkX, int chunkZ,
 // Task 1 集成：BlockDataResult → BLOCK_READY
 // ============================================================================
 
+template <class Result>
+void ChunkManager::sortPendingByDistance(std::deque<std::unique_ptr<Result>>& queue, uint8_t bit) {
+    if (!(m_pendingResortMask & bit)) return;
+    m_pendingResortMask &= (uint8_t)~bit;
+    if (queue.size() < 2) return;
+    const glm::ivec2 center = m_currentCenterChunk;
+    auto dist2 = [&center](const glm::ivec2& p) {
+        glm::ivec2 d = p - center;
+        return d.x * d.x + d.y * d.y;
+    };
+    std::stable_sort(queue.begin(), queue.end(),
+        [&](const std::unique_ptr<Result>& a, const std::unique_ptr<Result>& b) {
+            return dist2(a->pos) < dist2(b->pos);
+        });
+}
+
 void ChunkManager::integrateBlockData() {
     PROFILE_SCOPE("integrateBlockData");
     {
@@ -555,12 +648,14 @@ void ChunkManager::integrateBlockData() {
         if (!results.empty()) {
             Profiler::addCounter("ibd.resultCount", (int64_t)results.size());
             for (auto& r : results) m_pendingBlockData.push_back(std::move(r));
+            m_pendingResortMask |= 0x1;
         }
     }
-    if (m_pendingBlockData.empty()) return;
+    m_integrationBudget.beginStage(IntegrationBudget::STAGE_BLOCK);
+    sortPendingByDistance(m_pendingBlockData, 0x1);
 
-    int budget = MAX_BLOCK_INTEGRATE_PER_FRAME;
-    while (budget > 0 && !m_pendingBlockData.empty()) {
+    while (!m_pendingBlockData.empty() && m_integrationBudget.admit()) {
+        IntegrationBudget::Item item(m_integrationBudget);
         auto r = std::move(m_pendingBlockData.front());
         m_pendingBlockData.pop_front();
 
@@ -568,8 +663,8 @@ void ChunkManager::integrateBlockData() {
         m_inFlight.erase(key);
 
         // 已存在（loaded 或 block-ready）→ 跳过
-        if (m_loadedChunks.find(key) != m_loadedChunks.end()) continue;
-        if (m_blockReady.find(key) != m_blockReady.end()) continue;
+        if (m_loadedChunks.find(key) != m_loadedChunks.end()) { item.discard(); continue; }
+        if (m_blockReady.find(key) != m_blockReady.end()) { item.discard(); continue; }
 
         // 进入 BLOCK_READY（直接 move worker 产出的 16 个 box + 光源缓存）
         BlockReadyEntry entry;
@@ -580,10 +675,10 @@ void ChunkManager::integrateBlockData() {
         notePromotedChunk(r->pos);
         notifyNeighborsBlockReady(r->pos);
         checkAndSubmitMesh(r->pos);
-
-        --budget;
     }
+    Profiler::addCounter("ibd.integrated", m_integrationBudget.stageItems());
     Profiler::addCounter("ibd.queueDepth", (int64_t)m_pendingBlockData.size());
+    m_integrationBudget.endStage();
 }
 
 // ============================================================================
@@ -698,25 +793,27 @@ void ChunkManager::integrateMeshResults() {
         if (!results.empty()) {
             Profiler::addCounter("imr.resultCount", (int64_t)results.size());
             for (auto& r : results) m_pendingMeshResults.push_back(std::move(r));
+            m_pendingResortMask |= 0x2;
         }
     }
-    if (m_pendingMeshResults.empty()) return;
+    m_integrationBudget.beginStage(IntegrationBudget::STAGE_MESH);
+    sortPendingByDistance(m_pendingMeshResults, 0x2);
 
-    int budget = MAX_MESH_INTEGRATE_PER_FRAME;
-    while (budget > 0 && !m_pendingMeshResults.empty()) {
+    while (!m_pendingMeshResults.empty() && m_integrationBudget.admit()) {
+        IntegrationBudget::Item item(m_integrationBudget);
         auto r = std::move(m_pendingMeshResults.front());
         m_pendingMeshResults.pop_front();
 
         ChunkKey key = chunkPosToKey(r->pos);
         m_meshInFlight.erase(key);
 
-        if (m_loadedChunks.find(key) != m_loadedChunks.end()) continue;
+        if (m_loadedChunks.find(key) != m_loadedChunks.end()) { item.discard(); continue; }
 
         loadMeshResult(*r);
-
-        --budget;
     }
+    Profiler::addCounter("imr.integrated", m_integrationBudget.stageItems());
     Profiler::addCounter("imr.queueDepth", (int64_t)m_pendingMeshResults.size());
+    m_integrationBudget.endStage();
 }
 
 void ChunkManager::loadMeshResult(ChunkBuildResult& result) {
@@ -741,6 +838,23 @@ void ChunkManager::loadMeshResult(ChunkBuildResult& result) {
         }
     }
 
+    // Task 2 运行期间 entry 里的哨兵 box 被写时复制过（applyBlockChange）→ 结果里的 Section
+    // 仍指向哨兵。记下私有 box，等 chunk 连好邻居后逐格补回（见下方 replayCowSections）。
+    ChunkBoxes cowBoxes;
+    bool anyCow = false;
+    {
+        auto brIt = m_blockReady.find(key);
+        if (brIt != m_blockReady.end()) {
+            for (int sy = 0; sy < CHUNK_SECTION_COUNT; ++sy) {
+                const auto& brBox = brIt->second.boxes[sy];
+                if (brBox && brBox != chunk->getSectionBox(sy)) {
+                    cowBoxes[sy] = brBox;
+                    anyCow = true;
+                }
+            }
+        }
+    }
+
     // block-ready entry 的使命完成，清除（它持有的 box shared_ptr 释放，引用计数交给 Section）
     m_blockReady.erase(key);
 
@@ -761,6 +875,8 @@ void ChunkManager::loadMeshResult(ChunkBuildResult& result) {
     // 连通邻居指针 + 8 邻域光照就绪追踪
     linkNeighbors(raw);
 
+    if (anyCow) replayCowSections(raw, cowBoxes);
+
     // ── 检查该 chunk 及其 8 邻居是否满足 Task 3 光照 BFS 条件 ──
     checkAndSubmitLightBFS(raw);
 
@@ -788,6 +904,35 @@ void ChunkManager::loadMeshResult(ChunkBuildResult& result) {
     }
 }
 
+void ChunkManager::replayCowSections(Chunk* chunk, const ChunkBoxes& cowBoxes) {
+    constexpr int W = Chunk::WIDTH;
+    constexpr int D = Chunk::DEPTH;
+    for (int sy = 0; sy < CHUNK_SECTION_COUNT; ++sy) {
+        const auto& cow = cowBoxes[sy];
+        if (!cow) continue;
+        Section& sec = chunk->getSection(sy);
+        // Section 此刻仍指向 Task 2 用过的哨兵；逐格对比，setBlockAndUpdate 首次写入时自行复制
+        BlockState before[BlockBox::VOLUME];
+        sec.getBox()->copyTo(before);
+        BlockState after[BlockBox::VOLUME];
+        {
+            auto lk = cow->lockShared();
+            cow->copyTo(after);
+        }
+        for (int i = 0; i < BlockBox::VOLUME; ++i) {
+            if (before[i] == after[i]) continue;
+            int lx = i % W;
+            int lz = (i / W) % D;
+            int y = sy * Section::HEIGHT + i / (W * D);
+            chunk->setBlockAndUpdate(lx, y, lz, after[i]);
+            uint16_t packed = packChunkLightPos(lx, y, lz);
+            if (isEmissive(before[i].type())) sec.removeLightSource(packed);
+            if (isEmissive(after[i].type())) sec.addLightSource(packed);
+        }
+    }
+    chunk->markSaveDirty();
+}
+
 void ChunkManager::linkNeighbors(Chunk* newChunk) {
     glm::ivec2 p = newChunk->getPosition();
 
@@ -833,10 +978,62 @@ void ChunkManager::releaseSectionSlot(SectionKey key) {
     m_sectionSlots.erase(it);
 }
 
-void ChunkManager::uploadSection(int chunkX, int chunkZ, int sectionY,
-    Section& section, int& uploadBudget) {
-    if (uploadBudget <= 0) return;
+void ChunkManager::compactArenaStep() {
+    if (!m_arena.isCompacting()) {
+        if (!m_arena.wantsCompaction()) return;
+        PROFILE_SCOPE("arena.compactBegin");
+        m_compactQueue.clear();
+        m_compactCursor = 0;
+        for (auto& kv : m_loadedChunks) {
+            Chunk* chunk = kv.second.get();
+            if (!chunk) continue;
+            for (int sy = 0; sy < Chunk::SECTION_COUNT; ++sy) {
+                const ChunkArena::Slot& slot = chunk->getSection(sy).getGpuSlot();
+                if (slot.valid()) m_compactQueue.push_back({ slot.offset, chunk->getPosition(), sy });
+            }
+        }
+        std::sort(m_compactQueue.begin(), m_compactQueue.end(),
+            [](const CompactCandidate& a, const CompactCandidate& b) { return a.offset > b.offset; });
+        m_arena.beginCompaction();
+    }
+
+    PROFILE_SCOPE("arena.compactStep");
+    uint32_t movedInstances = 0;
+    int movedSlots = 0;
+    while (m_compactCursor < m_compactQueue.size() && movedInstances < COMPACT_INSTANCES_PER_FRAME) {
+        const CompactCandidate& c = m_compactQueue[m_compactCursor];
+        Chunk* chunk = getChunk(c.chunkPos);
+        Section* sec = chunk ? &chunk->getSection(c.sectionY) : nullptr;
+        ChunkArena::Slot cur = sec ? sec->getGpuSlot() : ChunkArena::Slot{};
+        if (!cur.valid() || cur.offset != c.offset) { ++m_compactCursor; continue; }
+        // 已落在"活数据总量"大小的前缀内：后面的候选地址更低，再搬也收益甚微，本轮结束
+        if (cur.offset + cur.capacity <= m_arena.getInUse()) {
+            m_compactCursor = m_compactQueue.size();
+            break;
+        }
+        ++m_compactCursor;
+
+        ChunkArena::Slot moved = m_arena.relocate(cur);
+        if (!moved.valid()) continue;  // 低处没有放得下的空洞
+        sec->setGpuSlot(moved);
+        m_sectionSlots[makeSectionKey(c.chunkPos.x, c.chunkPos.y, c.sectionY)] = moved;
+        movedInstances += moved.count;
+        ++movedSlots;
+    }
+
+    if (m_compactCursor >= m_compactQueue.size()) {
+        m_arena.endCompaction();
+        m_compactQueue.clear();
+        m_compactCursor = 0;
+    }
+    if (movedSlots > 0) {
+        m_drawListDirty = true;  // slot offset 变了 → draw list 的 baseInstance 需重建
+        Profiler::addCounter("arena.compactSlots", movedSlots);
+        Profiler::addCounter("arena.compactKB", (int64_t)movedInstances * sizeof(InstanceData) / 1024);
+    }
+}
 
+void ChunkManager::uploadSection(int chunkX, int chunkZ, int sectionY, Section& section) {
     SectionKey key = makeSectionKey(chunkX, chunkZ, sectionY);
     const auto& data = section.getInstanceData();
     const auto& dirtyIdx = section.getDirtyIndices();
@@ -873,13 +1070,11 @@ void ChunkManager::uploadSection(int chunkX, int chunkZ, int sectionY,
     }
 
     section.clearDirty();
-    --uploadBudget;
 }
 
 void ChunkManager::rebuildDrawCommands() {
     PROFILE_SCOPE("rebuildDrawCommands");
 
-    int uploadBudget = m_maxUploadsPerFrame;
     int uploadedCount = 0;
 
     {
@@ -888,12 +1083,23 @@ void ChunkManager::rebuildDrawCommands() {
         // 用 chunk 的脏掩码（getDirtySectionMask）跳过整块干净 chunk，
         // 稳态零脏时本 pass 每个 chunk 只做一次位运算判 0，整体接近 0 开销。
         // 非 active 的脏 section 不会被绘制，dirty 标记+掩码位都保留，待 chunk 进入
+        // 有脏 section 的 chunk 先按到相机的距离排序，预算不够时近处先上传。
+        m_uploadCandidates.clear();
         for (Chunk* chunk : m_activeChunks) {
-            uint32_t dirtyMask = chunk->getDirtySectionMask();
-            if (dirtyMask == 0) continue;          // 整块干净 → 一次位运算跳过
+            if (chunk->getDirtySectionMask() == 0) continue;  // 整块干净 → 一次位运算跳过
             if (!chunk->isMeshReady()) continue;
+            glm::ivec2 d = chunk->getPosition() - m_currentCenterChunk;
+            m_uploadCandidates.emplace_back(d.x * d.x + d.y * d.y, chunk);
+        }
+        std::sort(m_uploadCandidates.begin(), m_uploadCandidates.end(),
+            [](const std::pair<int, Chunk*>& a, const std::pair<int, Chunk*>& b) { return a.first < b.first; });
+
+        m_integrationBudget.beginStage(IntegrationBudget::STAGE_UPLOAD);
+        for (const auto& cand : m_uploadCandidates) {
+            Chunk* chunk = cand.second;
+            uint32_t dirtyMask = chunk->getDirtySectionMask();
             glm::ivec2 cp = chunk->getPosition();
-            while (dirtyMask) {
+            while (dirtyMask && m_integrationBudget.admit()) {
                 int sy = lowestBitIndex(dirtyMask);
                 dirtyMask &= dirtyMask - 1u;
                 Section& s = chunk->getSection(sy);
@@ -901,18 +1107,28 @@ void ChunkManager::rebuildDrawCommands() {
                     chunk->clearSectionDirtyBit(sy);
                     continue;
                 }
-                int before = uploadBudget;
-                uploadSection(cp.x, cp.y, sy, s, uploadBudget);
-                if (before != uploadBudget) {
-                    ++uploadedCount;
-                    chunk->clearSectionDirtyBit(sy);  // 上传成功 → 清掩码位
-                }
-                if (uploadBudget <= 0) break;
+                IntegrationBudget::Item item(m_integrationBudget);
+                uploadSection(cp.x, cp.y, sy, s);
+                ++uploadedCount;
+                chunk->clearSectionDirtyBit(sy);    // 上传成功 → 清掩码位
             }
-            if (uploadBudget <= 0) break;
+            if (!m_integrationBudget.admit()) break;
         }
+        m_integrationBudget.endStage();
+
+        // 本帧所有 section 的 staging 数据一次性拷进 arena VBO（必须在绘制之前）
+        m_arena.flushUploads();
     }
+    compactArenaStep();
     Profiler::addCounter("rdc.uploadCount", uploadedCount);
+    {
+        ChunkArena::UploadStats us = m_arena.takeUploadStats();
+        if (us.bytes > 0) {
+            Profiler::addCounter("arena.uploadKB", (int64_t)(us.bytes / 1024));
+            Profiler::addCounter("arena.copyCmds", us.copies);
+        }
+        if (us.ringStalls > 0) Profiler::addCounter("arena.ringStalls", us.ringStalls);
+    }
 
     // 有 section 上传 → 可见 slot 的 count/offset 可能变了，draw list 需重建。
     if (uploadedCount > 0) m_drawListDirty = true;
@@ -1223,6 +1439,12 @@ bool ChunkManager::applyLocalSetBlock(const glm::ivec3& worldPos, BlockState sta
     );
     if (localPos.y < 0 || localPos.y >= Chunk::HEIGHT) return false;
 
+    applyLocalSetBlockIn(chunk, worldPos, localPos, state);
+    return true;
+}
+
+void ChunkManager::applyLocalSetBlockIn(Chunk* chunk, const glm::ivec3& worldPos,
+                                        const glm::ivec3& localPos, BlockState state) {
     // 读取旧方块状态（用于光源变动检测）
     BlockState oldState = chunk->getBlock(localPos.x, localPos.y, localPos.z);
 
@@ -1260,8 +1482,6 @@ bool ChunkManager::applyLocalSetBlock(const glm::ivec3& worldPos, BlockState sta
             m_onBlockChanged(worldPos, oldState, state);
         }
     }
-
-    return true;
 }
 
 BlockState ChunkManager::getBlockAt(const glm::ivec3& worldPos) {
@@ -1283,7 +1503,7 @@ BlockState ChunkManager::getBlockAt(const glm::ivec3& worldPos) {
     if (itBR != m_blockReady.end()) {
         const auto& box = itBR->second.boxes[sy];
         if (!box) return BlockState{};
-        return box->blocks[(ly * Chunk::DEPTH + lz) * Chunk::WIDTH + lx];
+        return box->get((ly * Chunk::DEPTH + lz) * Chunk::WIDTH + lx);
     }
     auto itLoaded = m_loadedChunks.find(key);
     if (itLoaded != m_loadedChunks.end()) {
@@ -1316,9 +1536,16 @@ bool ChunkManager::applyBlockChange(const glm::ivec3& worldPos, BlockState state
         int ly = worldPos.y % Section::HEIGHT;
         auto& box = itBR->second.boxes[sy];
         if (!box) return false;
+        const int idx = (ly * Chunk::DEPTH + lz) * Chunk::WIDTH + lx;
+        if (box->isShared()) {
+            if (box->get(idx) == state) return true;
+            // 写时复制：entry 换成私有 box。若该 chunk 的 Task 2 正在跑，它拿的还是哨兵，
+            // loadMeshResult 会发现两边 box 不一致并把改动补回 loaded chunk。
+            box = box->cloneMutable();
+        }
         {
             std::unique_lock<std::shared_mutex> lk(box->mutex);
-            box->blocks[(ly * Chunk::DEPTH + lz) * Chunk::WIDTH + lx] = state;
+            box->set(idx, state);
         }
         // 仅服务端需要持久化；客户端 m_saveManager 为空，记了也不会落盘。
         if (m_saveManager) m_blockReadyDirty.insert(key);
@@ -1329,6 +1556,84 @@ bool ChunkManager::applyBlockChange(const glm::ivec3& worldPos, BlockState state
     return false;
 }
 
+int ChunkManager::applyBlockChangeBatch(const glm::ivec2& chunkPos, int sectionY,
+                                        const uint16_t* cells, const BlockState* states, int count) {
+    if (sectionY < 0 || sectionY >= Chunk::SECTION_COUNT || count <= 0) return 0;
+    ChunkKey key = chunkPosToKey(chunkPos);
+    const int baseX = chunkPos.x * Chunk::WIDTH;
+    const int baseY = sectionY * Section::HEIGHT;
+    const int baseZ = chunkPos.y * Chunk::DEPTH;
+
+    // 1. LOADED：逐格走本地应用路径。改面只动脏下标 + 脏掩码，光照变动进 m_pendingLightChanges，
+    //    两者都在本帧稍后（upload pass / updateLighting）统一处理，不随条数放大。
+    auto itLoaded = m_loadedChunks.find(key);
+    if (itLoaded != m_loadedChunks.end()) {
+        Chunk* chunk = itLoaded->second.get();
+        for (int i = 0; i < count; ++i) {
+            const int cell = cells[i] & 0xFFF;
+            const int lx = cell & 15, lz = (cell >> 4) & 15, ly = cell >> 8;
+            applyLocalSetBlockIn(chunk, glm::ivec3(baseX + lx, baseY + ly, baseZ + lz),
+                glm::ivec3(lx, baseY + ly, lz), states[i]);
+        }
+        return count;
+    }
+
+    // 2. BLOCK_READY：整批只做一次写时复制 + 一次加写锁
+    auto itBR = m_blockReady.find(key);
+    if (itBR != m_blockReady.end()) {
+        auto& box = itBR->second.boxes[sectionY];
+        if (!box) return 0;
+        if (box->isShared()) box = box->cloneMutable();  // 见 applyBlockChange 的写时复制说明
+        {
+            std::unique_lock<std::shared_mutex> lk(box->mutex);
+            for (int i = 0; i < count; ++i) box->set(cells[i] & 0xFFF, states[i]);
+        }
+        if (m_saveManager) m_blockReadyDirty.insert(key);
+        return count;
+    }
+    return 0;
+}
+
+int ChunkManager::applySectionSnapshot(const glm::ivec2& chunkPos, int sectionY, const BlockState* states) {
+    if (sectionY < 0 || sectionY >= Chunk::SECTION_COUNT) return 0;
+    ChunkKey key = chunkPosToKey(chunkPos);
+    constexpr int VOL = Section::VOLUME;
+
+    // BLOCK_READY：没有 mesh 要维护，整段 assign
+    auto itBR = m_blockReady.find(key);
+    if (itBR != m_blockReady.end()) {
+        auto& box = itBR->second.boxes[sectionY];
+        if (!box) return 0;
+        if (box->isShared()) box = box->cloneMutable();
+        {
+            std::unique_lock<std::shared_mutex> lk(box->mutex);
+            box->assign(states);
+        }
+        if (m_saveManager) m_blockReadyDirty.insert(key);
+        return VOL;
+    }
+
+    // LOADED：与本地逐格比较，只有不同的格子走增量改面
+    auto itLoaded = m_loadedChunks.find(key);
+    if (itLoaded == m_loadedChunks.end()) return 0;
+    auto box = itLoaded->second->getSectionBox(sectionY);
+    if (!box) return 0;
+    std::vector<BlockState> local(VOL);
+    {
+        auto lk = box->lockShared();
+        box->copyTo(local.data());
+    }
+    std::vector<uint16_t> cells;
+    std::vector<BlockState> changed;
+    for (int i = 0; i < VOL; ++i) {
+        if (local[i] == states[i]) continue;
+        cells.push_back((uint16_t)i);
+        changed.push_back(states[i]);
+    }
+    if (cells.empty()) return 0;
+    return applyBlockChangeBatch(chunkPos, sectionY, cells.data(), changed.data(), (int)cells.size());
+}
+
 // ============================================================================
 // 存档
 // ============================================================================
@@ -1342,27 +1647,12 @@ void ChunkManager::setSaveManager(ChunkSaveManager* sm) {
 void ChunkManager::saveChunkToDisk(Chunk* chunk) {
     if (!m_saveManager || !chunk) return;
 
-    constexpr int VOL = ChunkConstants::CHUNK_VOLUME;
-    constexpr int W = Chunk::WIDTH;
-    constexpr int D = Chunk::DEPTH;
-
-    auto buf = std::make_unique<BlockState[]>(VOL);
-    BlockState* dst = buf.get();
+    // 只拷 box 指针，解码 + 编码 + 写盘交给存档写线程（见 ChunkSaveManager::saveChunkAsync）
+    ChunkBoxes boxes;
     for (int sy = 0; sy < Chunk::SECTION_COUNT; ++sy) {
-        const Section& sec = chunk->getSection(sy);
-        const BlockState* src = sec.stateData();
-        int baseY = sy * Section::HEIGHT;
-        for (int y = 0; y < Section::HEIGHT; ++y) {
-            for (int z = 0; z < D; ++z) {
-                for (int x = 0; x < W; ++x) {
-                    dst[(baseY + y) * D * W + z * W + x] =
-                        src[(y * Section::DEPTH + z) * Section::WIDTH + x];
-                }
-            }
-        }
+        boxes[sy] = chunk->getSectionBox(sy);
     }
-
-    m_saveManager->saveChunk(chunk->getPosition(), dst);
+    m_saveManager->saveChunkAsync(chunk->getPosition(), boxes);
     chunk->clearSaveDirty();
 }
 
@@ -1382,35 +1672,10 @@ void ChunkManager::doAutoSave() {
 
 void ChunkManager::saveBlockReadyChunkToDisk(ChunkKey key, const ChunkBoxes& boxes) {
     if (!m_saveManager) return;
-    constexpr int VOL = ChunkConstants::CHUNK_VOLUME;
-    constexpr int W = Chunk::WIDTH;
-    constexpr int D = Chunk::DEPTH;
-    auto buf = std::make_unique<BlockState[]>(VOL);
-    BlockState* dst = buf.get();
-
-    for (int sy = 0; sy < Chunk::SECTION_COUNT; ++sy) {
-        int baseY = sy * Section::HEIGHT;
-        const auto& box = boxes[sy];
-        if (!box) {
-            // 该 section 无数据：填空气
-            for (int y = 0; y < Section::HEIGHT; ++y)
-                for (int z = 0; z < D; ++z)
-                    for (int x = 0; x < W; ++x)
-                        dst[((baseY + y) * D + z) * W + x] = BlockState{};
-            continue;
-        }
-        std::shared_lock<std::shared_mutex> lk(box->mutex);
-        const BlockState* src = box->blocks.data();
-        for (int y = 0; y < Section::HEIGHT; ++y)
-            for (int z = 0; z < D; ++z)
-                for (int x = 0; x < W; ++x)
-                    dst[((baseY + y) * D + z) * W + x] =
-                        src[(y * D + z) * W + x];
-    }
-
+    // nullptr box 由写线程按全空气处理
     int32_t cx = static_cast<int32_t>(key >> 32);
     int32_t cz = static_cast<int32_t>(key & 0xFFFFFFFFLL);
-    m_saveManager->saveChunk(glm::ivec2(cx, cz), dst);
+    m_saveManager->saveChunkAsync(glm::ivec2(cx, cz), boxes);
 }
 
 void ChunkManager::saveDirtyBlockReadyChunks() {
@@ -1506,14 +1771,17 @@ void ChunkManager::drainLightResults() {
             for (auto& r : results) {
                 if (r) m_pendingLightResults.push_back(std::move(r));
             }
+            m_pendingResortMask |= 0x4;
         }
     }
 
-    if (m_pendingLightResults.empty()) return;
+    // ── 按时间预算逐条消费（分摊多 worker 同时完成 Task 3 的尖峰），近处优先 ──
+    m_integrationBudget.beginStage(IntegrationBudget::STAGE_LIGHT);
+    sortPendingByDistance(m_pendingLightResults, 0x4);
 
-    // ── 按预算逐条消费（分摊多 worker 同时完成 Task 3 的尖峰）──
-    int budget = MAX_LIGHT_INTEGRATE_PER_FRAME;
-    while (budget > 0 && !m_pendingLightResults.empty()) {
+    bool wroteAny = false;
+    while (!m_pendingLightResults.empty() && m_integrationBudget.admit()) {
+        IntegrationBudget::Item item(m_integrationBudget);
         auto r = std::move(m_pendingLightResults.front());
         m_pendingLightResults.pop_front();
 
@@ -1521,20 +1789,27 @@ void ChunkManager::drainLightResults() {
         m_lightInFlight.erase(key);
 
         auto it = m_loadedChunks.find(key);
-        if (it == m_loadedChunks.end()) { --budget; continue; }  // chunk 已卸载
+        if (it == m_loadedChunks.end()) { item.discard(); continue; }  // chunk 已卸载
 
         Chunk* chunk = it->second.get();
 
-        // 写入光照缓存
+        // 写入光照缓存。Task 3 是中心 chunk 的整块重算：nullptr = 该 section 全暗，
+        // 必须清掉之前留下的光照（例如光源被挖掉后重新入队 Task 3），否则旧光照会一直显示
         for (int sy = 0; sy < CHUNK_SECTION_COUNT; ++sy) {
+            SectionKey secKey = makeSectionKey(r->pos.x, r->pos.y, sy);
             if (r->sectionLightData[sy]) {
-                SectionKey secKey = makeSectionKey(r->pos.x, r->pos.y, sy);
                 // try_emplace 避免 operator[] 的额外默认构造+查找
                 SectionLightCache* cache =
                     &m_lightCaches.try_emplace(secKey).first->second;
                 cache->writeRawData(r->sectionLightData[sy]->data());
                 cache->setHasLight(true);
                 m_dirtyLightSections.insert(secKey);
+            } else {
+                auto cit = m_lightCaches.find(secKey);
+                if (cit != m_lightCaches.end()) {
+                    cit->second.clear();
+                    m_dirtyLightSections.insert(secKey);
+                }
             }
             // 设置 per-section 光源列表（供增量更新 sourceQuery 使用）
             if (r->sectionLightSources[sy] && !r->sectionLightSources[sy]->empty()) {
@@ -1543,11 +1818,13 @@ void ChunkManager::drainLightResults() {
         }
 
         chunk->markLightBfsDone();
-        --budget;
+        m_chunkLightVersion[key] = ++m_lightVersionClock;  // 在途的增量重光照据此判定过期
+        wroteAny = true;
     }
+    m_integrationBudget.endStage();
 
     // Task 3 结果可能创建了新的光照缓存条目，section 查找表需要重建。
-    if (budget < MAX_LIGHT_INTEGRATE_PER_FRAME) m_lightSectionMapDirty = true;
+    if (wroteAny) m_lightSectionMapDirty = true;
 }
 
 void ChunkManager::unloadDistantChunks() {
@@ -1631,6 +1908,9 @@ void ChunkManager::unloadDistantChunks() {
 void ChunkManager::saveAllDirtyChunks() {
     if (!m_saveManager) return;
     doAutoSave();
+    // 屏障：退出前确保全部写入 region
+    if (!m_saveManager->flush())
+        std::cerr << "[Save] " << m_saveManager->failedSaveCount() << " chunk(s) failed to save\n";
 }
 
 // ── 光源传播 ──────────────────────────────────────────────────────
@@ -1792,159 +2072,11 @@ void ChunkManager::notifyLightChange(const glm::ivec3& worldPos,
 }
 
 void ChunkManager::updateLighting() {
-    // ── 增量光照传播（主线程，仅处理方块变动引发的局部重传播）────
-    // 统一策略：对于遮挡/去遮挡，清空受影响区域 + 找出所有邻近光源 + 重传播。
-    // 不再使用估算方法（propagateDeocclusion 的虚拟光源 / propagateOcclusion 的阴影半径估算），
-    // 因为从单一亮度值无法反推光源参数，估算在数学上就不可能是准确的。
-    // 重传播 BFS 体积 ≤ (2×kMaxLightRadius+1)³ ≈ 36K 格，主线程耗时 <2ms，完全可接受。
-    if (!m_pendingLightChanges.empty()) {
-        constexpr float kRadius = kMaxLightRadius;
-        int r = (int)std::ceil(kRadius);
-
-        // ── 稠密 chunk 网格：替代 unordered_map，BFS 内零哈希查找 ──
-        // 思路同 worker 端 ChunkGrid：将所有可能被 BFS 访问的 chunk 编入
-        // 一个稠密二维数组，blockQuery 用纯算术 (cx-minCX)+(cz-minCZ)*cw 索引。
-        int margin = (int)std::ceil(kMaxLightRadius / 16.0f) + 1;  // = 2
-        int minCX = INT_MAX, maxCX = INT_MIN, minCZ = INT_MAX, maxCZ = INT_MIN;
-        for (const auto& ch : m_pendingLightChanges) {
-            int cx = (int)std::floor((float)ch.pos.x / 16.0f);
-            int cz = (int)std::floor((float)ch.pos.z / 16.0f);
-            minCX = std::min(minCX, cx - margin);
-            maxCX = std::max(maxCX, cx + margin);
-            minCZ = std::min(minCZ, cz - margin);
-            maxCZ = std::max(maxCZ, cz + margin);
-        }
-        int cw = maxCX - minCX + 1;
-        int cd = maxCZ - minCZ + 1;
-        std::vector<ChunkBoxes> chunkStorage(cw * cd);        // 持有 shared_ptr 所有权
-        std::vector<const ChunkBoxes*> grid(cw * cd, nullptr); // 稠密索引数组
-
-        for (int cx = minCX; cx <= maxCX; ++cx) {
-            for (int cz = minCZ; cz <= maxCZ; ++cz) {
-                int gi = (cx - minCX) + (cz - minCZ) * cw;
-                ChunkBoxes boxes;
-                if (getChunkBoxes(glm::ivec2(cx, cz), boxes)) {
-                    chunkStorage[gi] = std::move(boxes);
-                    grid[gi] = &chunkStorage[gi];
-                }
-            }
-        }
-
-        // BFS 内方块查询：稠密数组索引（零哈希）+ last-chunk 缓存。
-        // BFS 6-邻域访问约 63%+ 的水平步在同一 chunk 内，缓存消除重复数组解引用。
-        auto blockQuery = [&](const glm::ivec3& pos) -> BlockState {
-            if (pos.y < 0 || pos.y >= Chunk::HEIGHT) {
-                return BlockState{ BLOCK_STONE, ORIENT_NONE };
-            }
-            int cx = (int)std::floor((float)pos.x / 16.0f);
-            int cz = (int)std::floor((float)pos.z / 16.0f);
-            if (cx < minCX || cx > maxCX || cz < minCZ || cz > maxCZ)
-                return BlockState{ BLOCK_STONE, ORIENT_NONE };
-
-            int gi = (cx - minCX) + (cz - minCZ) * cw;
-            const ChunkBoxes* cb = grid[gi];  // 纯算术索引，零哈希！
-            if (!cb) return BlockState{ BLOCK_STONE, ORIENT_NONE };
-
-            int lx = ((pos.x % 16) + 16) % 16;
-            int lz = ((pos.z % 16) + 16) % 16;
-            int sy = pos.y / 16;
-            if (pos.y < 0) sy--;
-            if (sy < 0 || sy >= CHUNK_SECTION_COUNT) {
-                return BlockState{ BLOCK_STONE, ORIENT_NONE };
-            }
-            int ly = pos.y - sy * 16;
-            const auto& box = (*cb)[sy];
-            if (!box) return BlockState{};
-            return box->blocks[(ly * 16 + lz) * 16 + lx];
-        };
-        
-        // 局部脏集合：BFS 过程中所有被访问（清空/写入）的 section 都会记录于此。
-        // BFS 结束后合并到 m_dirtyLightSections，实现精确脏跟踪。
-        std::unordered_set<uint64_t> bfsDirtySections;
-        auto cacheGetter = [this, &bfsDirtySections](uint64_t sectionKey) -> SectionLightCache* {
-            bfsDirtySections.insert(sectionKey);
-            auto [it, _] = m_lightCaches.try_emplace(sectionKey);
-            return &it->second;
-        };
-
-        // SourceQuery：仅用于删光源 / 增遮挡的回退路径
-        auto sourceQuery = [this](const glm::ivec3& min, const glm::ivec3& max) -> std::vector<glm::ivec3> {
-            std::vector<glm::ivec3> result;
-            int cMinX = (int)std::floor((float)min.x / 16.0f);
-            int cMinZ = (int)std::floor((float)min.z / 16.0f);
-            int cMaxX = (int)std::floor((float)max.x / 16.0f);
-            int cMaxZ = (int)std::floor((float)max.z / 16.0f);
-            int sMinY = min.y / 16;
-            int sMaxY = max.y / 16;
-            for (int cx = cMinX; cx <= cMaxX; ++cx) {
-                for (int cz = cMinZ; cz <= cMaxZ; ++cz) {
-                    Chunk* chunk = getChunk(glm::ivec2(cx, cz));
-                    if (!chunk) continue;
-                    for (int sy = sMinY; sy <= sMaxY; ++sy) {
-                        if (sy < 0 || sy >= Chunk::SECTION_COUNT) continue;
-                        Section& sec = chunk->getSection(sy);
-                        auto& sources = sec.getLightSources();
-                        if (!sources || sources->empty()) continue;
-                        for (uint16_t packed : *sources) {
-                            glm::ivec3 wp = unpackLightWorld(packed, cx, cz);
-                            if (wp.x >= min.x && wp.x <= max.x &&
-                                wp.y >= min.y && wp.y <= max.y &&
-                                wp.z >= min.z && wp.z <= max.z)
-                                result.push_back(wp);
-                        }
-                    }
-                }
-            }
-            return result;
-        };
-        
-        
-        // ── 按 8×8×8 网格去重后，逐条按类型分派 ──
-        std::unordered_set<uint64_t> processed;
-        for (const auto& ch : m_pendingLightChanges) {
-            glm::ivec3 q(ch.pos.x / 8, ch.pos.y / 8, ch.pos.z / 8);
-            uint64_t key = (uint64_t)(uint32_t)q.x
-                         | ((uint64_t)(uint32_t)q.y << 22)
-                         | ((uint64_t)(uint32_t)q.z << 44);
-            if (processed.count(key)) continue;
-            processed.insert(key);
-
-            bool oldEmissive = isEmissive(ch.oldType);
-            bool newEmissive = isEmissive(ch.newType);
-            bool oldOpaque = LightPropagation::blocksLight(ch.oldType);
-            bool newOpaque = LightPropagation::blocksLight(ch.newType);
-
-            if (newEmissive && !oldEmissive) {
-                // 情况 A：增光源（如火把）—— 仅从新光源 max-clamp 叠加 BFS
-                LightPropagation::propagateSingle(ch.pos, blockQuery, cacheGetter);
-            }
-            else if (oldEmissive && !newEmissive) {
-                // 情况 B：删光源 —— 清空旧范围 + 重传播邻近光源
-                LightDef oldDef = getLightDefForBlock(ch.oldType);
-                LightPropagation::removeAndReLight(ch.pos, oldDef.radius,
-                                                    sourceQuery, blockQuery, cacheGetter);
-            }
-            else if (newOpaque && !oldOpaque) {
-                // 情况 C：增遮挡物 —— 清空区域 + 重传播邻近光源（精确重传播）
-                LightPropagation::propagateOcclusion(ch.pos,
-                                                      sourceQuery, blockQuery, cacheGetter);
-            }
-            else if (oldOpaque && !newOpaque) {
-                // 情况 D：删遮挡物（如破坏石头）—— 清空区域 + 重传播邻近光源（精确重传播）
-                LightPropagation::propagateDeocclusion(ch.pos,
-                    sourceQuery, blockQuery, cacheGetter);
-            }
-            // else: 纯透明→纯透明（如玻璃→空气），光照不变，跳过
-        }
-        m_pendingLightChanges.clear();
-
-        // 将 BFS 过程中所有被修改的 section 标记为脏
-        for (uint64_t sk : bfsDirtySections) m_dirtyLightSections.insert(sk);
-
-        // 增量光照传播可能创建了新的缓存条目或修改了现有条目，
-        // section 查找表需要重建以包含新条目的槽位映射。
-        m_lightSectionMapDirty = true;
-    }
+    // ── 增量光照传播（worker 执行，仅处理方块变动引发的局部重传播）────
+    // 重传播 BFS 体积 ≤ (2×kMaxLightRadius+1)³ ≈ 36K 格，连续挖掘 / 爆炸时一帧可能堆积多条，
+    // 放在主线程会直接顶高帧时间。这里只做快照与整段写回，BFS 本身交给 ChunkWorkerPool。
+    applyRelightResults();
+    if (!m_pendingLightChanges.empty()) dispatchRelight();
 
     // ── 上传脏光照缓存到 GPU ─────────────────────────────────────
     int R = m_renderRadius;
@@ -1959,6 +2091,153 @@ void ChunkManager::updateLighting() {
     uploadLightSSBOs(secMin, secMax);
 }
 
+void ChunkManager::dispatchRelight() {
+    // 每条变动的影响范围：所在 chunk ±margin（光源半径 16 → 清空区对齐到 section 后再外扩一层光照）
+    int margin = (int)std::ceil(kMaxLightRadius / 16.0f) + 1;  // = 2
+
+    struct Cluster {
+        int minCX, minCZ, maxCX, maxCZ;
+        int minY, maxY;
+        std::vector<PendingLightChange> changes;
+    };
+    std::vector<Cluster> clusters;
+    auto overlaps = [](int aMinX, int aMinZ, int aMaxX, int aMaxZ,
+                       int bMinX, int bMinZ, int bMaxX, int bMaxZ) {
+        return aMinX <= bMaxX && bMinX <= aMaxX && aMinZ <= bMaxZ && bMinZ <= aMaxZ;
+    };
+
+    // ── 1. 按影响矩形聚类（相交即合并为包围矩形），保持变动原有顺序 ──
+    for (const auto& ch : m_pendingLightChanges) {
+        int cx = (int)std::floor((float)ch.pos.x / 16.0f);
+        int cz = (int)std::floor((float)ch.pos.z / 16.0f);
+        Cluster c{ cx - margin, cz - margin, cx + margin, cz + margin, ch.pos.y, ch.pos.y, { ch } };
+        for (size_t i = 0; i < clusters.size();) {
+            Cluster& o = clusters[i];
+            if (overlaps(c.minCX, c.minCZ, c.maxCX, c.maxCZ, o.minCX, o.minCZ, o.maxCX, o.maxCZ)) {
+                c.minCX = std::min(c.minCX, o.minCX); c.maxCX = std::max(c.maxCX, o.maxCX);
+                c.minCZ = std::min(c.minCZ, o.minCZ); c.maxCZ = std::max(c.maxCZ, o.maxCZ);
+                c.minY = std::min(c.minY, o.minY);    c.maxY = std::max(c.maxY, o.maxY);
+                o.changes.insert(o.changes.end(), c.changes.begin(), c.changes.end());
+                c.changes = std::move(o.changes);
+                clusters.erase(clusters.begin() + i);
+                i = 0;  // 包围矩形变大，重新检查
+                continue;
+            }
+            ++i;
+        }
+        clusters.push_back(std::move(c));
+    }
+    m_pendingLightChanges.clear();
+
+    for (auto& c : clusters) {
+        // ── 2. 与在途任务相交：留到该任务写回后再投（基础光照要包含它的结果）──
+        bool blocked = false;
+        for (const auto& kv : m_relightInFlight) {
+            const RelightJob& j = kv.second;
+            if (overlaps(c.minCX, c.minCZ, c.maxCX, c.maxCZ, j.minCX, j.minCZ, j.maxCX, j.maxCZ)) {
+                blocked = true;
+                break;
+            }
+        }
+        if (blocked) {
+            m_pendingLightChanges.insert(m_pendingLightChanges.end(), c.changes.begin(), c.changes.end());
+            continue;
+        }
+
+        // ── 3. 快照：BlockBox（拷指针）、光源列表（深拷贝）、有光 section 的当前光照 ──
+        auto input = std::make_unique<RelightInput>();
+        RelightJob job;
+        job.minCX = c.minCX; job.minCZ = c.minCZ;
+        job.maxCX = c.maxCX; job.maxCZ = c.maxCZ;
+        input->jobId = m_nextRelightId++;
+        input->minCX = c.minCX;
+        input->minCZ = c.minCZ;
+        input->cw = c.maxCX - c.minCX + 1;
+        input->cd = c.maxCZ - c.minCZ + 1;
+        input->boxes.resize((size_t)input->cw * input->cd);
+        input->present.assign((size_t)input->cw * input->cd, 0);
+        input->sources.resize((size_t)input->cw * input->cd);
+        // 竖直方向 BFS 同样只能触及变动所在 section ±margin
+        int syMin = std::max(c.minY / 16 - margin, 0);
+        int syMax = std::min(c.maxY / 16 + margin, Chunk::SECTION_COUNT - 1);
+
+        for (int cz = c.minCZ; cz <= c.maxCZ; ++cz) {
+            for (int cx = c.minCX; cx <= c.maxCX; ++cx) {
+                glm::ivec2 cp(cx, cz);
+                int gi = (cx - c.minCX) + (cz - c.minCZ) * input->cw;
+                if (!getChunkBoxes(cp, input->boxes[gi])) continue;
+                input->present[gi] = 1;
+
+                ChunkKey key = chunkPosToKey(cp);
+                auto vit = m_chunkLightVersion.find(key);
+                job.versions[key] = (vit != m_chunkLightVersion.end()) ? vit->second : 0;
+
+                if (Chunk* chunk = getChunk(cp)) {
+                    for (int sy = 0; sy < Chunk::SECTION_COUNT; ++sy) {
+                        const auto& src = chunk->getSection(sy).getLightSources();
+                        if (src && !src->empty())
+                            input->sources[gi][sy] = std::make_shared<std::vector<uint16_t>>(*src);
+                    }
+                }
+                for (int sy = syMin; sy <= syMax; ++sy) {
+                    SectionKey secKey = makeSectionKey(cx, cz, sy);
+                    auto lit = m_lightCaches.find(secKey);
+                    if (lit == m_lightCaches.end() || !lit->second.hasAnyLight()) continue;
+                    auto data = std::make_shared<SectionLightData>();
+                    std::memcpy(data->data(), lit->second.rawData(), SectionLightCache::BYTES);
+                    input->baseLight.emplace(secKey, std::move(data));
+                }
+            }
+        }
+
+        input->changes = c.changes;
+        job.changes = std::move(c.changes);
+        m_relightInFlight.emplace(input->jobId, std::move(job));
+        m_workerPool.submitRelight(std::move(input));
+        Profiler::addCounter("light.relightJobs", 1);
+    }
+}
+
+void ChunkManager::applyRelightResults() {
+    auto results = m_workerPool.drainRelightResults();
+    for (auto& r : results) {
+        auto jit = m_relightInFlight.find(r->jobId);
+        if (jit == m_relightInFlight.end()) continue;
+        RelightJob job = std::move(jit->second);
+        m_relightInFlight.erase(jit);
+
+        // 快照后有 chunk 被 Task 3 整块重写了光照 → 本结果基于过期光照，整批作废并重新排队
+        bool stale = false;
+        for (const auto& kv : job.versions) {
+            auto vit = m_chunkLightVersion.find(kv.first);
+            uint32_t cur = (vit != m_chunkLightVersion.end()) ? vit->second : 0;
+            if (cur != kv.second) { stale = true; break; }
+        }
+        if (stale) {
+            m_pendingLightChanges.insert(m_pendingLightChanges.end(), job.changes.begin(), job.changes.end());
+            Profiler::addCounter("light.relightStale", 1);
+            continue;
+        }
+
+        for (auto& sec : r->sections) {
+            // 快照后已卸载的 chunk（unregisterChunkLightSources 已从 versions 移除）直接跳过
+            if (!job.versions.count(chunkPosToKey(sec.chunk))) continue;
+            SectionKey secKey = makeSectionKey(sec.chunk.x, sec.chunk.y, sec.sy);
+            if (sec.data) {
+                SectionLightCache& cache = m_lightCaches.try_emplace(secKey).first->second;
+                cache.writeRawData(sec.data->data());
+                cache.setHasLight(true);
+            } else {
+                auto it = m_lightCaches.find(secKey);
+                if (it == m_lightCaches.end()) continue;
+                it->second.clear();
+            }
+            m_dirtyLightSections.insert(secKey);
+            m_lightSectionMapDirty = true;
+        }
+    }
+}
+
 // ── 区块光照：扫描 chunk 内所有发光方块并触发光照传播 ──────────
 
 //void ChunkManager::registerChunkLightSources(Chunk* chunk) {
@@ -1978,6 +2257,9 @@ void ChunkManager::unregisterChunkLightSources(const glm::ivec2& chunkPos) {
     // 清理该 chunk 所有 section 的光照缓存和 SSBO 槽位。
     // 光源列表随 Section 生命周期自动释放（shared_ptr），无需单独清理。
     // 释放的槽位回收到 free list，供后续新 section 复用，避免 SSBO 无限增长。
+    ChunkKey chunkKey = chunkPosToKey(chunkPos);
+    m_chunkLightVersion.erase(chunkKey);
+    for (auto& kv : m_relightInFlight) kv.second.versions.erase(chunkKey);  // 结果回来时跳过该 chunk
     for (int sy = 0; sy < Chunk::SECTION_COUNT; ++sy) {
         uint64_t key = makeSectionKey(cx, cz, sy);
         m_lightCaches.erase(key);
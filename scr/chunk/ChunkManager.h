@@ -10,15 +10,16 @@
 #include "BlockType.h"
 #include "ChunkArena.h"
 #include "ChunkWorkerPool.h"
+#include "IntegrationBudget.h"
 #include "../Camera.h"
 #include "../Shader.h"
 #include "../light/LightSource.h"
 #include "../light/LightCache.h"
 #include "../light/LightPropagation.h"
+#include "SectionKey.h"
 #include <mutex>
 
 using ChunkKey = int64_t;
-using SectionKey = uint64_t; // (chunkX, chunkZ, sectionY) packed
 
 // 与 OpenGL 4.3 的 DrawElementsIndirectCommand 二进制布局一致
 struct DrawElementsIndirectCommand {
@@ -41,12 +42,8 @@ struct BlockReadyEntry {
     uint8_t neighborBlockReady = 0; // 4-bit: bit[i]=1 表示 m_neighbors[i] 方向已完成 Task 1
 };
 
-// 增量光照变动记录：记录位置与变动前后的方块类型，用于区分四种情况
-struct PendingLightChange {
-    glm::ivec3 pos;
-    BlockType oldType;
-    BlockType newType;
-};
+// 增量光照变动记录（定义见 LightPropagation.h，worker 端重光照同样使用）
+using PendingLightChange = LightChange;
 
 class ChunkManager {
 public:
@@ -71,9 +68,10 @@ public:
     Chunk* getChunk(const int x, const int z);
     // 查找 loaded 中的区块（有完整 mesh）
     Chunk* getChunkAnyState(const glm::ivec2& chunkPos);
-    // 取某 chunk 的 16 个 section BlockBox（数据 + 锁），填入 out。BLOCK_READY 或 LOADED 均可。
+    // 取某 chunk 的 16 个 section BlockBox（数据 + 锁），填入 out。BLOCK_READY 或 LOADED 均可
+    // （includeBlockReady = false 时只认 LOADED）。
     // 找到返回 true；out 持有 shared_ptr 保证使用期间 box 不被释放。
-    bool getChunkBoxes(const glm::ivec2& chunkPos, ChunkBoxes& out);
+    bool getChunkBoxes(const glm::ivec2& chunkPos, ChunkBoxes& out, bool includeBlockReady = true);
     // 仅判断某 chunk 是否有方块数据（BLOCK_READY 或 LOADED）。
     bool hasBlockData(const glm::ivec2& chunkPos) const;
     const std::vector<Chunk*>& getActiveChunks() const { return m_activeChunks; }
@@ -141,13 +139,24 @@ public:
     // 返回 true 表示已应用（loaded 或 block-ready 命中）。
     bool applyBlockChange(const glm::ivec3& worldPos, BlockState state);
 
+    // 批量版（BLOCK_CHANGE_BATCH 落地）：同一 section 的一组改动，cells 是 section 内
+    // 12 位下标 (ly*16+lz)*16+lx。chunk 只查一次；BLOCK_READY 时整批一次写时复制 + 一次写锁。
+    // 返回应用的条数（chunk 不存在为 0）。
+    int applyBlockChangeBatch(const glm::ivec2& chunkPos, int sectionY,
+                              const uint16_t* cells, const BlockState* states, int count);
+    // 整 section 快照（BLOCK_CHANGE_BATCH 的整段回退）：BLOCK_READY 直接整段替换，
+    // LOADED 与本地比较后只把不同的格子交给 applyBlockChangeBatch。返回变化的格子数。
+    int applySectionSnapshot(const glm::ivec2& chunkPos, int sectionY, const BlockState* states);
+
     // 用户发起方块修改的重定向 sink。设置后，setBlock() 不再本地生效，而是转交 sink
     // （网络会话：客户端发请求 / 服务端应用+广播）。单机模式不设置，setBlock 直接本地应用。
     void setBlockChangeSink(std::function<void(const glm::ivec3&, BlockState)> fn) {
         m_blockChangeSink = std::move(fn);
     }
 
-    static SectionKey makeSectionKey(int chunkX, int chunkZ, int sectionY);
+    static SectionKey makeSectionKey(int chunkX, int chunkZ, int sectionY) {
+        return packSectionKey(chunkX, chunkZ, sectionY);
+    }
 
     uint32_t getVisibilityGeneration() const { return m_visGeneration; }
 
@@ -238,6 +247,18 @@ private:
     ChunkArena m_arena;
     std::unordered_map<SectionKey, ChunkArena::Slot> m_sectionSlots;
 
+    // arena 碎片整理队列：整理开始时对所有活 slot 拍快照，按 offset 从高到低排，逐帧消费。
+    // 消费时按 (chunkPos, sectionY) 回查 section，offset 对不上（期间被重传/释放）就跳过。
+    struct CompactCandidate {
+        uint32_t offset;
+        glm::ivec2 chunkPos;
+        int sectionY;
+    };
+    std::vector<CompactCandidate> m_compactQueue;
+    size_t m_compactCursor = 0;
+    // 每帧最多搬运的实例数（64K * 8B = 512KB GPU 拷贝）
+    static constexpr uint32_t COMPACT_INSTANCES_PER_FRAME = 64 * 1024;
+
     // 渲染指令
     std::vector<DrawElementsIndirectCommand> m_drawCommands;
     GLuint m_indirectBuffer = 0;
@@ -281,21 +302,26 @@ private:
     // 让 renderRadius 边缘的 chunk 有外侧邻居提供方块数据以缝 mesh 边界。编译期常量
     // （由 mesh 邻居需求决定，与内存预算无关）。
     static constexpr int DATA_MARGIN = 1;
+    // 预读外推：加载中心移动时，沿移动方向再往前多少 chunk 预读 region（见 prefetchAroundCenters）
+    static constexpr int PREFETCH_LEAD = 2;
 
     // 温存/落盘半径余量（曾名 UNLOAD_MARGIN_CHUNKS）：render + RETAIN_MARGIN 内的 chunk
     // 离开渲染半径后仍保留在内存（不渲染、不卸载、不落盘），超出才落盘 + 卸载。
     // 运行时从 RuntimeConfig.retainMarginChunks 读，按内存预算可调。见 m_retainMargin。
 
-    // 每帧最多处理多少个 Task 1 / Task 2 / Task 3 结果（分摊多 worker 同时完成的尖峰）
-    static constexpr int MAX_BLOCK_INTEGRATE_PER_FRAME = 8;
-    static constexpr int MAX_MESH_INTEGRATE_PER_FRAME = 4;
-    static constexpr int MAX_LIGHT_INTEGRATE_PER_FRAME = 2;
+    // 每帧主线程集成（Task 1 / Task 2 / Task 3 结果 + GPU 上传）的时间预算，分摊多 worker 同时完成的尖峰。
+    // 毫秒数每帧从 RuntimeConfig.integrationBudgetMs 读（支持热重载），见 IntegrationBudget。
+    IntegrationBudget m_integrationBudget;
+    // 待集成队列需要按到相机的距离重排：bit0 = Task 1，bit1 = Task 2，bit2 = Task 3。
+    // 新结果入队或相机跨 chunk 时置位，集成前重排后清位。
+    uint8_t m_pendingResortMask = 0;
+    // 上传 pass 的候选（到相机距离², chunk），按帧复用
+    std::vector<std::pair<int, Chunk*>> m_uploadCandidates;
 
     // 网络请求超时（秒），超时后允许重新请求
     static constexpr double INFLIGHT_TIMEOUT_SEC = 5.0;
 
     // 从 RuntimeConfig 读
-    int m_maxUploadsPerFrame = 8;
     int m_maxInflightRequests = 64;
     int m_autoSaveIntervalSec = 60;
     int m_retainMargin = 6;  // 温存/落盘半径余量（render + 此值），见 RETAIN 注释
@@ -342,6 +368,9 @@ private:
     std::function<void(const glm::ivec3&, BlockState, BlockState)> m_onBlockChanged;
     // setBlock 的真正本地实现（绕过 sink，供 sink 内部 / applyBlockChange 调用）
     bool applyLocalSetBlock(const glm::ivec3& worldPos, BlockState state);
+    // 已定位到 chunk 后的落地部分（改面 + 光源列表 + 光照变动 + 变动回调），批量路径复用
+    void applyLocalSetBlockIn(Chunk* chunk, const glm::ivec3& worldPos,
+                              const glm::ivec3& localPos, BlockState state);
 
     // 是否需要扫描缺失 chunk
     bool m_needChunkScan = true;
@@ -393,6 +422,25 @@ private:
 
     std::vector<PendingLightChange> m_pendingLightChanges; // 待处理的增量光照变动
 
+    // ── 增量重光照（worker 执行）─────────────────────────────────
+    // 每个在途任务覆盖一个 chunk 矩形；矩形互不重叠（与在途矩形相交的变动留到下帧再投），
+    // 因此同一 section 的光照同一时刻至多被一个任务改写，结果可整段替换。
+    struct RelightJob {
+        std::vector<PendingLightChange> changes;        // 结果作废时重新排队
+        std::unordered_map<ChunkKey, uint32_t> versions; // 快照时各 chunk 的光照版本（卸载即移除）
+        int minCX, minCZ, maxCX, maxCZ;
+    };
+    std::unordered_map<uint64_t, RelightJob> m_relightInFlight;
+    uint64_t m_nextRelightId = 1;
+    // chunk 光照版本：Task 3 整块写入光照时递增。重光照结果回来时版本不符 = 基础光照已被覆盖，作废重做
+    std::unordered_map<ChunkKey, uint32_t> m_chunkLightVersion;
+    uint32_t m_lightVersionClock = 0;
+
+    // 把 m_pendingLightChanges 按影响矩形分组，快照后投递给 worker
+    void dispatchRelight();
+    // 取回重光照结果，按 section 整段写回 m_lightCaches
+    void applyRelightResults();
+
     // 可见性缓存版本号
     uint32_t m_visGeneration = 1;
     glm::vec3 m_lastVisCameraPos{ 0.0f };
@@ -417,18 +465,33 @@ private:
 
     // 将 Task 2 结果装入 Chunk 并放入 m_loadedChunks
     void loadMeshResult(ChunkBuildResult& result);
+    // Task 2 期间被写时复制的 section：把私有 box 与哨兵的差异逐格重放到 loaded chunk（改面 + 光源列表）
+    void replayCowSections(Chunk* chunk, const ChunkBoxes& cowBoxes);
 
     void rebuildDrawCommands();
     void rebuildFullDrawList();     // 重建全量模板（无剔除，所有非空 section）
     void dispatchGpuCull();         // dispatch compute shader 改写 instanceCount
-    void uploadSection(int chunkX, int chunkZ, int sectionY, Section& section, int& uploadBudget);
+    void uploadSection(int chunkX, int chunkZ, int sectionY, Section& section);
+    // 待集成队列按到相机 chunk 的距离稳定重排（m_pendingResortMask 对应位未置位则跳过）
+    template <class Result>
+    void sortPendingByDistance(std::deque<std::unique_ptr<Result>>& queue, uint8_t bit);
     void releaseSectionSlot(SectionKey key);
+    // arena 增量碎片整理：每帧把最高地址的若干活 slot 搬进低地址空洞
+    void compactArenaStep();
     void syncIndirectBuffer();
     void syncSectionBaseSSBO();
 
     bool isWithinActiveRadius(const glm::ivec2& chunkPos,
         const glm::ivec2& centerChunk) const;
 
+    // 把当前加载中心（或本机相机中心）同步给 worker 调度器，用于优先级排序与取消；未变化时不重复推送。
+    void syncWorkerPriorities();
+    std::vector<LoadCenter> m_priorityCenters;  // 上次推给调度器的中心
+
+    // 加载中心变化时：把各中心（沿移动方向外推 PREFETCH_LEAD）加载方框内还缺的 chunk
+    // 交给存档预读线程，region 按顺序大段读进页缓存，Task 1 随后读盘不再逐 chunk 随机寻道。
+    void prefetchAroundCenters(const std::vector<LoadCenter>& prev, const std::vector<LoadCenter>& cur);
+
     // 数据相关：chunkPos 是否在任一加载中心的「各自半径 + margin」内。
     // m_loadCenters 为空时退化为只看 m_currentCenterChunk + m_renderRadius + margin。
     bool isDataRelevant(const glm::ivec2& chunkPos, int margin) const;
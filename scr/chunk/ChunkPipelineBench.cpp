@@ -0,0 +1,576 @@
+﻿#include "ChunkPipelineBench.h"
+#include "ChunkWorkerPool.h"
+#include "../generate/TerrainGenerator.h"
+#include "../light/LightBfs.h"
+#include "../net/NetSerializeWorker.h"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <new>
+#include <string>
+#include <vector>
+
+// ── 堆分配计数 ────────────────────────────────────────────────────────
+// 替换全局 operator new / delete，按线程累计分配次数与字节数。替换是整个 exe 范围的，
+// 但只在 t_countAllocs 置位（measure() 执行阶段期间）时才计数，平时只多一次线程局部布尔判断。
+// 线程局部计数不争用缓存行，基准只读调用线程自己的差值，worker / 网络线程互不干扰。
+// 普通 / 数组 / nothrow / 对齐各版本都显式替换，不依赖标准库默认实现是否互相转发。
+namespace {
+thread_local uint64_t t_allocCount = 0;
+thread_local uint64_t t_allocBytes = 0;
+thread_local bool t_countAllocs = false;
+
+void* countedAlloc(std::size_t size, std::size_t align) {
+    if (t_countAllocs) {
+        ++t_allocCount;
+        t_allocBytes += size;
+    }
+    if (size == 0) size = 1;
+    for (;;) {
+#ifdef _MSC_VER
+        void* p = align > alignof(std::max_align_t) ? _aligned_malloc(size, align) : std::malloc(size);
+#else
+        void* p = align > alignof(std::max_align_t)
+            ? std::aligned_alloc(align, (size + align - 1) / align * align) : std::malloc(size);
+#endif
+        if (p) return p;
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+
+void countedFree(void* p, std::size_t align) noexcept {
+#ifdef _MSC_VER
+    if (align > alignof(std::max_align_t)) { _aligned_free(p); return; }
+#endif
+    (void)align;
+    std::free(p);
+}
+
+void* countedAllocNoThrow(std::size_t size, std::size_t align) noexcept {
+    try { return countedAlloc(size, align); } catch (...) { return nullptr; }
+}
+
+constexpr std::size_t kDefaultAlign = alignof(std::max_align_t);
+} // namespace
+
+void* operator new(std::size_t size) { return countedAlloc(size, kDefaultAlign); }
+void* operator new[](std::size_t size) { return countedAlloc(size, kDefaultAlign); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return countedAllocNoThrow(size, kDefaultAlign); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return countedAllocNoThrow(size, kDefaultAlign); }
+void* operator new(std::size_t size, std::align_val_t al) { return countedAlloc(size, std::size_t(al)); }
+void* operator new[](std::size_t size, std::align_val_t al) { return countedAlloc(size, std::size_t(al)); }
+void* operator new(std::size_t size, std::align_val_t al, const std::nothrow_t&) noexcept { return countedAllocNoThrow(size, std::size_t(al)); }
+void* operator new[](std::size_t size, std::align_val_t al, const std::nothrow_t&) noexcept { return countedAllocNoThrow(size, std::size_t(al)); }
+
+void operator delete(void* p) noexcept { countedFree(p, kDefaultAlign); }
+void operator delete[](void* p) noexcept { countedFree(p, kDefaultAlign); }
+void operator delete(void* p, std::size_t) noexcept { countedFree(p, kDefaultAlign); }
+void operator delete[](void* p, std::size_t) noexcept { countedFree(p, kDefaultAlign); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { countedFree(p, kDefaultAlign); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { countedFree(p, kDefaultAlign); }
+void operator delete(void* p, std::align_val_t al) noexcept { countedFree(p, std::size_t(al)); }
+void operator delete[](void* p, std::align_val_t al) noexcept { countedFree(p, std::size_t(al)); }
+void operator delete(void* p, std::size_t, std::align_val_t al) noexcept { countedFree(p, std::size_t(al)); }
+void operator delete[](void* p, std::size_t, std::align_val_t al) noexcept { countedFree(p, std::size_t(al)); }
+void operator delete(void* p, std::align_val_t al, const std::nothrow_t&) noexcept { countedFree(p, std::size_t(al)); }
+void operator delete[](void* p, std::align_val_t al, const std::nothrow_t&) noexcept { countedFree(p, std::size_t(al)); }
+
+namespace {
+
+struct StageStats {
+    const char* name;
+    std::vector<double> ms;     // 每 chunk 耗时
+    uint64_t allocs = 0;
+    uint64_t bytes = 0;
+};
+
+// 计时 + 计分配执行一次 f()，结果记入 s
+template <class F>
+void measure(StageStats& s, F&& f) {
+    using Clock = std::chrono::steady_clock;
+    const uint64_t a0 = t_allocCount, b0 = t_allocBytes;
+    t_countAllocs = true;
+    auto t0 = Clock::now();
+    f();
+    auto t1 = Clock::now();
+    t_countAllocs = false;
+    s.ms.push_back(std::chrono::duration<double, std::milli>(t1 - t0).count());
+    s.allocs += t_allocCount - a0;
+    s.bytes += t_allocBytes - b0;
+}
+
+double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    size_t idx = static_cast<size_t>(p * sorted.size());
+    return sorted[std::min(idx, sorted.size() - 1)];
+}
+
+using ChunkMap = std::map<std::pair<int, int>, std::unique_ptr<BlockDataResult>>;
+
+const BlockDataResult* findChunk(const ChunkMap& chunks, int cx, int cz) {
+    auto it = chunks.find({ cx, cz });
+    return it != chunks.end() ? it->second.get() : nullptr;
+}
+
+// ── 光照 BFS 基准（--bench-light）──────────────────────────────────────
+
+constexpr int BW = ChunkConstants::CHUNK_WIDTH;   // 16
+constexpr int BD = ChunkConstants::CHUNK_DEPTH;   // 16
+constexpr int BH = ChunkConstants::CHUNK_HEIGHT;  // 256
+constexpr int BSEC_H = ChunkConstants::SECTION_HEIGHT; // 16
+constexpr int BSEC_COUNT = BH / BSEC_H;            // 16
+
+// BFS 区域边界：3×3 chunk = 48×256×48 格
+constexpr int REGION_W = BW * 3;   // 48
+constexpr int REGION_D = BD * 3;   // 48
+
+// 3×3 网格下标 → chunk 偏移（与 Task 3 相同：[4] 是 self，行按 z 递增）
+constexpr int gridX[9] = { -1, 0, +1, -1, 0, +1, -1, 0, +1 };
+constexpr int gridZ[9] = { -1, -1, -1, 0, 0, 0, +1, +1, +1 };
+constexpr int SELF_IDX = 4;
+
+// 光照基准的 3×3 区块视图：query 供旧版 BFS 逐格查方块，其余成员是 LightBfs 访问器
+// （与 Task 3 一致：仅中心 chunk 可写，输出按 section 惰性分配）。
+// 逐格免锁读 box——读的是基准自建、从不对外共享的 box。
+struct LightBenchGrid {
+    static constexpr int chunksX = 3;
+    static constexpr int chunksZ = 3;
+    int minCX = -1, minCZ = -1;
+    const ChunkBoxes* boxes[9] = {}; // nullptr 表示该 chunk 不存在
+    int originX = 0, originZ = 0;     // self chunk 的世界原点（min 坐标）
+    ChunkLightData* out = nullptr;    // 内核输出（中心 chunk）
+
+    bool hasChunk(int ci) const { return boxes[ci] != nullptr; }
+    const BlockBox* box(int ci, int sy) const { return (*boxes[ci])[sy].get(); }
+    uint32_t* lightSection(int ci, int sy) {
+        if (ci != SELF_IDX) return nullptr;
+        auto& sp = (*out)[sy];
+        if (!sp) {
+            sp = std::make_shared<SectionLightData>();
+            sp->fill(0u);
+        }
+        return sp->data();
+    }
+    void markLit(int, int) {}
+
+    // 查询 world 位置的方块。超出所有 chunk 范围返回 BLOCK_STONE（视为墙）。
+    BlockState query(int wx, int wy, int wz) const {
+        // 先判断是否在 self chunk 的 3×3 范围内
+        int relX = wx - originX;  // [-16, 31]
+        int relZ = wz - originZ;  // [-16, 31]
+        if (wy < 0 || wy >= BH) return BlockState{ BLOCK_STONE, ORIENT_NONE };
+        // 确定所属的 grid 索引
+        int gx = (relX + BW) / BW;  // 0, 1, or 2
+        int gz = (relZ + BD) / BD;  // 0, 1, or 2
+        if (gx < 0 || gx > 2 || gz < 0 || gz > 2) return BlockState{ BLOCK_STONE, ORIENT_NONE };
+        int gi = gz * 3 + gx;
+        const ChunkBoxes* cb = boxes[gi];
+        if (!cb) return BlockState{ BLOCK_STONE, ORIENT_NONE };
+        // 映射到该 chunk 的局部坐标
+        int lx = (relX + BW) % BW;
+        int lz = (relZ + BD) % BD;
+        int sy = wy / BSEC_H;
+        if (sy < 0 || sy >= BSEC_COUNT) return BlockState{ BLOCK_STONE, ORIENT_NONE };
+        int ly = wy - sy * BSEC_H;
+        const auto& box = (*cb)[sy];
+        if (!box) return BlockState{};
+        return box->get((ly * BD + lz) * BW + lx);
+    }
+};
+
+// 旧版 Task 3 BFS（浮点亮度 + 每源重新分配 visited），仅供光照基准对照吞吐与结果。
+// 返回出队格数。
+uint64_t legacyLightBfs(const LightBenchGrid& grid, const std::vector<glm::ivec3>& worldSources,
+                        ChunkLightData& sectionLightData) {
+    uint64_t processed = 0;
+    const int selfMinX = grid.originX;
+    const int selfMaxX = selfMinX + BW - 1;
+    const int selfMinZ = grid.originZ;
+    const int selfMaxZ = selfMinZ + BD - 1;
+
+    // ── 逐光源 BFS（每源小 visited 数组，分离传播门控与输出写入）──
+    // 设计要点：
+    //   - 每源独立 BFS。visited 按该源包围盒分配（≤31³≈30KB），远小于旧的
+    //     全局 48×256×48（576KB）。
+    //   - 传播门控（visited）与输出写入（writeLightMax）解耦：
+    //     - 中心 chunk 内：max-clamp 写入 + visited 推入队列
+    //     - 中心 chunk 外：visited 推入队列（允许 BFS 穿越邻居 chunk 格抵达中心）
+    //     这修复了「光源在邻居 chunk → BFS 第一步就断掉」的跨区块 bug。
+    //   - 逐分量 max（非 packed uint32 比较）保证多色光源正确混合。
+    static const glm::ivec3 bfsDirs[6] = {
+        {1,0,0}, {-1,0,0}, {0,1,0}, {0,-1,0}, {0,0,1}, {0,0,-1}
+    };
+
+    struct BfsEntry {
+        glm::ivec3 pos;
+        int        dist;
+        float      srcRadius;
+        glm::vec3  srcBrightness;
+    };
+
+    // 逐光源环形缓冲 + visited（thread_local，复用）
+    static thread_local std::vector<BfsEntry> s_ring;
+    s_ring.reserve(65536);
+    static thread_local std::vector<uint8_t> s_visited;
+
+    // 计算 world pos 是否在中心 chunk 范围内
+    auto inCenterChunk = [&](int wx, int wy, int wz) -> bool {
+        return wx >= selfMinX && wx <= selfMaxX &&
+               wz >= selfMinZ && wz <= selfMaxZ &&
+               wy >= 0 && wy < BH;
+    };
+
+    // 逐分量 max 写入（仅对中心 chunk 格有效）。
+    // dist: 到光源的等效曼哈顿距离（含透明方块衰减），编码进 alpha 通道。
+    auto writeLightMax = [&](int wx, int wy, int wz, const glm::vec3& light, int dist) -> bool {
+        if (!inCenterChunk(wx, wy, wz)) return false;
+        int lx = wx - selfMinX;
+        int lz = wz - selfMinZ;
+        int sy = wy / BSEC_H;
+        int ly = wy - sy * BSEC_H;
+        int cellIdx = (ly * BD + lz) * BW + lx;
+        auto& secLight = sectionLightData[sy];
+        if (!secLight) {
+            secLight = std::make_shared<SectionLightData>();
+            secLight->fill(0u);
+        }
+        uint32_t oldPacked = (*secLight)[cellIdx];
+        float oldR = float(oldPacked & 0xFFu) / 255.0f;
+        float oldG = float((oldPacked >> 8) & 0xFFu) / 255.0f;
+        float oldB = float((oldPacked >> 16) & 0xFFu) / 255.0f;
+        float newR = oldR > light.r ? oldR : light.r;
+        float newG = oldG > light.g ? oldG : light.g;
+        float newB = oldB > light.b ? oldB : light.b;
+        if (newR <= oldR && newG <= oldG && newB <= oldB) return false;
+        uint8_t pr = uint8_t(glm::clamp(int(newR * 255.0f + 0.5f), 0, 255));
+        uint8_t pg = uint8_t(glm::clamp(int(newG * 255.0f + 0.5f), 0, 255));
+        uint8_t pb = uint8_t(glm::clamp(int(newB * 255.0f + 0.5f), 0, 255));
+        uint8_t pd = uint8_t(glm::clamp(dist, 0, 255));
+        (*secLight)[cellIdx] =
+            uint32_t(pr) | (uint32_t(pg) << 8) | (uint32_t(pb) << 16) | (uint32_t(pd) << 24);
+        return true;
+    };
+
+    // ── 逐光源 BFS 主循环 ────────────────────────────────────────
+    for (const auto& src : worldSources) {
+        BlockState st = grid.query(src.x, src.y, src.z);
+        const LightDef& def = getLightDefForBlock(st.type());
+        if (def.intensity <= 0.0f) continue;
+
+        glm::vec3 srcLight = def.color * def.intensity;
+        float srcRadius = def.radius;
+        int srcR = (int)std::ceil(srcRadius);
+
+        // ── 每源包围盒（限制在 3×3 chunk 内）──
+        int bminX = std::max(src.x - srcR, selfMinX - BW);
+        int bmaxX = std::min(src.x + srcR, selfMaxX + BW);
+        int bminY = std::max(src.y - srcR, 0);
+        int bmaxY = std::min(src.y + srcR, BH - 1);
+        int bminZ = std::max(src.z - srcR, selfMinZ - BD);
+        int bmaxZ = std::min(src.z + srcR, selfMaxZ + BD);
+        int bw = bmaxX - bminX + 1;
+        int bh = bmaxY - bminY + 1;
+        int bd = bmaxZ - bminZ + 1;
+
+        // 每源独立 visited（复用 thread_local，≤31³≈30KB）
+        s_visited.assign((size_t)bw * bh * bd, 0);
+        auto visitIdx = [&](int wx, int wy, int wz) -> int {
+            return ((wy - bminY) * bd + (wz - bminZ)) * bw + (wx - bminX);
+        };
+        // 光源格：如在中心 chunk 则写入；无论如何入队
+        writeLightMax(src.x, src.y, src.z, srcLight, 0);
+        s_visited[visitIdx(src.x, src.y, src.z)] = 1;
+
+        s_ring.clear();
+        s_ring.push_back(BfsEntry{ src, 0, srcRadius, srcLight });
+        size_t head = 0;
+        static constexpr size_t kMaxIterPerSource = 1 << 20; // ~1M 防御上限
+
+        while (head < s_ring.size()) {
+            if (head > kMaxIterPerSource) break;  // 防御性截断
+            BfsEntry cur = s_ring[head++];
+            ++processed;
+
+            if (cur.dist >= (int)cur.srcRadius) continue;
+
+            int nextDist = cur.dist + 1;
+
+            for (const auto& dir : bfsDirs) {
+                glm::ivec3 nextPos = cur.pos + dir;
+
+                // 区域检查（3×3 chunk）
+                int rx = nextPos.x - (selfMinX - BW);
+                int rz = nextPos.z - (selfMinZ - BD);
+                if (rx < 0 || rx >= REGION_W || rz < 0 || rz >= REGION_D) continue;
+                if (nextPos.y < 0 || nextPos.y >= BH) continue;
+
+                // visited 检查（传播门控）
+                int idx = visitIdx(nextPos.x, nextPos.y, nextPos.z);
+                if (s_visited[idx]) continue;
+
+                // 方块透光检查
+                BlockState ns = grid.query(nextPos.x, nextPos.y, nextPos.z);
+                if (ns.type() != BLOCK_AIR && ns.type() != BLOCK_ERRER) {
+                    if (!GetBlockProperties(ns.type()).isTransparent) {
+                        s_visited[idx] = 1;  // 不透明块标记 visited，不传播
+                        continue;
+                    }
+                }
+
+                // ── 透明方块光衰减 ──
+                int opacity = 0;
+                if (ns.type() != BLOCK_AIR && ns.type() != BLOCK_ERRER
+                    && GetBlockProperties(ns.type()).isTransparent) {
+                    // 水/树叶等透明方块：每格额外增加等效距离
+                    switch (ns.type()) {
+                    case BLOCK_WATER: opacity = 2; break;
+                    case BLOCK_LEAVES: opacity = 1; break;
+                    default: opacity = 0; break;
+                    }
+                }
+                int effectiveDist = nextDist + opacity;
+                if (effectiveDist >= (int)cur.srcRadius) {
+                    s_visited[idx] = 1;
+                    continue;
+                }
+
+                float falloffAdj = 1.0f - (float)effectiveDist / cur.srcRadius;
+                if (falloffAdj <= 0.0f) {
+                    s_visited[idx] = 1;
+                    continue;
+                }
+
+                glm::vec3 nextLightAdj = cur.srcBrightness * falloffAdj;
+                float nc2 = nextLightAdj.r;
+                if (nextLightAdj.g > nc2) nc2 = nextLightAdj.g;
+                if (nextLightAdj.b > nc2) nc2 = nextLightAdj.b;
+                if (nc2 < 0.005f) {
+                    s_visited[idx] = 1;
+                    continue;
+                }
+
+                // 标记 visited + 入队（无论是否在中心 chunk）
+                s_visited[idx] = 1;
+
+                // 尝试写入光照（仅在中心 chunk 内有效），含距离元数据
+                bool improved = writeLightMax(nextPos.x, nextPos.y, nextPos.z,
+                                              nextLightAdj, effectiveDist);
+
+                // 传播条件：光照有提升 或 格子在中心 chunk 外（需穿越到达中心）
+                if (improved || !inCenterChunk(nextPos.x, nextPos.y, nextPos.z)) {
+                    s_ring.push_back(BfsEntry{ nextPos, nextDist, srcRadius, cur.srcBrightness });
+                }
+            }
+        }
+    }
+
+    return processed;
+}
+
+} // namespace
+
+int ChunkPipelineBench::run(int radius, uint64_t seed) {
+    if (radius < 0) radius = 0;
+    const int outer = radius + 1;   // 最外一圈只生成方块，给 mesh / 光照当邻居
+
+    TerrainGenerator gen;
+    gen.setSeed(seed);
+    ChunkWorkerPool pool;           // 不 start：只借用阶段函数，不起 worker 线程
+    pool.setGreedyMeshing(true);
+
+    StageStats fill{ "fill", {}, 0, 0 };
+    StageStats split{ "split", {}, 0, 0 };
+    StageStats mesh{ "mesh", {}, 0, 0 };
+    StageStats light{ "light", {}, 0, 0 };
+    StageStats net{ "serialize", {}, 0, 0 };
+
+    // ── Task 1：地形填充 + 切片 ──
+    ChunkMap chunks;
+    std::vector<BlockState> buffer(ChunkConstants::CHUNK_VOLUME);
+    for (int cz = -outer; cz <= outer; ++cz) {
+        for (int cx = -outer; cx <= outer; ++cx) {
+            const glm::ivec2 pos(cx, cz);
+            measure(fill, [&] { gen.fillChunkBuffer(buffer.data(), pos); });
+            auto res = std::make_unique<BlockDataResult>();
+            res->pos = pos;
+            measure(split, [&] { splitChunkBufferToBoxes(buffer.data(), res->boxes, res->lightSources); });
+            chunks[{ cx, cz }] = std::move(res);
+        }
+    }
+
+    // ── Task 2 / Task 3 / 网络序列化：只对半径内的 chunk（邻居齐全）──
+    static const glm::ivec2 meshOffsets[4] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+    static const glm::ivec2 mooreOffsets[8] = {
+        { -1, -1 }, { 0, -1 }, { 1, -1 }, { -1, 0 }, { 1, 0 }, { -1, 1 }, { 0, 1 }, { 1, 1 }
+    };
+    size_t faces = 0, litSections = 0, netBytes = 0;
+    for (int cz = -radius; cz <= radius; ++cz) {
+        for (int cx = -radius; cx <= radius; ++cx) {
+            const BlockDataResult* self = findChunk(chunks, cx, cz);
+
+            MeshBuildInput meshIn;
+            meshIn.pos = glm::ivec2(cx, cz);
+            meshIn.self = self->boxes;
+            for (int d = 0; d < 4; ++d)
+                meshIn.neighbors[d] = findChunk(chunks, cx + meshOffsets[d].x, cz + meshOffsets[d].y)->boxes;
+            auto meshOut = std::make_unique<ChunkBuildResult>();
+            meshOut->pos = meshIn.pos;
+            measure(mesh, [&] { pool.meshBuildOne(meshIn, *meshOut); });
+            for (const Section& sec : meshOut->sections) faces += sec.getInstanceCount();
+
+            LightBuildInput lightIn;
+            lightIn.pos = glm::ivec2(cx, cz);
+            lightIn.self = self->boxes;
+            lightIn.selfSources = self->lightSources;
+            for (int mi = 0; mi < 8; ++mi) {
+                const BlockDataResult* nb = findChunk(chunks, cx + mooreOffsets[mi].x, cz + mooreOffsets[mi].y);
+                lightIn.neighbors[mi] = nb->boxes;
+                lightIn.neighborSources[mi] = nb->lightSources;
+            }
+            LightBuildResult lightOut;
+            measure(light, [&] { ChunkWorkerPool::lightBuildOne(lightIn, lightOut); });
+            for (const auto& sec : lightOut.sectionLightData)
+                if (sec) ++litSections;
+
+            NetSerializeWorker::Job job;
+            job.chunkX = cx;
+            job.chunkZ = cz;
+            job.boxes = self->boxes;
+            std::vector<uint8_t> payload;
+            measure(net, [&] { NetSerializeWorker::serialize(job, payload); });
+            netBytes += payload.size();
+        }
+    }
+
+    // ── 汇总 ──
+    const int side = 2 * radius + 1;
+    std::cout << "[PipelineBench] seed=" << seed << " radius=" << radius
+              << " chunks=" << side * side << " (blocks generated for " << chunks.size() << ")" << std::endl;
+    std::cout << "[PipelineBench] " << std::left << std::setw(10) << "stage" << std::right
+              << std::setw(12) << "chunks/s" << std::setw(10) << "p50 ms" << std::setw(10) << "p90 ms"
+              << std::setw(10) << "p99 ms" << std::setw(10) << "max ms"
+              << std::setw(14) << "allocs/chunk" << std::setw(12) << "KB/chunk" << std::endl;
+    double pipelineMs = 0.0;
+    for (StageStats* s : { &fill, &split, &mesh, &light, &net }) {
+        std::vector<double> sorted = s->ms;
+        std::sort(sorted.begin(), sorted.end());
+        double total = 0.0;
+        for (double v : sorted) total += v;
+        const double n = static_cast<double>(sorted.size());
+        const double mean = n > 0.0 ? total / n : 0.0;
+        pipelineMs += mean;
+        std::cout << "[PipelineBench] " << std::left << std::setw(10) << s->name << std::right
+                  << std::fixed << std::setprecision(1)
+                  << std::setw(12) << (mean > 0.0 ? 1000.0 / mean : 0.0)
+                  << std::setprecision(3)
+                  << std::setw(10) << percentile(sorted, 0.50) << std::setw(10) << percentile(sorted, 0.90)
+                  << std::setw(10) << percentile(sorted, 0.99) << std::setw(10) << (sorted.empty() ? 0.0 : sorted.back())
+                  << std::setprecision(1);
+        std::cout << std::setw(14) << (n > 0.0 ? s->allocs / n : 0.0)
+                  << std::setw(12) << (n > 0.0 ? s->bytes / n / 1024.0 : 0.0) << std::endl;
+        std::cout.unsetf(std::ios::floatfield);
+    }
+    std::cout << "[PipelineBench] pipeline " << std::fixed << std::setprecision(3) << pipelineMs
+              << " ms/chunk (" << std::setprecision(1) << (pipelineMs > 0.0 ? 1000.0 / pipelineMs : 0.0)
+              << " chunks/s single-threaded)" << std::endl;
+    std::cout.unsetf(std::ios::floatfield);
+    // 输出摘要：换实现后数字应不变（纯性能改动的回归检查）
+    std::cout << "[PipelineBench] faces=" << faces << " litSections=" << litSections
+              << " netBytes=" << netBytes << std::endl;
+    return 0;
+}
+
+int ChunkPipelineBench::runLight(int rounds) {
+    if (rounds <= 0) rounds = 200;
+
+    // ── 构造萤石密集的 3×3 区块：y<64 石头；其上 4×4 间距的萤石阵列（y=66 / 74），
+    //    夹杂确定性伪随机的石块 / 水 / 树叶，覆盖遮挡与透明衰减路径 ──
+    std::vector<BlockState> buffer((size_t)BW * BD * BH);
+    ChunkBoxes boxes[9];
+    ChunkLightSources sources[9];
+    uint32_t rng = 12345u;
+    auto next = [&rng]() { rng = rng * 1664525u + 1013904223u; return rng >> 8; };
+    for (int gi = 0; gi < 9; ++gi) {
+        std::fill(buffer.begin(), buffer.end(), BlockState{});
+        for (int y = 0; y < BH; ++y) {
+            for (int z = 0; z < BD; ++z) {
+                for (int x = 0; x < BW; ++x) {
+                    BlockState& b = buffer[((size_t)y * BD + z) * BW + x];
+                    if (y < 64) { b = BlockState{ BLOCK_STONE, ORIENT_NONE }; continue; }
+                    if ((y == 66 || y == 74) && (x % 4) == 1 && (z % 4) == 1) {
+                        b = BlockState{ BLOCK_GLOWSTONE, ORIENT_NONE };
+                        continue;
+                    }
+                    if (y < 90) {
+                        uint32_t r = next() % 100;
+                        if (r < 8) b = BlockState{ BLOCK_STONE, ORIENT_NONE };
+                        else if (r < 10) b = BlockState{ BLOCK_WATER, ORIENT_NONE };
+                        else if (r < 12) b = BlockState{ BLOCK_LEAVES, ORIENT_NONE };
+                    }
+                }
+            }
+        }
+        splitChunkBufferToBoxes(buffer.data(), boxes[gi], sources[gi]);
+    }
+
+    LightBenchGrid grid;
+    std::vector<glm::ivec3> worldSources;
+    for (int gi = 0; gi < 9; ++gi) {
+        grid.boxes[gi] = &boxes[gi];
+        for (int sy = 0; sy < BSEC_COUNT; ++sy) {
+            if (!sources[gi][sy]) continue;
+            for (uint16_t p : *sources[gi][sy])
+                worldSources.push_back(unpackLightWorld(p, gridX[gi], gridZ[gi]));
+        }
+    }
+
+    using Clock = std::chrono::steady_clock;
+    ChunkLightData legacyOut{}, kernelOut{};
+    uint64_t legacyCells = 0, kernelCells = 0;
+
+    auto t0 = Clock::now();
+    for (int i = 0; i < rounds; ++i) {
+        ChunkLightData data{};
+        legacyCells += legacyLightBfs(grid, worldSources, data);
+        if (i == 0) legacyOut = data;
+    }
+    auto t1 = Clock::now();
+    for (int i = 0; i < rounds; ++i) {
+        ChunkLightData data{};
+        grid.out = &data;
+        kernelCells += LightBfs::propagate(grid, worldSources.data(), worldSources.size());
+        if (i == 0) kernelOut = data;
+    }
+    auto t2 = Clock::now();
+
+    // 逐格核对（缺失的 section 视为全零）
+    int64_t mismatched = 0;
+    for (int sy = 0; sy < BSEC_COUNT; ++sy) {
+        for (int c = 0; c < SectionLightCache::CELLS; ++c) {
+            uint32_t a = legacyOut[sy] ? (*legacyOut[sy])[c] : 0u;
+            uint32_t b = kernelOut[sy] ? (*kernelOut[sy])[c] : 0u;
+            if (a != b) ++mismatched;
+        }
+    }
+
+    auto perSec = [](uint64_t n, Clock::duration d) {
+        double s = std::chrono::duration<double>(d).count();
+        return s > 0.0 ? n / s : 0.0;
+    };
+    const double legacyRate = perSec(legacyCells, t1 - t0);
+    const double kernelRate = perSec(kernelCells, t2 - t1);
+    std::cout << "[LightBench] sources=" << worldSources.size() << " rounds=" << rounds << std::endl;
+    std::cout << "[LightBench] legacy  " << legacyRate / 1e6 << " Mcells/s ("
+              << std::chrono::duration<double, std::milli>(t1 - t0).count() / rounds << " ms/chunk)" << std::endl;
+    std::cout << "[LightBench] kernel  " << kernelRate / 1e6 << " Mcells/s ("
+              << std::chrono::duration<double, std::milli>(t2 - t1).count() / rounds << " ms/chunk, "
+              << (legacyRate > 0.0 ? kernelRate / legacyRate : 0.0) << "x)" << std::endl;
+    std::cout << "[LightBench] mismatched cells: " << mismatched << std::endl;
+    return mismatched == 0 ? 0 : 1;
+}
@@ -0,0 +1,22 @@
+﻿#pragma once
+#include <cstdint>
+
+// ── 无头 chunk 流水线基准（--bench-pipeline）──────────────────────────
+// 不建窗口、不碰 GL，在调用线程上按 ChunkWorkerPool 的真实阶段顺序逐 chunk 执行：
+//   地形填充（TerrainGenerator::fillChunkBuffer）→ 切片（splitChunkBufferToBoxes）
+//   → 可见面（meshBuildOne）→ 光照 BFS（lightBuildOne）→ 网络序列化（NetSerializeWorker::serialize）
+// 输出每阶段 chunks/s、单 chunk 延迟分位数（p50/p90/p99/max）和每 chunk 的堆分配次数 / 字节数，
+// 供无 GPU 的 CI 机器发现流水线性能回退。
+//
+// 单线程、固定种子 → 除计时外结果确定；区域为以原点为中心、半径 radius 的正方形
+// （外加一圈只生成方块、给 mesh / 光照当邻居的 chunk）。
+class ChunkPipelineBench {
+public:
+    // 返回 0 = 成功
+    static int run(int radius, uint64_t seed);
+
+    // 光照 BFS 基准（--bench-light）：在萤石密集的 3×3 区块上对比旧版浮点 BFS 与 LightBfs 内核的
+    // 出队格/秒，并逐格核对两者输出。rounds = 每条路径重复次数；返回 0 表示输出一致。
+    // 旧版 BFS 只作对照，随基准放在这里，不进 worker 代码。
+    static int runLight(int rounds);
+};
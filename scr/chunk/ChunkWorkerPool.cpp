@@ -1,5 +1,6 @@
 ﻿#include "ChunkWorkerPool.h"
 #include "Chunk.h"
+#include "../light/LightBfs.h"
 #include "../generate/TerrainGenerator.h"
 #include "../save/ChunkSaveManager.h"
 #include "../net/lz4.h"
@@ -10,6 +11,8 @@
 #include <bitset>
 #include <unordered_set>
 #include <shared_mutex>
+#include <algorithm>
+#include <climits>
 
 ChunkWorkerPool::ChunkWorkerPool() = default;
 
@@ -24,10 +27,21 @@ void ChunkWorkerPool::start(const TerrainGenerator* generator, int numThreads) {
 
     if (numThreads <= 0) numThreads = 2;
 
+    m_queues.clear();
+    for (int i = 0; i < numThreads; ++i) m_queues.push_back(std::make_unique<WorkerQueue>());
+
     m_workers.reserve(numThreads);
     for (int i = 0; i < numThreads; ++i) {
-        m_workers.emplace_back([this] { this->workerMain(); });
+        m_workers.emplace_back([this, i] { this->workerMain(i); });
     }
+
+    // start 前投递的任务此时才有队列可进（m_pending 已在投递时计入）
+    std::vector<std::unique_ptr<Job>> early;
+    {
+        std::lock_guard<std::mutex> lk(m_earlyJobMutex);
+        early.swap(m_earlyJobs);
+    }
+    for (auto& j : early) pushJob(std::move(j));
 }
 
 void ChunkWorkerPool::stop() {
@@ -39,13 +53,33 @@ void ChunkWorkerPool::stop() {
     }
     m_workers.clear();
 
+    for (auto& q : m_queues) {
+        std::lock_guard<std::mutex> lk(q->mutex);
+        q->heap.clear();
+    }
+    m_queues.clear();   // 之后的投递进 m_earlyJobs，等下次 start
+    m_queued.store(0);
     {
-        std::lock_guard<std::mutex> lk(m_jobMutex);
-        m_jobs.clear();
+        std::lock_guard<std::mutex> lk(m_earlyJobMutex);
+        m_earlyJobs.clear();
+    }
+    {
+        std::lock_guard<std::mutex> lk(m_cancelMutex);
+        m_cancelled.clear();
     }
     {
         std::lock_guard<std::mutex> lk(m_lightJobMutex);
         m_lightJobs.clear();
+        m_lightQueued.store(0);
+    }
+    {
+        std::lock_guard<std::mutex> lk(m_relightJobMutex);
+        m_relightJobs.clear();
+        m_relightQueued.store(0);
+    }
+    {
+        std::lock_guard<std::mutex> lk(m_relightDoneMutex);
+        m_relightDone.clear();
     }
     {
         std::lock_guard<std::mutex> lk(m_blockDoneMutex);
@@ -63,47 +97,187 @@ void ChunkWorkerPool::stop() {
 }
 
 void ChunkWorkerPool::submitBuild(const glm::ivec2& pos) {
-    Job j;
-    j.kind = JOB_BUILD;
-    j.pos = pos;
-    {
-        std::lock_guard<std::mutex> lk(m_jobMutex);
-        m_jobs.push_back(std::move(j));
-    }
+    auto j = std::make_unique<Job>();
+    j->kind = JOB_BUILD;
+    j->pos = pos;
     m_pending.fetch_add(1, std::memory_order_relaxed);
-    m_jobCV.notify_one();
+    pushJob(std::move(j));
 }
 
 void ChunkWorkerPool::submitMeshBuild(const MeshBuildInput& input) {
+    auto j = std::make_unique<Job>();
+    j->kind = JOB_MESH;
+    j->pos = input.pos;
+    j->meshInput = input;
+    pushJob(std::move(j));
+}
+
+void ChunkWorkerPool::submitNetImport(int chunkX, int chunkZ, std::vector<uint8_t>&& serialized) {
+    auto j = std::make_unique<Job>();
+    j->kind = JOB_NET_IMPORT;
+    j->pos = glm::ivec2(chunkX, chunkZ);
+    j->netData = std::move(serialized);
+    m_pending.fetch_add(1, std::memory_order_relaxed);
+    pushJob(std::move(j));
+}
+
+// ============================================================================
+// 调度：per-worker 优先队列 + 窃取
+// ============================================================================
+
+namespace {
+    // 小顶堆比较器：priority 小的在堆顶，同优先级 seq 小（先投递）的在前
+    struct QueuedJobGreater {
+        template<class T>
+        bool operator()(const T& a, const T& b) const {
+            if (a.priority != b.priority) return a.priority > b.priority;
+            return a.seq > b.seq;
+        }
+    };
+} // namespace
+
+uint32_t ChunkWorkerPool::computePriority(const Job& job, const CenterSet& cs, bool& relevant) {
+    relevant = true;
+    if (cs.centers.empty()) return 0;   // 无中心：纯按 seq（投递顺序）
+
+    int best = INT_MAX;
+    relevant = false;
+    for (const auto& c : cs.centers) {
+        int d = std::max(std::abs(job.pos.x - c.center.x), std::abs(job.pos.y - c.center.y));
+        best = std::min(best, d);
+        if (d <= c.radius + cs.cancelMargin) relevant = true;
+    }
+    // 同距离下 mesh 先于 Task 1：数据已就绪的 chunk 越早出 mesh，脚下地面越早可见
+    return (uint32_t)best * 2u + (job.kind == JOB_MESH ? 0u : 1u);
+}
+
+std::shared_ptr<const ChunkWorkerPool::CenterSet> ChunkWorkerPool::centerSnapshot() const {
+    std::lock_guard<std::mutex> lk(m_centerMutex);
+    return m_centers;
+}
+
+void ChunkWorkerPool::setPriorityCenters(std::vector<ChunkJobCenter> centers, int cancelMargin) {
+    auto cs = std::make_shared<CenterSet>();
+    cs->centers = std::move(centers);
+    cs->cancelMargin = cancelMargin;
     {
-        std::lock_guard<std::mutex> lk(m_jobMutex);
-        Job j;
-        j.kind = JOB_MESH;
-        j.meshInput = input;
-        m_jobs.push_back(std::move(j));
+        std::lock_guard<std::mutex> lk(m_centerMutex);
+        m_centers = std::move(cs);
     }
-    m_jobCV.notify_one();
+    // epoch 自增后，各队列下次被访问时惰性重排（不在主线程里挨个锁队列）
+    m_centerEpoch.fetch_add(1, std::memory_order_release);
 }
 
-void ChunkWorkerPool::submitNetImport(int chunkX, int chunkZ, std::vector<uint8_t>&& serialized) {
-    Job j;
-    j.kind = JOB_NET_IMPORT;
-    j.pos = glm::ivec2(chunkX, chunkZ);
-    j.netData = std::move(serialized);
+void ChunkWorkerPool::cancelJob(const Job& job) {
+    if (job.kind != JOB_MESH) m_pending.fetch_sub(1, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lk(m_cancelMutex);
+    m_cancelled.push_back({ job.pos, job.kind == JOB_MESH });
+}
+
+void ChunkWorkerPool::drainCancelled(std::vector<CancelledChunkJob>& out) {
+    std::lock_guard<std::mutex> lk(m_cancelMutex);
+    if (m_cancelled.empty()) return;
+    out.insert(out.end(), m_cancelled.begin(), m_cancelled.end());
+    m_cancelled.clear();
+}
+
+void ChunkWorkerPool::pushJob(std::unique_ptr<Job> job) {
+    if (m_queues.empty()) {
+        // 未 start / 已 stop：先缓存，start() 时再分派。不能直接丢——
+        // submitBuild / submitNetImport 已计入 m_pending，ChunkManager 也已标记在途，丢了就永远不会重排
+        std::lock_guard<std::mutex> lk(m_earlyJobMutex);
+        m_earlyJobs.push_back(std::move(job));
+        return;
+    }
+
+    auto cs = centerSnapshot();
+    bool relevant = true;
+    uint32_t prio = cs ? computePriority(*job, *cs, relevant) : 0;
+    if (!relevant) {
+        // 投递时就已无关（中心刚跑远）：直接回报取消，不进队列
+        cancelJob(*job);
+        return;
+    }
+
+    uint32_t qi = m_nextQueue.fetch_add(1, std::memory_order_relaxed) % (uint32_t)m_queues.size();
+    WorkerQueue& q = *m_queues[qi];
     {
-        std::lock_guard<std::mutex> lk(m_jobMutex);
-        m_jobs.push_back(std::move(j));
+        std::lock_guard<std::mutex> lk(q.mutex);
+        q.heap.push_back({ prio, m_jobSeq.fetch_add(1, std::memory_order_relaxed), std::move(job) });
+        std::push_heap(q.heap.begin(), q.heap.end(), QueuedJobGreater{});
+        m_queued.fetch_add(1, std::memory_order_release);
     }
-    m_pending.fetch_add(1, std::memory_order_relaxed);
+    // 短暂持有 m_jobMutex 再通知：与 worker 的 wait 谓词检查串行化，避免丢失唤醒
+    { std::lock_guard<std::mutex> lk(m_jobMutex); }
     m_jobCV.notify_one();
 }
 
+void ChunkWorkerPool::refreshQueueLocked(WorkerQueue& q) {
+    uint32_t epoch = m_centerEpoch.load(std::memory_order_acquire);
+    if (q.epoch == epoch) return;
+    q.epoch = epoch;
+    if (q.heap.empty()) return;
+
+    auto cs = centerSnapshot();
+    if (!cs) return;
+    size_t kept = 0;
+    for (size_t i = 0; i < q.heap.size(); ++i) {
+        bool relevant = true;
+        uint32_t prio = computePriority(*q.heap[i].job, *cs, relevant);
+        if (!relevant) {
+            cancelJob(*q.heap[i].job);
+            continue;
+        }
+        q.heap[i].priority = prio;
+        if (kept != i) q.heap[kept] = std::move(q.heap[i]);
+        ++kept;
+    }
+    m_queued.fetch_sub((int)(q.heap.size() - kept), std::memory_order_relaxed);
+    q.heap.resize(kept);
+    std::make_heap(q.heap.begin(), q.heap.end(), QueuedJobGreater{});
+}
+
+std::unique_ptr<ChunkWorkerPool::Job> ChunkWorkerPool::popJob(int self) {
+    const int n = (int)m_queues.size();
+    // 先取自己的队列，空了再按顺序去别的队列偷（偷的也是对方堆顶 = 对方最优任务）
+    for (int k = 0; k < n; ++k) {
+        WorkerQueue& q = *m_queues[(self + k) % n];
+        std::lock_guard<std::mutex> lk(q.mutex);
+        refreshQueueLocked(q);
+        if (q.heap.empty()) continue;
+        std::pop_heap(q.heap.begin(), q.heap.end(), QueuedJobGreater{});
+        std::unique_ptr<Job> job = std::move(q.heap.back().job);
+        q.heap.pop_back();
+        m_queued.fetch_sub(1, std::memory_order_relaxed);
+        if (k > 0) m_stealCount.fetch_add(1, std::memory_order_relaxed);
+        return job;
+    }
+    return nullptr;
+}
+
 void ChunkWorkerPool::submitLightBuild(LightBuildInput&& input) {
     {
         std::lock_guard<std::mutex> lk(m_lightJobMutex);
         m_lightJobs.push_back(std::move(input));
+        m_lightQueued.fetch_add(1, std::memory_order_release);
+    }
+    { std::lock_guard<std::mutex> lk(m_jobMutex); }
+    m_jobCV.notify_one();
+}
+
+void ChunkWorkerPool::submitRelight(std::unique_ptr<RelightInput> input) {
+    {
+        std::lock_guard<std::mutex> lk(m_relightJobMutex);
+        m_relightJobs.push_back(std::move(input));
+        m_relightQueued.fetch_add(1, std::memory_order_release);
     }
-    m_jobCV.notify_all();  // 唤醒所有 worker，其中一个会取走 light job
+    { std::lock_guard<std::mutex> lk(m_jobMutex); }
+    m_jobCV.notify_one();
+}
+
+bool ChunkWorkerPool::lightSlotAvailable() const {
+    return m_maxLightJobs <= 0
+        || m_lightJobsRunning.load(std::memory_order_acquire) < m_maxLightJobs;
 }
 
 std::vector<std::unique_ptr<BlockDataResult>> ChunkWorkerPool::drainBlockData() {
@@ -142,17 +316,51 @@ std::vector<std::unique_ptr<LightBuildResult>> ChunkWorkerPool::drainLightResult
     return out;
 }
 
-void ChunkWorkerPool::workerMain() {
+std::vector<std::unique_ptr<RelightResult>> ChunkWorkerPool::drainRelightResults() {
+    std::deque<std::unique_ptr<RelightResult>> tmp;
+    {
+        std::lock_guard<std::mutex> lk(m_relightDoneMutex);
+        tmp.swap(m_relightDone);
+    }
+    std::vector<std::unique_ptr<RelightResult>> out;
+    out.reserve(tmp.size());
+    for (auto& p : tmp) out.push_back(std::move(p));
+    return out;
+}
+
+void ChunkWorkerPool::workerMain(int self) {
     while (true) {
+        // ── 最优先：增量重光照（玩家改方块后的局部重传播，延迟直接可见）──
+        if (m_relightQueued.load(std::memory_order_acquire) > 0) {
+            std::unique_ptr<RelightInput> input;
+            {
+                std::lock_guard<std::mutex> lk(m_relightJobMutex);
+                if (!m_relightJobs.empty()) {
+                    input = std::move(m_relightJobs.front());
+                    m_relightJobs.pop_front();
+                    m_relightQueued.fetch_sub(1, std::memory_order_release);
+                }
+            }
+            if (input) {
+                auto result = std::make_unique<RelightResult>();
+                relightOne(*input, *result);
+                std::lock_guard<std::mutex> dlk(m_relightDoneMutex);
+                m_relightDone.push_back(std::move(result));
+                continue;
+            }
+        }
+
         // ── 优先检查 Task 3 光照队列 ──
-        // 仅一个 worker 可同时执行 Task 3（通过 m_lightJobRunning 互斥）。
-        // 这样不同 chunk 的光照 BFS 不会同时读写相同的光照输出缓冲。
-        {
+        // 多个 worker 可并发执行 Task 3：每个任务先逐 box 在读锁下复制出私有快照（见 lightBuildOne），
+        // BFS 免锁读快照、写自己的 LightBuildResult，BFS 临时缓冲是 thread_local。
+        // 并发数受 m_maxLightJobs 限制；"检查名额 + 占名额"在 m_lightJobMutex 内完成，不会超发。
+        if (m_lightQueued.load(std::memory_order_acquire) > 0 && lightSlotAvailable()) {
             std::unique_lock<std::mutex> lk(m_lightJobMutex);
-            if (!m_lightJobs.empty() && !m_lightJobRunning.load(std::memory_order_relaxed)) {
-                m_lightJobRunning.store(true, std::memory_order_relaxed);
+            if (!m_lightJobs.empty() && lightSlotAvailable()) {
+                m_lightJobsRunning.fetch_add(1, std::memory_order_acq_rel);
                 LightBuildInput input = std::move(m_lightJobs.front());
                 m_lightJobs.pop_front();
+                m_lightQueued.fetch_sub(1, std::memory_order_release);
                 lk.unlock();
 
                 auto result = std::make_unique<LightBuildResult>();
@@ -162,34 +370,34 @@ void ChunkWorkerPool::workerMain() {
                     std::lock_guard<std::mutex> dlk(m_lightDoneMutex);
                     m_lightDone.push_back(std::move(result));
                 }
-                m_lightJobRunning.store(false, std::memory_order_relaxed);
-                m_jobCV.notify_all();  // 唤醒其他 worker 检查 light 队列
+                m_lightBuiltCount.fetch_add(1, std::memory_order_relaxed);
+                m_lightJobsRunning.fetch_sub(1, std::memory_order_acq_rel);
+                // 名额释放：若还有排队的光照任务，唤醒一个因名额已满而睡眠的 worker
+                if (m_lightQueued.load(std::memory_order_acquire) > 0) {
+                    { std::lock_guard<std::mutex> wlk(m_jobMutex); }
+                    m_jobCV.notify_one();
+                }
                 continue;
             }
         }
 
-        // ── 常规任务 ──
-        Job job;
-        {
+        // ── 常规任务：自己的队列 → 窃取 → 都空则睡眠 ──
+        std::unique_ptr<Job> jobPtr = popJob(self);
+        if (!jobPtr) {
             std::unique_lock<std::mutex> lk(m_jobMutex);
             m_jobCV.wait(lk, [this] {
-                return m_stop.load() || !m_jobs.empty()
-                    || (!m_lightJobs.empty() && !m_lightJobRunning.load(std::memory_order_relaxed));
+                return m_stop.load() || m_queued.load(std::memory_order_acquire) > 0
+                    || m_relightQueued.load(std::memory_order_acquire) > 0
+                    || (m_lightQueued.load(std::memory_order_acquire) > 0 && lightSlotAvailable());
             });
-            if (m_stop.load() && m_jobs.empty()) {
-                // 再次检查 light 队列：stop 时先 drain 完 light jobs
-                bool hasLight = false;
-                {
-                    std::lock_guard<std::mutex> llk(m_lightJobMutex);
-                    hasLight = !m_lightJobs.empty();
-                }
-                if (!hasLight) return;
-                continue;  // 有 light job → 回到循环顶部取走
+            if (m_stop.load() && m_queued.load(std::memory_order_acquire) == 0
+                && m_relightQueued.load(std::memory_order_acquire) == 0) {
+                // stop 时先 drain 完 light jobs；名额已满则交给正在跑 Task 3 的 worker 收尾
+                if (m_lightQueued.load(std::memory_order_acquire) == 0 || !lightSlotAvailable()) return;
             }
-            if (m_jobs.empty()) continue;  // 被 light job 唤醒但被其他 worker 取走了
-            job = std::move(m_jobs.front());
-            m_jobs.pop_front();
+            continue;  // 回到循环顶部重新取（light 优先，其次本地队列 / 窃取）
         }
+        Job& job = *jobPtr;
 
         if (job.kind == JOB_BUILD) {
             auto result = std::make_unique<BlockDataResult>();
@@ -315,24 +523,29 @@ namespace {
         constexpr int H = ChunkConstants::SECTION_HEIGHT;
         auto sidx = [](int x, int y, int z) { return (y * D + z) * W + x; };
 
+        // 共享哨兵：整层同一个值，免锁直接填
+        if (box->isShared()) {
+            std::fill(out, out + H * (W > D ? W : D), box->get(0));
+            return;
+        }
         std::shared_lock<std::shared_mutex> lk(box->mutex);
-        const auto& b = box->blocks;
+        const BlockBox& b = *box;
         switch (face) {
         case RIGHT: // x = W-1 平面
             for (int y = 0; y < H; ++y)
-                for (int z = 0; z < D; ++z) out[y * D + z] = b[sidx(W - 1, y, z)];
+                for (int z = 0; z < D; ++z) out[y * D + z] = b.get(sidx(W - 1, y, z));
             break;
         case LEFT:  // x = 0 平面
             for (int y = 0; y < H; ++y)
-                for (int z = 0; z < D; ++z) out[y * D + z] = b[sidx(0, y, z)];
+                for (int z = 0; z < D; ++z) out[y * D + z] = b.get(sidx(0, y, z));
             break;
         case FRONT: // z = D-1 平面
             for (int y = 0; y < H; ++y)
-                for (int x = 0; x < W; ++x) out[y * W + x] = b[sidx(x, y, D - 1)];
+                for (int x = 0; x < W; ++x) out[y * W + x] = b.get(sidx(x, y, D - 1));
             break;
         case BACK:  // z = 0 平面
             for (int y = 0; y < H; ++y)
-                for (int x = 0; x < W; ++x) out[y * W + x] = b[sidx(x, y, 0)];
+                for (int x = 0; x < W; ++x) out[y * W + x] = b.get(sidx(x, y, 0));
             break;
         default: break;
         }
@@ -344,10 +557,12 @@ void ChunkWorkerPool::meshBuildOne(const MeshBuildInput& in, ChunkBuildResult& o
     constexpr int D = ChunkConstants::CHUNK_DEPTH;
     constexpr int SEC_H = Section::HEIGHT;
 
-    // self 数据：直接把 Task 1 产出的 16 个 BlockBox 共享给生成出来的 Section（零拷贝）。
+    // self 数据：构建期间 Section 读的是各 box 的读快照（只在复制时持读锁）——重建可见面、
+    // 拼边时逐格读自身方块，已装载 chunk 的 box 此刻可能正被主线程改写（含调色板升级换缓冲）。
+    // 构建完再换回 Task 1 / 当前 chunk 的原 box，装载后 Section 与 chunk 共享同一数据源（零拷贝）。
     for (int sy = 0; sy < ChunkBuildResult::SECTION_COUNT; ++sy) {
         out.sections[sy].setCoords(in.pos.x, in.pos.y, sy);
-        out.sections[sy].setBox(in.self[sy]);
+        out.sections[sy].setBox(BlockBox::snapshotOf(in.self[sy]));
     }
 
     // 邻居边界层临时缓冲
@@ -355,6 +570,9 @@ void ChunkWorkerPool::meshBuildOne(const MeshBuildInput& in, ChunkBuildResult& o
 
     // 计算每个 section 的可见性（含垂直邻居 + 横向邻居）
     for (int sy = 0; sy < ChunkBuildResult::SECTION_COUNT; ++sy) {
+        // 全空气哨兵：没有方块就没有面，内部重建与四周拼边都是空操作，整段跳过
+        if (in.self[sy] && in.self[sy]->isSharedAir()) continue;
+
         const Section* above = (sy + 1 < ChunkBuildResult::SECTION_COUNT)
             ? &out.sections[sy + 1] : nullptr;
         const Section* below = (sy > 0) ? &out.sections[sy - 1] : nullptr;
@@ -393,6 +611,15 @@ void ChunkWorkerPool::meshBuildOne(const MeshBuildInput& in, ChunkBuildResult& o
                     sec.updateFaceWithNeighbor(x, y, 0, BACK, layer[y * W + x]);
         }
     }
+
+    // 贪心合并必须放在四周边界面都拼完之后：边界面与内部面同平面时才能连成一片
+    if (m_greedyMeshing) {
+        for (int sy = 0; sy < ChunkBuildResult::SECTION_COUNT; ++sy)
+            out.sections[sy].mergeCoplanarFaces();
+    }
+
+    for (int sy = 0; sy < ChunkBuildResult::SECTION_COUNT; ++sy)
+        out.sections[sy].setBox(in.self[sy]);
 }
 
 // ============================================================================
@@ -407,10 +634,6 @@ constexpr int BH = ChunkConstants::CHUNK_HEIGHT;  // 256
 constexpr int BSEC_H = ChunkConstants::SECTION_HEIGHT; // 16
 constexpr int BSEC_COUNT = BH / BSEC_H;            // 16
 
-// BFS 区域边界：3×3 chunk = 48×256×48 格
-constexpr int REGION_W = BW * 3;   // 48
-constexpr int REGION_D = BD * 3;   // 48
-
 // 区块布局 → 9 个 chunk 在 3×3 网格中的偏移
 // 布局（从 +Z 方向俯视）：
 //   [0]=(-1,-1) [1]=(0,-1) [2]=(+1,-1)
@@ -420,34 +643,32 @@ constexpr int gridX[9] = { -1, 0, +1, -1, 0, +1, -1, 0, +1 };
 constexpr int gridZ[9] = { -1, -1, -1, 0, 0, 0, +1, +1, +1 };
 constexpr int SELF_IDX = 4;
 
-// 9 个 chunk 的 BlockBox 引用数组
-struct ChunkGrid {
-    const ChunkBoxes* boxes[9] = {}; // nullptr 表示该 chunk 不存在
-    int originX, originZ;             // self chunk 的世界原点（min 坐标）
-
-    // 查询 world 位置的方块。超出所有 chunk 范围返回 BLOCK_STONE（视为墙）。
-    BlockState query(int wx, int wy, int wz) const {
-        // 先判断是否在 self chunk 的 3×3 范围内
-        int relX = wx - originX;  // [-16, 31]
-        int relZ = wz - originZ;  // [-16, 31]
-        if (wy < 0 || wy >= BH) return BlockState{ BLOCK_STONE, ORIENT_NONE };
-        // 确定所属的 grid 索引
-        int gx = (relX + BW) / BW;  // 0, 1, or 2
-        int gz = (relZ + BD) / BD;  // 0, 1, or 2
-        if (gx < 0 || gx > 2 || gz < 0 || gz > 2) return BlockState{ BLOCK_STONE, ORIENT_NONE };
-        int gi = gz * 3 + gx;
-        const ChunkBoxes* cb = boxes[gi];
-        if (!cb) return BlockState{ BLOCK_STONE, ORIENT_NONE };
-        // 映射到该 chunk 的局部坐标
-        int lx = (relX + BW) % BW;
-        int lz = (relZ + BD) % BD;
-        int sy = wy / BSEC_H;
-        if (sy < 0 || sy >= BSEC_COUNT) return BlockState{ BLOCK_STONE, ORIENT_NONE };
-        int ly = wy - sy * BSEC_H;
-        const auto& box = (*cb)[sy];
-        if (!box) return BlockState{};
-        return box->blocks[(ly * BD + lz) * BW + lx];
+// Task 3 的 LightBfs 访问器：3×3 区块，仅中心 chunk 可写（输出按 section 惰性分配）
+struct Task3LightGrid {
+    int minCX, minCZ;
+    static constexpr int chunksX = 3;
+    static constexpr int chunksZ = 3;
+    const ChunkBoxes* chunks[9];
+    ChunkLightData& out;
+
+    Task3LightGrid(const LightBuildInput& in, ChunkLightData& output)
+        : minCX(in.pos.x - 1), minCZ(in.pos.y - 1), out(output) {
+        chunks[SELF_IDX] = &in.self;
+        for (int mi = 0; mi < 8; ++mi) chunks[(mi < 4) ? mi : (mi + 1)] = &in.neighbors[mi];
     }
+
+    bool hasChunk(int) const { return true; }
+    const BlockBox* box(int ci, int sy) const { return (*chunks[ci])[sy].get(); }
+    uint32_t* lightSection(int ci, int sy) {
+        if (ci != SELF_IDX) return nullptr;
+        auto& sp = out[sy];
+        if (!sp) {
+            sp = std::make_shared<SectionLightData>();
+            sp->fill(0u);
+        }
+        return sp->data();
+    }
+    void markLit(int, int) {}
 };
 
 } // namespace
@@ -455,26 +676,16 @@ struct ChunkGrid {
 void ChunkWorkerPool::lightBuildOne(const LightBuildInput& in, LightBuildResult& out) {
     out.pos = in.pos;
 
-    // ── 1. 构建 9-chunk 查询网格 ──────────────────────────────────
+    // ── 1. 从缓存收集光源（Task 1 产出，避免重复扫描 9×4096 格）──
     // Moore 邻居索引 mi → 3×3 grid 索引 gi：
     //   mi:  0(-1,-1) 1(0,-1) 2(+1,-1) 3(-1,0) 4(+1,0) 5(-1,+1) 6(0,+1) 7(+1,+1)
     //   gi:      0        1        2        3       5        6        7        8
     // 即 mi<4 时 gi=mi，mi>=4 时 gi=mi+1（跳过中间的 self=grid[4]）
-    ChunkGrid grid;
-    grid.originX = in.pos.x * BW;
-    grid.originZ = in.pos.y * BD;
-    grid.boxes[SELF_IDX] = &in.self;
-    for (int mi = 0; mi < 8; ++mi) {
-        int gi = (mi < 4) ? mi : (mi + 1);
-        grid.boxes[gi] = &in.neighbors[mi];
-    }
-
-    // ── 2. 从缓存收集光源（Task 1 产出，避免重复扫描 9×4096 格）──
     std::vector<glm::ivec3> worldSources;
     {
         // 中心 chunk：共享 shared_ptr + 解包到世界坐标
-        int cx = grid.originX;
-        int cz = grid.originZ;
+        int cx = in.pos.x * BW;
+        int cz = in.pos.y * BD;
         for (int sy = 0; sy < BSEC_COUNT; ++sy) {
             out.sectionLightSources[sy] = in.selfSources[sy]; // shared_ptr 拷贝
             if (in.selfSources[sy]) {
@@ -488,7 +699,6 @@ void ChunkWorkerPool::lightBuildOne(const LightBuildInput& in, LightBuildResult&
         // 8 邻居：仅解包到世界坐标
         for (int mi = 0; mi < 8; ++mi) {
             int gi = (mi < 4) ? mi : (mi + 1);
-            if (!grid.boxes[gi]) continue;
             int nx = cx + gridX[gi] * BW;
             int nz = cz + gridZ[gi] * BD;
             for (int sy = 0; sy < BSEC_COUNT; ++sy) {
@@ -509,188 +719,28 @@ void ChunkWorkerPool::lightBuildOne(const LightBuildInput& in, LightBuildResult&
 
     if (worldSources.empty()) return;  // 无光源 → 全零光照
 
-    // ── 3. 初始化输出 buffer ─────────────────────────────────────
-    for (int sy = 0; sy < BSEC_COUNT; ++sy) {
-        out.sectionLightData[sy] = std::make_shared<SectionLightData>();
-        out.sectionLightData[sy]->fill(0u);
-    }
-
-    const int selfMinX = grid.originX;
-    const int selfMaxX = selfMinX + BW - 1;
-    const int selfMinZ = grid.originZ;
-    const int selfMaxZ = selfMinZ + BD - 1;
-
-    // ── 4. 逐光源 BFS（每源小 visited 数组，分离传播门控与输出写入）──
-    // 设计要点：
-    //   - 每源独立 BFS。visited 按该源包围盒分配（≤31³≈30KB），远小于旧的
-    //     全局 48×256×48（576KB）。
-    //   - 传播门控（visited）与输出写入（writeLightMax）解耦：
-    //     - 中心 chunk 内：max-clamp 写入 + visited 推入队列
-    //     - 中心 chunk 外：visited 推入队列（允许 BFS 穿越邻居 chunk 格抵达中心）
-    //     这修复了「光源在邻居 chunk → BFS 第一步就断掉」的跨区块 bug。
-    //   - 逐分量 max（非 packed uint32 比较）保证多色光源正确混合。
-    static const glm::ivec3 bfsDirs[6] = {
-        {1,0,0}, {-1,0,0}, {0,1,0}, {0,-1,0}, {0,0,1}, {0,0,-1}
-    };
-
-    struct BfsEntry {
-        glm::ivec3 pos;
-        int        dist;
-        float      srcRadius;
-        glm::vec3  srcBrightness;
-    };
-
-    // 逐光源环形缓冲 + visited（thread_local，复用）
-    static thread_local std::vector<BfsEntry> s_ring;
-    s_ring.reserve(65536);
-    static thread_local std::vector<uint8_t> s_visited;
-
-    // 计算 world pos 是否在中心 chunk 范围内
-    auto inCenterChunk = [&](int wx, int wy, int wz) -> bool {
-        return wx >= selfMinX && wx <= selfMaxX &&
-               wz >= selfMinZ && wz <= selfMaxZ &&
-               wy >= 0 && wy < BH;
-    };
-
-    // 逐分量 max 写入（仅对中心 chunk 格有效）。
-    // dist: 到光源的等效曼哈顿距离（含透明方块衰减），编码进 alpha 通道。
-    auto writeLightMax = [&](int wx, int wy, int wz, const glm::vec3& light, int dist) -> bool {
-        if (!inCenterChunk(wx, wy, wz)) return false;
-        int lx = wx - selfMinX;
-        int lz = wz - selfMinZ;
-        int sy = wy / BSEC_H;
-        int ly = wy - sy * BSEC_H;
-        int cellIdx = (ly * BD + lz) * BW + lx;
-        uint32_t oldPacked = (*out.sectionLightData[sy])[cellIdx];
-        float oldR = float(oldPacked & 0xFFu) / 255.0f;
-        float oldG = float((oldPacked >> 8) & 0xFFu) / 255.0f;
-        float oldB = float((oldPacked >> 16) & 0xFFu) / 255.0f;
-        float newR = oldR > light.r ? oldR : light.r;
-        float newG = oldG > light.g ? oldG : light.g;
-        float newB = oldB > light.b ? oldB : light.b;
-        if (newR <= oldR && newG <= oldG && newB <= oldB) return false;
-        uint8_t pr = uint8_t(glm::clamp(int(newR * 255.0f + 0.5f), 0, 255));
-        uint8_t pg = uint8_t(glm::clamp(int(newG * 255.0f + 0.5f), 0, 255));
-        uint8_t pb = uint8_t(glm::clamp(int(newB * 255.0f + 0.5f), 0, 255));
-        uint8_t pd = uint8_t(glm::clamp(dist, 0, 255));
-        (*out.sectionLightData[sy])[cellIdx] =
-            uint32_t(pr) | (uint32_t(pg) << 8) | (uint32_t(pb) << 16) | (uint32_t(pd) << 24);
-        return true;
-    };
-
-    // ── 逐光源 BFS 主循环 ────────────────────────────────────────
-    for (const auto& src : worldSources) {
-        BlockState st = grid.query(src.x, src.y, src.z);
-        const LightDef& def = getLightDefForBlock(st.type());
-        if (def.intensity <= 0.0f) continue;
-
-        glm::vec3 srcLight = def.color * def.intensity;
-        float srcRadius = def.radius;
-        int srcR = (int)std::ceil(srcRadius);
-
-        // ── 每源包围盒（限制在 3×3 chunk 内）──
-        int bminX = max(src.x - srcR, selfMinX - BW);
-        int bmaxX = min(src.x + srcR, selfMaxX + BW);
-        int bminY = max(src.y - srcR, 0);
-        int bmaxY = min(src.y + srcR, BH - 1);
-        int bminZ = max(src.z - srcR, selfMinZ - BD);
-        int bmaxZ = min(src.z + srcR, selfMaxZ + BD);
-        int bw = bmaxX - bminX + 1;
-        int bh = bmaxY - bminY + 1;
-        int bd = bmaxZ - bminZ + 1;
-
-        // 每源独立 visited（复用 thread_local，≤31³≈30KB）
-        s_visited.assign((size_t)bw * bh * bd, 0);
-        auto visitIdx = [&](int wx, int wy, int wz) -> int {
-            return ((wy - bminY) * bd + (wz - bminZ)) * bw + (wx - bminX);
-        };
-        // 光源格：如在中心 chunk 则写入；无论如何入队
-        writeLightMax(src.x, src.y, src.z, srcLight, 0);
-        s_visited[visitIdx(src.x, src.y, src.z)] = 1;
-
-        s_ring.clear();
-        s_ring.push_back(BfsEntry{ src, 0, srcRadius, srcLight });
-        size_t head = 0;
-        static constexpr size_t kMaxIterPerSource = 1 << 20; // ~1M 防御上限
-
-        while (head < s_ring.size()) {
-            if (head > kMaxIterPerSource) break;  // 防御性截断
-            BfsEntry cur = s_ring[head++];
-
-            if (cur.dist >= (int)cur.srcRadius) continue;
-
-            int nextDist = cur.dist + 1;
-
-            for (const auto& dir : bfsDirs) {
-                glm::ivec3 nextPos = cur.pos + dir;
-
-                // 区域检查（3×3 chunk）
-                int rx = nextPos.x - (selfMinX - BW);
-                int rz = nextPos.z - (selfMinZ - BD);
-                if (rx < 0 || rx >= REGION_W || rz < 0 || rz >= REGION_D) continue;
-                if (nextPos.y < 0 || nextPos.y >= BH) continue;
-
-                // visited 检查（传播门控）
-                int idx = visitIdx(nextPos.x, nextPos.y, nextPos.z);
-                if (s_visited[idx]) continue;
-
-                // 方块透光检查
-                BlockState ns = grid.query(nextPos.x, nextPos.y, nextPos.z);
-                if (ns.type() != BLOCK_AIR && ns.type() != BLOCK_ERRER) {
-                    if (!GetBlockProperties(ns.type()).isTransparent) {
-                        s_visited[idx] = 1;  // 不透明块标记 visited，不传播
-                        continue;
-                    }
-                }
-
-                // ── 透明方块光衰减 ──
-                int opacity = 0;
-                if (ns.type() != BLOCK_AIR && ns.type() != BLOCK_ERRER
-                    && GetBlockProperties(ns.type()).isTransparent) {
-                    // 水/树叶等透明方块：每格额外增加等效距离
-                    switch (ns.type()) {
-                    case BLOCK_WATER: opacity = 2; break;
-                    case BLOCK_LEAVES: opacity = 1; break;
-                    default: opacity = 0; break;
-                    }
-                }
-                int effectiveDist = nextDist + opacity;
-                if (effectiveDist >= (int)cur.srcRadius) {
-                    s_visited[idx] = 1;
-                    continue;
-                }
-
-                float falloffAdj = 1.0f - (float)effectiveDist / cur.srcRadius;
-                if (falloffAdj <= 0.0f) {
-                    s_visited[idx] = 1;
-                    continue;
-                }
-
-                glm::vec3 nextLightAdj = cur.srcBrightness * falloffAdj;
-                float nc2 = nextLightAdj.r;
-                if (nextLightAdj.g > nc2) nc2 = nextLightAdj.g;
-                if (nextLightAdj.b > nc2) nc2 = nextLightAdj.b;
-                if (nc2 < 0.005f) {
-                    s_visited[idx] = 1;
-                    continue;
-                }
-
-                // 标记 visited + 入队（无论是否在中心 chunk）
-                s_visited[idx] = 1;
-
-                // 尝试写入光照（仅在中心 chunk 内有效），含距离元数据
-                bool improved = writeLightMax(nextPos.x, nextPos.y, nextPos.z,
-                                              nextLightAdj, effectiveDist);
-
-                // 传播条件：光照有提升 或 格子在中心 chunk 外（需穿越到达中心）
-                if (improved || !inCenterChunk(nextPos.x, nextPos.y, nextPos.z)) {
-                    s_ring.push_back(BfsEntry{ nextPos, nextDist, srcRadius, cur.srcBrightness });
-                }
-            }
+    // ── 2. 逐光源 BFS（LightBfs 内核）──────────────────────────────
+    // 只有中心 chunk 可写：section 光照数组（16KB）在第一次写入时才分配，光照够不到的 section
+    // 保持 nullptr；邻居 chunk 的格只穿越不写，光源在邻居 chunk 时 BFS 也能抵达中心。
+    // BFS 要反复读 3×3 区块的 box，而邻居（已装载）的 box 随时可能被主线程改写：
+    // 先对光源够得着的 section 逐个取读快照（锁只覆盖一次复制），BFS 在快照上免锁运行。
+    LightBuildInput view;
+    view.pos = in.pos;
+    {
+        int minY = BH, maxY = -1;
+        for (const auto& s : worldSources) {
+            minY = std::min(minY, s.y);
+            maxY = std::max(maxY, s.y);
         }
+        const int syMin = std::max(minY - LightBfs::kMaxR, 0) / BSEC_H;
+        const int syMax = std::min(maxY + LightBfs::kMaxR, BH - 1) / BSEC_H;
+        snapshotChunkBoxes(in.self, view.self, syMin, syMax);
+        for (int mi = 0; mi < 8; ++mi) snapshotChunkBoxes(in.neighbors[mi], view.neighbors[mi], syMin, syMax);
     }
+    Task3LightGrid lightGrid(view, out.sectionLightData);
+    LightBfs::propagate(lightGrid, worldSources.data(), worldSources.size());
 
-    // ── 5. 清除全零 section ──
+    // ── 3. 清除全零 section ──
     for (int sy = 0; sy < BSEC_COUNT; ++sy) {
         auto& sp = out.sectionLightData[sy];
         if (!sp) continue;
@@ -701,3 +751,74 @@ void ChunkWorkerPool::lightBuildOne(const LightBuildInput& in, LightBuildResult&
         if (!any) sp.reset();
     }
 }
+
+// ============================================================================
+// 增量重光照：方块变动引发的局部重传播（原先在主线程 updateLighting 里同步执行）
+// ============================================================================
+
+void ChunkWorkerPool::relightOne(const RelightInput& in, RelightResult& out) {
+    out.jobId = in.jobId;
+    const int maxCX = in.minCX + in.cw - 1;
+    const int maxCZ = in.minCZ + in.cd - 1;
+
+    // 方块读快照：变动点 ±(2×最大光照半径 + 一个 section) 内的 section——清空区按 section 对齐，
+    // 其中的受影响光源再向外 BFS 一个半径。
+    // 每个 box 只在复制期间持读锁，BFS 全程读私有快照，主线程改方块不必等重光照跑完。
+    int minY = BH, maxY = -1;
+    for (const LightChange& c : in.changes) {
+        minY = std::min(minY, c.pos.y);
+        maxY = std::max(maxY, c.pos.y);
+    }
+    const int syMin = std::max(minY - 2 * LightBfs::kMaxR - BSEC_H, 0) / BSEC_H;
+    const int syMax = std::min(maxY + 2 * LightBfs::kMaxR + BSEC_H, BH - 1) / BSEC_H;
+    std::vector<ChunkBoxes> snapshots(in.boxes.size());
+    for (size_t gi = 0; gi < in.boxes.size(); ++gi) {
+        if (in.present[gi]) snapshotChunkBoxes(in.boxes[gi], snapshots[gi], syMin, syMax);
+    }
+
+    // 快照 → LightRegion：方块 / 光源按 chunk 下标索引，无数据 chunk 视为石墙
+    LightRegion region;
+    region.resize(in.minCX, in.minCZ, in.cw, in.cd);
+    for (size_t gi = 0; gi < in.boxes.size(); ++gi) {
+        if (!in.present[gi]) continue;
+        region.boxes[gi] = &snapshots[gi];
+        region.sources[gi] = &in.sources[gi];
+    }
+
+    // 本地光照副本：首次访问某 section 时从基础光照拷入（unordered_map 节点地址稳定）
+    std::unordered_map<uint64_t, SectionLightCache> caches;
+    region.cacheProvider = [&](int cx, int cz, int sy) -> SectionLightCache* {
+        SectionKey sectionKey = packSectionKey(cx, cz, sy);
+        auto [it, inserted] = caches.try_emplace(sectionKey);
+        if (inserted) {
+            auto bit = in.baseLight.find(sectionKey);
+            if (bit != in.baseLight.end()) {
+                it->second.writeRawData(bit->second->data());
+                it->second.setHasLight(true);
+            }
+        }
+        return &it->second;
+    };
+
+    LightPropagation::relightChanges(in.changes, region);
+
+    // ── 与基础光照比对，只回传真正变化的 section ──
+    for (auto& [key, cache] : caches) {
+        int cx, cz, sy;
+        unpackSectionKey(key, cx, cz, sy);
+        if (cx < in.minCX || cx > maxCX || cz < in.minCZ || cz > maxCZ) continue;
+        if (!in.present[(cx - in.minCX) + (cz - in.minCZ) * in.cw]) continue;
+
+        auto bit = in.baseLight.find(key);
+        const bool hadLight = bit != in.baseLight.end();
+        if (!cache.hasAnyLight()) {
+            if (hadLight) out.sections.push_back({ glm::ivec2(cx, cz), sy, nullptr });
+            continue;
+        }
+        if (hadLight && std::memcmp(bit->second->data(), cache.rawData(), SectionLightCache::BYTES) == 0)
+            continue;
+        auto data = std::make_shared<SectionLightData>();
+        std::memcpy(data->data(), cache.rawData(), SectionLightCache::BYTES);
+        out.sections.push_back({ glm::ivec2(cx, cz), sy, std::move(data) });
+    }
+}
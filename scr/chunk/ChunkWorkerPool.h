@@ -4,8 +4,10 @@
 #include "BlockBox.h"
 #include "ChunkDimensions.h"
 #include "Section.h"
+#include "SectionKey.h"
 #include "../light/LightSource.h"
 #include "../light/LightCache.h"  // SectionLightData / ChunkLightData 类型
+#include "../light/LightPropagation.h"  // LightChange
 #include <array>
 #include <atomic>
 #include <condition_variable>
@@ -14,6 +16,7 @@
 #include <memory>
 #include <mutex>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 #include <glm/glm.hpp>
 
@@ -60,10 +63,53 @@ struct LightBuildInput {
 // Task 3 输出：中心区块的完整光照（3×3 区域完整 BFS）
 struct LightBuildResult {
     glm::ivec2 pos;
-    ChunkLightData sectionLightData;    // 最终光照（shared_ptr 共享）
+    ChunkLightData sectionLightData;    // 最终光照（shared_ptr 共享）；nullptr = 该 section 全暗，集成时清空旧光照
     ChunkLightSources sectionLightSources; // 中心区块 per-section 光源位置（复用 Task 1 缓存）
 };
 
+// ── 增量重光照（方块变动引发的局部重传播）──────────────────────────
+
+// 重光照输入：一批方块变动 + 覆盖其影响范围的 cw×cd 区块矩形快照。
+// BlockBox 仅拷 shared_ptr（worker 开跑时按影响范围逐 box 取快照）；光源列表主线程会原地增删，故深拷贝；
+// 基础光照只带有光的 section（缺省 = 全零），worker 在本地副本上跑 BFS。
+struct RelightInput {
+    uint64_t jobId = 0;
+    std::vector<LightChange> changes;
+    int minCX = 0, minCZ = 0;          // 矩形左下角 chunk 坐标
+    int cw = 0, cd = 0;                // 矩形宽 / 深（chunk 数）
+    std::vector<ChunkBoxes> boxes;     // cw×cd，索引 (cx-minCX)+(cz-minCZ)*cw
+    std::vector<uint8_t> present;      // 对应 chunk 是否有方块数据（否则视为石墙）
+    std::vector<ChunkLightSources> sources; // 仅 loaded chunk 的光源列表（深拷贝）
+    std::unordered_map<SectionKey, std::shared_ptr<const SectionLightData>> baseLight; // sectionKey → 当前光照
+};
+
+// 重光照输出：与基础光照相比发生变化的 section（整段替换）
+struct RelightSection {
+    glm::ivec2 chunk;
+    int sy;
+    std::shared_ptr<SectionLightData> data;  // nullptr = 该 section 已无光照（清空）
+};
+
+struct RelightResult {
+    uint64_t jobId = 0;
+    std::vector<RelightSection> sections;
+};
+
+// ── 调度优先级 ───────────────────────────────────────────────────────
+
+// 调度参考的加载中心（语义同 ChunkManager::LoadCenter；单独定义避免头文件互相包含）
+struct ChunkJobCenter {
+    glm::ivec2 center;
+    int radius;
+};
+
+// 被调度器丢弃的任务：位置已落在所有加载中心的 radius + cancelMargin 之外。
+// 主线程据此清理对应的 in-flight 标记（Task 1/网络导入 → m_inFlight，Task 2 → m_meshInFlight）。
+struct CancelledChunkJob {
+    glm::ivec2 pos;
+    bool isMesh;
+};
+
 class ChunkWorkerPool {
 public:
     ChunkWorkerPool();
@@ -87,25 +133,54 @@ public:
     // Task 3：光照 BFS（仅当 8 个 Moore 邻居都已 loaded 时投递）
     void submitLightBuild(LightBuildInput&& input);
 
+    // 增量重光照：不受 m_maxLightJobs 限制，优先于 Task 3（玩家操作的即时反馈）
+    void submitRelight(std::unique_ptr<RelightInput> input);
+
     // 主线程每帧调用：拿出已完成的 Task 1 结果
     std::vector<std::unique_ptr<BlockDataResult>> drainBlockData();
     // 主线程每帧调用：拿出已完成的 Task 2 结果
     std::vector<std::unique_ptr<ChunkBuildResult>> drainMeshResults();
     // 主线程每帧调用：拿出已完成的 Task 3 结果
     std::vector<std::unique_ptr<LightBuildResult>> drainLightResults();
+    // 主线程每帧调用：拿出已完成的增量重光照结果
+    std::vector<std::unique_ptr<RelightResult>> drainRelightResults();
 
     // 当前队列待处理任务数（Task 1/2/网络导入，不含 Task 3）
     int pendingCount() const { return m_pending.load(std::memory_order_relaxed); }
+    // Task 3 排队中（尚未被 worker 取走）的任务数
+    int lightQueuedCount() const { return m_lightQueued.load(std::memory_order_relaxed); }
+    // 自上次调用以来完成的 Task 3 数（主线程取走后清零，供 Profiler 统计吞吐）
+    int64_t takeLightBuiltCount() { return m_lightBuiltCount.exchange(0, std::memory_order_relaxed); }
+
+    // 设置调度优先级参考的加载中心。任务优先级 = 到最近中心的 Chebyshev 距离（同距离 mesh 先于 Task 1）。
+    // 中心变化后各 worker 队列在下次取任务时惰性重排，并丢弃落在所有中心 radius + cancelMargin 外的任务。
+    // centers 为空 = 不排序（按投递顺序）、不取消。
+    void setPriorityCenters(std::vector<ChunkJobCenter> centers, int cancelMargin);
+    // 主线程每帧调用：取出被取消的任务（追加到 out）
+    void drainCancelled(std::vector<CancelledChunkJob>& out);
+    // 自上次调用以来跨 worker 窃取的任务数（主线程取走后清零，供 Profiler 计数）
+    int64_t takeStealCount() { return m_stealCount.exchange(0, std::memory_order_relaxed); }
 
     // 设置存档管理器指针（用于 buildOne 中尝试从磁盘加载）
     void setSaveManager(const class ChunkSaveManager* sm) { m_saveManager = sm; }
 
+    // Task 2 产出前是否对每个 section 做贪心合并（见 Section::mergeCoplanarFaces）；start 前设置
+    void setGreedyMeshing(bool on) { m_greedyMeshing = on; }
+
+    // 同时执行 Task 3 的 worker 上限；<=0 = 不限制（所有 worker 都可取光照任务）。start 前设置。
+    // 留出余量给 Task 1/2，避免大批光源 chunk 涌入时把 mesh 构建饿住。
+    void setMaxConcurrentLightJobs(int n) { m_maxLightJobs = n; }
+
 private:
-    void workerMain();
+    friend class ChunkPipelineBench;  // 无头基准直接驱动各阶段函数
+
+    void workerMain(int self);
     void buildOne(const glm::ivec2& pos, BlockDataResult& out) const;
     void meshBuildOne(const MeshBuildInput& in, ChunkBuildResult& out) const;
     // Task 3：从 3×3 区块做一次完整 BFS，产出中心 chunk 的光照
     static void lightBuildOne(const LightBuildInput& in, LightBuildResult& out);
+    // 增量重光照：在快照的本地光照副本上执行 LightPropagation::relightChanges，产出变化的 section
+    static void relightOne(const RelightInput& in, RelightResult& out);
     // 网络导入：解压 serialized → 切片成 16 个 box
     static void netImportOne(const glm::ivec2& pos, const std::vector<uint8_t>& serialized,
                              BlockDataResult& out);
@@ -120,20 +195,82 @@ private:
         // 注：JOB_LIGHT 走独立队列 m_lightJobs，不经过本结构体
     };
 
+    // 优先级快照：setPriorityCenters 整体替换，worker 取 shared_ptr 拷贝后无锁读
+    struct CenterSet {
+        std::vector<ChunkJobCenter> centers;
+        int cancelMargin = 0;
+    };
+
+    // 堆元素：Job 本体较大（MeshBuildInput 含 80 个 shared_ptr），堆里只搬 unique_ptr
+    struct QueuedJob {
+        uint32_t priority;   // 越小越先做
+        uint64_t seq;        // 同优先级按投递顺序
+        std::unique_ptr<Job> job;
+    };
+
+    // 每 worker 一个本地优先队列（小顶堆）。投递按轮转分散到各队列，worker 先取自己的，
+    // 空了再从别的队列"偷"最优任务 —— 锁粒度降到单队列，平时基本无竞争。
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::vector<QueuedJob> heap;
+        uint32_t epoch = 0;   // 上次按加载中心重排时的 m_centerEpoch
+    };
+
+    void pushJob(std::unique_ptr<Job> job);
+    std::unique_ptr<Job> popJob(int self);
+    // 持 q.mutex 调用：加载中心变了就重算优先级、剔除无关任务并重建堆
+    void refreshQueueLocked(WorkerQueue& q);
+    std::shared_ptr<const CenterSet> centerSnapshot() const;
+    // 计算优先级；relevant=false 表示已落在所有中心的取消半径外
+    static uint32_t computePriority(const Job& job, const CenterSet& cs, bool& relevant);
+    void cancelJob(const Job& job);
+    // 是否还能再开一个 Task 3（m_lightJobsRunning 未达上限）
+    bool lightSlotAvailable() const;
+
     const TerrainGenerator* m_generator = nullptr;
     const class ChunkSaveManager* m_saveManager = nullptr;
+    bool m_greedyMeshing = false;
+    int m_maxLightJobs = 0;
     std::vector<std::thread> m_workers;
     std::atomic<bool> m_stop{ false };
 
-    // 常规任务队列（Task 1 / Task 2 / 网络导入）
+    // 常规任务队列（Task 1 / Task 2 / 网络导入）：每 worker 一个，见 WorkerQueue
+    std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+    std::atomic<uint32_t> m_nextQueue{ 0 };     // 投递轮转游标
+    std::atomic<uint64_t> m_jobSeq{ 0 };
+    std::atomic<int> m_queued{ 0 };             // 所有本地队列中的任务总数（空闲判定用）
+    std::atomic<int64_t> m_stealCount{ 0 };
+    // start 前（或 stop 后）投递的任务，start() 时统一分派
+    std::mutex m_earlyJobMutex;
+    std::vector<std::unique_ptr<Job>> m_earlyJobs;
+
+    // 空闲 worker 在此睡眠；m_jobMutex 只在入睡 / 唤醒时短暂持有，不再保护队列本身
     std::mutex m_jobMutex;
     std::condition_variable m_jobCV;
-    std::deque<Job> m_jobs;
 
-    // Task 3 独立队列：单 worker 消费（通过 m_lightJobRunning 互斥）
+    // 调度优先级参考
+    mutable std::mutex m_centerMutex;
+    std::shared_ptr<const CenterSet> m_centers;
+    std::atomic<uint32_t> m_centerEpoch{ 0 };
+
+    // 被取消的任务，主线程 drainCancelled 取走
+    std::mutex m_cancelMutex;
+    std::vector<CancelledChunkJob> m_cancelled;
+
+    // Task 3 独立队列：多 worker 并发消费，同时在跑的数量受 m_maxLightJobs 限制。
+    // 每个任务自带 3×3 BlockBox 快照、输出各自独立，worker 之间无共享可写状态。
     std::mutex m_lightJobMutex;
     std::deque<LightBuildInput> m_lightJobs;
-    std::atomic<bool> m_lightJobRunning{ false };
+    std::atomic<int> m_lightQueued{ 0 };        // m_lightJobs.size() 的无锁镜像（wait 谓词用）
+    std::atomic<int> m_lightJobsRunning{ 0 };
+    std::atomic<int64_t> m_lightBuiltCount{ 0 };
+
+    // 增量重光照队列：任务很少（仅玩家改方块时），有任务就立即被下一个空闲 worker 取走
+    std::mutex m_relightJobMutex;
+    std::deque<std::unique_ptr<RelightInput>> m_relightJobs;
+    std::atomic<int> m_relightQueued{ 0 };
+    std::mutex m_relightDoneMutex;
+    std::deque<std::unique_ptr<RelightResult>> m_relightDone;
 
     // 完成队列：Task 1 (block data) / Task 2 (mesh) / Task 3 (light)
     std::mutex m_blockDoneMutex;
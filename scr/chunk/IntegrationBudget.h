@@ -0,0 +1,87 @@
+﻿#pragma once
+#include <algorithm>
+#include <chrono>
+
+// ── 主线程每帧集成的时间预算 ──────────────────────────────────────────
+// 取代固定的"每帧最多处理 N 个结果"：Task 1 / Task 2 / Task 3 结果集成与 GPU 上传
+// 共用一份毫秒预算，按流水线顺序依次消费。每阶段开始时分到「剩余预算 / 剩余阶段数」，
+// 用不完的顺延给后面的阶段（上传排在最后，能吃到前面所有的结余）。
+//
+// 单项成本由各阶段自己测：每处理一项记一次耗时，按指数滑动平均估计下一项；
+// 预计放得下才继续。每阶段每帧至少处理一项，慢机器上也保证前进。
+//
+// 用法（主线程）：
+//   budget.beginFrame(ms);
+//   budget.beginStage(STAGE_BLOCK);
+//   while (有待处理 && budget.admit()) { IntegrationBudget::Item item(budget); ... }
+//   budget.endStage();
+class IntegrationBudget {
+public:
+    enum Stage { STAGE_BLOCK = 0, STAGE_MESH, STAGE_LIGHT, STAGE_UPLOAD, STAGE_COUNT };
+    using Clock = std::chrono::steady_clock;
+
+    void beginFrame(double budgetMs) {
+        m_remainingMs = std::max(0.0, budgetMs);
+        m_stagesLeft = STAGE_COUNT;
+    }
+
+    void beginStage(Stage s) {
+        m_stage = s;
+        m_allowanceMs = m_remainingMs / std::max(1, m_stagesLeft);
+        m_stageUsedMs = 0.0;
+        m_stageItems = 0;
+    }
+
+    // 本阶段还能否再处理一项
+    bool admit() const {
+        return m_stageItems == 0 || m_stageUsedMs + m_avgMs[m_stage] <= m_allowanceMs;
+    }
+
+    void endStage() {
+        m_remainingMs = std::max(0.0, m_remainingMs - m_stageUsedMs);
+        if (m_stagesLeft > 0) --m_stagesLeft;
+    }
+
+    int stageItems() const { return m_stageItems; }
+    double stageUsedMs() const { return m_stageUsedMs; }
+    double averageMs(Stage s) const { return m_avgMs[s]; }
+
+    // 单项计时（RAII）：析构时把耗时记到当前阶段。
+    // discard()：这一项其实没干活（结果已过期 / chunk 已卸载等），只扣时间，不计数、不进成本估计。
+    class Item {
+    public:
+        explicit Item(IntegrationBudget& b) : m_budget(b), m_start(Clock::now()) {}
+        ~Item() {
+            const double ms = std::chrono::duration<double, std::milli>(Clock::now() - m_start).count();
+            m_budget.record(ms, m_counted);
+        }
+        void discard() { m_counted = false; }
+
+        Item(const Item&) = delete;
+        Item& operator=(const Item&) = delete;
+
+    private:
+        IntegrationBudget& m_budget;
+        Clock::time_point m_start;
+        bool m_counted = true;
+    };
+
+private:
+    static constexpr double EWMA_ALPHA = 0.1;
+
+    void record(double ms, bool counted) {
+        m_stageUsedMs += ms;
+        if (!counted) return;
+        ++m_stageItems;
+        double& avg = m_avgMs[m_stage];
+        avg = (avg <= 0.0) ? ms : avg + (ms - avg) * EWMA_ALPHA;
+    }
+
+    double m_remainingMs = 0.0;
+    int m_stagesLeft = STAGE_COUNT;
+    Stage m_stage = STAGE_BLOCK;
+    double m_allowanceMs = 0.0;
+    double m_stageUsedMs = 0.0;
+    int m_stageItems = 0;
+    double m_avgMs[STAGE_COUNT] = {};
+};
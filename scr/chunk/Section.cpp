@@ -2,10 +2,61 @@
 #include <algorithm>
 #include <cstring>
 
+namespace {
+    // 贪心合并用的面平面参数化，必须与 g_buffer.vert / shadow_mapping_depth.vert 的 faceMatrices 列向量一致：
+    //   n = 法线轴；u / v = 面局部 X / Y 轴落在哪个 section 轴上（0=x, 1=y, 2=z），sign 为方向。
+    // 平面坐标 (s, i, j)：s 沿法线，i/j 沿局部 X/Y 递增 —— 合并矩形的锚点就是 (i, j) 最小的那一格。
+    struct FaceAxes { int n, u, uSign, v, vSign; };
+    constexpr FaceAxes kFaceAxes[6] = {
+        { 0, 2, -1, 1, +1 },  // RIGHT: 局部 X → -Z，局部 Y → +Y
+        { 0, 2, +1, 1, +1 },  // LEFT:  局部 X → +Z，局部 Y → +Y
+        { 2, 0, +1, 1, +1 },  // FRONT: 局部 X → +X，局部 Y → +Y
+        { 2, 0, -1, 1, +1 },  // BACK:  局部 X → -X，局部 Y → +Y
+        { 1, 0, +1, 2, -1 },  // UP:    局部 X → +X，局部 Y → -Z
+        { 1, 0, +1, 2, +1 },  // DOWN:  局部 X → +X，局部 Y → +Z
+    };
+    constexpr int N = Section::WIDTH;
+    static_assert(Section::WIDTH == Section::HEIGHT && Section::HEIGHT == Section::DEPTH,
+        "greedy meshing assumes cubic sections");
+
+    inline void planeToLocal(BlockFace face, int s, int i, int j, int c[3]) {
+        const FaceAxes& a = kFaceAxes[face];
+        c[a.n] = s;
+        c[a.u] = a.uSign > 0 ? i : N - 1 - i;
+        c[a.v] = a.vSign > 0 ? j : N - 1 - j;
+    }
+
+    inline void localToPlane(BlockFace face, const int c[3], int& s, int& i, int& j) {
+        const FaceAxes& a = kFaceAxes[face];
+        s = c[a.n];
+        i = a.uSign > 0 ? c[a.u] : N - 1 - c[a.u];
+        j = a.vSign > 0 ? c[a.v] : N - 1 - c[a.v];
+    }
+
+    // 遍历一个实例（单位面或合并矩形）覆盖的所有格子，回调 section 局部坐标
+    template<class Fn>
+    void forEachQuadCell(uint32_t packed, Fn&& fn) {
+        BlockFace face = InstanceData::unpackFace(packed);
+        int c[3] = { InstanceData::unpackX(packed), InstanceData::unpackY(packed), InstanceData::unpackZ(packed) };
+        int s, i0, j0;
+        localToPlane(face, c, s, i0, j0);
+        int w = InstanceData::unpackQuadW(packed);
+        int h = InstanceData::unpackQuadH(packed);
+        for (int dj = 0; dj < h; ++dj) {
+            for (int di = 0; di < w; ++di) {
+                planeToLocal(face, s, i0 + di, j0 + dj, c);
+                fn(c[0], c[1], c[2], face);
+            }
+        }
+    }
+
+    inline uint8_t unpackOrient(uint32_t p) { return uint8_t((p >> 15) & 0xFu); }
+} // namespace
+
 Section::Section()
-    : m_box(std::make_shared<BlockBox>())
+    : m_box(BlockBox::sharedUniform(BlockState{}))
 {
-    // BlockBox 构造函数已把数据整段写 0（type=BLOCK_AIR, orient=ORIENT_PX）。
+    // 默认引用全空气哨兵，不分配 box；第一次写入时才复制出私有 box。
 }
 
 void Section::setCoords(int chunkX, int chunkZ, int sectionY) {
@@ -18,19 +69,48 @@ BlockState Section::getBlock(int x, int y, int z) const {
     if (x < 0 || x >= WIDTH || y < 0 || y >= HEIGHT || z < 0 || z >= DEPTH) {
         return BlockState{};
     }
-    return m_box->blocks[idx(x, y, z)];
+    return m_box->get(idx(x, y, z));
 }
 
 void Section::setBlock(int x, int y, int z, BlockState s) {
     if (x < 0 || x >= WIDTH || y < 0 || y >= HEIGHT || z < 0 || z >= DEPTH) return;
+    if (m_box->isShared()) {
+        if (m_box->get(idx(x, y, z)) == s) return;
+        // 写时复制：换成私有 box 再改。已拿走哨兵指针的 worker 读到的是修改前的快照，
+        // 与它在修改前读完边界等价。
+        m_box = m_box->cloneMutable();
+    }
     // 玩家修改方块数据：持写锁，与 worker（Task 2）读邻居边界的读锁互斥。
     std::unique_lock<std::shared_mutex> lk(m_box->mutex);
-    m_box->blocks[idx(x, y, z)] = s;
+    m_box->set(idx(x, y, z), s);
+}
+
+void Section::copyLayer(int y, BlockState* out) const {
+    auto lk = m_box->lockShared();
+    for (int z = 0; z < DEPTH; ++z)
+        for (int x = 0; x < WIDTH; ++x) out[z * WIDTH + x] = m_box->get(idx(x, y, z));
+}
+
+void Section::setFace(int key, int index) {
+    if (!m_faceIndex) {
+        m_faceIndex.reset(new uint16_t[FACE_KEYS]);
+        std::fill_n(m_faceIndex.get(), FACE_KEYS, NO_FACE);
+    }
+    uint16_t& slot = m_faceIndex[key];
+    if (slot == NO_FACE) ++m_faceKeyCount;
+    slot = (uint16_t)index;
+}
+
+void Section::clearFace(int key) {
+    uint16_t& slot = m_faceIndex[key];
+    if (slot == NO_FACE) return;
+    slot = NO_FACE;
+    --m_faceKeyCount;
 }
 
 void Section::addFaceLocal(int x, int y, int z, BlockFace face, BlockState state) {
-    BlockFaceLocKey key{ (uint8_t)x, (uint8_t)y, (uint8_t)z, face };
-    if (m_PosToInstanceIndex.find(key) != m_PosToInstanceIndex.end()) {
+    const int key = faceKey(x, y, z, face);
+    if (findFace(key) >= 0) {
         return;
     }
     BlockType type = state.type();
@@ -46,34 +126,64 @@ void Section::addFaceLocal(int x, int y, int z, BlockFace face, BlockState state
     uint32_t packed = InstanceData::makePacked(
         (uint8_t)x, (uint8_t)y, (uint8_t)z, face, state.orient());
 
+    placeInstance(key, InstanceData(packed, (uint16_t)type, (uint16_t)textureLayer));
+}
+
+int Section::placeInstance(int key, const InstanceData& d) {
     int idx;
     if (!m_freeSlots.empty()) {
         // 复用一个 ERRER 占位槽：原地写入，不增长数组长度
         idx = (int)m_freeSlots.back();
         m_freeSlots.pop_back();
-        m_instanceData[idx] = InstanceData(packed, (uint16_t)type, (uint16_t)textureLayer);
+        m_instanceData[idx] = d;
         if (m_errerCount > 0) m_errerCount--;
     } else {
         // 没有可复用槽 → 数组尾部追加；slot.count 在上传时由 ChunkManager 同步
         idx = (int)m_instanceData.size();
-        m_instanceData.emplace_back(packed, (uint16_t)type, (uint16_t)textureLayer);
+        m_instanceData.push_back(d);
     }
-    m_PosToInstanceIndex[key] = idx;
+    setFace(key, idx);
     m_dirty = true;
     // 已标记全量重建时无需累积增量 index（最终会全量传）
     if (!m_fullRebuildPending) m_dirtyIndices.push_back((uint32_t)idx);
+    return idx;
+}
+
+void Section::splitQuad(int index) {
+    const InstanceData d = m_instanceData[index];
+    const uint8_t ax = InstanceData::unpackX(d.packed);
+    const uint8_t ay = InstanceData::unpackY(d.packed);
+    const uint8_t az = InstanceData::unpackZ(d.packed);
+    const uint8_t orient = unpackOrient(d.packed);
+
+    // 锚点格原地退化为单位面（映射本来就指向 index，不用改）
+    m_instanceData[index].packed = d.packed & ~InstanceData::QUAD_SIZE_MASK;
+    m_dirty = true;
+    if (!m_fullRebuildPending) m_dirtyIndices.push_back((uint32_t)index);
+
+    // 其余格子各自落一个单位面（优先吃 free list 里的 ERRER 槽）
+    forEachQuadCell(d.packed, [&](int x, int y, int z, BlockFace face) {
+        if (x == ax && y == ay && z == az) return;
+        uint32_t packed = InstanceData::makePacked((uint8_t)x, (uint8_t)y, (uint8_t)z, face, orient);
+        placeInstance(faceKey(x, y, z, face), InstanceData(packed, d.blockType, d.textureLayer));
+    });
 }
 
 void Section::removeFaceLocal(int x, int y, int z, BlockFace face) {
-    BlockFaceLocKey key{ (uint8_t)x, (uint8_t)y, (uint8_t)z, face };
-    auto it = m_PosToInstanceIndex.find(key);
-    if (it == m_PosToInstanceIndex.end()) return;
+    const int key = faceKey(x, y, z, face);
+    int index = findFace(key);
+    if (index < 0) return;
+
+    // 落在合并矩形里：先拆回单位面（其余格子改指新槽，本格仍指锚点或被改写，重新查一次）
+    if (InstanceData::isMergedQuad(m_instanceData[index].packed)) {
+        splitQuad(index);
+        index = findFace(key);
+    }
 
-    int index = it->second;
     // 占位：g_buffer.frag 见到 BLOCK_ERRER 直接 discard。位置上仍占一格，slot.count 不变。
     // 同时把 index 收进 free list，下次 addFaceLocal 优先复用此槽，避免数组无限膨胀。
     m_instanceData[index].blockType = BLOCK_ERRER;
-    m_PosToInstanceIndex.erase(it);
+    clearFace(key);
     m_errerCount++;
     m_dirty = true;
     if (!m_fullRebuildPending) m_dirtyIndices.push_back((uint32_t)index);
@@ -87,8 +197,7 @@ void Section::updateFaceWithNeighbor(int x, int y, int z, BlockFace face, BlockS
         return;
     }
     bool visible = (neighbor.type() == BLOCK_AIR);
-    BlockFaceLocKey key{ (uint8_t)x, (uint8_t)y, (uint8_t)z, face };
-    bool exists = m_PosToInstanceIndex.find(key) != m_PosToInstanceIndex.end();
+    bool exists = findFace(faceKey(x, y, z, face)) >= 0;
     if (visible && !exists) {
         addFaceLocal(x, y, z, face, state);
     } else if (!visible && exists) {
@@ -99,26 +208,24 @@ void Section::updateFaceWithNeighbor(int x, int y, int z, BlockFace face, BlockS
 void Section::compact() {
     if (m_errerCount == 0) return;
 
+    // 面集合不变（ERRER 槽的 key 早已注销），只是下标前移 → 面索引原地改写
     std::vector<InstanceData> nd;
-    std::unordered_map<BlockFaceLocKey, int> nm;
     nd.reserve(m_instanceData.size() - m_errerCount);
 
     for (size_t i = 0; i < m_instanceData.size(); ++i) {
         const auto& d = m_instanceData[i];
         if (d.blockType == BLOCK_ERRER) continue;
 
-        // 局部坐标直接从 packed 字段拆出（不再需要从世界坐标反推）
-        uint8_t lx = InstanceData::unpackX(d.packed);
-        uint8_t ly = InstanceData::unpackY(d.packed);
-        uint8_t lz = InstanceData::unpackZ(d.packed);
-        BlockFace face = InstanceData::unpackFace(d.packed);
-        BlockFaceLocKey key{ lx, ly, lz, face };
-        nm[key] = (int)nd.size();
+        // 局部坐标直接从 packed 字段拆出（不再需要从世界坐标反推）；
+        // 合并矩形覆盖的每一格都要重新登记到新下标
+        int newIndex = (int)nd.size();
+        forEachQuadCell(d.packed, [&](int x, int y, int z, BlockFace face) {
+            m_faceIndex[faceKey(x, y, z, face)] = (uint16_t)newIndex;
+        });
         nd.push_back(d);
     }
 
     m_instanceData.swap(nd);
-    m_PosToInstanceIndex.swap(nm);
     m_errerCount = 0;
     m_dirty = true;
     // compact 改变了 instanceData 整体布局 → 走全量
@@ -129,7 +236,9 @@ void Section::compact() {
 
 void Section::rebuildVisibilityInternal(const Section* above, const Section* below) {
     m_instanceData.clear();
-    m_PosToInstanceIndex.clear();
+    // 面索引整表释放，有面时由 setFace 重新分配 —— 被完全包裹的 section 重建后不再占 48KB
+    m_faceIndex.reset();
+    m_faceKeyCount = 0;
     m_errerCount = 0;
     // rebuild 是大幅替换 → 不能走增量
     m_dirtyIndices.clear();
@@ -138,10 +247,22 @@ void Section::rebuildVisibilityInternal(const Section* above, const Section* bel
 
     BlockFace allFaces[6] = { RIGHT, LEFT, FRONT, BACK, UP, DOWN };
 
+    // box 可能是调色板形态：先整段解码到栈上，内层循环按平铺数组随机访问。
+    // 持读锁解码：worker 上跑时主线程可能正在改同一 box（升级形态会换掉调色板 / 下标缓冲）。
+    BlockState blocks[VOLUME];
+    {
+        auto lk = m_box->lockShared();
+        m_box->copyTo(blocks);
+    }
+    // 上下相邻 section 的贴边层同样持读锁一次拷出，内层循环不再逐格读 box
+    BlockState belowTop[WIDTH * DEPTH], aboveBottom[WIDTH * DEPTH];
+    if (below) below->copyLayer(HEIGHT - 1, belowTop);
+    if (above) above->copyLayer(0, aboveBottom);
+
     for (int z = 0; z < DEPTH; ++z) {
         for (int y = 0; y < HEIGHT; ++y) {
             for (int x = 0; x < WIDTH; ++x) {
-                BlockState state = m_box->blocks[idx(x, y, z)];
+                BlockState state = blocks[idx(x, y, z)];
                 BlockType block = state.type();
                 if (block == BLOCK_AIR) continue;
 
@@ -168,11 +289,11 @@ void Section::rebuildVisibilityInternal(const Section* above, const Section* bel
                         // 横向跨 chunk：worker 不知道，默认不可见，主线程 stitch 时再补
                         continue;
                     } else if (ny < 0) {
-                        nb = below ? below->getBlock(x, HEIGHT - 1, z).type() : BLOCK_AIR;
+                        nb = below ? belowTop[z * WIDTH + x].type() : BLOCK_AIR;
                     } else if (ny >= HEIGHT) {
-                        nb = above ? above->getBlock(x, 0, z).type() : BLOCK_AIR;
+                        nb = above ? aboveBottom[z * WIDTH + x].type() : BLOCK_AIR;
                     } else {
-                        nb = m_box->blocks[idx(nx, ny, nz)].type();
+                        nb = blocks[idx(nx, ny, nz)].type();
                     }
 
                     if (nb == BLOCK_AIR) {
@@ -186,11 +307,96 @@ void Section::rebuildVisibilityInternal(const Section* above, const Section* bel
     // 给后续 stitch 阶段预留容量：4 边 × 16×16 边界格上限 = 1024 个新增面。
     // 在 worker 上下文做这次堆分配，避免主线程 adoptFrom 时的尖峰。
     m_instanceData.reserve(m_instanceData.size() + 1024);
-    m_PosToInstanceIndex.reserve(m_PosToInstanceIndex.size() + 1024);
 
     m_dirty = true;
 }
 
+void Section::mergeCoplanarFaces() {
+    if (m_instanceData.empty()) return;
+
+    constexpr int PLANE = N * N;
+    // grid[face][s][j][i] = 该格该面的实例下标，-1 = 无面（或已被某个矩形吃掉）。
+    // 96KB，按线程复用，避免每个 section 一次堆分配。
+    thread_local std::vector<int32_t> grid;
+    grid.assign(6 * VOLUME, -1);
+
+    for (size_t k = 0; k < m_instanceData.size(); ++k) {
+        const auto& d = m_instanceData[k];
+        if (d.blockType == BLOCK_ERRER) continue;
+        forEachQuadCell(d.packed, [&](int x, int y, int z, BlockFace face) {
+            int c[3] = { x, y, z };
+            int s, i, j;
+            localToPlane(face, c, s, i, j);
+            grid[(face * N + s) * PLANE + j * N + i] = (int32_t)k;
+        });
+    }
+
+    // 可合并：同 blockType + 同纹理层 + 同朝向（朝向决定着色器里的端面/UV 旋转）
+    auto sameKind = [&](int32_t a, int32_t b) {
+        if (b < 0) return false;
+        const auto& A = m_instanceData[a];
+        const auto& B = m_instanceData[b];
+        return A.blockType == B.blockType && A.textureLayer == B.textureLayer
+            && unpackOrient(A.packed) == unpackOrient(B.packed);
+    };
+
+    // 合并前后覆盖的面集合相同 → 面索引原地改写成新下标，不用重建
+    std::vector<InstanceData> nd;
+    nd.reserve(m_instanceData.size());
+
+    for (int f = 0; f < 6; ++f) {
+        BlockFace face = (BlockFace)f;
+        for (int s = 0; s < N; ++s) {
+            int32_t* g = &grid[(f * N + s) * PLANE];
+            for (int j = 0; j < N; ++j) {
+                for (int i = 0; i < N; ++i) {
+                    int32_t first = g[j * N + i];
+                    if (first < 0) continue;
+
+                    // 先沿 i 尽量拉宽，再逐行沿 j 拉高（整行都同类才接受）
+                    int w = 1;
+                    while (i + w < N && sameKind(first, g[j * N + i + w])) ++w;
+                    int h = 1;
+                    for (; j + h < N; ++h) {
+                        bool rowOk = true;
+                        for (int di = 0; di < w; ++di) {
+                            if (!sameKind(first, g[(j + h) * N + i + di])) { rowOk = false; break; }
+                        }
+                        if (!rowOk) break;
+                    }
+
+                    const InstanceData& src = m_instanceData[first];
+                    int c[3];
+                    planeToLocal(face, s, i, j, c);
+                    uint32_t packed = InstanceData::withQuadSize(
+                        InstanceData::makePacked((uint8_t)c[0], (uint8_t)c[1], (uint8_t)c[2],
+                            face, unpackOrient(src.packed)), w, h);
+                    int newIndex = (int)nd.size();
+                    nd.emplace_back(packed, src.blockType, src.textureLayer);
+
+                    for (int dj = 0; dj < h; ++dj) {
+                        for (int di = 0; di < w; ++di) {
+                            g[(j + dj) * N + i + di] = -1;
+                            planeToLocal(face, s, i + di, j + dj, c);
+                            m_faceIndex[faceKey(c[0], c[1], c[2], face)] = (uint16_t)newIndex;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // 与 rebuildVisibilityInternal 一样给后续增量编辑留余量（拆矩形会一次性追加多个单位面）
+    nd.reserve(nd.size() + 1024);
+
+    m_instanceData.swap(nd);
+    m_errerCount = 0;
+    m_dirty = true;
+    m_fullRebuildPending = true;
+    m_dirtyIndices.clear();
+    m_freeSlots.clear();
+}
+
 void Section::notifyGpuSlotReleased() {
     m_dirty = true;
     m_dirtyIndices.clear();
@@ -201,7 +407,9 @@ void Section::notifyGpuSlotReleased() {
 void Section::adoptFrom(Section&& other) {
     m_box = std::move(other.m_box);
     m_instanceData = std::move(other.m_instanceData);
-    m_PosToInstanceIndex = std::move(other.m_PosToInstanceIndex);
+    m_faceIndex = std::move(other.m_faceIndex);
+    m_faceKeyCount = other.m_faceKeyCount;
+    other.m_faceKeyCount = 0;
     m_errerCount = other.m_errerCount;
     m_dirty = true;
     // worker 产出的整段都是新的 → 首次上传必然是全量
@@ -214,12 +422,20 @@ void Section::adoptFrom(Section&& other) {
 void Section::readAllBlocks(std::vector<BlockState>& out) const {
     out.resize(VOLUME);
     // 网络序列化在主线程调用；持读锁以防 worker 此刻正读同一 box 边界（读读共享，主要是规范化）。
-    std::shared_lock<std::shared_mutex> lk(m_box->mutex);
-    std::memcpy(out.data(), m_box->blocks.data(), VOLUME * sizeof(BlockState));
+    auto lk = m_box->lockShared();
+    m_box->copyTo(out.data());
 }
 
 void Section::writeAllBlocks(const std::vector<BlockState>& data) {
+    if (m_box->isShared()) m_box = m_box->cloneMutable();
     std::unique_lock<std::shared_mutex> lk(m_box->mutex);
-    std::memcpy(m_box->blocks.data(), data.data(),
-        std::min(data.size(), (size_t)VOLUME) * sizeof(BlockState));
+    if (data.size() >= (size_t)VOLUME) {
+        m_box->assign(data.data());
+        return;
+    }
+    // 不足一整段：只覆盖前缀，其余保持原值
+    BlockState merged[VOLUME];
+    m_box->copyTo(merged);
+    std::memcpy(merged, data.data(), data.size() * sizeof(BlockState));
+    m_box->assign(merged);
 }
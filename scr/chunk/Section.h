@@ -8,7 +8,6 @@
 #include <array>
 #include <memory>
 #include <vector>
-#include <unordered_map>
 #include <shared_mutex>
 
 // Section：16x16x16 的子区块。Chunk 持有 4 个 Section 沿 Y 方向堆叠。
@@ -46,11 +45,17 @@ public:
     // 越界返回 BlockState{} == (AIR, orient=0)。
     BlockState getBlock(int x, int y, int z) const;
     void       setBlock(int x, int y, int z, BlockState s);
+    // 持读锁拷出第 y 层（WIDTH×DEPTH，下标 z*WIDTH+x）。worker 读相邻 section 边界用。
+    void copyLayer(int y, BlockState* out) const;
 
     // 直接拿 raw state buffer 指针，方便 worker 端批量写入（地形生成器写入这里）。
     // 注意：不加锁。仅在「Section 尚未对外可见」的阶段（worker 构建、装载前）使用。
-    BlockState* stateData() { return m_box->blocks.data(); }
-    const BlockState* stateData() const { return m_box->blocks.data(); }
+    // box 为调色板形态时会被惰性展开成平铺数组（见 BlockBox::rawData）；只读场景优先用 getBox()->copyTo。
+    // 引用共享哨兵时先复制出私有 box（哨兵不可写）。
+    BlockState* stateData() {
+        if (m_box->isShared()) m_box = m_box->cloneMutable();
+        return m_box->rawData();
+    }
 
     // ---- BlockBox 共享数据源 ----
     // Section 不再独占一份方块数组，而是持有一个 shared_ptr<BlockBox>（数据 + 读写锁）。
@@ -63,7 +68,7 @@ public:
     size_t getInstanceCount() const { return m_instanceData.size(); }
 
     // 是否完全没有有效面（含全空气、全包裹的实心、纯被邻居挡住三种情况）。
-    bool isEmpty() const { return m_PosToInstanceIndex.empty(); }
+    bool isEmpty() const { return m_faceKeyCount == 0; }
 
     bool isDirty() const { return m_dirty; }
     void markDirty() { m_dirty = true; }
@@ -90,6 +95,13 @@ public:
     // 压缩 BLOCK_ERRER 占位面
     void compact();
 
+    // 贪心合并（greedy meshing）：把同一平面上相邻、且 blockType / textureLayer / orient
+    // 完全一致的单位面合并成矩形，宽高写进 packed 的保留位（见 InstanceData::withQuadSize）。
+    // 仅在 worker 端 Task 2 拼完四周边界面之后调用一次；之后 add/remove 仍按单位面语义工作，
+    // 碰到被合并的矩形时由 splitQuad 就地拆回单位面再处理。
+    // 面索引 m_faceIndex 仍按"每个被覆盖的格子一条"维护，多个 key 可指向同一个合并实例。
+    void mergeCoplanarFaces();
+
     // 给定局部坐标 + 面，根据当前 block 状态和给定的"邻居方块"重新计算该面是否可见。
     // 邻居方块 neighbor.type() == BLOCK_AIR 表示透空，否则不可见。
     void updateFaceWithNeighbor(int x, int y, int z, BlockFace face, BlockState neighbor);
@@ -101,7 +113,7 @@ public:
     void adoptFrom(Section&& other);
 
     // GPU slot 已被 ChunkManager 释放：抹掉所有增量状态，下次进入活跃半径时强制走全量上传。
-    // 不动 m_box / m_instanceData / m_PosToInstanceIndex —— 这些是 CPU 端方块数据与 mesh，仍然有效。
+    // 不动 m_box / m_instanceData / m_faceIndex —— 这些是 CPU 端方块数据与 mesh，仍然有效。
     void notifyGpuSlotReleased();
 
     // ── 光照数据（与 m_box 平行的独立数据源）──────────────────────
@@ -149,11 +161,16 @@ public:
 
 private:
     // section 方块数据 + 读写锁，打包在 BlockBox 里，全程只经 shared_ptr 共享（见 BlockBox.h）。
-    // Section() 构造时新建一个；adoptFrom / setBox 时换指针（锁随数据一起转移，但锁对象本身原地不动）。
-    // 玩家修改持 m_box->mutex 写锁；worker 读邻居边界持读锁；主线程内部串行读不加锁。
+    // Section() 构造时引用全空气哨兵；adoptFrom / setBox 时换指针（锁随数据一起转移，但锁对象本身原地不动）。
+    // 指向 BlockBox::sharedUniform 哨兵时，任何写入前先 cloneMutable 换成私有 box。
+    // 玩家修改持 m_box->mutex 写锁；worker 读（自身整段解码 / 邻居边界）持读锁；主线程内部串行读不加锁。
     std::shared_ptr<BlockBox> m_box;
     std::vector<InstanceData> m_instanceData;
-    std::unordered_map<BlockFaceLocKey, int> m_PosToInstanceIndex;
+    // 面 → 实例下标的稠密表：key = 格子下标 × 6 + 面（共 16³×6 = 24576 项），NO_FACE = 该面不可见。
+    // 只在第一次登记面时分配（48KB），全空气 / 全包裹的 section 不占。
+    // m_faceKeyCount = 已登记的 key 数（合并矩形每覆盖一格算一条），为 0 即 isEmpty。
+    std::unique_ptr<uint16_t[]> m_faceIndex;
+    int m_faceKeyCount = 0;
     int m_errerCount = 0;
     bool m_dirty = true;
 
@@ -183,4 +200,23 @@ private:
 
     // 内部辅助
     static int idx(int x, int y, int z) { return (y * DEPTH + z) * WIDTH + x; }
+
+    static constexpr int FACE_KEYS = VOLUME * 6;
+    static constexpr uint16_t NO_FACE = 0xFFFF;
+    static_assert(FACE_KEYS < NO_FACE, "face index must fit in uint16");
+    static int faceKey(int x, int y, int z, BlockFace face) { return idx(x, y, z) * 6 + face; }
+    // key 对应的实例下标；-1 = 无面
+    int findFace(int key) const {
+        if (!m_faceIndex) return -1;
+        uint16_t v = m_faceIndex[key];
+        return v == NO_FACE ? -1 : v;
+    }
+    // 登记 / 注销 key（维护 m_faceKeyCount；表按需分配）
+    void setFace(int key, int index);
+    void clearFace(int key);
+
+    // 把一个实例放进数组（优先复用 ERRER 空槽）并登记 key → index，返回下标
+    int placeInstance(int key, const InstanceData& d);
+    // 把 index 处的合并矩形拆回单位面：锚点格原地改写，其余格子逐个 placeInstance
+    void splitQuad(int index);
 };
@@ -0,0 +1,22 @@
+﻿#pragma once
+#include <cstdint>
+
+// section 键：(chunkX, chunkZ, sectionY) 打包成 64 bit，光照缓存 / SSBO 槽位 / GPU slot 等按 section 索引的表共用。
+// 布局：[63..32] chunkX 低 24 位 | [31..8] chunkZ 低 24 位 | [7..0] sectionY。
+// 单独成头，worker（重光照）与 ChunkManager 共用同一套编解码，不必为此 include 整个 ChunkManager。
+using SectionKey = uint64_t;
+
+inline SectionKey packSectionKey(int chunkX, int chunkZ, int sectionY) {
+    uint64_t ux = (uint32_t)chunkX & 0xFFFFFFu;
+    uint64_t uz = (uint32_t)chunkZ & 0xFFFFFFu;
+    uint64_t uy = (uint32_t)sectionY & 0xFFu;
+    return (ux << 32) | (uz << 8) | uy;
+}
+
+// packSectionKey 的逆：chunk 坐标按 24 位有符号数还原
+inline void unpackSectionKey(SectionKey key, int& chunkX, int& chunkZ, int& sectionY) {
+    auto sext24 = [](uint32_t v) { return (v & 0x800000u) ? int(v | 0xFF000000u) : int(v); };
+    chunkX = sext24(uint32_t((key >> 32) & 0xFFFFFFu));
+    chunkZ = sext24(uint32_t((key >> 8) & 0xFFFFFFu));
+    sectionY = int(key & 0xFFu);
+}
@@ -0,0 +1,21 @@
+﻿#include "WorldView.h"
+#include "ChunkManager.h"
+
+const WorldView::Entry* WorldView::resolve(int cx, int cz) {
+    for (Entry& e : m_entries) {
+        if (e.used && e.cx == cx && e.cz == cz) {
+            m_last = &e;
+            return e.present ? &e : nullptr;
+        }
+    }
+
+    Entry& e = m_entries[m_nextSlot];
+    m_nextSlot = (m_nextSlot + 1) % CACHE_SLOTS;
+    e.cx = cx;
+    e.cz = cz;
+    e.used = true;
+    e.present = m_cm.getChunkBoxes(glm::ivec2(cx, cz), e.boxes, m_source == ANY_STATE);
+    if (!e.present) e.boxes = ChunkBoxes{};
+    m_last = &e;
+    return e.present ? &e : nullptr;
+}
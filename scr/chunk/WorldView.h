@@ -0,0 +1,105 @@
+﻿#pragma once
+#include "BlockBox.h"
+#include "BlockType.h"
+#include "ChunkDimensions.h"
+#include <glm/glm.hpp>
+
+class ChunkManager;
+
+// ── 主线程方块只读视图（物理 / 射线 / 掉落物模拟用）─────────────────────
+// ChunkManager::getBlockAt 每次查询都要 float floor 除法 + 最多两次 unordered_map 查找；
+// 碰撞检测每 tick 对 AABB 覆盖的每个格子都调一次，开销正比于体素数而不是实体数。
+//
+// WorldView 把用到的 chunk 的 ChunkBoxes 解析一次后缓存在小数组里（shared_ptr 保活），
+// 同一 chunk 连续查询只比较一次坐标（last-chunk 命中），坐标拆分全用整数移位/掩码。
+// 未加载的 chunk 也缓存（负缓存），边界外反复查询不会重新哈希。
+//
+// 约束：只在主线程、短生命周期内使用（一次物理更新 / 一次射线检测建一个）。
+// 视图存活期间不要改方块 —— 写时复制会替换 section 的 box，视图里拿的仍是旧的。
+//
+// 用法：
+//   WorldView view(chunkManager);
+//   if (view.anySolid(minBlock, maxBlock)) ...
+//   BlockState s = view.get(x, y, z);
+class WorldView {
+public:
+    enum Source {
+        ANY_STATE,       // LOADED + BLOCK_READY（同 getBlockAt，碰撞需要 block-ready 的方块）
+        LOADED_ONLY,     // 只看已有 mesh 的 chunk（同 getChunk，射线选中不应命中看不见的方块）
+    };
+
+    explicit WorldView(ChunkManager& cm, Source source = ANY_STATE)
+        : m_cm(cm), m_source(source) {}
+    // m_last 指向自身缓存槽，禁止拷贝
+    WorldView(const WorldView&) = delete;
+    WorldView& operator=(const WorldView&) = delete;
+
+    BlockState get(int x, int y, int z) {
+        if ((unsigned)y >= (unsigned)ChunkConstants::CHUNK_HEIGHT) return BlockState{};
+        const Entry* e = lookup(x >> 4, z >> 4);
+        if (!e) return BlockState{};
+        const BlockBox* box = e->boxes[y >> 4].get();
+        if (!box) return BlockState{};
+        return box->get(((y & 15) * ChunkConstants::CHUNK_DEPTH + (z & 15)) * ChunkConstants::CHUNK_WIDTH + (x & 15));
+    }
+    BlockState get(const glm::ivec3& p) { return get(p.x, p.y, p.z); }
+
+    bool isSolid(int x, int y, int z) {
+        BlockType t = get(x, y, z).type();
+        return t != BLOCK_AIR && GetBlockProperties(t).isSolid;
+    }
+
+    // ── AABB 范围查询（闭区间方块坐标，遍历顺序 x → y → z，与原三重循环一致）──
+    bool anyNonAir(const glm::ivec3& minBlock, const glm::ivec3& maxBlock) {
+        bool hit = false;
+        forEachNonAir(minBlock, maxBlock, [&](const glm::ivec3&, BlockState) { hit = true; return false; });
+        return hit;
+    }
+    bool anySolid(const glm::ivec3& minBlock, const glm::ivec3& maxBlock) {
+        bool hit = false;
+        forEachNonAir(minBlock, maxBlock, [&](const glm::ivec3&, BlockState s) {
+            if (!GetBlockProperties(s.type()).isSolid) return true;
+            hit = true;
+            return false;
+        });
+        return hit;
+    }
+    // fn(pos, state) 返回 false 提前结束。y 先夹到世界高度内，整列都在界外直接跳过。
+    template <class Fn>
+    void forEachNonAir(const glm::ivec3& minBlock, const glm::ivec3& maxBlock, Fn&& fn) {
+        const int y0 = minBlock.y < 0 ? 0 : minBlock.y;
+        const int y1 = maxBlock.y >= ChunkConstants::CHUNK_HEIGHT ? ChunkConstants::CHUNK_HEIGHT - 1 : maxBlock.y;
+        if (y0 > y1) return;
+        for (int x = minBlock.x; x <= maxBlock.x; ++x) {
+            for (int y = y0; y <= y1; ++y) {
+                for (int z = minBlock.z; z <= maxBlock.z; ++z) {
+                    BlockState s = get(x, y, z);
+                    if (s.type() == BLOCK_AIR) continue;
+                    if (!fn(glm::ivec3(x, y, z), s)) return;
+                }
+            }
+        }
+    }
+
+private:
+    struct Entry {
+        int cx = 0, cz = 0;
+        bool used = false;       // 槽位是否已填
+        bool present = false;    // chunk 是否存在（false = 负缓存）
+        ChunkBoxes boxes;
+    };
+    // 3×3 邻域足够覆盖玩家/掉落物的 AABB 与 8 格射线；满了按轮转覆盖
+    static constexpr int CACHE_SLOTS = 9;
+
+    const Entry* lookup(int cx, int cz) {
+        if (m_last && m_last->cx == cx && m_last->cz == cz) return m_last->present ? m_last : nullptr;
+        return resolve(cx, cz);
+    }
+    const Entry* resolve(int cx, int cz);
+
+    ChunkManager& m_cm;
+    Source m_source;
+    Entry m_entries[CACHE_SLOTS];
+    Entry* m_last = nullptr;
+    int m_nextSlot = 0;
+};
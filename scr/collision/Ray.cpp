@@ -2,6 +2,7 @@
 #include "Ray.h"
 #include "../chunk/ChunkManager.h"
 #include "../chunk/Chunk.h"
+#include "../chunk/WorldView.h"
 #include <iostream>
 #include <limits>
 #include <cmath>
@@ -44,6 +45,9 @@ bool Ray::ddaCast(ChunkManager* chunkManager, HitResult& result, float maxDistan
     // 1. 重要：对起点进行微小偏移，避免精度问题
     glm::vec3 origin = m_origin;
 
+    // 沿途方块查询走区块缓存，避免每一步都查 ChunkManager 的哈希表
+    WorldView view(*chunkManager, WorldView::LOADED_ONLY);
+
     // 2. 确定当前方块坐标（向下取整）
     glm::ivec3 currentBlock(
         static_cast<int>(std::floor(origin.x)),
@@ -111,24 +115,8 @@ bool Ray::ddaCast(ChunkManager* chunkManager, HitResult& result, float maxDistan
             break;
         }
 
-        // 6. 检查当前方块
-        // 获取区块位置
-        glm::ivec2 chunkPos(
-            static_cast<int>(std::floor(static_cast<float>(currentBlock.x) / Chunk::WIDTH)),
-            static_cast<int>(std::floor(static_cast<float>(currentBlock.z) / Chunk::DEPTH))
-        );
-
-        Chunk* chunk = chunkManager->getChunk(chunkPos);
-        if (!chunk) {
-            // 区块未加载，跳过
-            continue;
-        }
-
-        // 获取局部坐标
-        glm::ivec3 localPos = worldToLocal(currentBlock);
-
-        // 获取方块状态（含朝向）
-        BlockState blockState = chunk->getBlock(localPos.x, localPos.y, localPos.z);
+        // 6. 检查当前方块（未加载区块视为空气，射线直接穿过）
+        BlockState blockState = view.get(currentBlock);
 
         // 跳过空气方块
         if (blockState.type() == BLOCK_AIR) {
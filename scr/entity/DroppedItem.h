@@ -1,6 +1,8 @@
 ﻿#pragma once
 #include "../core.h"
 #include "../item/ItemStack.h"
+#include <vector>
+#include <cstdint>
 
 // ── 掉落物实体 ──────────────────────────────────────────────────
 // 世界里的一个掉落物：一个物品栈 + 位置 / 速度 + 动画状态。
@@ -16,3 +18,68 @@ struct DroppedItem {
     bool  onGround = false;
     uint16_t netId = 0;        // 网络 id（服务端分配；0 = 单机/未联网）
 };
+
+// ── 掉落物存储（按字段分列，SoA）─────────────────────────────────
+// 物理只扫 pos/vel，合并/吸引只扫 pos/stack，渲染/同步各取所需，
+// 数万个掉落物时比整块 DroppedItem 数组缓存友好得多。
+// 删除用 swap-remove，各列保持紧凑 —— 下标不稳定，跨帧引用一律用 netId。
+struct DroppedItemStore {
+    std::vector<ItemStack> stack;
+    std::vector<glm::vec3> pos;
+    std::vector<glm::vec3> vel;
+    std::vector<float>     age;
+    std::vector<float>     spin;
+    std::vector<float>     bob;
+    std::vector<float>     pickupDelay;
+    std::vector<uint8_t>   onGround;
+    std::vector<uint16_t>  netId;
+
+    size_t size() const { return pos.size(); }
+    bool empty() const { return pos.empty(); }
+
+    void push(const DroppedItem& it) {
+        stack.push_back(it.stack);
+        pos.push_back(it.pos);
+        vel.push_back(it.vel);
+        age.push_back(it.age);
+        spin.push_back(it.spin);
+        bob.push_back(it.bob);
+        pickupDelay.push_back(it.pickupDelay);
+        onGround.push_back(it.onGround ? 1 : 0);
+        netId.push_back(it.netId);
+    }
+
+    // 末尾元素搬到 i 并缩短一格（i 为末尾时只是 pop）
+    void swapRemove(size_t i) {
+        size_t last = size() - 1;
+        if (i != last) {
+            stack[i] = stack[last];
+            pos[i] = pos[last];
+            vel[i] = vel[last];
+            age[i] = age[last];
+            spin[i] = spin[last];
+            bob[i] = bob[last];
+            pickupDelay[i] = pickupDelay[last];
+            onGround[i] = onGround[last];
+            netId[i] = netId[last];
+        }
+        stack.pop_back(); pos.pop_back(); vel.pop_back();
+        age.pop_back(); spin.pop_back(); bob.pop_back();
+        pickupDelay.pop_back(); onGround.pop_back(); netId.pop_back();
+    }
+
+    // 拼回一个完整实体（生成回调等低频路径用）
+    DroppedItem get(size_t i) const {
+        DroppedItem it;
+        it.stack = stack[i];
+        it.pos = pos[i];
+        it.vel = vel[i];
+        it.age = age[i];
+        it.spin = spin[i];
+        it.bob = bob[i];
+        it.pickupDelay = pickupDelay[i];
+        it.onGround = onGround[i] != 0;
+        it.netId = netId[i];
+        return it;
+    }
+};
@@ -1,9 +1,11 @@
 ﻿#include "DroppedItemManager.h"
 #include "../chunk/ChunkManager.h"
+#include "../chunk/WorldView.h"
 #include "../chunk/BlockType.h"
 #include "../Player.h"
 #include <glm/gtc/matrix_transform.hpp>
 #include <cmath>
+#include <algorithm>
 
 namespace {
     const float GRAVITY       = 20.0f;
@@ -27,67 +29,122 @@ void DroppedItemManager::spawn(const ItemStack& stack, const glm::vec3& pos, con
     it.pos = pos;
     it.vel = vel;
     it.netId = m_nextNetId++;
-    m_items.push_back(it);
-    if (m_onSpawn) m_onSpawn(m_items.back());  // 服务端广播 SPAWN
+    addItem(it);
+    if (m_onSpawn) m_onSpawn(it);
 }
 
-DroppedItem* DroppedItemManager::findByNetId(uint16_t netId) {
-    for (auto& it : m_items) if (it.netId == netId) return &it;
-    return nullptr;
+int DroppedItemManager::findByNetId(uint16_t netId) const {
+    auto f = m_netIndex.find(netId);
+    return f == m_netIndex.end() ? -1 : (int)f->second;
+}
+
+void DroppedItemManager::addItem(const DroppedItem& it) {
+    m_netIndex[it.netId] = (uint32_t)m_items.size();
+    m_items.push(it);
+}
+
+void DroppedItemManager::removeAt(size_t i) {
+    size_t last = m_items.size() - 1;
+    auto f = m_netIndex.find(m_items.netId[i]);
+    if (f != m_netIndex.end() && f->second == (uint32_t)i) m_netIndex.erase(f);
+    if (i != last) m_netIndex[m_items.netId[last]] = (uint32_t)i;
+    m_items.swapRemove(i);
 }
 
 void DroppedItemManager::updateClientVisual(float dt) {
     const float rotSpeed = 1.5f;
-    for (auto& it : m_items) {
-        it.spin += rotSpeed * dt;
-        it.bob += dt;
+    for (size_t i = 0; i < m_items.size(); ++i) {
+        m_items.spin[i] += rotSpeed * dt;
+        m_items.bob[i] += dt;
     }
 }
 
 void DroppedItemManager::netSpawn(uint16_t netId, const ItemStack& stack, const glm::vec3& pos) {
-    if (DroppedItem* ex = findByNetId(netId)) { ex->stack = stack; ex->pos = pos; return; }
+    int ex = findByNetId(netId);
+    if (ex >= 0) { m_items.stack[ex] = stack; m_items.pos[ex] = pos; return; }
     DroppedItem it;
     it.stack = stack;
     it.pos = pos;
     it.netId = netId;
     it.pickupDelay = 0.0f;
-    m_items.push_back(it);
+    addItem(it);
 }
 
-void DroppedItemManager::netApply(uint16_t netId, const glm::vec3& pos, int count) {
-    DroppedItem* it = findByNetId(netId);
-    if (!it) return;
-    it->pos = pos;
-    if (count > 0) it->stack.count = count;
+bool DroppedItemManager::netApply(uint16_t netId, const glm::vec3* pos, int count) {
+    int i = findByNetId(netId);
+    if (i < 0) return false;
+    if (pos) m_items.pos[i] = *pos;
+    if (count > 0) m_items.stack[i].count = count;
+    return true;
 }
 
 void DroppedItemManager::netDespawn(uint16_t netId) {
-    m_items.erase(
-        std::remove_if(m_items.begin(), m_items.end(),
-            [netId](const DroppedItem& it) { return it.netId == netId; }),
-        m_items.end());
-}
-
-bool DroppedItemManager::boxHitsSolid(ChunkManager& cm, const glm::vec3& c, float half) const {
-    int minX = (int)std::floor(c.x - half), maxX = (int)std::floor(c.x + half);
-    int minY = (int)std::floor(c.y - half), maxY = (int)std::floor(c.y + half);
-    int minZ = (int)std::floor(c.z - half), maxZ = (int)std::floor(c.z + half);
-    for (int x = minX; x <= maxX; ++x)
-        for (int y = minY; y <= maxY; ++y)
-            for (int z = minZ; z <= maxZ; ++z) {
-                BlockState b = cm.getBlockAt(glm::ivec3(x, y, z));
-                if (b.type() != BLOCK_AIR && GetBlockProperties(b.type()).isSolid)
-                    return true;
+    int i = findByNetId(netId);
+    if (i >= 0) removeAt((size_t)i);
+}
+
+// ==================== 空间哈希 ====================
+
+uint32_t DroppedItemManager::SpatialGrid::bucketOf(const glm::ivec3& c) const {
+    uint32_t h = (uint32_t)c.x * 73856093u ^ (uint32_t)c.y * 19349663u ^ (uint32_t)c.z * 83492791u;
+    return h & mask;
+}
+
+void DroppedItemManager::SpatialGrid::build(const std::vector<glm::vec3>& pos, float cell) {
+    cellSize = cell;
+    const size_t n = pos.size();
+    // 桶数取 ≥ 2n 的 2 的幂：平均每桶不到一个格子，冲突少
+    uint32_t buckets = 16;
+    while (buckets < n * 2) buckets <<= 1;
+    mask = buckets - 1;
+
+    const float inv = 1.0f / cellSize;
+    cellOf.resize(n);
+    cellStart.assign(buckets + 1, 0);
+    for (size_t i = 0; i < n; ++i) {
+        cellOf[i] = glm::ivec3(glm::floor(pos[i] * inv));
+        ++cellStart[bucketOf(cellOf[i]) + 1];
+    }
+    for (uint32_t b = 0; b < buckets; ++b) cellStart[b + 1] += cellStart[b];
+
+    // 计数排序：cursor 从各桶起点往后填
+    sorted.resize(n);
+    std::vector<uint32_t> cursor(cellStart.begin(), cellStart.end() - 1);
+    for (size_t i = 0; i < n; ++i) sorted[cursor[bucketOf(cellOf[i])]++] = (uint32_t)i;
+}
+
+template <class Fn>
+void DroppedItemManager::SpatialGrid::forEachNear(const glm::vec3& p, float r, Fn&& fn) const {
+    if (sorted.empty()) return;
+    const float inv = 1.0f / cellSize;
+    glm::ivec3 lo(glm::floor((p - r) * inv));
+    glm::ivec3 hi(glm::floor((p + r) * inv));
+    for (int cx = lo.x; cx <= hi.x; ++cx)
+        for (int cy = lo.y; cy <= hi.y; ++cy)
+            for (int cz = lo.z; cz <= hi.z; ++cz) {
+                glm::ivec3 c(cx, cy, cz);
+                uint32_t b = bucketOf(c);
+                for (uint32_t k = cellStart[b]; k < cellStart[b + 1]; ++k) {
+                    uint32_t j = sorted[k];
+                    if (cellOf[j] == c) fn(j);  // 同桶不同格的跳过，保证每项只访问一次
+                }
             }
-    return false;
 }
 
-bool DroppedItemManager::moveAxis(ChunkManager& cm, DroppedItem& it, int axis, float delta, float half) {
+// ==================== 模拟 ====================
+
+bool DroppedItemManager::boxHitsSolid(WorldView& view, const glm::vec3& c, float half) const {
+    glm::ivec3 minB((int)std::floor(c.x - half), (int)std::floor(c.y - half), (int)std::floor(c.z - half));
+    glm::ivec3 maxB((int)std::floor(c.x + half), (int)std::floor(c.y + half), (int)std::floor(c.z + half));
+    return view.anySolid(minB, maxB);
+}
+
+bool DroppedItemManager::moveAxis(WorldView& view, glm::vec3& pos, int axis, float delta, float half) {
     if (delta == 0.0f) return false;
-    glm::vec3 np = it.pos;
+    glm::vec3 np = pos;
     np[axis] += delta;
-    if (boxHitsSolid(cm, np, half)) return true; // 碰撞：不移动
-    it.pos = np;
+    if (boxHitsSolid(view, np, half)) return true; // 碰撞：不移动
+    pos = np;
     return false;
 }
 
@@ -97,92 +154,114 @@ void DroppedItemManager::update(float dt, ChunkManager& chunkManager, Player& pl
 
     const float rotSpeed = 1.5f;
     glm::vec3 pc = player.getPosition();
+    const size_t n = m_items.size();
 
     // 同类掉落物相互吸引：让在途的同种物品先聚拢，从而更容易堆叠合并。
-    // 只影响水平速度（保持重力自然下落），且未满栈才吸引。
-    for (size_t i = 0; i < m_items.size(); ++i) {
-        DroppedItem& a = m_items[i];
-        if (a.stack.empty() || a.stack.count >= a.stack.maxStack()) continue;
-        for (size_t j = i + 1; j < m_items.size(); ++j) {
-            DroppedItem& b = m_items[j];
-            if (b.stack.empty() || !a.stack.sameItem(b.stack)) continue;
-            glm::vec3 d = b.pos - a.pos;
-            float dist = glm::length(d);
-            if (dist < 1e-4f || dist > ATTRACT_RANGE) continue;
-            glm::vec3 dir = d / dist;
-            float pull = ATTRACT_ACCEL * dt;
-            a.vel.x += dir.x * pull;  a.vel.z += dir.z * pull;
-            b.vel.x -= dir.x * pull;  b.vel.z -= dir.z * pull;
-        }
-    }
+    m_grid.build(m_items.pos, ATTRACT_RANGE);
+    attractNearby(dt);
+
+    // 所有掉落物共用一个 WorldView：物品通常扎堆在少数几个区块里
+    WorldView view(chunkManager);
+    for (size_t i = 0; i < n; ++i) {
+        m_items.age[i] += dt;
+        m_items.spin[i] += rotSpeed * dt;
+        m_items.bob[i] += dt;
+        if (m_items.pickupDelay[i] > 0.0f) m_items.pickupDelay[i] -= dt;
 
-    for (auto& it : m_items) {
-        it.age += dt;
-        it.spin += rotSpeed * dt;
-        it.bob += dt;
-        if (it.pickupDelay > 0.0f) it.pickupDelay -= dt;
+        glm::vec3& pos = m_items.pos[i];
+        glm::vec3& vel = m_items.vel[i];
 
         // 重力
-        it.vel.y -= GRAVITY * dt;
-        if (it.vel.y < -MAX_FALL) it.vel.y = -MAX_FALL;
+        vel.y -= GRAVITY * dt;
+        if (vel.y < -MAX_FALL) vel.y = -MAX_FALL;
 
         // 垂直移动 + 落地判定
-        bool hitY = moveAxis(chunkManager, it, 1, it.vel.y * dt, ITEM_HALF);
+        bool hitY = moveAxis(view, pos, 1, vel.y * dt, ITEM_HALF);
         if (hitY) {
-            it.onGround = (it.vel.y < 0.0f);
-            it.vel.y = 0.0f;
+            m_items.onGround[i] = (vel.y < 0.0f) ? 1 : 0;
+            vel.y = 0.0f;
         } else {
-            it.onGround = false;
+            m_items.onGround[i] = 0;
         }
 
         // 水平移动
-        moveAxis(chunkManager, it, 0, it.vel.x * dt, ITEM_HALF);
-        moveAxis(chunkManager, it, 2, it.vel.z * dt, ITEM_HALF);
+        moveAxis(view, pos, 0, vel.x * dt, ITEM_HALF);
+        moveAxis(view, pos, 2, vel.z * dt, ITEM_HALF);
 
         // 阻尼（落地强、空中弱），帧率无关
-        float damp = it.onGround ? 10.0f : 1.0f;
+        float damp = m_items.onGround[i] ? 10.0f : 1.0f;
         float f = std::exp(-damp * dt);
-        it.vel.x *= f;
-        it.vel.z *= f;
+        vel.x *= f;
+        vel.z *= f;
     }
 
-    // 邻近同类合并
+    // 邻近同类合并（位置已更新，按合并距离重建网格；拾取复用这张网格）
+    m_grid.build(m_items.pos, MERGE_RANGE);
     mergeNearby();
 
-    // 拾取 + 清理
-    for (auto& it : m_items) {
-        if (it.pickupDelay <= 0.0f && !it.stack.empty()) {
-            if (glm::distance(it.pos, pc) < PICKUP_RANGE) {
-                player.addToInventory(it.stack); // 就地减少；余量留在掉落物里
-            }
-        }
+    // 拾取：只看玩家周围格子里的掉落物
+    const float pickupSq = PICKUP_RANGE * PICKUP_RANGE;
+    m_grid.forEachNear(pc, PICKUP_RANGE, [&](uint32_t i) {
+        ItemStack& st = m_items.stack[i];
+        if (m_items.pickupDelay[i] > 0.0f || st.empty()) return;
+        glm::vec3 d = m_items.pos[i] - pc;
+        if (glm::dot(d, d) < pickupSq)
+            player.addToInventory(st); // 就地减少；余量留在掉落物里
+    });
+
+    // 移除已被完全拾取 / 掉出世界的项；服务端在移除前通知 onDespawn 广播 DESTROY。
+    // 倒序 swap-remove：搬进来的末尾元素已经检查过。
+    for (size_t i = m_items.size(); i-- > 0;) {
+        bool gone = m_items.stack[i].empty() || m_items.pos[i].y < -64.0f;
+        if (!gone) continue;
+        if (m_onDespawn && m_items.netId[i] != 0) m_onDespawn(m_items.netId[i]);
+        removeAt(i);
     }
+}
 
-    // 移除已被完全拾取 / 掉出世界的项；服务端在移除前通知 onDespawn 广播 DESTROY
-    m_items.erase(
-        std::remove_if(m_items.begin(), m_items.end(),
-            [this](const DroppedItem& it) {
-                bool gone = it.stack.empty() || it.pos.y < -64.0f;
-                if (gone && m_onDespawn && it.netId != 0) m_onDespawn(it.netId);
-                return gone;
-            }),
-        m_items.end());
+void DroppedItemManager::attractNearby(float dt) {
+    // 只影响水平速度（保持重力自然下落），且未满栈才吸引。每对 (i<j) 只算一次。
+    const float pull = ATTRACT_ACCEL * dt;
+    const float rangeSq = ATTRACT_RANGE * ATTRACT_RANGE;
+    for (uint32_t i = 0; i < (uint32_t)m_items.size(); ++i) {
+        const ItemStack& a = m_items.stack[i];
+        if (a.empty() || a.count >= a.maxStack()) continue;
+        const glm::vec3 pa = m_items.pos[i];
+        m_grid.forEachNear(pa, ATTRACT_RANGE, [&](uint32_t j) {
+            if (j <= i) return;
+            const ItemStack& b = m_items.stack[j];
+            if (b.empty() || !a.sameItem(b)) return;
+            glm::vec3 d = m_items.pos[j] - pa;
+            float distSq = glm::dot(d, d);
+            if (distSq < 1e-8f || distSq > rangeSq) return;
+            glm::vec3 dir = d / std::sqrt(distSq);
+            glm::vec3& va = m_items.vel[i];
+            glm::vec3& vb = m_items.vel[j];
+            va.x += dir.x * pull;  va.z += dir.z * pull;
+            vb.x -= dir.x * pull;  vb.z -= dir.z * pull;
+        });
+    }
 }
 
 void DroppedItemManager::mergeNearby() {
-    for (size_t i = 0; i < m_items.size(); ++i) {
-        if (m_items[i].stack.empty()) continue;
-        for (size_t j = i + 1; j < m_items.size(); ++j) {
-            DroppedItem& a = m_items[i];
-            DroppedItem& b = m_items[j];
-            if (b.stack.empty() || !a.stack.sameItem(b.stack)) continue;
-            if (glm::distance(a.pos, b.pos) > MERGE_RANGE) continue;
-            int space = a.stack.maxStack() - a.stack.count;
-            if (space <= 0) continue;
-            int move = std::min(space, b.stack.count);
-            a.stack.count += move;
-            b.stack.count -= move;
-            if (b.stack.count <= 0) b.stack.clear();
-        }
+    // 下标小的吸收下标大的（与原先两两遍历的方向一致）
+    const float rangeSq = MERGE_RANGE * MERGE_RANGE;
+    for (uint32_t i = 0; i < (uint32_t)m_items.size(); ++i) {
+        if (m_items.stack[i].empty()) continue;
+        const glm::vec3 pa = m_items.pos[i];
+        m_grid.forEachNear(pa, MERGE_RANGE, [&](uint32_t j) {
+            if (j <= i) return;
+            ItemStack& a = m_items.stack[i];
+            ItemStack& b = m_items.stack[j];
+            if (b.empty() || !a.sameItem(b)) return;
+            glm::vec3 d = m_items.pos[j] - pa;
+            if (glm::dot(d, d) > rangeSq) return;
+            int space = a.maxStack() - a.count;
+            if (space <= 0) return;
+            int move = std::min(space, b.count);
+            a.count += move;
+            b.count -= move;
+            if (b.count <= 0) b.clear();
+        });
     }
 }
@@ -1,10 +1,12 @@
 ﻿#pragma once
 #include "DroppedItem.h"
 #include <vector>
+#include <unordered_map>
 #include <functional>
 #include <cstdint>
 
 class ChunkManager;
+class WorldView;
 class Player;
 
 // ── 掉落物管理器 ────────────────────────────────────────────────
@@ -14,6 +16,9 @@ class Player;
 // 联机（需求 3）：服务端权威模拟——生成/销毁经回调广播给客户端，位置由 World 定时
 // 批量同步。客户端置 clientMode：不跑物理/拾取，只播动画，实体由网络 spawn/despawn/同步
 // 驱动；客户端本地的丢弃/破坏改为向服务端发「生成请求」（onDropRequest）。
+//
+// 规模：数据按列存（DroppedItemStore），邻近查询（吸引/合并/拾取）走每帧重建的均匀网格
+// 空间哈希，netId → 下标用哈希表，整体近线性，可撑住数万个掉落物（刷怪塔/大量破坏）。
 class DroppedItemManager {
 public:
     // 生成一个掉落物（stack 拷贝进来）。pos 为世界坐标，vel 为初速度。
@@ -25,14 +30,14 @@ public:
     // clientMode 下退化为只播动画（updateClientVisual）。
     void update(float dt, ChunkManager& chunkManager, Player& player);
 
-    const std::vector<DroppedItem>& items() const { return m_items; }
+    const DroppedItemStore& items() const { return m_items; }
     size_t count() const { return m_items.size(); }
 
     // ---- 联机 ----
     void setClientMode(bool v) { m_clientMode = v; }
     bool isClientMode() const { return m_clientMode; }
 
-    // 服务端：生成/销毁回调（World 用来广播 SPAWN/DESTROY）
+    // 服务端：生成/销毁回调（World 用来广播 DESTROY；SPAWN 由 NetDroppedSync 按兴趣范围单发，onSpawn 可为空）
     void setServerCallbacks(std::function<void(const DroppedItem&)> onSpawn,
                             std::function<void(uint16_t)> onDespawn) {
         m_onSpawn = std::move(onSpawn);
@@ -46,11 +51,29 @@ public:
 
     // 客户端：网络驱动的实体生命周期
     void netSpawn(uint16_t netId, const ItemStack& stack, const glm::vec3& pos);
-    void netApply(uint16_t netId, const glm::vec3& pos, int count);  // 位置/数量同步
+    // 位置/数量同步：pos 为空 = 位置不变，count <= 0 = 数量不变。本地没有该 item 返回 false
+    bool netApply(uint16_t netId, const glm::vec3* pos, int count);
     void netDespawn(uint16_t netId);
 
 private:
-    std::vector<DroppedItem> m_items;
+    // 均匀网格空间哈希：build 时按格子哈希做一次计数排序（O(n)），
+    // 查询只遍历半径覆盖的格子。格子坐标随 item 记下，用来过滤哈希桶冲突。
+    struct SpatialGrid {
+        float cellSize = 1.0f;
+        uint32_t mask = 0;
+        std::vector<uint32_t>   cellStart;  // 桶 → sorted 中的起点（mask + 2 项）
+        std::vector<uint32_t>   sorted;     // 按桶排好的 item 下标
+        std::vector<glm::ivec3> cellOf;     // item → 所在格子
+
+        void build(const std::vector<glm::vec3>& pos, float cell);
+        // fn(index)：对所有可能落在 p 周围 r 内的 item 调用一次（调用方再做精确距离判断）
+        template <class Fn> void forEachNear(const glm::vec3& p, float r, Fn&& fn) const;
+        uint32_t bucketOf(const glm::ivec3& c) const;
+    };
+
+    DroppedItemStore m_items;
+    std::unordered_map<uint16_t, uint32_t> m_netIndex;  // netId → m_items 下标
+    SpatialGrid m_grid;
 
     bool m_clientMode = false;
     uint16_t m_nextNetId = 0x1000;  // = NetConstants::DROPPED_ITEM_NETID_BASE
@@ -58,15 +81,21 @@ private:
     std::function<void(uint16_t)> m_onDespawn;
     std::function<void(const ItemStack&, const glm::vec3&, const glm::vec3&)> m_onDropRequest;
 
-    DroppedItem* findByNetId(uint16_t netId);
+    // netId → 下标；找不到返回 -1
+    int findByNetId(uint16_t netId) const;
+    void addItem(const DroppedItem& it);
+    // swap-remove，同时修正被搬动那一项的 netId 索引
+    void removeAt(size_t i);
 
     // 客户端：只推进动画（旋转/浮动），不做物理/拾取
     void updateClientVisual(float dt);
 
     // item 小盒是否与实体方块相交（half = 半边长）
-    bool boxHitsSolid(ChunkManager& cm, const glm::vec3& center, float half) const;
+    bool boxHitsSolid(WorldView& view, const glm::vec3& center, float half) const;
     // 沿单轴移动并做碰撞：碰撞则不移动并返回 true
-    bool moveAxis(ChunkManager& cm, DroppedItem& it, int axis, float delta, float half);
-    // 邻近同类掉落物合并
+    bool moveAxis(WorldView& view, glm::vec3& pos, int axis, float delta, float half);
+    // 同类掉落物相互吸引（m_grid 须按 ATTRACT_RANGE 建好）
+    void attractNearby(float dt);
+    // 邻近同类掉落物合并（m_grid 须按 MERGE_RANGE 建好）
     void mergeNearby();
 };
@@ -2,6 +2,16 @@
 #include "Noise.h"
 #include <glm/glm.hpp>
 #include <glm/gtc/noise.hpp>
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+    #define NOISE_GRID_AVX2 1
+#elif defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define NOISE_GRID_SSE2 1
+#endif
 
 // 将 64-bit 种子展开为坐标偏移，使不同种子采样噪声场中完全不同的区域
 static inline float seedToOffset(uint64_t seed, int slot) {
@@ -76,3 +86,200 @@ float Noise::valueNoise2D(float x, float y, uint64_t seed) {
     float b = v01 + sx * (v11 - v01);
     return a + sy * (b - a);
 }
+
+
+// ============================================================================
+// 批量网格求值
+// ============================================================================
+
+namespace {
+
+// 通道抽象：同一份 perlin 内核按 N 路并行实例化。只用到四则运算 / floor / abs，
+// 全部是逐元素 IEEE 运算，与标量 glm 路径舍入一致。
+#if defined(NOISE_GRID_AVX2)
+struct Lanes {
+    using V = __m256;
+    static constexpr int N = 8;
+    static V set1(float f) { return _mm256_set1_ps(f); }
+    static V load(const float* p) { return _mm256_loadu_ps(p); }
+    static void store(float* p, V v) { _mm256_storeu_ps(p, v); }
+    static V add(V a, V b) { return _mm256_add_ps(a, b); }
+    static V sub(V a, V b) { return _mm256_sub_ps(a, b); }
+    static V mul(V a, V b) { return _mm256_mul_ps(a, b); }
+    static V div(V a, V b) { return _mm256_div_ps(a, b); }
+    static V floor(V x) { return _mm256_floor_ps(x); }
+    static V abs(V x) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), x); }
+};
+#elif defined(NOISE_GRID_SSE2)
+struct Lanes {
+    using V = __m128;
+    static constexpr int N = 4;
+    static V set1(float f) { return _mm_set1_ps(f); }
+    static V load(const float* p) { return _mm_loadu_ps(p); }
+    static void store(float* p, V v) { _mm_storeu_ps(p, v); }
+    static V add(V a, V b) { return _mm_add_ps(a, b); }
+    static V sub(V a, V b) { return _mm_sub_ps(a, b); }
+    static V mul(V a, V b) { return _mm_mul_ps(a, b); }
+    static V div(V a, V b) { return _mm_div_ps(a, b); }
+    // SSE2 没有 roundps：截断后对负数非整数回退 1。噪声坐标远小于 2^31，截断不会溢出。
+    static V floor(V x) {
+        V t = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+        return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, x), _mm_set1_ps(1.0f)));
+    }
+    static V abs(V x) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), x); }
+};
+#else
+struct Lanes {
+    using V = float;
+    static constexpr int N = 1;
+    static V set1(float f) { return f; }
+    static V load(const float* p) { return *p; }
+    static void store(float* p, V v) { *p = v; }
+    static V add(V a, V b) { return a + b; }
+    static V sub(V a, V b) { return a - b; }
+    static V mul(V a, V b) { return a * b; }
+    static V div(V a, V b) { return a / b; }
+    static V floor(V x) { return std::floor(x); }
+    static V abs(V x) { return std::fabs(x); }
+};
+#endif
+
+using V = Lanes::V;
+
+// glm detail::mod289 / permute / taylorInvSqrt / fade 的通道版，运算顺序照抄
+inline V mod289(V x) {
+    return Lanes::sub(x, Lanes::mul(Lanes::floor(Lanes::mul(x, Lanes::set1(1.0f / 289.0f))),
+                                    Lanes::set1(289.0f)));
+}
+inline V permute(V x) {
+    return mod289(Lanes::mul(Lanes::add(Lanes::mul(x, Lanes::set1(34.0f)), Lanes::set1(1.0f)), x));
+}
+// glm::mod(x, 289)：x - 289 * floor(x / 289)
+inline V mod289Div(V x) {
+    const V m = Lanes::set1(289.0f);
+    return Lanes::sub(x, Lanes::mul(m, Lanes::floor(Lanes::div(x, m))));
+}
+inline V fract(V x) { return Lanes::sub(x, Lanes::floor(x)); }
+inline V fade(V t) {
+    V t3 = Lanes::mul(Lanes::mul(t, t), t);
+    V inner = Lanes::add(Lanes::mul(t, Lanes::sub(Lanes::mul(t, Lanes::set1(6.0f)), Lanes::set1(15.0f))),
+                         Lanes::set1(10.0f));
+    return Lanes::mul(t3, inner);
+}
+// glm::mix(x, y, a) = x * (1 - a) + y * a
+inline V mix(V x, V y, V a) {
+    return Lanes::add(Lanes::mul(x, Lanes::sub(Lanes::set1(1.0f), a)), Lanes::mul(y, a));
+}
+
+// 单个格点角的梯度贡献：i 为该角的 permute 结果，(fx, fy) 为到该角的偏移
+inline V cornerGrad(V i, V fx, V fy) {
+    V gx = Lanes::sub(Lanes::mul(Lanes::set1(2.0f), fract(Lanes::div(i, Lanes::set1(41.0f)))),
+                      Lanes::set1(1.0f));
+    V gy = Lanes::sub(Lanes::abs(gx), Lanes::set1(0.5f));
+    V tx = Lanes::floor(Lanes::add(gx, Lanes::set1(0.5f)));
+    gx = Lanes::sub(gx, tx);
+    V d = Lanes::add(Lanes::mul(gx, gx), Lanes::mul(gy, gy));
+    V norm = Lanes::sub(Lanes::set1(1.79284291400159f), Lanes::mul(Lanes::set1(0.85373472095314f), d));
+    gx = Lanes::mul(gx, norm);
+    gy = Lanes::mul(gy, norm);
+    return Lanes::add(Lanes::mul(gx, fx), Lanes::mul(gy, fy));
+}
+
+// glm::perlin(vec2) 的 N 路版本
+inline V perlinLanes(V x, V y) {
+    V fl_x = Lanes::floor(x), fl_y = Lanes::floor(y);
+    V pf0x = fract(x), pf0y = fract(y);
+    V pf1x = Lanes::sub(pf0x, Lanes::set1(1.0f));
+    V pf1y = Lanes::sub(pf0y, Lanes::set1(1.0f));
+    V pi0x = mod289Div(fl_x);
+    V pi0y = mod289Div(fl_y);
+    V pi1x = mod289Div(Lanes::add(fl_x, Lanes::set1(1.0f)));
+    V pi1y = mod289Div(Lanes::add(fl_y, Lanes::set1(1.0f)));
+
+    V px0 = permute(pi0x), px1 = permute(pi1x);
+    V n00 = cornerGrad(permute(Lanes::add(px0, pi0y)), pf0x, pf0y);
+    V n10 = cornerGrad(permute(Lanes::add(px1, pi0y)), pf1x, pf0y);
+    V n01 = cornerGrad(permute(Lanes::add(px0, pi1y)), pf0x, pf1y);
+    V n11 = cornerGrad(permute(Lanes::add(px1, pi1y)), pf1x, pf1y);
+
+    V fadeX = fade(pf0x), fadeY = fade(pf0y);
+    V nx0 = mix(n00, n10, fadeX);
+    V nx1 = mix(n01, n11, fadeX);
+    return Lanes::mul(Lanes::set1(2.3f), mix(nx0, nx1, fadeY));
+}
+
+// 按 N 路遍历网格；尾部不足 N 的列拷进临时缓冲补齐
+template <class Fn>
+void forEachLaneBlock(const float* xs, int nx, const float* ys, int ny, float* out, Fn&& fn) {
+    constexpr int N = Lanes::N;
+    alignas(32) float tailX[N];
+    alignas(32) float tailOut[N];
+    for (int j = 0; j < ny; ++j) {
+        const V y = Lanes::set1(ys[j]);
+        float* row = out + (size_t)j * nx;
+        int i = 0;
+        for (; i + N <= nx; i += N) {
+            Lanes::store(row + i, fn(Lanes::load(xs + i), y));
+        }
+        if (i < nx) {
+            const int rem = nx - i;
+            for (int k = 0; k < N; ++k) tailX[k] = xs[i + std::min(k, rem - 1)];
+            Lanes::store(tailOut, fn(Lanes::load(tailX), y));
+            for (int k = 0; k < rem; ++k) row[i + k] = tailOut[k];
+        }
+    }
+}
+
+} // namespace
+
+Noise::FbmOctaves Noise::makeFbmOctaves(int octaves, float persistence, float lacunarity, uint64_t seed) {
+    FbmOctaves f;
+    f.octaves = std::clamp(octaves, 0, FbmOctaves::MAX_OCTAVES);
+    float amplitude = 1.0f;
+    float frequency = 1.0f;
+    float maxValue = 0.0f;
+    for (int i = 0; i < f.octaves; ++i) {
+        f.offsetX[i] = seedToOffset(seed, i * 2);
+        f.offsetY[i] = seedToOffset(seed, i * 2 + 1);
+        f.frequency[i] = frequency;
+        f.amplitude[i] = amplitude;
+        maxValue += amplitude;
+        amplitude *= persistence;
+        frequency *= lacunarity;
+    }
+    f.maxValue = maxValue;
+    return f;
+}
+
+void Noise::perlin2DGrid(const float* xs, int nx, const float* ys, int ny, uint64_t seed, float* out) {
+    const V ox = Lanes::set1(seedToOffset(seed, 0));
+    const V oy = Lanes::set1(seedToOffset(seed, 1));
+    forEachLaneBlock(xs, nx, ys, ny, out, [&](V x, V y) {
+        return perlinLanes(Lanes::add(x, ox), Lanes::add(y, oy));
+    });
+}
+
+void Noise::fbm2DGrid(const FbmOctaves& fbm, const float* xs, int nx, const float* ys, int ny, float* out) {
+    const V maxValue = Lanes::set1(fbm.maxValue);
+    forEachLaneBlock(xs, nx, ys, ny, out, [&](V x, V y) {
+        V value = Lanes::set1(0.0f);
+        for (int i = 0; i < fbm.octaves; ++i) {
+            const V freq = Lanes::set1(fbm.frequency[i]);
+            V n = perlinLanes(Lanes::add(Lanes::mul(x, freq), Lanes::set1(fbm.offsetX[i])),
+                              Lanes::add(Lanes::mul(y, freq), Lanes::set1(fbm.offsetY[i])));
+            n = Lanes::mul(Lanes::add(n, Lanes::set1(1.0f)), Lanes::set1(0.5f));
+            value = Lanes::add(value, Lanes::mul(n, Lanes::set1(fbm.amplitude[i])));
+        }
+        return Lanes::div(value, maxValue);
+    });
+}
+
+const char* Noise::gridBackendName() {
+#if defined(NOISE_GRID_AVX2)
+    return "avx2";
+#elif defined(NOISE_GRID_SSE2)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
@@ -19,4 +19,30 @@ namespace Noise {
 
     // 值噪声
     float valueNoise2D(float x, float y, uint64_t seed = 0);
+
+    // ── 批量接口 ─────────────────────────────────────────────────────
+    // 一次对整块网格求值：out[j * nx + i] = f(xs[i], ys[j])。
+    // 内核逐条移植 glm::perlin(vec2) 的运算顺序，按 SIMD 通道（AVX2 8 路 / SSE2 4 路 / 标量）并行，
+    // 结果与上面的标量接口逐位一致（--bench-noise 会顺带校验）。
+
+    // fBm 的逐八度参数（种子偏移 / 频率 / 振幅）预先算好，批量调用间复用，不再每次重算 seedToOffset
+    struct FbmOctaves {
+        static constexpr int MAX_OCTAVES = 8;
+        int octaves = 0;
+        float offsetX[MAX_OCTAVES] = {};
+        float offsetY[MAX_OCTAVES] = {};
+        float frequency[MAX_OCTAVES] = {};
+        float amplitude[MAX_OCTAVES] = {};
+        float maxValue = 1.0f;
+    };
+    // 参数语义同 fractalBrownianMotion2D；octaves 截断到 MAX_OCTAVES
+    FbmOctaves makeFbmOctaves(int octaves, float persistence, float lacunarity, uint64_t seed);
+
+    // 批量 perlin2D（同种子）
+    void perlin2DGrid(const float* xs, int nx, const float* ys, int ny, uint64_t seed, float* out);
+    // 批量 fractalBrownianMotion2D
+    void fbm2DGrid(const FbmOctaves& fbm, const float* xs, int nx, const float* ys, int ny, float* out);
+
+    // 当前编译选用的批量实现（"avx2" / "sse2" / "scalar"），供日志与基准输出
+    const char* gridBackendName();
 }
\ No newline at end of file
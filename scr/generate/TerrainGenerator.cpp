@@ -4,28 +4,30 @@
 #include <cmath>
 #include <algorithm>
 #include <cstring>
+#include <chrono>
 #include <iostream>
+#include <vector>
 
 struct TerrainGenerator::Impl {
     uint64_t seed = 0;
+    // 批量路径的逐八度参数，随种子一起更新
+    Noise::FbmOctaves baseOctaves;
+    Noise::FbmOctaves detailOctaves;
+
+    void setSeed(uint64_t s) {
+        seed = s;
+        baseOctaves = Noise::makeFbmOctaves(5, 0.55f, 2.1f, s);
+        detailOctaves = Noise::makeFbmOctaves(3, 0.5f, 2.0f, s + 3041);
+    }
 
-    float generateTerrainNoise(int worldX, int worldZ) const {
-        const float fx = static_cast<float>(worldX);
-        const float fz = static_cast<float>(worldZ);
-
-        float baseFbm = Noise::fractalBrownianMotion2D(
-            fx * 0.012f, fz * 0.012f,
-            5, 0.55f, 2.1f, seed);
+    // 三层噪声 → 归一化高度；标量 / 批量两条路径共用
+    static float composeHeight(float baseFbm, float ridgeRaw, float detailFbm) {
         float base = baseFbm * 2.0f - 1.0f;               // [-1, 1]
 
-        float ridgeRaw = Noise::perlin2D(fx * 0.018f, fz * 0.018f, seed + 2027);
         float ridge = 1.0f - std::fabs(ridgeRaw);         // [0, 1]
         ridge = ridge * ridge;
         ridge = ridge * 2.0f - 1.0f;                      // [-1, 1]
 
-        float detailFbm = Noise::fractalBrownianMotion2D(
-            fx * 0.06f, fz * 0.06f,
-            3, 0.5f, 2.0f, seed + 3041);
         float detail = detailFbm * 2.0f - 1.0f;           // [-1, 1]
 
         float signed_h = base * 0.55f + ridge * 0.35f + detail * 0.10f;
@@ -38,18 +40,67 @@ struct TerrainGenerator::Impl {
         float norm = worldY / static_cast<float>(Chunk::HEIGHT);
         return std::clamp(norm, 0.0f, 1.0f);
     }
+
+    // 标量参考实现：逐列调用 Noise 标量接口（基准对照 / 一致性校验用）
+    float generateTerrainNoise(int worldX, int worldZ) const {
+        const float fx = static_cast<float>(worldX);
+        const float fz = static_cast<float>(worldZ);
+
+        float baseFbm = Noise::fractalBrownianMotion2D(
+            fx * 0.012f, fz * 0.012f,
+            5, 0.55f, 2.1f, seed);
+        float ridgeRaw = Noise::perlin2D(fx * 0.018f, fz * 0.018f, seed + 2027);
+        float detailFbm = Noise::fractalBrownianMotion2D(
+            fx * 0.06f, fz * 0.06f,
+            3, 0.5f, 2.0f, seed + 3041);
+        return composeHeight(baseFbm, ridgeRaw, detailFbm);
+    }
+
+    // 批量实现：nx×nz 列一次求值，out[z * nx + x]
+    void generateHeightTile(int worldX0, int worldZ0, int nx, int nz, float* out) const {
+        // worker 线程各自一份，chunk 间复用，避免每次分配
+        struct Scratch {
+            std::vector<float> coords;   // 三种缩放下的 x / z 坐标
+            std::vector<float> noise;    // base / ridge / detail 三张网格
+        };
+        thread_local Scratch sc;
+        const size_t cols = static_cast<size_t>(nx) * nz;
+        sc.coords.resize(static_cast<size_t>(nx + nz) * 3);
+        sc.noise.resize(cols * 3);
+
+        static constexpr float SCALES[3] = { 0.012f, 0.018f, 0.06f };
+        float* xs[3];
+        float* zs[3];
+        for (int s = 0; s < 3; ++s) {
+            xs[s] = sc.coords.data() + static_cast<size_t>(nx + nz) * s;
+            zs[s] = xs[s] + nx;
+            for (int i = 0; i < nx; ++i) xs[s][i] = static_cast<float>(worldX0 + i) * SCALES[s];
+            for (int j = 0; j < nz; ++j) zs[s][j] = static_cast<float>(worldZ0 + j) * SCALES[s];
+        }
+
+        float* base = sc.noise.data();
+        float* ridge = base + cols;
+        float* detail = ridge + cols;
+        Noise::fbm2DGrid(baseOctaves, xs[0], nx, zs[0], nz, base);
+        Noise::perlin2DGrid(xs[1], nx, zs[1], nz, seed + 2027, ridge);
+        Noise::fbm2DGrid(detailOctaves, xs[2], nx, zs[2], nz, detail);
+
+        for (size_t c = 0; c < cols; ++c) {
+            out[c] = composeHeight(base[c], ridge[c], detail[c]);
+        }
+    }
 };
 
 TerrainGenerator::TerrainGenerator()
     : m_impl(std::make_unique<Impl>()) {
-    m_impl->seed = m_params.seed;
+    m_impl->setSeed(m_params.seed);
 }
 
 TerrainGenerator::~TerrainGenerator() = default;
 
 void TerrainGenerator::setSeed(uint64_t seed) {
     m_params.seed = seed;
-    m_impl->seed = seed;
+    m_impl->setSeed(seed);
 }
 
 void TerrainGenerator::fillChunkBuffer(BlockState* dst, const glm::ivec2& chunkPos) const {
@@ -62,12 +113,13 @@ void TerrainGenerator::fillChunkBuffer(BlockState* dst, const glm::ivec2& chunkP
     int startX = chunkPos.x * W;
     int startZ = chunkPos.y * D;
 
+    // 整个 chunk 的 W×D 列高度一次批量算出
+    float heights[W * D];
+    m_impl->generateHeightTile(startX, startZ, W, D, heights);
+
     for (int localZ = 0; localZ < D; ++localZ) {
         for (int localX = 0; localX < W; ++localX) {
-            int worldX = startX + localX;
-            int worldZ = startZ + localZ;
-
-            float heightValue = m_impl->generateTerrainNoise(worldX, worldZ);
+            float heightValue = heights[localZ * W + localX];
             int groundHeight = std::clamp(
                 static_cast<int>(heightValue * H), 0, H - 1);
 
@@ -85,13 +137,20 @@ void TerrainGenerator::fillChunkBuffer(BlockState* dst, const glm::ivec2& chunkP
     }
 }
 
+void TerrainGenerator::generateHeightTile(int worldX0, int worldZ0, int nx, int nz, float* out) const {
+    if (!out || nx <= 0 || nz <= 0) return;
+    m_impl->generateHeightTile(worldX0, worldZ0, nx, nz, out);
+}
+
 float TerrainGenerator::getHeightAt(int worldX, int worldZ) const {
-    float heightValue = m_impl->generateTerrainNoise(worldX, worldZ);
+    float heightValue = 0.0f;
+    m_impl->generateHeightTile(worldX, worldZ, 1, 1, &heightValue);
     return heightValue * Chunk::HEIGHT;
 }
 
 BlockType TerrainGenerator::getBlockAt(int worldX, int worldY, int worldZ) const {
-    float heightValue = m_impl->generateTerrainNoise(worldX, worldZ);
+    float heightValue = 0.0f;
+    m_impl->generateHeightTile(worldX, worldZ, 1, 1, &heightValue);
     int groundHeight = std::clamp(
         static_cast<int>(heightValue * Chunk::HEIGHT),
         0, Chunk::HEIGHT - 1);
@@ -107,3 +166,67 @@ BlockType TerrainGenerator::getBlockAt(int worldX, int worldY, int worldZ) const
     }
     return BLOCK_DIRT;
 }
+
+
+int TerrainGenerator::runNoiseBenchmark(int chunkCount, uint64_t seed) {
+    if (chunkCount <= 0) chunkCount = 1024;
+    const int W = ChunkConstants::CHUNK_WIDTH;
+    const int D = ChunkConstants::CHUNK_DEPTH;
+    const int side = std::max(1, static_cast<int>(std::ceil(std::sqrt(static_cast<double>(chunkCount)))));
+
+    TerrainGenerator gen;
+    gen.setSeed(seed);
+
+    // 两条路径各写一份高度，最后逐列对比
+    std::vector<float> scalarH(static_cast<size_t>(chunkCount) * W * D);
+    std::vector<float> gridH(scalarH.size());
+
+    using Clock = std::chrono::steady_clock;
+    auto t0 = Clock::now();
+    for (int c = 0; c < chunkCount; ++c) {
+        const int sx = (c % side) * W;
+        const int sz = (c / side) * D;
+        float* dst = scalarH.data() + static_cast<size_t>(c) * W * D;
+        for (int z = 0; z < D; ++z)
+            for (int x = 0; x < W; ++x)
+                dst[z * W + x] = gen.m_impl->generateTerrainNoise(sx + x, sz + z);
+    }
+    auto t1 = Clock::now();
+    for (int c = 0; c < chunkCount; ++c) {
+        const int sx = (c % side) * W;
+        const int sz = (c / side) * D;
+        gen.generateHeightTile(sx, sz, W, D, gridH.data() + static_cast<size_t>(c) * W * D);
+    }
+    auto t2 = Clock::now();
+
+    // 宽 tile：一次算 side×W 列宽的整行 chunk，摊薄行首的坐标准备与尾部补齐
+    std::vector<float> row(static_cast<size_t>(side) * W * D);
+    int tileChunks = 0;
+    for (int r = 0; r * side < chunkCount; ++r) {
+        gen.generateHeightTile(0, r * D, side * W, D, row.data());
+        tileChunks += side;
+    }
+    auto t3 = Clock::now();
+
+    int64_t mismatched = 0;
+    for (size_t i = 0; i < scalarH.size(); ++i) {
+        if (scalarH[i] != gridH[i]) ++mismatched;
+    }
+
+    auto perSec = [](int n, Clock::duration d) {
+        double s = std::chrono::duration<double>(d).count();
+        return s > 0.0 ? n / s : 0.0;
+    };
+    const double scalarRate = perSec(chunkCount, t1 - t0);
+    const double gridRate = perSec(chunkCount, t2 - t1);
+    const double tileRate = perSec(tileChunks, t3 - t2);
+    std::cout << "[NoiseBench] backend=" << Noise::gridBackendName()
+              << " chunks=" << chunkCount << std::endl;
+    std::cout << "[NoiseBench] scalar      " << scalarRate << " chunks/s" << std::endl;
+    std::cout << "[NoiseBench] grid 16x16  " << gridRate << " chunks/s ("
+              << (scalarRate > 0.0 ? gridRate / scalarRate : 0.0) << "x)" << std::endl;
+    std::cout << "[NoiseBench] grid " << side * W << "x" << D << " " << tileRate << " chunks/s ("
+              << (scalarRate > 0.0 ? tileRate / scalarRate : 0.0) << "x)" << std::endl;
+    std::cout << "[NoiseBench] mismatched columns: " << mismatched << std::endl;
+    return mismatched == 0 ? 0 : 1;
+}
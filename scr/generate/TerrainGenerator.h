@@ -35,6 +35,9 @@ public:
     // 地形生成只输出无轴向方块，orient 字段统一写 ORIENT_NONE。
     void fillChunkBuffer(BlockState* dst, const glm::ivec2& chunkPos) const;
 
+    // 批量求 nx×nz 列的归一化地表高度 [0,1]，out[z * nx + x]；线程安全，同 fillChunkBuffer
+    void generateHeightTile(int worldX0, int worldZ0, int nx, int nz, float* out) const;
+
     // 获取世界位置的高度（用于区块间连续）
     float getHeightAt(int worldX, int worldZ) const;
 
@@ -45,6 +48,10 @@ public:
     TerrainParams& getParams() { return m_params; }
     const TerrainParams& getParams() const { return m_params; }
 
+    // 噪声微基准（--bench-noise）：同一批 chunk 分别走标量逐列路径与批量网格路径，
+    // 输出 chunks/s 并逐列对比高度。返回 0 = 两条路径结果一致。
+    static int runNoiseBenchmark(int chunkCount, uint64_t seed);
+
 private:
     // 私有实现
     struct Impl;
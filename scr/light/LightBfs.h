@@ -0,0 +1,276 @@
+﻿#pragma once
+#include "../core.h"
+#include "LightSource.h"
+#include "LightPropagation.h"  // blocksLight / getLightOpacity
+#include "../chunk/BlockType.h"
+#include "../chunk/BlockBox.h"
+#include "../chunk/ChunkDimensions.h"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// ── 光照 BFS 内核（编译期特化）──────────────────────────────────────
+// Task 3（ChunkWorkerPool::lightBuildOne）与增量重光照（LightPropagation）共用的逐光源 BFS。
+// 相比旧实现（std::function 回调 + 每步 float floor 求 sectionKey + 每源重新分配 visited）：
+//   - 按 Grid 访问器模板展开，方块 / 光照查询全部内联；
+//   - BFS 前把光源 y 范围 ±kMaxR 内的 section 解码成一块稠密透光表（网格局部 [y][z][x]），
+//     BFS 内查方块 = 一次数组读取，不再逐格走 chunk → section → BlockBox 调色板；
+//   - 每种光源的逐距离亮度预先量化成整数表（见 Levels），BFS 内无浮点运算；
+//   - visited 为所有光源共用的一块 33³ 代数戳数组，换源只递增戳，不再清零。
+//
+// Grid 访问器需提供：
+//   int minCX, minCZ, chunksX, chunksZ;          // 网格左下角 chunk 坐标与尺寸（chunk 数）
+//   bool hasChunk(int ci) const;                 // ci = cx + cz*chunksX（网格局部）；false = 无数据，视为石墙
+//   const BlockBox* box(int ci, int sy) const;   // nullptr = 空 section（全空气）
+//   uint32_t* lightSection(int ci, int sy);      // 可写光照（4096 个 RGBA8）；nullptr = 不可写，BFS 只穿越
+//   void markLit(int ci, int sy);                // 该 section 被写入了光照
+//
+// 语义与原 lightBuildOne 逐位一致：逐分量 max 混合；"提升"按浮点亮度 > 旧字节/255 判定；
+// 可写格仅在提升时继续传播，不可写格（如 Task 3 的邻居 chunk）总是穿越。
+
+namespace LightBfs {
+
+constexpr int CW = ChunkConstants::CHUNK_WIDTH;     // 16
+constexpr int CD = ChunkConstants::CHUNK_DEPTH;     // 16
+constexpr int CH = ChunkConstants::CHUNK_HEIGHT;    // 256
+constexpr int SH = ChunkConstants::SECTION_HEIGHT;  // 16
+constexpr int kMaxR = static_cast<int>(kMaxLightRadius);
+constexpr int kBoxSide = 2 * kMaxR + 1;             // 每源包围盒边长上限
+constexpr size_t kBoxCells = static_cast<size_t>(kBoxSide) * kBoxSide * kBoxSide;
+constexpr size_t kMaxIterPerSource = 1 << 20;      // 防御上限（同旧实现）
+
+// 方块透光：-1 = 不透明；>=0 = 每格额外等效距离（查表化的 LightPropagation::getLightOpacity）
+struct OpacityTable {
+    int8_t v[256];
+    OpacityTable() {
+        for (int t = 0; t < 256; ++t) {
+            BlockType type = static_cast<BlockType>(t);
+            v[t] = LightPropagation::blocksLight(type)
+                ? int8_t(-1) : static_cast<int8_t>(LightPropagation::getLightOpacity(type));
+        }
+    }
+};
+inline const OpacityTable& opacityTable() {
+    static const OpacityTable t;
+    return t;
+}
+
+// 单种光源按等效距离展开的整数亮度表
+struct Levels {
+    int radius = 0;                       // (int)def.radius；0 = 不发光
+    uint8_t valid[kMaxR + 1] = {};        // 该距离亮度是否仍 >= 截断阈值（0.005）
+    uint8_t rgb[kMaxR + 1][3] = {};       // 写入值：round(亮度 × 255)
+    uint16_t thr[kMaxR + 1][3] = {};      // 提升阈值：旧分量 < thr ⇔ 亮度 > 旧字节/255（0..256）
+};
+
+inline Levels makeLevels(const LightDef& def) {
+    Levels lv;
+    if (def.intensity <= 0.0f) return lv;
+    lv.radius = std::min(static_cast<int>(def.radius), kMaxR);
+    const glm::vec3 src = def.color * def.intensity;
+    for (int d = 0; d <= lv.radius && d <= kMaxR; ++d) {
+        // 与旧实现相同的浮点表达式，保证逐位一致
+        const float falloff = 1.0f - static_cast<float>(d) / def.radius;
+        const glm::vec3 light = src * falloff;
+        float maxComp = light.r;
+        if (light.g > maxComp) maxComp = light.g;
+        if (light.b > maxComp) maxComp = light.b;
+        lv.valid[d] = (d == 0) || (falloff > 0.0f && maxComp >= 0.005f);
+        for (int c = 0; c < 3; ++c) {
+            const float v = light[c];
+            lv.rgb[d][c] = static_cast<uint8_t>(glm::clamp(static_cast<int>(v * 255.0f + 0.5f), 0, 255));
+            int t = 0;
+            while (t < 256 && v > static_cast<float>(t) / 255.0f) ++t;
+            lv.thr[d][c] = static_cast<uint16_t>(t);
+        }
+    }
+    return lv;
+}
+
+// 各方块类型的亮度表（只算一次）
+inline const Levels& levelsFor(BlockType type) {
+    static const std::array<Levels, 256> table = [] {
+        std::array<Levels, 256> t{};
+        for (int i = 0; i < 256; ++i) t[i] = makeLevels(getLightDefForBlock(static_cast<BlockType>(i)));
+        return t;
+    }();
+    return table[static_cast<uint8_t>(type)];
+}
+
+struct Entry {
+    int16_t x, y, z;   // 网格局部坐标
+    int16_t dist;      // BFS 步数（非等效距离）
+};
+
+// 对 sources（世界坐标）逐个做 BFS，返回出队格数（基准统计用）
+template <class Grid>
+uint64_t propagate(Grid& grid, const glm::ivec3* sources, size_t count) {
+    static thread_local std::vector<Entry> s_ring;     // 每源入队格数 ≤ 33³，定长即可
+    static thread_local std::vector<uint16_t> s_visited;
+    static thread_local uint16_t s_stamp = 0;
+    static thread_local std::vector<int8_t> s_opacity;
+    static thread_local std::vector<BlockState> s_decode;
+    if (s_visited.size() != kBoxCells) {
+        s_visited.assign(kBoxCells, 0);
+        s_stamp = 0;
+    }
+    if (s_ring.size() < kBoxCells) s_ring.resize(kBoxCells);
+    Entry* const ring = s_ring.data();       // 热循环内避免反复取 TLS 地址
+    uint16_t* const visited = s_visited.data();
+
+    const OpacityTable& opacityOf = opacityTable();
+    const int sizeX = grid.chunksX * CW;
+    const int sizeZ = grid.chunksZ * CD;
+    const int originX = grid.minCX * CW;
+    const int originZ = grid.minCZ * CD;
+
+    auto chunkIndex = [&](int x, int z) { return (x >> 4) + (z >> 4) * grid.chunksX; };
+    auto cellIndex = [](int x, int y, int z) { return ((y & (SH - 1)) * CD + (z & (CD - 1))) * CW + (x & (CW - 1)); };
+
+    // ── 1. 解码稠密透光表：只覆盖光源 y 范围 ±kMaxR 涉及的 section ──
+    int srcMinY = CH, srcMaxY = -1;
+    for (size_t si = 0; si < count; ++si) {
+        const int y = sources[si].y;
+        if (y < 0 || y >= CH) continue;
+        srcMinY = std::min(srcMinY, y);
+        srcMaxY = std::max(srcMaxY, y);
+    }
+    if (srcMaxY < 0) return 0;
+    const int sy0 = std::max(srcMinY - kMaxR, 0) / SH;
+    const int sy1 = std::min(srcMaxY + kMaxR, CH - 1) / SH;
+    const int yBase = sy0 * SH;
+    const int sizeY = (sy1 - sy0 + 1) * SH;
+    const size_t strideZ = static_cast<size_t>(sizeX);
+    const size_t strideY = static_cast<size_t>(sizeX) * sizeZ;
+    s_opacity.resize(strideY * sizeY);
+    s_decode.resize(BlockBox::VOLUME);
+    int8_t* const opacity = s_opacity.data();
+    for (int cz = 0; cz < grid.chunksZ; ++cz) {
+        for (int cx = 0; cx < grid.chunksX; ++cx) {
+            const int ci = cx + cz * grid.chunksX;
+            for (int sy = sy0; sy <= sy1; ++sy) {
+                int8_t* base = opacity + static_cast<size_t>(sy * SH - yBase) * strideY
+                             + static_cast<size_t>(cz * CD) * strideZ + cx * CW;
+                const BlockBox* box = grid.hasChunk(ci) ? grid.box(ci, sy) : nullptr;
+                BlockState uniform{};
+                if (!grid.hasChunk(ci)) uniform = BlockState{ BLOCK_STONE, ORIENT_NONE };
+                if (!box || box->isUniform(&uniform)) {
+                    const int8_t v = opacityOf.v[uniform.type()];
+                    for (int ly = 0; ly < SH; ++ly)
+                        for (int lz = 0; lz < CD; ++lz)
+                            std::fill_n(base + ly * strideY + lz * strideZ, CW, v);
+                    continue;
+                }
+                box->copyTo(s_decode.data());
+                const BlockState* src = s_decode.data();
+                for (int ly = 0; ly < SH; ++ly)
+                    for (int lz = 0; lz < CD; ++lz) {
+                        int8_t* row = base + ly * strideY + lz * strideZ;
+                        for (int lx = 0; lx < CW; ++lx) row[lx] = opacityOf.v[(src++)->type()];
+                    }
+            }
+        }
+    }
+
+    // 可写 section 指针表：首次写入某 (chunk, section) 时向 Grid 取一次，之后直接索引
+    static thread_local std::vector<uint32_t*> s_sections;
+    uint32_t* const kUnresolved = reinterpret_cast<uint32_t*>(uintptr_t(1));
+    s_sections.assign(static_cast<size_t>(grid.chunksX) * grid.chunksZ * (CH / SH), kUnresolved);
+    uint32_t** const sections = s_sections.data();
+
+    // 写入一格：返回是否应继续传播（可写格 = 有提升；不可写格 = 总是穿越）
+    auto writeCell = [&](const Levels& lv, int x, int y, int z, int ed) -> bool {
+        const int ci = chunkIndex(x, z);
+        const int sy = y >> 4;
+        uint32_t*& slot = sections[ci * (CH / SH) + sy];
+        if (slot == kUnresolved) slot = grid.lightSection(ci, sy);
+        uint32_t* sec = slot;
+        if (!sec) return true;
+        uint32_t& cell = sec[cellIndex(x, y, z)];
+        const uint32_t old = cell;
+        const uint32_t o0 = old & 0xFFu, o1 = (old >> 8) & 0xFFu, o2 = (old >> 16) & 0xFFu;
+        const bool up0 = o0 < lv.thr[ed][0];
+        const bool up1 = o1 < lv.thr[ed][1];
+        const bool up2 = o2 < lv.thr[ed][2];
+        if (!(up0 || up1 || up2)) return false;
+        const uint32_t n0 = up0 ? lv.rgb[ed][0] : o0;
+        const uint32_t n1 = up1 ? lv.rgb[ed][1] : o1;
+        const uint32_t n2 = up2 ? lv.rgb[ed][2] : o2;
+        cell = n0 | (n1 << 8) | (n2 << 16) | (static_cast<uint32_t>(ed) << 24);
+        grid.markLit(ci, sy);
+        return true;
+    };
+
+    // ── 2. 逐光源 BFS ──
+    uint64_t processed = 0;
+    for (size_t si = 0; si < count; ++si) {
+        const int sx = sources[si].x - originX;
+        const int sy = sources[si].y;
+        const int sz = sources[si].z - originZ;
+        if (sx < 0 || sx >= sizeX || sz < 0 || sz >= sizeZ || sy < 0 || sy >= CH) continue;
+
+        const int sci = chunkIndex(sx, sz);
+        if (!grid.hasChunk(sci)) continue;
+        const BlockBox* sbox = grid.box(sci, sy >> 4);
+        const Levels& lv = levelsFor(sbox ? sbox->get(cellIndex(sx, sy, sz)).type() : BLOCK_AIR);
+        if (lv.radius <= 0) continue;
+        const int r = lv.radius;
+
+        if (++s_stamp == 0) {
+            std::fill(visited, visited + kBoxCells, uint16_t(0));
+            s_stamp = 1;
+        }
+        const uint16_t stamp = s_stamp;
+        // 包围盒：限制在网格（及已解码的 y 段）内；visited 以 (源 - kMaxR) 为原点，下标恒在 33³ 内
+        const int bminX = std::max(sx - r, 0), bmaxX = std::min(sx + r, sizeX - 1);
+        const int bminY = std::max(sy - r, yBase), bmaxY = std::min(sy + r, yBase + sizeY - 1);
+        const int bminZ = std::max(sz - r, 0), bmaxZ = std::min(sz + r, sizeZ - 1);
+        // visited 下标 = 相对 (源 - kMaxR) 的 33³ 局部坐标；相邻格下标差为常量步长
+        const int vx0 = sx - kMaxR, vy0 = sy - kMaxR, vz0 = sz - kMaxR;
+        auto visitIdx = [&](int x, int y, int z) {
+            return (static_cast<size_t>(y - vy0) * kBoxSide + (z - vz0)) * kBoxSide + (x - vx0);
+        };
+        constexpr ptrdiff_t kVZ = kBoxSide, kVY = ptrdiff_t(kBoxSide) * kBoxSide;
+
+        writeCell(lv, sx, sy, sz, 0);
+        visited[visitIdx(sx, sy, sz)] = stamp;
+        ring[0] = Entry{ int16_t(sx), int16_t(sy), int16_t(sz), 0 };
+        size_t head = 0, tail = 1;
+
+        // 单个方向：越界 / 已访问 / 不透明 / 超出半径即停；否则写入并按需入队。
+        // 6 个方向手工展开，步长均为编译期常量。
+        auto visit = [&](int nx, int ny, int nz, size_t vi, const int8_t* op, int nextDist) {
+            if (visited[vi] == stamp) return;
+            visited[vi] = stamp;
+            if (*op < 0) return;
+            const int ed = nextDist + *op;
+            if (ed >= r || !lv.valid[ed]) return;
+            if (writeCell(lv, nx, ny, nz, ed))
+                ring[tail++] = Entry{ int16_t(nx), int16_t(ny), int16_t(nz), int16_t(nextDist) };
+        };
+
+        while (head < tail) {
+            if (head > kMaxIterPerSource) break;
+            const Entry cur = ring[head++];
+            ++processed;
+            if (cur.dist >= r) continue;
+            const int nextDist = cur.dist + 1;
+            const int x = cur.x, y = cur.y, z = cur.z;
+            const size_t vi = visitIdx(x, y, z);
+            const int8_t* op = opacity + static_cast<size_t>(y - yBase) * strideY + z * strideZ + x;
+
+            if (x < bmaxX) visit(x + 1, y, z, vi + 1, op + 1, nextDist);
+            if (x > bminX) visit(x - 1, y, z, vi - 1, op - 1, nextDist);
+            if (y < bmaxY) visit(x, y + 1, z, vi + kVY, op + strideY, nextDist);
+            if (y > bminY) visit(x, y - 1, z, vi - kVY, op - strideY, nextDist);
+            if (z < bmaxZ) visit(x, y, z + 1, vi + kVZ, op + strideZ, nextDist);
+            if (z > bminZ) visit(x, y, z - 1, vi - kVZ, op - strideZ, nextDist);
+        }
+    }
+    return processed;
+}
+
+} // namespace LightBfs
@@ -73,6 +73,8 @@ public:
     // 脏标记已外移到 ChunkManager::m_dirtyLightSections，避免每帧全量扫描 m_lightCaches
 
     const uint32_t* rawData() const { return m_data.data(); }
+    // 可写原始数据（LightBfs 内核直接按格读写打包值；写入后由调用方 setHasLight）
+    uint32_t* mutableRawData() { return m_data.data(); }
     size_t rawSize() const { return BYTES; }
 
     // 整块写入（Task 3 结果，数据已含距离编码）
@@ -1,21 +1,7 @@
 ﻿#include "LightPropagation.h"
-#include "../chunk/ChunkManager.h"
+#include "LightBfs.h"
 #include <cmath>
-
-uint64_t LightPropagation::toSectionKey(const glm::ivec3& worldPos) {
-    int chunkX = (int)std::floor((float)worldPos.x / 16.0f);
-    int chunkZ = (int)std::floor((float)worldPos.z / 16.0f);
-    int sectionY = worldPos.y / 16;
-    if (worldPos.y < 0) sectionY--;
-    return ChunkManager::makeSectionKey(chunkX, chunkZ, sectionY);
-}
-
-glm::ivec3 LightPropagation::toLocal(const glm::ivec3& worldPos) {
-    int lx = ((worldPos.x % 16) + 16) % 16;
-    int ly = ((worldPos.y % 16) + 16) % 16;
-    int lz = ((worldPos.z % 16) + 16) % 16;
-    return glm::ivec3(lx, ly, lz);
-}
+#include <unordered_set>
 
 bool LightPropagation::blocksLight(BlockType type) {
     if (type == BLOCK_AIR || type == BLOCK_ERRER) return false;
@@ -37,156 +23,64 @@ int LightPropagation::getLightOpacity(BlockType type) {
 
 void LightPropagation::clearSectionCaches(const glm::ivec3& regionMin,
                                            const glm::ivec3& regionMax,
-                                           CacheGetter cacheGetter) {
+                                           LightRegion& region) {
     int secMinX = (int)std::floor((float)regionMin.x / 16.0f);
-    int secMinY = regionMin.y / 16;
+    int secMinY = std::max(regionMin.y / 16, 0);
     int secMinZ = (int)std::floor((float)regionMin.z / 16.0f);
     int secMaxX = (int)std::floor((float)regionMax.x / 16.0f);
-    int secMaxY = regionMax.y / 16;
+    int secMaxY = std::min(regionMax.y / 16, CHUNK_SECTION_COUNT - 1);
     int secMaxZ = (int)std::floor((float)regionMax.z / 16.0f);
 
     for (int sx = secMinX; sx <= secMaxX; ++sx) {
-        for (int sy = secMinY; sy <= secMaxY; ++sy) {
-            for (int sz = secMinZ; sz <= secMaxZ; ++sz) {
-                uint64_t key = ChunkManager::makeSectionKey(sx, sz, sy);
-                SectionLightCache* c = cacheGetter(key);
+        for (int sz = secMinZ; sz <= secMaxZ; ++sz) {
+            if (!region.containsChunk(sx, sz)) continue;
+            int ci = region.chunkIndex(sx, sz);
+            for (int sy = secMinY; sy <= secMaxY; ++sy) {
+                SectionLightCache* c = region.cache(ci, sy);
                 if (c) c->clear();
             }
         }
     }
 }
 
-// ── 多光源合并 BFS（含距离元数据 + 透明方块衰减）────────────────────
-// 设计要点：
-//   - 所有光源同时入队，共享 visited + queue，每格只访问一次。
-//   - 每格缓存包含 RGB + 曼哈顿距离（alpha 通道），供增量更新精确计算衰减。
-//   - 透明非空气方块（水、树叶）增加等效距离惩罚，模拟光在水中/树叶中更快衰减。
-//   - 必须使用 visited 数组：SectionLightCache 以 byte 精度存储，get() 返回
-//     字节量化 float。原始 float 与字节量化 float 的 <= 比较存在精度偏差
-//     （如 0.68 > 173/255≈0.67843），仅靠 max-clamp 会导致已写入格被误判为
-//     "亮度提升"，重新入队 → 无限重入循环。visited 保证每格每源只处理一次。
-
-void LightPropagation::propagateMultiSource(const std::vector<glm::ivec3>& sources,
-                                             BlockQuery blockQuery,
-                                             CacheGetter cacheGetter) {
-    if (sources.empty()) return;
-
-    static const glm::ivec3 dirs[6] = {
-        { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 }
-    };
-
-    static thread_local std::vector<QueueEntry> s_ring;
-    s_ring.reserve(65536);
-    static thread_local std::vector<uint8_t> s_visited;
-
-    for (const auto& src : sources) {
-        BlockState st = blockQuery(src);
-        const LightDef& def = isEmissive(st.type())
-            ? getLightDefForBlock(st.type()) : getTorchLightDef();
-        if (def.intensity <= 0.0f) continue;
-
-        glm::vec3 srcLight = def.color * def.intensity;
-        float srcRadius = def.radius;
-        int srcR = (int)std::ceil(srcRadius);
-
-        // ── 每源包围盒 + visited ──
-        int bminX = src.x - srcR, bmaxX = src.x + srcR;
-        int bminY = src.y - srcR, bmaxY = src.y + srcR;
-        int bminZ = src.z - srcR, bmaxZ = src.z + srcR;
-        int bw = bmaxX - bminX + 1, bh = bmaxY - bminY + 1, bd = bmaxZ - bminZ + 1;
-        s_visited.assign((size_t)bw * bh * bd, 0);
-        auto vIdx = [&](int wx, int wy, int wz) -> size_t {
-            return (size_t)((wy - bminY) * bd + (wz - bminZ)) * bw + (wx - bminX);
-        };
-
-        // 写入辅助：量化后比较 RGB；距离取传入的 dist。
-        auto maxWrite = [&](const glm::ivec3& wp, const glm::vec3& light, int dist) -> bool {
-            uint64_t secKey = toSectionKey(wp);
-            SectionLightCache* cache = cacheGetter(secKey);
-            if (!cache) return false;
-            glm::ivec3 local = toLocal(wp);
-            glm::vec3 cur = cache->get(local.x, local.y, local.z);
-            float qr = std::round(light.r * 255.0f) / 255.0f;
-            float qg = std::round(light.g * 255.0f) / 255.0f;
-            float qb = std::round(light.b * 255.0f) / 255.0f;
-            if (qr <= cur.r && qg <= cur.g && qb <= cur.b) return false;
-            cache->maxSet(local.x, local.y, local.z, light, (uint8_t)dist);
-            cache->setHasLight(true);
-            return true;
-        };
-
-        // 光源格（距离 = 0）
-        maxWrite(src, srcLight, 0);
-        s_visited[vIdx(src.x, src.y, src.z)] = 1;
-
-        s_ring.clear();
-        s_ring.push_back(QueueEntry{ src, 0, srcRadius, srcLight });
-        size_t head = 0;
-
-        while (head < s_ring.size()) {
-            QueueEntry cur = s_ring[head++];
-
-            if (cur.dist >= (int)cur.srcRadius) continue;
-
-            int nextDist = cur.dist + 1;
-
-            for (const auto& dir : dirs) {
-                glm::ivec3 nextPos = cur.pos + dir;
-
-                // 包围盒检查
-                if (nextPos.x < bminX || nextPos.x > bmaxX) continue;
-                if (nextPos.y < bminY || nextPos.y > bmaxY) continue;
-                if (nextPos.z < bminZ || nextPos.z > bmaxZ) continue;
-
-                size_t idx = vIdx(nextPos.x, nextPos.y, nextPos.z);
-                if (s_visited[idx]) continue;
-
-                BlockState ns = blockQuery(nextPos);
-                if (blocksLight(ns.type())) {
-                    s_visited[idx] = 1;  // 不透明块标 visited，不传播
-                    continue;
+std::vector<glm::ivec3> LightPropagation::collectSources(const LightRegion& region,
+                                                         const glm::ivec3& min, const glm::ivec3& max) {
+    std::vector<glm::ivec3> result;
+    int cMinX = std::max((int)std::floor((float)min.x / 16.0f), region.minCX);
+    int cMinZ = std::max((int)std::floor((float)min.z / 16.0f), region.minCZ);
+    int cMaxX = std::min((int)std::floor((float)max.x / 16.0f), region.minCX + region.chunksX - 1);
+    int cMaxZ = std::min((int)std::floor((float)max.z / 16.0f), region.minCZ + region.chunksZ - 1);
+    int sMinY = std::max(min.y / 16, 0);
+    int sMaxY = std::min(max.y / 16, CHUNK_SECTION_COUNT - 1);
+    for (int cx = cMinX; cx <= cMaxX; ++cx) {
+        for (int cz = cMinZ; cz <= cMaxZ; ++cz) {
+            const ChunkLightSources* cs = region.sources[region.chunkIndex(cx, cz)];
+            if (!cs) continue;
+            for (int sy = sMinY; sy <= sMaxY; ++sy) {
+                if (!(*cs)[sy]) continue;
+                for (uint16_t packed : *(*cs)[sy]) {
+                    glm::ivec3 wp = unpackLightWorld(packed, cx, cz);
+                    if (wp.x >= min.x && wp.x <= max.x &&
+                        wp.y >= min.y && wp.y <= max.y &&
+                        wp.z >= min.z && wp.z <= max.z)
+                        result.push_back(wp);
                 }
-
-                s_visited[idx] = 1;
-
-                // ── 透明方块光衰减 ──
-                // 透明非空气方块（水、树叶）增加等效距离，使光在其中更快衰减
-                int opacity = getLightOpacity(ns.type());
-                int effectiveDist = nextDist + opacity;
-                if (effectiveDist >= (int)cur.srcRadius) continue;  // 衰减后超出范围
-
-                float falloff = 1.0f - (float)effectiveDist / cur.srcRadius;
-                if (falloff <= 0.0f) continue;
-
-                glm::vec3 nextLight = cur.srcBrightness * falloff;
-                float maxComp = nextLight.r;
-                if (nextLight.g > maxComp) maxComp = nextLight.g;
-                if (nextLight.b > maxComp) maxComp = nextLight.b;
-                if (maxComp < 0.005f) continue;
-
-                // max-clamp 跨源混合：仅当本源的入射亮度提升了缓存值才继续传播
-                if (!maxWrite(nextPos, nextLight, effectiveDist)) continue;
-                // 入队时使用实际距离（非等效距离），保持 BFS 步数准确
-                s_ring.push_back(QueueEntry{ nextPos, nextDist, srcRadius, cur.srcBrightness });
             }
         }
     }
+    return result;
 }
 
-// ── 单光源 BFS（薄封装，内部委托 propagateMultiSource）───────────────
+// ── 光源 BFS：委托 LightBfs 内核（与 Task 3 同一实现，逐分量 max 混合）─────────
 
-void LightPropagation::propagateSingle(const glm::ivec3& srcPos,
-                                        BlockQuery blockQuery,
-                                        CacheGetter cacheGetter) {
-    propagateMultiSource({ srcPos }, blockQuery, cacheGetter);
+void LightPropagation::propagateSingle(const glm::ivec3& srcPos, LightRegion& region) {
+    LightBfs::propagate(region, &srcPos, 1);
 }
 
 // ── 全量传播 ───────────────────────────────────────────────────────
 
-void LightPropagation::propagateAll(const std::vector<glm::ivec3>& sources,
-                                     BlockQuery blockQuery,
-                                     CacheGetter cacheGetter) {
-    propagateMultiSource(sources, blockQuery, cacheGetter);
+void LightPropagation::propagateAll(const std::vector<glm::ivec3>& sources, LightRegion& region) {
+    LightBfs::propagate(region, sources.data(), sources.size());
 }
 
 // ── 区域边界对齐 ───────────────────────────────────────────────────
@@ -203,9 +97,7 @@ static void alignToSectionBounds(glm::ivec3& vmin, glm::ivec3& vmax) {
 // ── 增量：清空区域并从受影响光源重传播 ───────────────────────────
 
 void LightPropagation::propagateRegion(const glm::ivec3& center, float maxRadius,
-                                        SourceQuery sourceQuery,
-                                        BlockQuery blockQuery,
-                                        CacheGetter cacheGetter) {
+                                        LightRegion& region) {
     int r = (int)std::ceil(maxRadius);
     glm::ivec3 regionMin = center - glm::ivec3(r);
     glm::ivec3 regionMax = center + glm::ivec3(r);
@@ -214,20 +106,18 @@ void LightPropagation::propagateRegion(const glm::ivec3& center, float maxRadius
     glm::ivec3 alignedMax = regionMax;
     alignToSectionBounds(alignedMin, alignedMax);
 
-    clearSectionCaches(alignedMin, alignedMax, cacheGetter);
+    clearSectionCaches(alignedMin, alignedMax, region);
 
-    auto affected = sourceQuery(alignedMin, alignedMax);
+    auto affected = collectSources(region, alignedMin, alignedMax);
 
-    // 合并 BFS：所有受影响光源一次遍历
-    propagateMultiSource(affected, blockQuery, cacheGetter);
+    // 受影响光源逐个 BFS（LightBfs 内核，visited 共用代数戳，换源不清零）
+    LightBfs::propagate(region, affected.data(), affected.size());
 }
 
 // ── 增量：移除光源并重光照其区域 ─────────────────────────────────
 
 void LightPropagation::removeAndReLight(const glm::ivec3& oldPos, float oldRadius,
-                                         SourceQuery sourceQuery,
-                                         BlockQuery blockQuery,
-                                         CacheGetter cacheGetter) {
+                                         LightRegion& region) {
     int r = (int)std::ceil(oldRadius);
     glm::ivec3 regionMin = oldPos - glm::ivec3(r);
     glm::ivec3 regionMax = oldPos + glm::ivec3(r);
@@ -236,12 +126,12 @@ void LightPropagation::removeAndReLight(const glm::ivec3& oldPos, float oldRadiu
     glm::ivec3 alignedMax = regionMax;
     alignToSectionBounds(alignedMin, alignedMax);
 
-    clearSectionCaches(alignedMin, alignedMax, cacheGetter);
+    clearSectionCaches(alignedMin, alignedMax, region);
 
-    auto affected = sourceQuery(alignedMin, alignedMax);
+    auto affected = collectSources(region, alignedMin, alignedMax);
 
-    // 合并 BFS：所有受影响光源一次遍历
-    propagateMultiSource(affected, blockQuery, cacheGetter);
+    // 受影响光源逐个 BFS（LightBfs 内核，visited 共用代数戳，换源不清零）
+    LightBfs::propagate(region, affected.data(), affected.size());
 }
 
 // ── 增量：移除遮挡物后的去遮挡传播（精确重传播）─────────────────────
@@ -249,14 +139,12 @@ void LightPropagation::removeAndReLight(const glm::ivec3& oldPos, float oldRadiu
 // 改为清空受影响区域并重传播所有邻近光源，结果始终准确。
 
 void LightPropagation::propagateDeocclusion(const glm::ivec3& openedPos,
-                                             SourceQuery sourceQuery,
-                                             BlockQuery blockQuery,
-                                             CacheGetter cacheGetter) {
+                                             LightRegion& region) {
     // 以 openedPos 为中心，清空最大光源半径范围内的缓存，
     // 然后找出该范围内所有光源并重传播。
     // 这保证无论光源在哪个方向、有几个光源、距离多远，结果都准确。
     propagateRegion(openedPos, kMaxLightRadius,
-                    sourceQuery, blockQuery, cacheGetter);
+                    region);
 }
 
 // ── 增量：新增遮挡物的阴影传播（精确重传播）─────────────────────────
@@ -264,12 +152,53 @@ void LightPropagation::propagateDeocclusion(const glm::ivec3& openedPos,
 // 改为清空受影响区域并重传播所有邻近光源，结果始终准确。
 
 void LightPropagation::propagateOcclusion(const glm::ivec3& blockedPos,
-                                           SourceQuery sourceQuery,
-                                           BlockQuery blockQuery,
-                                           CacheGetter cacheGetter) {
+                                           LightRegion& region) {
     // 以 blockedPos 为中心，清空最大光源半径范围内的缓存，
     // 然后找出该范围内所有光源并重传播。
     // BFS 自动正确处理新的遮挡关系——不透明方块在 BFS 中天然阻挡光。
     propagateRegion(blockedPos, kMaxLightRadius,
-                    sourceQuery, blockQuery, cacheGetter);
+                    region);
+}
+
+// ── 增量：一批方块变动的分派 ─────────────────────────────────────
+// 统一策略：对于遮挡/去遮挡，清空受影响区域 + 找出所有邻近光源 + 重传播。
+// 不再使用估算方法（propagateDeocclusion 的虚拟光源 / propagateOcclusion 的阴影半径估算），
+// 因为从单一亮度值无法反推光源参数，估算在数学上就不可能是准确的。
+
+void LightPropagation::relightChanges(const std::vector<LightChange>& changes,
+                                       LightRegion& region) {
+    // 按 8×8×8 网格去重后，逐条按类型分派
+    std::unordered_set<uint64_t> processed;
+    for (const auto& ch : changes) {
+        glm::ivec3 q(ch.pos.x / 8, ch.pos.y / 8, ch.pos.z / 8);
+        uint64_t key = (uint64_t)(uint32_t)q.x
+                     | ((uint64_t)(uint32_t)q.y << 22)
+                     | ((uint64_t)(uint32_t)q.z << 44);
+        if (processed.count(key)) continue;
+        processed.insert(key);
+
+        bool oldEmissive = isEmissive(ch.oldType);
+        bool newEmissive = isEmissive(ch.newType);
+        bool oldOpaque = blocksLight(ch.oldType);
+        bool newOpaque = blocksLight(ch.newType);
+
+        if (newEmissive && !oldEmissive) {
+            // 情况 A：增光源（如火把）—— 仅从新光源 max-clamp 叠加 BFS
+            propagateSingle(ch.pos, region);
+        }
+        else if (oldEmissive && !newEmissive) {
+            // 情况 B：删光源 —— 清空旧范围 + 重传播邻近光源
+            LightDef oldDef = getLightDefForBlock(ch.oldType);
+            removeAndReLight(ch.pos, oldDef.radius, region);
+        }
+        else if (newOpaque && !oldOpaque) {
+            // 情况 C：增遮挡物 —— 清空区域 + 重传播邻近光源（精确重传播）
+            propagateOcclusion(ch.pos, region);
+        }
+        else if (oldOpaque && !newOpaque) {
+            // 情况 D：删遮挡物（如破坏石头）—— 清空区域 + 重传播邻近光源（精确重传播）
+            propagateDeocclusion(ch.pos, region);
+        }
+        // else: 纯透明→纯透明（如玻璃→空气），光照不变，跳过
+    }
 }
@@ -2,11 +2,60 @@
 #include "../core.h"
 #include "LightSource.h"
 #include "LightCache.h"
+#include "../chunk/BlockBox.h"  // ChunkBoxes / ChunkLightSources
 #include <glm/glm.hpp>
 #include <functional>
-#include <unordered_set>
+#include <vector>
 
-class SectionLightCache;  // 前向声明（供 std::function 指针类型使用）
+// 增量光照变动记录：记录位置与变动前后的方块类型，用于区分四种情况
+struct LightChange {
+    glm::ivec3 pos;
+    BlockType oldType;
+    BlockType newType;
+};
+
+// ── 增量重光照的数据视图 ──────────────────────────────────────────
+// 以 (minCX, minCZ) 为左下角的 chunksX×chunksZ 区块稠密网格：方块与光源按 chunk 下标直接索引，
+// 光照缓存首次访问某 section 时经 cacheProvider 取得并记住。
+// 同时满足 LightBfs 的 Grid 访问器接口（hasChunk / box / lightSection / markLit）。
+struct LightRegion {
+    int minCX = 0, minCZ = 0;
+    int chunksX = 0, chunksZ = 0;
+    std::vector<const ChunkBoxes*> boxes;            // chunksX×chunksZ；nullptr = 无方块数据（视为石墙）
+    std::vector<const ChunkLightSources*> sources;   // 同上；nullptr = 无光源
+    // (cx, cz, sy) → 可写光照缓存；仅对有方块数据的 chunk 调用
+    std::function<SectionLightCache*(int cx, int cz, int sy)> cacheProvider;
+
+    void resize(int minChunkX, int minChunkZ, int w, int d) {
+        minCX = minChunkX; minCZ = minChunkZ; chunksX = w; chunksZ = d;
+        boxes.assign((size_t)w * d, nullptr);
+        sources.assign((size_t)w * d, nullptr);
+        m_caches.assign((size_t)w * d * CHUNK_SECTION_COUNT, nullptr);
+    }
+    bool containsChunk(int cx, int cz) const {
+        return cx >= minCX && cx < minCX + chunksX && cz >= minCZ && cz < minCZ + chunksZ;
+    }
+    int chunkIndex(int cx, int cz) const { return (cx - minCX) + (cz - minCZ) * chunksX; }
+
+    // 取 (ci, sy) 的光照缓存；无方块数据的 chunk 返回 nullptr
+    SectionLightCache* cache(int ci, int sy) {
+        SectionLightCache*& c = m_caches[(size_t)ci * CHUNK_SECTION_COUNT + sy];
+        if (!c && boxes[ci]) c = cacheProvider(minCX + ci % chunksX, minCZ + ci / chunksX, sy);
+        return c;
+    }
+
+    // ── LightBfs 访问器 ──
+    bool hasChunk(int ci) const { return boxes[ci] != nullptr; }
+    const BlockBox* box(int ci, int sy) const { return (*boxes[ci])[sy].get(); }
+    uint32_t* lightSection(int ci, int sy) {
+        SectionLightCache* c = cache(ci, sy);
+        return c ? c->mutableRawData() : nullptr;
+    }
+    void markLit(int ci, int sy) { m_caches[(size_t)ci * CHUNK_SECTION_COUNT + sy]->setHasLight(true); }
+
+private:
+    std::vector<SectionLightCache*> m_caches;
+};
 
 // ── 体素洪水填充光照传播 ──────────────────────────────────────────
 // 从光源出发向 6 邻域 BFS，遇不透明方块停止。
@@ -18,48 +67,33 @@ class SectionLightCache;  // 前向声明（供 std::function 指针类型使用
 
 class LightPropagation {
 public:
-    using BlockQuery  = std::function<BlockState(const glm::ivec3&)>;
-    using CacheGetter = std::function<SectionLightCache*(uint64_t)>;
-    using SourceQuery = std::function<std::vector<glm::ivec3>(const glm::ivec3&, const glm::ivec3&)>;
-
     /// 从单个光源位置做 BFS（光源属性从该位置方块类型查表获取）
-    static void propagateSingle(const glm::ivec3& srcPos,
-                                BlockQuery blockQuery,
-                                CacheGetter cacheGetter);
+    static void propagateSingle(const glm::ivec3& srcPos, LightRegion& region);
 
     /// 清空区域并重传播所有影响该区域的光源
-    static void propagateRegion(const glm::ivec3& center, float maxRadius,
-                                SourceQuery sourceQuery,
-                                BlockQuery blockQuery,
-                                CacheGetter cacheGetter);
+    static void propagateRegion(const glm::ivec3& center, float maxRadius, LightRegion& region);
 
     /// 全量传播（初始加载/传送）
     /// sources: 所有光源的世界坐标列表
-    static void propagateAll(const std::vector<glm::ivec3>& sources,
-                             BlockQuery blockQuery,
-                             CacheGetter cacheGetter);
+    static void propagateAll(const std::vector<glm::ivec3>& sources, LightRegion& region);
 
     /// 移除光源后重光照其区域
-    static void removeAndReLight(const glm::ivec3& oldPos, float oldRadius,
-                                 SourceQuery sourceQuery,
-                                 BlockQuery blockQuery,
-                                 CacheGetter cacheGetter);
+    static void removeAndReLight(const glm::ivec3& oldPos, float oldRadius, LightRegion& region);
 
     /// 移除遮挡物后的去遮挡传播。
     /// 精确算法：清空受影响区域 + 重传播所有邻近光源，
     /// 替代了原来依赖估算的 6 向追踪 + 虚拟光源 BFS。
-    static void propagateDeocclusion(const glm::ivec3& openedPos,
-                                     SourceQuery sourceQuery,
-                                     BlockQuery blockQuery,
-                                     CacheGetter cacheGetter);
+    static void propagateDeocclusion(const glm::ivec3& openedPos, LightRegion& region);
 
     /// 新增遮挡物（空气→不透明方块）的阴影传播。
     /// 精确算法：清空受影响区域 + 重传播所有邻近光源，
     /// 替代了原来基于邻居亮度估算阴影半径的近似方法。
-    static void propagateOcclusion(const glm::ivec3& blockedPos,
-                                   SourceQuery sourceQuery,
-                                   BlockQuery blockQuery,
-                                   CacheGetter cacheGetter);
+    static void propagateOcclusion(const glm::ivec3& blockedPos, LightRegion& region);
+
+    /// 一批方块变动的增量重传播：按 8×8×8 网格去重后，逐条按类型分派
+    /// （增光源 / 删光源 / 增遮挡 / 删遮挡；透明→透明跳过）。
+    /// 由 ChunkWorkerPool 的重光照任务在快照出的 LightRegion 上调用。
+    static void relightChanges(const std::vector<LightChange>& changes, LightRegion& region);
 
     /// 判断方块是否阻挡光照传播
     static bool blocksLight(BlockType type);
@@ -69,24 +103,11 @@ public:
     static int getLightOpacity(BlockType type);
 
 private:
-
-    // 多光源合并 BFS：所有种子同时入队，共享 visited + queue，每格只访问一次。
-    // 每格缓存包含 RGB + 曼哈顿距离（alpha 通道）。
-    static void propagateMultiSource(const std::vector<glm::ivec3>& sources,
-                                     BlockQuery blockQuery,
-                                     CacheGetter cacheGetter);
-
-    struct QueueEntry {
-        glm::ivec3 pos;
-        int        dist;
-        float      srcRadius;
-        glm::vec3  srcBrightness;
-    };
-
-    static uint64_t toSectionKey(const glm::ivec3& worldPos);
-    static glm::ivec3 toLocal(const glm::ivec3& worldPos);
+    // 区域内（含边界）的光源世界坐标
+    static std::vector<glm::ivec3> collectSources(const LightRegion& region,
+                                                  const glm::ivec3& min, const glm::ivec3& max);
 
     static void clearSectionCaches(const glm::ivec3& regionMin,
                                    const glm::ivec3& regionMax,
-                                   CacheGetter cacheGetter);
+                                   LightRegion& region);
 };
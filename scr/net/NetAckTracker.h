@@ -0,0 +1,133 @@
+﻿#pragma once
+
+#include <unordered_map>
+#include <deque>
+#include <vector>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+
+// ============================================================================
+// 不可靠通道上的"相对已确认状态做增量"通用件（掉落物同步、玩家移动复制共用）
+// ============================================================================
+
+// 16 位序号比较（回绕安全）：a 是否比 b 新
+inline bool netSeqNewer(uint16_t a, uint16_t b) { return (int16_t)(a - b) > 0; }
+
+// 发送端：记录每条消息带出去的 (key, state)，收到回执后提升为"对端已确认持有"的基线。
+// 基线之后发出、尚未确认的状态按 key 保留为"在途候选"：对端可能已经应用了它们，只是回执丢了
+// 或被扣下。调用方用 diffPending 相对基线和全部候选求变化字段的并集——只和基线比的话，
+// 字段先变后又变回基线值时永远不会重发，对端会停在中间值上。
+// 回执时该 key 的状态整体成为新基线：未发的字段与当时所有候选都相等，对端无论持有哪个都一致。
+template <class Key, class State>
+class NetAckTracker {
+public:
+    // 最多保留的未确认消息数（超出丢最旧的）
+    static constexpr size_t MAX_INFLIGHT = 64;
+    // 每个 key 最多保留的在途候选数；超出时丢最旧的候选并作废基线（下次全量，等更新的回执）
+    static constexpr size_t MAX_PENDING = MAX_INFLIGHT;
+
+    uint16_t takeSeq() { return m_nextSeq++; }
+
+    const State* acked(const Key& key) const {
+        auto it = m_keys.find(key);
+        return it == m_keys.end() || !it->second.valid ? nullptr : &it->second.state;
+    }
+
+    // diff(base) 返回当前状态相对 base 变化的字段（base 为空 = 全量）；这里对基线与每个在途候选
+    // 求并集。没有有效基线时直接全量。
+    template <class DiffFn>
+    auto diffPending(const Key& key, DiffFn&& diff) const
+        -> decltype(diff(static_cast<const State*>(nullptr))) {
+        auto it = m_keys.find(key);
+        if (it == m_keys.end() || !it->second.valid) return diff(static_cast<const State*>(nullptr));
+        auto mask = diff(&it->second.state);
+        for (const auto& p : it->second.pending) mask |= diff(&p.second);
+        return mask;
+    }
+
+    void recordSent(uint16_t seq, std::vector<std::pair<Key, State>>&& items) {
+        for (const auto& [key, state] : items) {
+            KeyState& k = m_keys[key];
+            k.pending.emplace_back(seq, state);
+            if (k.pending.size() > MAX_PENDING) {
+                // 丢掉的候选可能正是对端持有的：基线作废，且不再接受不比它新的回执
+                k.floor = k.pending.front().first;
+                k.hasFloor = true;
+                k.valid = false;
+                k.pending.pop_front();
+            }
+        }
+        m_inflight.push_back({ seq, std::move(items) });
+        if (m_inflight.size() > MAX_INFLIGHT) m_inflight.pop_front();
+    }
+
+    // seq 携带的状态记为已确认，并丢弃各 key 不比它新的候选；更早的未确认消息不再等回执，
+    // 但其中的状态仍作为候选留在各 key 上，直到该 key 被更新的回执覆盖
+    void onAck(uint16_t seq) {
+        onAck(seq, [](const Key&) { return false; });
+    }
+
+    // 部分回执：skip(key) 为 true 的 key 对端没能应用（例如本地还没有该对象），不提升基线、
+    // 候选原样保留，其余照常确认
+    template <class SkipFn>
+    void onAck(uint16_t seq, SkipFn&& skip) {
+        while (!m_inflight.empty() && !netSeqNewer(m_inflight.front().seq, seq)) {
+            Inflight& f = m_inflight.front();
+            if (f.seq == seq) {
+                for (auto& [key, state] : f.items) {
+                    if (skip(key)) continue;
+                    auto it = m_keys.find(key);
+                    if (it == m_keys.end()) continue;  // 发出后已 forget（netId 可能被复用）
+                    KeyState& k = it->second;
+                    if (k.hasFloor && !netSeqNewer(seq, k.floor)) continue;
+                    // 乱序回执：旧消息不覆盖新消息确认过的状态
+                    if (k.valid && netSeqNewer(k.seq, seq)) continue;
+                    k.state = state;
+                    k.seq = seq;
+                    k.valid = true;
+                    k.hasFloor = false;
+                    while (!k.pending.empty() && !netSeqNewer(k.pending.front().first, seq))
+                        k.pending.pop_front();
+                }
+            }
+            m_inflight.pop_front();
+        }
+    }
+
+    void forget(const Key& key) { m_keys.erase(key); }
+    void clear() { m_keys.clear(); m_inflight.clear(); m_nextSeq = 1; }
+
+private:
+    struct KeyState {
+        State state{};                                // 已确认基线
+        uint16_t seq = 0;
+        bool valid = false;
+        bool hasFloor = false;                        // 候选溢出过：不比 floor 新的回执无效
+        uint16_t floor = 0;
+        std::deque<std::pair<uint16_t, State>> pending;  // 基线之后的在途候选（按 seq 递增）
+    };
+    struct Inflight {
+        uint16_t seq;
+        std::vector<std::pair<Key, State>> items;
+    };
+    uint16_t m_nextSeq = 1;
+    std::unordered_map<Key, KeyState> m_keys;
+    std::deque<Inflight> m_inflight;
+};
+
+// 接收端：丢弃比已应用的更旧的消息（不可靠通道会乱序，旧包会把状态倒回去）
+class NetSeqFilter {
+public:
+    bool accept(uint16_t seq) {
+        if (m_valid && !netSeqNewer(seq, m_last)) return false;
+        m_last = seq;
+        m_valid = true;
+        return true;
+    }
+    void reset() { m_valid = false; m_last = 0; }
+
+private:
+    uint16_t m_last = 0;
+    bool m_valid = false;
+};
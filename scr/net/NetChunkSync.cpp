@@ -3,6 +3,7 @@
 #include "../chunk/ChunkManager.h"
 #include "../chunk/Chunk.h"
 #include "../chunk/Section.h"
+#include "lz4.h"
 #include <algorithm>
 #include <cstdio>
 #include <cstring>
@@ -27,6 +28,7 @@ void NetChunkSync::shutdown() {
     m_pendingRequests.clear();
     m_sentChunks.clear();
     m_alivePeers.clear();
+    m_pendingBlockEdits.clear();
 }
 
 void NetChunkSync::submitSerializeJob(int chunkX, int chunkZ, const ChunkBoxes& boxes,
@@ -54,20 +56,23 @@ void NetChunkSync::pollSerializeResults() {
     if (results.empty()) return;
 
     bool sentAny = false;
+    std::vector<ENetPeer*> peers;
     for (auto& res : results) {
         if (res.payload.empty()) continue;
-        // 包一层 CHUNK_DATA header（轻量，不压缩）
-        auto msg = NetMessage::chunkData(res.payload);
-        std::vector<uint8_t> buf;
-        msg.encode(buf);
 
+        peers.clear();
         for (ENetPeer* peer : res.targets) {
             if (!peer) continue;
             // peer 失效复核：result 取回时该 peer 可能已断开
             if (m_alivePeers.find(peer) == m_alivePeers.end()) continue;
-            m_netManager->getTransport().sendReliable(peer, buf.data(), buf.size());
-            sentAny = true;
+            peers.push_back(peer);
         }
+        if (peers.empty()) continue;
+
+        // 套一层 CHUNK_DATA 消息头直接写进包（不压缩），所有目标 peer 共享这一个包
+        m_netManager->getTransport().sendShared(peers, NetMsgType::CHUNK_DATA,
+            res.payload.data(), res.payload.size(), true);
+        sentAny = true;
     }
     if (sentAny) m_netManager->getTransport().flush();
 }
@@ -102,8 +107,6 @@ void NetChunkSync::pushChunks() {
     auto& players = m_netManager->getPlayers();
     if (m_pendingPush.empty()) return;
 
-    const int hostRadius = m_chunkManager->getRenderRadius();
-
     // 本帧投递预算：把多 worker 同时完成的晋升尖峰摊到多帧。序列化已卸载到专用线程，
     // 主线程这里只算相关性 + 拷 ChunkBoxes（shared_ptr）+ 投递，开销很低；预算主要
     // 用于限制 worker 队列与每帧主线程拷贝量。本帧只取队首 budget 个，剩余下帧继续。
@@ -145,7 +148,7 @@ void NetChunkSync::pushChunks() {
                 glm::ivec2 pChunk(
                     (int)std::floor(ppos.x / (float)ChunkConstants::CHUNK_WIDTH),
                     (int)std::floor(ppos.z / (float)ChunkConstants::CHUNK_DEPTH));
-                int pushR = (player->renderRadius > 0) ? player->renderRadius : hostRadius;
+                int pushR = relevanceRadius(*player);
                 int dx = std::abs(pos.x - pChunk.x);
                 int dz = std::abs(pos.y - pChunk.y);
                 if (dx > pushR || dz > pushR) {
@@ -191,6 +194,11 @@ void NetChunkSync::pushChunks() {
     }
 }
 
+int NetChunkSync::relevanceRadius(const NetPlayer& player) const {
+    if (player.renderRadius > 0) return player.renderRadius;
+    return m_chunkManager ? m_chunkManager->getRenderRadius() : 0;
+}
+
 void NetChunkSync::pushAllChunks(ENetPeer* peer) {
     if (!m_chunkManager || !m_netManager || !peer) return;
 
@@ -318,19 +326,164 @@ void NetChunkSync::onChunkUnloaded(int chunkX, int chunkZ) {
     }
 }
 
-void NetChunkSync::broadcastBlockChange(int chunkX, int chunkZ,
-                                        const std::vector<uint8_t>& encodedMsg) {
-    if (!m_netManager) return;
-    ChunkKey key = makeKey(chunkX, chunkZ);
+// ============================================================================
+// 方块修改合并（BLOCK_CHANGE_BATCH）
+// ============================================================================
 
-    // 只发给"已经收到过该 chunk"的客户端（相关性过滤）。
-    // 没加载该 chunk 的客户端将来 CHUNK_REQUEST 时拿到的已是改后的最新快照，无需补发。
-    for (auto& [peer, sent] : m_sentChunks) {
-        if (!peer) continue;
-        if (sent.count(key) == 0) continue;
-        m_netManager->getTransport().sendReliable(peer, encodedMsg.data(), encodedMsg.size());
+void NetChunkSync::queueBlockChange(int32_t worldX, int32_t worldY, int32_t worldZ,
+                                    uint16_t blockStateBits) {
+    if (worldY < 0 || worldY >= ChunkConstants::CHUNK_HEIGHT) return;
+    const int cx = (int)std::floor(worldX / (float)ChunkConstants::CHUNK_WIDTH);
+    const int cz = (int)std::floor(worldZ / (float)ChunkConstants::CHUNK_DEPTH);
+    const int lx = worldX - cx * ChunkConstants::CHUNK_WIDTH;
+    const int lz = worldZ - cz * ChunkConstants::CHUNK_DEPTH;
+    const int sy = worldY / ChunkConstants::SECTION_HEIGHT;
+    const int ly = worldY % ChunkConstants::SECTION_HEIGHT;
+    const uint16_t cell = (uint16_t)((sy << 12) | (ly << 8) | (lz << 4) | lx);
+    m_pendingBlockEdits[makeKey(cx, cz)].push_back({ cell, blockStateBits });
+}
+
+int NetChunkSync::compressSectionSnapshot(int chunkX, int chunkZ, int sectionY) {
+    ChunkBoxes boxes;
+    if (!m_chunkManager || !m_chunkManager->getChunkBoxes(glm::ivec2(chunkX, chunkZ), boxes)) return 0;
+    const auto& box = boxes[sectionY];
+    if (!box) return 0;
+
+    constexpr int SEC_VOL = ChunkConstants::SECTION_HEIGHT * ChunkConstants::CHUNK_WIDTH * ChunkConstants::CHUNK_DEPTH;
+    BlockState blocks[SEC_VOL];
+    {
+        auto lk = box->lockShared();
+        box->copyTo(blocks);
+    }
+    const int srcSize = (int)sizeof(blocks);
+    m_batchCompress.resize((size_t)LZ4_compressBound(srcSize));
+    int n = LZ4_compress_default(reinterpret_cast<const char*>(blocks),
+        reinterpret_cast<char*>(m_batchCompress.data()), srcSize, (int)m_batchCompress.size());
+    return (n > 0 && n <= 0xFFFF) ? n : 0;
+}
+
+void NetChunkSync::flushBlockChanges(ENetPeer* serverPeer) {
+    if (m_pendingBlockEdits.empty() || !m_netManager) return;
+    auto& transport = m_netManager->getTransport();
+
+    std::vector<ENetPeer*> targets;
+    MemoryStream body;
+    for (auto& [key, edits] : m_pendingBlockEdits) {
+        const int cx = (int32_t)(key >> 32);
+        const int cz = (int32_t)(key & 0xFFFFFFFFLL);
+
+        // 1. 相关 peer：客户端只发服务端；服务端只发已收到该 chunk 的客户端。
+        //    没加载该 chunk 的客户端将来 CHUNK_REQUEST 时拿到的已是改后的最新快照，无需补发。
+        targets.clear();
+        if (serverPeer) {
+            targets.push_back(serverPeer);
+        } else {
+            for (auto& [peer, sent] : m_sentChunks) {
+                if (peer && sent.count(key)) targets.push_back(peer);
+            }
+        }
+        if (targets.empty()) continue;
+
+        // 2. 去重：按 cell 稳定排序，同一位置只留最后一次（last-write-wins），同时按 section 分好组
+        std::stable_sort(edits.begin(), edits.end(),
+            [](const PendingBlockEdit& a, const PendingBlockEdit& b) { return a.cell < b.cell; });
+        size_t w = 0;
+        for (size_t i = 0; i < edits.size(); ++i) {
+            if (i + 1 < edits.size() && edits[i + 1].cell == edits[i].cell) continue;
+            edits[w++] = edits[i];
+        }
+        edits.resize(w);
+
+        // 3. 逐 section 编码；加上下一段会超出单条上限时先把已有的发出去
+        uint8_t sectionCount = 0;
+        body.reset();
+        auto emit = [&]() {
+            if (sectionCount == 0) return;
+            NetMessage msg(NetMsgType::BLOCK_CHANGE_BATCH);
+            msg.payload.writePod((int32_t)cx);
+            msg.payload.writePod((int32_t)cz);
+            msg.payload.writePod(sectionCount);
+            msg.payload.writeBytes(body.data(), body.size());
+            transport.sendShared(targets, msg, true);
+            sectionCount = 0;
+            body.reset();
+        };
+
+        for (size_t a = 0; a < edits.size();) {
+            const int sy = edits[a].cell >> 12;
+            size_t b = a;
+            while (b < edits.size() && (edits[b].cell >> 12) == sy) ++b;
+            const uint32_t n = (uint32_t)(b - a);
+
+            // 大批量（爆炸 / 填充）：整段快照压缩后更小就发快照
+            int fullLen = 0;
+            if (!serverPeer && n >= ChunkSyncFormat::BATCH_FULL_MIN_EDITS) {
+                fullLen = compressSectionSnapshot(cx, cz, sy);
+                if (fullLen > 0 && (uint32_t)fullLen >= n * 4) fullLen = 0;
+            }
+            const size_t segBytes = 4 + (fullLen > 0 ? (size_t)fullLen : (size_t)n * 4);
+            if (body.size() + segBytes + 9 > NetConstants::MAX_MSG_PAYLOAD) emit();
+
+            body.writePod((uint8_t)sy);
+            if (fullLen > 0) {
+                body.writePod(ChunkSyncFormat::BATCH_FULL);
+                body.writePod((uint16_t)fullLen);
+                body.writeBytes(m_batchCompress.data(), (size_t)fullLen);
+            } else {
+                body.writePod(ChunkSyncFormat::BATCH_EDITS);
+                body.writePod((uint16_t)n);
+                for (size_t i = a; i < b; ++i) {
+                    body.writePod((uint16_t)(edits[i].cell & 0xFFF));
+                    body.writePod(edits[i].bits);
+                }
+            }
+            ++sectionCount;
+            a = b;
+        }
+        emit();
+    }
+    m_pendingBlockEdits.clear();
+    transport.flush();
+}
+
+bool NetChunkSync::readBatchEdits(MemoryStream& payload) {
+    if (payload.remaining() < sizeof(uint16_t)) return false;
+    const uint16_t n = payload.readPod<uint16_t>();
+    if (payload.remaining() < (size_t)n * 4) return false;
+    m_batchCells.resize(n);
+    m_batchStates.resize(n);
+    for (uint16_t i = 0; i < n; ++i) {
+        m_batchCells[i] = payload.readPod<uint16_t>() & 0xFFF;
+        m_batchStates[i] = BlockState(payload.readPod<uint16_t>());
+    }
+    return true;
+}
+
+void NetChunkSync::onBlockChangeRequest(MemoryStream& payload) {
+    if (!m_chunkManager || payload.remaining() < 9) return;
+    const int32_t cx = payload.readPod<int32_t>();
+    const int32_t cz = payload.readPod<int32_t>();
+    const uint8_t sectionCount = payload.readPod<uint8_t>();
+
+    for (uint8_t s = 0; s < sectionCount; ++s) {
+        if (payload.remaining() < 2) return;
+        const uint8_t sy = payload.readPod<uint8_t>();
+        const uint8_t mode = payload.readPod<uint8_t>();
+        // 客户端只能发逐条改动；整段快照是服务端专用
+        if (sy >= ChunkConstants::SECTION_COUNT || mode != ChunkSyncFormat::BATCH_EDITS) return;
+        if (!readBatchEdits(payload)) return;
+
+        // TODO(校验): 距离/权限/冷却。逐条应用，成功的才记入广播批次。
+        for (size_t i = 0; i < m_batchCells.size(); ++i) {
+            const int cell = m_batchCells[i];
+            glm::ivec3 wp(cx * ChunkConstants::CHUNK_WIDTH + (cell & 15),
+                          sy * ChunkConstants::SECTION_HEIGHT + (cell >> 8),
+                          cz * ChunkConstants::CHUNK_DEPTH + ((cell >> 4) & 15));
+            if (m_chunkManager->applyBlockChange(wp, m_batchStates[i])) {
+                queueBlockChange(wp.x, wp.y, wp.z, m_batchStates[i].bits);
+            }
+        }
     }
-    m_netManager->getTransport().flush();
 }
 
 // ============================================================================
@@ -345,6 +498,45 @@ void NetChunkSync::onChunkData(const uint8_t* data, size_t len) {
     deserializeAndImport(data, len);
 }
 
+void NetChunkSync::onBlockChangeBatch(MemoryStream& payload) {
+    if (!m_chunkManager || payload.remaining() < 9) return;
+    const int32_t cx = payload.readPod<int32_t>();
+    const int32_t cz = payload.readPod<int32_t>();
+    const uint8_t sectionCount = payload.readPod<uint8_t>();
+    const glm::ivec2 chunkPos(cx, cz);
+
+    constexpr int SEC_VOL = ChunkConstants::SECTION_HEIGHT * ChunkConstants::CHUNK_WIDTH * ChunkConstants::CHUNK_DEPTH;
+    for (uint8_t s = 0; s < sectionCount; ++s) {
+        if (payload.remaining() < 2) return;
+        const uint8_t sy = payload.readPod<uint8_t>();
+        const uint8_t mode = payload.readPod<uint8_t>();
+        if (sy >= ChunkConstants::SECTION_COUNT) return;
+
+        if (mode == ChunkSyncFormat::BATCH_EDITS) {
+            if (!readBatchEdits(payload)) return;
+            m_chunkManager->applyBlockChangeBatch(chunkPos, sy,
+                m_batchCells.data(), m_batchStates.data(), (int)m_batchCells.size());
+        } else if (mode == ChunkSyncFormat::BATCH_FULL) {
+            if (payload.remaining() < sizeof(uint16_t)) return;
+            const uint16_t len = payload.readPod<uint16_t>();
+            if (payload.remaining() < len) return;
+            m_batchCompress.resize(len);
+            payload.readBytes(m_batchCompress.data(), len);
+            m_batchStates.resize(SEC_VOL);
+            const int n = LZ4_decompress_safe(reinterpret_cast<const char*>(m_batchCompress.data()),
+                reinterpret_cast<char*>(m_batchStates.data()), len, SEC_VOL * (int)sizeof(BlockState));
+            if (n != SEC_VOL * (int)sizeof(BlockState)) {
+                fprintf(stderr, "[NetChunkSync] BLOCK_CHANGE_BATCH: bad section snapshot (%d,%d) sy=%u\n",
+                    cx, cz, sy);
+                return;
+            }
+            m_chunkManager->applySectionSnapshot(chunkPos, sy, m_batchStates.data());
+        } else {
+            return;
+        }
+    }
+}
+
 void NetChunkSync::deserializeAndImport(const uint8_t* data, size_t len) {
     // 一个 CHUNK_DATA 消息可能包含多个拼接的 chunk（pushChunks 按 16KB 批次打包）。
     // 这里【只走 framing】把每个 chunk 的字节子区间切出来，投递给 worker 线程做 LZ4 解压 + 切片
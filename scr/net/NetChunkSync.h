@@ -1,6 +1,7 @@
 ﻿#pragma once
 
 #include "NetCommon.h"
+#include "NetSerializer.h"
 #include "NetSerializeWorker.h"
 #include "../chunk/BlockType.h"
 #include "../chunk/BlockBox.h"
@@ -15,12 +16,20 @@
 #include "../enet/enet.h"
 class ChunkManager;
 class NetManager;
+class NetPlayer;
 struct BlockState;
 
 // ChunkSync 消息格式常量
 namespace ChunkSyncFormat {
     // section flags
     constexpr uint8_t FLAG_HAS_DATA = 0x01;  // 有方块数据，否则全空气
+
+    // BLOCK_CHANGE_BATCH：int32 chunkX, int32 chunkZ, uint8 sectionCount，
+    // 每个 section：uint8 sectionY, uint8 mode, 然后按 mode：
+    constexpr uint8_t BATCH_EDITS = 0;  // uint16 n + n × (uint16 cell, uint16 stateBits)，cell = section 内 12 位下标
+    constexpr uint8_t BATCH_FULL  = 1;  // uint16 len + LZ4(整 section 4096 个 stateBits)，仅服务端→客户端
+    // 单 section 去重后改动数达到此值才尝试整段回退（压缩后比逐条小才采用）
+    constexpr uint32_t BATCH_FULL_MIN_EDITS = 256;
 }
 
 // 网络地形同步：服务端推送 + 客户端接收
@@ -56,23 +65,43 @@ public:
     // 客户端断连时清理 pending 请求
     void onPeerDisconnected(ENetPeer* peer);
 
+    // ---- per-peer 相关性（掉落物等实体同步复用）----
+
+    // 该 peer 是否已收到（持有）该 chunk 的数据
+    bool peerHasChunk(ENetPeer* peer, int chunkX, int chunkZ) const {
+        auto it = m_sentChunks.find(peer);
+        return it != m_sentChunks.end() && it->second.count(makeKey(chunkX, chunkZ)) != 0;
+    }
+    // 玩家的推送半径（chunk）：上报的 renderRadius，未上报（0）时用服务端自己的
+    int relevanceRadius(const NetPlayer& player) const;
+
     // 服务端 chunk 卸载时：清除所有 peer 对该 chunk 的"已推送"记录，
     // 使玩家再次靠近该区域时能重新收到（最新）数据。
     void onChunkUnloaded(int chunkX, int chunkZ);
 
-    // ---- 服务端：方块修改广播（相关性过滤）----
+    // ---- 方块修改合并（双向，每网络 tick 发一次）----
 
-    // 把一条已编码好的 BLOCK_CHANGE 消息广播给所有"已加载该 chunk"的客户端
-    // （即 m_sentChunks 中含该 chunkKey 的 peer）。excludePeer 可排除发起者外的某 peer，
-    // 传 nullptr 表示发给所有相关 peer（含发起者，保证发起者也通过广播路径生效）。
-    void broadcastBlockChange(int chunkX, int chunkZ,
-                              const std::vector<uint8_t>& encodedMsg);
+    // 记入所属 chunk 的待发批次。服务端：已生效的改动；客户端：待发给服务端的请求。
+    void queueBlockChange(int32_t worldX, int32_t worldY, int32_t worldZ, uint16_t blockStateBits);
+
+    // NetManager::update 末尾调用：每个有改动的 chunk 编成一条 BLOCK_CHANGE_BATCH
+    // （超过 MAX_MSG_PAYLOAD 按 section 边界切成多条），同一位置只保留最后一次修改。
+    //  - serverPeer 非空（客户端）：全部发给服务端，只用 BATCH_EDITS
+    //  - serverPeer 为空（服务端）：只发给"已加载该 chunk"的客户端（m_sentChunks 含该 key，含发起者）；
+    //    大批量 section 退化为整段快照
+    void flushBlockChanges(ENetPeer* serverPeer);
+
+    // 服务端：客户端发来的 BLOCK_CHANGE_BATCH 请求，逐条应用到权威数据，成功的记入广播批次
+    void onBlockChangeRequest(MemoryStream& payload);
 
     // ---- 客户端 ----
 
     // 处理收到的 CHUNK_DATA / CHUNK_RESPONSE payload
     void onChunkData(const uint8_t* data, size_t len);
 
+    // 应用服务端广播的 BLOCK_CHANGE_BATCH：每个 section 一次性交给 ChunkManager 批量落地
+    void onBlockChangeBatch(MemoryStream& payload);
+
 private:
     using ChunkKey = int64_t;
 
@@ -112,4 +141,21 @@ private:
 
     // 从 CHUNK_DATA payload 反序列化为 BlockState buffer + 导入
     void deserializeAndImport(const uint8_t* data, size_t len);
+
+    // ---- 方块修改合并 ----
+    struct PendingBlockEdit {
+        uint16_t cell;      // sectionY << 12 | section 内 12 位下标，排序后按 section 自然分组
+        uint16_t bits;
+    };
+    // chunkKey → 本 tick 的改动（按发生顺序追加，flush 时去重）
+    std::unordered_map<ChunkKey, std::vector<PendingBlockEdit>> m_pendingBlockEdits;
+    // 解码 / 编码复用缓冲
+    std::vector<uint16_t> m_batchCells;
+    std::vector<BlockState> m_batchStates;
+    std::vector<uint8_t> m_batchCompress;
+
+    // 服务端：把权威数据的整个 section 压进 m_batchCompress，返回压缩长度（失败 0）
+    int compressSectionSnapshot(int chunkX, int chunkZ, int sectionY);
+    // 解析一个 BATCH_EDITS 段到 m_batchCells / m_batchStates，长度不足返回 false
+    bool readBatchEdits(MemoryStream& payload);
 };
@@ -75,12 +75,16 @@ enum class NetMsgType : uint8_t {
 
     // === 状态同步 (双向) ===
     PROPERTY_SYNC = 0x10,  // 属性同步 (MVP 双向: 客户端→服务端→广播)
+    PLAYER_MOVE   = 0x11,  // 双向: 玩家移动快照 (量化 + 相对已确认快照增量, 不可靠)
+    PLAYER_MOVE_ACK = 0x12,  // 双向: PLAYER_MOVE 回执 (seq, 不可靠)
+    PROPERTY_BATCH = 0x13,  // 双向: 一个 tick 内多个对象的属性同步合包 (见 NetPropertyBatch.h)
 
     // === 游戏数据 ===
     CHUNK_DATA    = 0x20,  // 服务端→客户端: chunk 方块数据 (LZ4 压缩)
     CHUNK_REQUEST = 0x21,  // 客户端→服务端: 请求 chunk 数据
     CHUNK_RESPONSE= 0x22,  // 服务端→客户端: chunk 数据响应
-    BLOCK_CHANGE  = 0x23,  // 双向: 方块修改 (MVP 后实现)
+    BLOCK_CHANGE  = 0x23,  // 双向: 单个方块修改（保留兼容，发送端已改用 BLOCK_CHANGE_BATCH）
+    BLOCK_CHANGE_BATCH = 0x24,  // 双向: 一个 chunk 一个网络 tick 内的方块修改合并批次
     CHAT_MESSAGE  = 0x30,  // 双向: 聊天 (MVP 后实现)
     INVENTORY_RESTORE = 0x31,  // 服务端→客户端: 加入时恢复该玩家存档的背包
 
@@ -88,8 +92,9 @@ enum class NetMsgType : uint8_t {
     SPAWN_OBJECT  = 0x40,  // 服务端→客户端: 生成一个实体 (typeTag + netId + 初始属性)
     DESTROY_OBJECT= 0x41,  // 服务端→客户端: 销毁一个实体 (netId)
     WORLD_CMD     = 0x42,  // 客户端→服务端: 世界命令请求 (WorldCmdType + 参数)
-    DROPPED_SYNC  = 0x43,  // 服务端→客户端: 掉落物位置/数量批量同步 (高频, 不可靠)
+    DROPPED_SYNC  = 0x43,  // 服务端→客户端: 掉落物位置/数量增量同步 (按 peer 兴趣管理, 不可靠)
     DROP_REQUEST  = 0x44,  // 客户端→服务端: 请求生成掉落物 (客户端丢弃/破坏方块)
+    DROPPED_ACK   = 0x45,  // 客户端→服务端: DROPPED_SYNC 回执 (seq + 未应用的 netId 列表, 不可靠)
 
     // === 内部 ===
     PING          = 0xFE,  // 心跳
@@ -0,0 +1,236 @@
+﻿#include "NetDroppedSync.h"
+#include "NetManager.h"
+#include "../entity/DroppedItem.h"
+#include "../chunk/ChunkDimensions.h"
+#include <algorithm>
+#include <cmath>
+
+void NetDroppedSync::shutdown() {
+    m_peers.clear();
+    m_quantized.clear();
+    m_sendList.clear();
+    m_seqFilter.reset();
+    m_unapplied.clear();
+}
+
+NetDroppedSync::ItemState NetDroppedSync::quantize(const glm::vec3& pos, int count) {
+    using namespace DroppedSyncFormat;
+    ItemState s;
+    s.chunkX = (int32_t)std::floor(pos.x / (float)ChunkConstants::CHUNK_WIDTH);
+    s.chunkZ = (int32_t)std::floor(pos.z / (float)ChunkConstants::CHUNK_DEPTH);
+    const float lx = pos.x - (float)(s.chunkX * ChunkConstants::CHUNK_WIDTH);
+    const float lz = pos.z - (float)(s.chunkZ * ChunkConstants::CHUNK_DEPTH);
+    auto q16 = [](float v) {
+        return (uint16_t)std::clamp((int)std::lround(v), 0, 0xFFFF);
+    };
+    s.q[0] = q16(lx * POS_XZ_SCALE);
+    s.q[1] = q16((pos.y + POS_Y_OFFSET) * POS_Y_SCALE);
+    s.q[2] = q16(lz * POS_XZ_SCALE);
+    s.count = (uint16_t)std::clamp(count, 0, 0xFFFF);
+    return s;
+}
+
+glm::vec3 NetDroppedSync::dequantize(int32_t chunkX, int32_t chunkZ, const uint16_t q[3]) {
+    using namespace DroppedSyncFormat;
+    return glm::vec3(
+        (float)(chunkX * ChunkConstants::CHUNK_WIDTH) + q[0] / POS_XZ_SCALE,
+        q[1] / POS_Y_SCALE - POS_Y_OFFSET,
+        (float)(chunkZ * ChunkConstants::CHUNK_DEPTH) + q[2] / POS_XZ_SCALE);
+}
+
+// ============================================================================
+// 服务端
+// ============================================================================
+
+void NetDroppedSync::broadcast(const DroppedItemStore& items) {
+    using namespace DroppedSyncFormat;
+    if (!m_netManager) return;
+    NetChunkSync& chunkSync = m_netManager->getChunkSync();
+    NetTransport& transport = m_netManager->getTransport();
+
+    // 量化一次，所有 peer 共用
+    const size_t n = items.size();
+    m_quantized.resize(n);
+    for (size_t i = 0; i < n; ++i) m_quantized[i] = quantize(items.pos[i], items.stack[i].count);
+
+    for (auto& [id, player] : m_netManager->getPlayers()) {
+        ENetPeer* peer = player->peer;
+        if (!peer) continue;  // 本地玩家
+        PeerState& ps = m_peers[peer];
+
+        glm::vec3 ppos = player->getRenderPosition();
+        const int pcx = (int)std::floor(ppos.x / (float)ChunkConstants::CHUNK_WIDTH);
+        const int pcz = (int)std::floor(ppos.z / (float)ChunkConstants::CHUNK_DEPTH);
+        const int radius = chunkSync.relevanceRadius(*player);
+
+        m_sendList.clear();
+        for (size_t i = 0; i < n; ++i) {
+            if (items.stack[i].empty()) continue;
+            const ItemState& st = m_quantized[i];
+            // 兴趣管理：玩家推送半径内，且该 peer 已持有所在 chunk
+            if (std::abs(st.chunkX - pcx) > radius || std::abs(st.chunkZ - pcz) > radius) continue;
+            if (!chunkSync.peerHasChunk(peer, st.chunkX, st.chunkZ)) continue;
+
+            // 第一次进入兴趣范围：先可靠地单发 SPAWN（含完整初始状态），增量同步从下个 tick 开始
+            const uint16_t netId = items.netId[i];
+            if (ps.spawned.insert(netId).second) {
+                if (m_spawnWriter) {
+                    NetMessage msg(NetMsgType::SPAWN_OBJECT);
+                    m_spawnWriter(msg.payload, items, i);
+                    transport.send(peer, msg, true);
+                }
+                continue;
+            }
+
+            // 增量：只发与客户端已确认 / 在途状态不同的字段
+            const uint8_t flags = ps.tracker.diffPending(netId, [&](const ItemState* base) -> uint8_t {
+                if (!base) return FLAG_POS | FLAG_COUNT;
+                return (base->samePos(st) ? 0 : FLAG_POS) | (base->count == st.count ? 0 : FLAG_COUNT);
+            });
+            if (flags == 0) continue;
+            m_sendList.push_back({ netId, flags, st });
+        }
+        if (m_sendList.empty()) continue;
+
+        // 按 chunk 分组
+        std::sort(m_sendList.begin(), m_sendList.end(),
+            [](const SentEntry& a, const SentEntry& b) {
+                if (a.state.chunkX != b.state.chunkX) return a.state.chunkX < b.state.chunkX;
+                return a.state.chunkZ < b.state.chunkZ;
+            });
+        emitForPeer(peer, ps);
+    }
+}
+
+void NetDroppedSync::emitForPeer(ENetPeer* peer, PeerState& ps) {
+    using namespace DroppedSyncFormat;
+    NetTransport& transport = m_netManager->getTransport();
+
+    MemoryStream body;       // 已封口的组
+    MemoryStream group;      // 当前组的 item
+    uint16_t groupCount = 0;
+    uint16_t groupItems = 0;
+    int32_t gx = 0, gz = 0;
+    std::vector<std::pair<uint16_t, ItemState>> flight;  // 本条消息带出的状态
+
+    auto closeGroup = [&]() {
+        if (groupItems == 0) return;
+        body.writePod(gx);
+        body.writePod(gz);
+        body.writePod(groupItems);
+        body.writeBytes(group.data(), group.size());
+        ++groupCount;
+        groupItems = 0;
+        group.reset();
+    };
+    auto emit = [&]() {
+        closeGroup();
+        if (groupCount == 0) return;
+        const uint16_t seq = ps.tracker.takeSeq();
+        NetMessage msg(NetMsgType::DROPPED_SYNC);
+        msg.payload.writePod(seq);
+        msg.payload.writePod(groupCount);
+        msg.payload.writeBytes(body.data(), body.size());
+        transport.send(peer, msg, false);
+
+        ps.tracker.recordSent(seq, std::move(flight));
+        flight.clear();
+        groupCount = 0;
+        body.reset();
+    };
+
+    for (const SentEntry& e : m_sendList) {
+        if (groupItems > 0 && (e.state.chunkX != gx || e.state.chunkZ != gz)) closeGroup();
+        const size_t itemBytes = 3 + ((e.flags & FLAG_POS) ? 6 : 0) + ((e.flags & FLAG_COUNT) ? 2 : 0);
+        // 4 = seq + groupCount，10 = 当前组头
+        if (4 + body.size() + 10 + group.size() + itemBytes > MAX_SYNC_BYTES) emit();
+        if (groupItems == 0) { gx = e.state.chunkX; gz = e.state.chunkZ; }
+
+        group.writePod(e.netId);
+        group.writePod(e.flags);
+        if (e.flags & FLAG_POS) {
+            group.writePod(e.state.q[0]);
+            group.writePod(e.state.q[1]);
+            group.writePod(e.state.q[2]);
+        }
+        if (e.flags & FLAG_COUNT) group.writePod(e.state.count);
+        ++groupItems;
+        flight.emplace_back(e.netId, e.state);
+    }
+    emit();
+}
+
+void NetDroppedSync::onAck(ENetPeer* peer, MemoryStream& payload) {
+    if (payload.remaining() < 2 * sizeof(uint16_t)) return;
+    const uint16_t seq = payload.readPod<uint16_t>();
+    const uint16_t n = payload.readPod<uint16_t>();
+    if (payload.remaining() < n * sizeof(uint16_t)) return;
+    auto pit = m_peers.find(peer);
+    if (pit == m_peers.end()) return;
+
+    // 未应用列表通常为空或只有几项，线性查找即可
+    m_unapplied.resize(n);
+    for (uint16_t k = 0; k < n; ++k) m_unapplied[k] = payload.readPod<uint16_t>();
+    pit->second.tracker.onAck(seq, [this](uint16_t netId) {
+        return std::find(m_unapplied.begin(), m_unapplied.end(), netId) != m_unapplied.end();
+    });
+}
+
+void NetDroppedSync::onItemDespawned(uint16_t netId) {
+    for (auto& [peer, ps] : m_peers) {
+        ps.tracker.forget(netId);
+        ps.spawned.erase(netId);
+    }
+}
+
+// ============================================================================
+// 客户端
+// ============================================================================
+
+void NetDroppedSync::onSync(MemoryStream& payload,
+                            const std::function<bool(uint16_t, const glm::vec3*, int)>& apply) {
+    using namespace DroppedSyncFormat;
+    if (payload.remaining() < 4) return;
+    const uint16_t seq = payload.readPod<uint16_t>();
+    const uint16_t groupCount = payload.readPod<uint16_t>();
+    // 不可靠通道可能乱序：比已应用的旧的整条丢弃（不回执，服务端会重发仍有差异的 item）
+    if (!m_seqFilter.accept(seq)) return;
+
+    m_unapplied.clear();
+    for (uint16_t g = 0; g < groupCount; ++g) {
+        if (payload.remaining() < 10) return;
+        const int32_t cx = payload.readPod<int32_t>();
+        const int32_t cz = payload.readPod<int32_t>();
+        const uint16_t n = payload.readPod<uint16_t>();
+        for (uint16_t k = 0; k < n; ++k) {
+            if (payload.remaining() < 3) return;
+            const uint16_t netId = payload.readPod<uint16_t>();
+            const uint8_t flags = payload.readPod<uint8_t>();
+            glm::vec3 pos;
+            const glm::vec3* posPtr = nullptr;
+            int count = 0;
+            if (flags & FLAG_POS) {
+                if (payload.remaining() < 6) return;
+                uint16_t q[3];
+                q[0] = payload.readPod<uint16_t>();
+                q[1] = payload.readPod<uint16_t>();
+                q[2] = payload.readPod<uint16_t>();
+                pos = dequantize(cx, cz, q);
+                posPtr = &pos;
+            }
+            if (flags & FLAG_COUNT) {
+                if (payload.remaining() < 2) return;
+                count = payload.readPod<uint16_t>();
+            }
+            if (!apply(netId, posPtr, count)) m_unapplied.push_back(netId);
+        }
+    }
+
+    if (!m_netManager) return;
+    // 逐 item 回执：只有本地还没有的 item 保持未确认，不连累同条消息里已应用的其他 item
+    MemoryStream ack;
+    ack.writePod(seq);
+    ack.writePod((uint16_t)m_unapplied.size());
+    for (uint16_t netId : m_unapplied) ack.writePod(netId);
+    m_netManager->sendToServer(NetMsgType::DROPPED_ACK, ack, false);
+}
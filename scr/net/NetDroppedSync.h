@@ -0,0 +1,108 @@
+﻿#pragma once
+
+#include "NetCommon.h"
+#include "NetSerializer.h"
+#include "NetAckTracker.h"
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <functional>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "../enet/enet.h"
+class NetManager;
+struct DroppedItemStore;
+
+// DROPPED_SYNC 消息格式常量
+namespace DroppedSyncFormat {
+    // DROPPED_SYNC：uint16 seq, uint16 groupCount，每组（一个 chunk）：
+    //   int32 chunkX, int32 chunkZ, uint16 n，每个 item：
+    //   uint16 netId, uint8 flags, [FLAG_POS: uint16 x, y, z], [FLAG_COUNT: uint16 count]
+    // DROPPED_ACK：uint16 seq, uint16 n, n × uint16 netId（客户端收到后回执，不可靠）；
+    //   列出的是本地还没有、没能应用的 item（SPAWN 尚未到达），其余 item 视为已确认
+    constexpr uint8_t FLAG_POS   = 0x01;
+    constexpr uint8_t FLAG_COUNT = 0x02;
+
+    // 位置量化（相对所在 chunk 原点）：x/z ∈ [0,16) 精度 1/4096，y ∈ [-64,448) 精度 1/128
+    constexpr float POS_XZ_SCALE = 4096.0f;
+    constexpr float POS_Y_SCALE  = 128.0f;
+    constexpr float POS_Y_OFFSET = 64.0f;
+
+    // 单条消息预算：压在一个 MTU 内，避免 ENet 对不可靠包分片（丢一片整包作废）
+    constexpr size_t MAX_SYNC_BYTES = 1200;
+}
+
+// 掉落物位置/数量同步：服务端按 peer 做兴趣管理 + 增量
+//  - 只同步落在该玩家推送半径内、且该 peer 已持有所在 chunk 的掉落物（复用 NetChunkSync 的相关性）
+//  - 位置按 chunk 分组、相对 chunk 原点量化成 uint16
+//  - 每个 peer 记录"客户端已确认持有"的量化状态与在途状态，只发与之不同的字段；
+//    消息丢失时对应 item 未被确认，下个同步 tick 自动重发
+//  - item 第一次进入某 peer 的兴趣范围时，先给它单发可靠的 SPAWN_OBJECT（晚加入的玩家也能拿到
+//    场上已有的掉落物）；销毁仍走可靠的 DESTROY_OBJECT 全量广播
+class NetDroppedSync {
+public:
+    void init(NetManager* net) { m_netManager = net; }
+    void shutdown();
+
+    // ---- 服务端 ----
+
+    // SPAWN_OBJECT 的负载编码（World 提供，与客户端解码放在一处）：写第 index 个 item
+    using SpawnWriter = std::function<void(MemoryStream&, const DroppedItemStore&, size_t)>;
+    void setSpawnWriter(SpawnWriter writer) { m_spawnWriter = std::move(writer); }
+
+    // 同步 tick（World 节流调用）：给每个远程 peer 发其相关且有变化的 item
+    void broadcast(const DroppedItemStore& items);
+    // 客户端回执：把该 seq 携带的状态记为已确认（回执里列出的未应用 item 除外）
+    void onAck(ENetPeer* peer, MemoryStream& payload);
+    void onPeerDisconnected(ENetPeer* peer) { m_peers.erase(peer); }
+    // item 销毁：清掉各 peer 对它的记录与"已生成"标记（netId 可能被复用）
+    void onItemDespawned(uint16_t netId);
+
+    // ---- 客户端 ----
+
+    // 解码 DROPPED_SYNC，逐项回调 apply(netId, pos 或 nullptr, count 或 0)。
+    // apply 返回 false 表示本地还没有该 item（SPAWN 尚未到达）：回执里把它列为未应用，
+    // 服务端只对它保持未确认、下个 tick 重发，其余 item 照常确认。过期（seq 比已应用的旧）的消息直接丢弃。
+    void onSync(MemoryStream& payload,
+                const std::function<bool(uint16_t, const glm::vec3*, int)>& apply);
+
+private:
+    // 一个 item 的量化状态（比较即判断"是否变化"）
+    struct ItemState {
+        int32_t  chunkX = 0, chunkZ = 0;
+        uint16_t q[3] = { 0, 0, 0 };
+        uint16_t count = 0;
+        bool samePos(const ItemState& o) const {
+            return chunkX == o.chunkX && chunkZ == o.chunkZ &&
+                   q[0] == o.q[0] && q[1] == o.q[1] && q[2] == o.q[2];
+        }
+    };
+    struct SentEntry {
+        uint16_t netId;
+        uint8_t flags;      // 相对已确认状态变化的字段（FLAG_POS / FLAG_COUNT）
+        ItemState state;
+    };
+    struct PeerState {
+        NetAckTracker<uint16_t, ItemState> tracker;  // netId → 客户端已确认 / 在途状态
+        std::unordered_set<uint16_t> spawned;        // 已给该 peer 发过 SPAWN 的 item
+    };
+
+    NetManager* m_netManager = nullptr;
+    SpawnWriter m_spawnWriter;
+    std::unordered_map<ENetPeer*, PeerState> m_peers;
+
+    // 客户端：丢弃比已应用的更旧的消息，避免乱序把位置倒回去
+    NetSeqFilter m_seqFilter;
+    std::vector<uint16_t> m_unapplied;    // 本条消息里本地还没有的 item（回执时列出）
+
+    // 编码复用缓冲
+    std::vector<ItemState> m_quantized;   // 本 tick 每个 item 的量化状态（所有 peer 共用）
+    std::vector<SentEntry> m_sendList;
+
+    static ItemState quantize(const glm::vec3& pos, int count);
+    static glm::vec3 dequantize(int32_t chunkX, int32_t chunkZ, const uint16_t q[3]);
+
+    // 把 m_sendList（已按 chunk 排好）切成若干条 ≤ MAX_SYNC_BYTES 的消息发给 peer
+    void emitForPeer(ENetPeer* peer, PeerState& ps);
+};
@@ -28,7 +28,9 @@ void WorldState::mirror(float h, float s, bool moving) {
     if (mb != m_sunMoving) { m_sunMoving = mb; markDirty(2); }
 }
 
-NetManager::NetManager() = default;
+NetManager::NetManager() {
+    m_moveSync.init(this);
+}
 
 NetManager::~NetManager() {
     leave();
@@ -142,16 +144,14 @@ bool NetManager::join(const std::string& ip, uint16_t port, const std::string& p
                     // peer 现在 CONNECTED，发送 JOIN_REQUEST（带本机渲染半径）。走出站队列。
                     uint16_t myRadius = (uint16_t)RuntimeConfig::get().renderRadius;
                     auto joinReq = NetMessage::joinRequest(playerName, myRadius);
-                    std::vector<uint8_t> joinBuf;
-                    joinReq.encode(joinBuf);
-                    m_transport.sendReliable(serverPeer, joinBuf.data(), joinBuf.size());
+                    m_transport.send(serverPeer, joinReq, true);
                     m_transport.flush();
                     joinRequestSent = true;
                     printf("[NetManager] JOIN_REQUEST sent (elapsed=%lldms)\n",
                         duration_cast<milliseconds>(steady_clock::now() - startTime).count());
                 } else if (ev.type == NetEvent::Data) {
                     NetMessage netMsg;
-                    if (NetMessage::decode(ev.data.data(), ev.data.size(), netMsg)) {
+                    if (NetMessage::decodeView(ev.data(), ev.size(), netMsg)) {
                         printf("[NetManager] received msg type=0x%02X (elapsed=%lldms)\n",
                             (int)netMsg.type,
                             duration_cast<milliseconds>(steady_clock::now() - startTime).count());
@@ -252,6 +252,9 @@ void NetManager::leave() {
     // 停止序列化线程：join 之前不能销毁 host / 清空容器，否则在途 result 取回时悬空。
     // worker 本身不碰 ENet（只产 payload），故顺序上先 stop 最安全。
     m_chunkSync.shutdown();
+    m_droppedSync.shutdown();
+    m_moveSync.shutdown();
+    m_nextServerTick = 0.0;
 
     if (m_isHost) {
         // 关服前持久化所有在线远程玩家的背包
@@ -307,50 +310,69 @@ void NetManager::update() {
 
     // 3. 收集脏属性并同步
     if (m_isHost) {
-        PROFILE_SCOPE("net.propSync");
-        // 服务端：收集所有 NetObject 的脏属性，发送给所有客户端
-        std::vector<NetMessage> relMsgs, unrelMsgs;
-        m_objManager.collectDirty(relMsgs, unrelMsgs);
-
-        for (auto& msg : relMsgs) {
-            sendToAll(nullptr, msg, true);
-        }
-        for (auto& msg : unrelMsgs) {
-            sendToAll(nullptr, msg, false);
-        }
-
-        // 清除脏标记
-        for (auto& pair : m_objManager.allObjects()) {
-            pair.second->clearDirty();
+        // 服务端按固定 tick 发：两 tick 之间的多次采样只发最新一次（脏标记留到 tick 再清）
+        if (consumeServerTick()) {
+            PROFILE_SCOPE("net.propSync");
+            // 移动属性走专用编码（量化 + 增量，一个 peer 一条消息）
+            m_moveSync.broadcast();
+
+            // 其余属性：所有 NetObject 的脏属性合成 PROPERTY_BATCH 包（与 peer 无关，组一次），
+            // 每个包原样发给所有客户端
+            m_propBatch.begin();
+            m_objManager.collectDirty(m_propBatch);
+            const auto& peers = remotePeers();
+            m_propBatch.flush([&](bool reliable, const uint8_t* data, size_t len) {
+                m_transport.sendShared(peers, data, len, reliable);
+            });
+
+            // 清除脏标记
+            for (auto& pair : m_objManager.allObjects()) {
+                pair.second->clearDirty();
+            }
         }
     } else {
         PROFILE_SCOPE("net.propSync");
         // 客户端：把所有「自己 owner」的对象的脏属性上报服务端，按可靠性分通道。
         // 目前只有本地玩家一个 owner 对象，但泛化后新增 owner 对象无需再改这里。
         if (m_serverPeer) {
-            for (auto& [id, obj] : m_objManager.allObjects()) {
-                if (obj->getOwnerId() != m_localPlayerId) continue;
-                if (!obj->isDirty()) continue;
-
-                MemoryStream rel, unrel;
-                obj->serializeDirtySplit(rel, unrel);
+            // 本地玩家移动：量化快照单独上报（serializeDirtySplit 会跳过这些属性）
+            if (m_localNetState && m_localNetState->hasMovementDirty())
+                m_moveSync.sendLocal(*m_localNetState, m_localPlayerId, m_serverPeer);
+
+            // 其余属性合成 PROPERTY_BATCH 包上报
+            m_propBatch.begin();
+            m_objManager.collectOwnedDirty(m_localPlayerId, m_propBatch);
+            m_propBatch.flush([this](bool reliable, const uint8_t* data, size_t len) {
+                if (reliable) m_transport.sendReliable(m_serverPeer, data, len);
+                else          m_transport.sendUnreliable(m_serverPeer, data, len);
+            });
 
-                if (rel.size() > 0) {
-                    auto msg = NetMessage::propertySync(obj->getNetId(), rel);
-                    std::vector<uint8_t> buf;
-                    msg.encode(buf);
-                    m_transport.sendReliable(m_serverPeer, buf.data(), buf.size());
-                }
-                if (unrel.size() > 0) {
-                    auto msg = NetMessage::propertySync(obj->getNetId(), unrel);
-                    std::vector<uint8_t> buf;
-                    msg.encode(buf);
-                    m_transport.sendUnreliable(m_serverPeer, buf.data(), buf.size());
-                }
-                obj->clearDirty();
+            for (auto& [id, obj] : m_objManager.allObjects()) {
+                if (obj->getOwnerId() == m_localPlayerId) obj->clearDirty();
             }
         }
     }
+
+    // 4. 本 tick 攒下的方块修改：每个 chunk 合并成一条 BLOCK_CHANGE_BATCH 发出
+    {
+        PROFILE_SCOPE("net.blockBatch");
+        m_chunkSync.flushBlockChanges(m_isHost ? nullptr : m_serverPeer);
+    }
+
+    // 出站拷贝量（调用方缓冲 → ENetPacket；入站已原地读不计）。Profiler 每秒汇总即为字节/秒。
+    Profiler::addCounter("net.bytesCopied", (int64_t)m_transport.takeBytesCopied());
+}
+
+bool NetManager::consumeServerTick() {
+    float rate = RuntimeConfig::get().netTickRate;
+    if (rate < 1.0f) rate = 1.0f;
+    const double interval = 1.0 / rate;
+    const double now = netNowSeconds();
+    if (m_nextServerTick == 0.0) m_nextServerTick = now;
+    if (now < m_nextServerTick) return false;
+    m_nextServerTick += interval;
+    if (m_nextServerTick < now) m_nextServerTick = now + interval;  // 长卡顿后不连发补 tick
+    return true;
 }
 
 void NetManager::updateSerializeThreadCount() {
@@ -398,6 +420,9 @@ void NetManager::dispatchEvents() {
 
                 // 清理地形同步中的 pending 请求
                 m_chunkSync.onPeerDisconnected(ev.peer);
+                m_droppedSync.onPeerDisconnected(ev.peer);
+                m_moveSync.onPeerDisconnected(ev.peer);
+                m_moveSync.onPlayerLeft(pid);
 
                 // 广播给其他人
                 if (m_isHost) {
@@ -418,7 +443,7 @@ void NetManager::dispatchEvents() {
 
         case NetEvent::Data: {
             NetMessage msg;
-            if (!NetMessage::decode(ev.data.data(), ev.data.size(), msg)) break;
+            if (!NetMessage::decodeView(ev.data(), ev.size(), msg)) break;
             dispatchMessage(ev.peer, msg);
             break;
         }
@@ -464,6 +489,23 @@ void NetManager::dispatchMessage(ENetPeer* peer, NetMessage& msg) {
         else          handlePropertySyncClient(payload);
         break;
 
+    case NetMsgType::PROPERTY_BATCH:
+        handlePropertyBatch(payload);
+        break;
+
+    case NetMsgType::PLAYER_MOVE:
+        if (m_isHost) {
+            auto it = m_peerToPlayer.find(peer);
+            if (it != m_peerToPlayer.end()) m_moveSync.onMoveFromClient(peer, it->second, payload);
+        } else {
+            m_moveSync.onMoveFromServer(payload);
+        }
+        break;
+
+    case NetMsgType::PLAYER_MOVE_ACK:
+        m_moveSync.onAck(peer, payload);
+        break;
+
     case NetMsgType::CHUNK_DATA:
     case NetMsgType::CHUNK_RESPONSE:
         if (!m_isHost) {
@@ -480,6 +522,11 @@ void NetManager::dispatchMessage(ENetPeer* peer, NetMessage& msg) {
         else          handleBlockChangeClient(payload);
         break;
 
+    case NetMsgType::BLOCK_CHANGE_BATCH:
+        if (m_isHost) m_chunkSync.onBlockChangeRequest(payload);
+        else          m_chunkSync.onBlockChangeBatch(payload);
+        break;
+
     case NetMsgType::WORLD_CMD:
         if (m_isHost) handleWorldCmd(payload);
         break;
@@ -488,6 +535,10 @@ void NetManager::dispatchMessage(ENetPeer* peer, NetMessage& msg) {
         if (!m_isHost) handleInventoryRestore(payload);
         break;
 
+    case NetMsgType::DROPPED_ACK:
+        if (m_isHost) m_droppedSync.onAck(peer, payload);
+        break;
+
     // 通用游戏消息：交由 World 注册的处理器按类型分派（掉落物 spawn/despawn/同步/生成请求）
     case NetMsgType::SPAWN_OBJECT:
     case NetMsgType::DESTROY_OBJECT:
@@ -572,9 +623,7 @@ void NetManager::handleJoinRequest(ENetPeer* peer, MemoryStream& payload) {
             hyaw = m_localNetState->m_yaw;
         }
         auto msg = NetMessage::joinAccept(newId, m_worldSeed, hx, hy, hz, hyaw, skinName, m_worldName);
-        std::vector<uint8_t> buf;
-        msg.encode(buf);
-        m_transport.sendReliable(peer, buf.data(), buf.size());
+        m_transport.send(peer, msg, true);
     }
 
     // 发送当前在线玩家列表给新玩家（含位置信息）
@@ -597,9 +646,7 @@ void NetManager::handleJoinRequest(ENetPeer* peer, MemoryStream& payload) {
             }
         }
         auto msg = NetMessage::playerList(list, posData.data(), yawData.data(), &skinNames);
-        std::vector<uint8_t> buf;
-        msg.encode(buf);
-        m_transport.sendReliable(peer, buf.data(), buf.size());
+        m_transport.send(peer, msg, true);
     }
 
     // 广播 PLAYER_JOINED 给其他人（含初始位置）
@@ -624,9 +671,7 @@ void NetManager::handleJoinRequest(ENetPeer* peer, MemoryStream& payload) {
                 static_cast<PlayerNetState*>(obj)->m_inventory = savedInv;
             NetMessage invMsg(NetMsgType::INVENTORY_RESTORE);
             NetTypeSerializer<InventoryData>::write(invMsg.payload, savedInv);
-            std::vector<uint8_t> invBuf;
-            invMsg.encode(invBuf);
-            m_transport.sendReliable(peer, invBuf.data(), invBuf.size());
+            m_transport.send(peer, invMsg, true);
         }
     }
 
@@ -643,7 +688,10 @@ void NetManager::handlePropertySyncServer(ENetPeer* peer, MemoryStream& payload)
     // 读取 payload: netObjId + 属性数据
     if (payload.remaining() < sizeof(uint16_t)) return;
     uint16_t netObjId = payload.readPod<uint16_t>();
+    applyPropertySyncServer(netObjId, payload);
+}
 
+void NetManager::applyPropertySyncServer(uint16_t netObjId, MemoryStream& payload) {
     NetObject* obj = m_objManager.findObject(netObjId);
     if (!obj) return;
 
@@ -660,22 +708,6 @@ void NetManager::handlePropertySyncServer(ENetPeer* peer, MemoryStream& payload)
             obj->markDirty(propId);
         }
     }
-
-    // 若本次含位置更新，为对应远程玩家压入一个插值快照（Host 也要看别的客户端平滑移动）。
-    pushInterpSnapshotIfMoved(netObjId, obj, applied);
-}
-
-// 若 applied 含位置属性（propId 0），把该玩家当前 pos/yaw/pitch/vel 压入其插值缓冲。
-// netObjId==playerId 时才是玩家对象；本地玩家不入缓冲（本地用自身实时数据渲染）。
-void NetManager::pushInterpSnapshotIfMoved(uint16_t netObjId, NetObject* obj,
-                                           const std::vector<uint16_t>& applied) {
-    if (netObjId == m_localPlayerId) return;
-    bool moved = std::find(applied.begin(), applied.end(), (uint16_t)0) != applied.end();
-    if (!moved) return;
-    auto it = m_players.find(netObjId);
-    if (it == m_players.end()) return;
-    auto* ps = static_cast<PlayerNetState*>(obj);
-    it->second->pushInterpSnapshot(ps->m_position, ps->m_yaw, ps->m_pitch, ps->m_velocity);
 }
 
 // ============================================================================
@@ -811,22 +843,36 @@ void NetManager::handlePlayerList(MemoryStream& payload) {
     }
 }
 
+void NetManager::handlePropertyBatch(MemoryStream& payload) {
+    // 逐条取出属性数据（视图，不拷贝），交给与 PROPERTY_SYNC 相同的应用函数，
+    // 保证单条与批量两条路径的语义（应用、转发标脏、清脏）完全一致。
+    using namespace PropertyBatchFormat;
+    while (payload.remaining() >= ENTRY_HEADER_BYTES) {
+        uint16_t netObjId = payload.readPod<uint16_t>();
+        uint16_t len = payload.readPod<uint16_t>();
+        if (payload.remaining() < len) return;  // 截断的包：丢弃余下部分
+
+        m_batchEntry.setView(payload.readSpan(len), len);
+        if (m_isHost) applyPropertySyncServer(netObjId, m_batchEntry);
+        else          applyPropertySyncClient(netObjId, m_batchEntry);
+    }
+}
+
 void NetManager::handlePropertySyncClient(MemoryStream& payload) {
     if (payload.remaining() < sizeof(uint16_t)) return;
     uint16_t netObjId = payload.readPod<uint16_t>();
+    applyPropertySyncClient(netObjId, payload);
+}
 
+void NetManager::applyPropertySyncClient(uint16_t netObjId, MemoryStream& payload) {
     NetObject* obj = m_objManager.findObject(netObjId);
     if (!obj) {
         // 未知对象（可能还未创建），静默跳过
         return;
     }
 
-    std::vector<uint16_t> applied;
-    obj->deserialize(payload, &applied);
+    obj->deserialize(payload);
     obj->clearDirty();  // 远程对象不需要再往外同步
-
-    // 若本次含位置更新，为对应远程玩家压入一个插值快照。
-    pushInterpSnapshotIfMoved(netObjId, obj, applied);
 }
 
 void NetManager::handleChunkData(MemoryStream& payload) {
@@ -865,19 +911,19 @@ std::string NetManager::getLocalSkinName() const {
     return "steve";
 }
 
-void NetManager::sendToAll(ENetPeer* exclude, const NetMessage& msg, bool reliable) {
-    std::vector<uint8_t> buf;
-    msg.encode(buf);
-
+const std::vector<ENetPeer*>& NetManager::remotePeers(ENetPeer* exclude) {
+    m_peerScratch.clear();
     for (auto& [id, player] : m_players) {
         if (!player->peer) continue;
         if (player->peer == exclude) continue;
-        if (reliable) {
-            m_transport.sendReliable(player->peer, buf.data(), buf.size());
-        } else {
-            m_transport.sendUnreliable(player->peer, buf.data(), buf.size());
-        }
+        m_peerScratch.push_back(player->peer);
     }
+    return m_peerScratch;
+}
+
+void NetManager::sendToAll(ENetPeer* exclude, const NetMessage& msg, bool reliable) {
+    // 所有 peer 共享同一个包
+    m_transport.sendShared(remotePeers(exclude), msg, reliable);
 }
 
 void NetManager::sendToAll(const NetMessage& msg, bool reliable) {
@@ -885,35 +931,27 @@ void NetManager::sendToAll(const NetMessage& msg, bool reliable) {
 }
 
 void NetManager::sendChunkData(ENetPeer* peer, const std::vector<uint8_t>& compressedData) {
-    auto msg = NetMessage::chunkData(compressedData);
-    std::vector<uint8_t> buf;
-    msg.encode(buf);
-    m_transport.sendReliable(peer, buf.data(), buf.size());
+    // 直接把 chunk 数据写进包（不先包成 NetMessage）
+    m_transport.send(peer, NetMsgType::CHUNK_DATA,
+                     compressedData.data(), compressedData.size(), true);
 }
 
 void NetManager::broadcastChunkData(const std::vector<uint8_t>& compressedData) {
-    auto msg = NetMessage::chunkData(compressedData);
-    std::vector<uint8_t> buf;
-    msg.encode(buf);
-
-    for (auto& [id, player] : m_players) {
-        if (!player->peer) continue;
-        m_transport.sendReliable(player->peer, buf.data(), buf.size());
-    }
+    m_transport.sendShared(remotePeers(), NetMsgType::CHUNK_DATA,
+                           compressedData.data(), compressedData.size(), true);
 }
 
 void NetManager::sendChunkRequest(int32_t chunkX, int32_t chunkZ) {
     if (m_isHost || !m_serverPeer) return;
     auto msg = NetMessage::chunkRequest(chunkX, chunkZ);
-    std::vector<uint8_t> buf;
-    msg.encode(buf);
-    m_transport.sendReliable(m_serverPeer, buf.data(), buf.size());
+    m_transport.send(m_serverPeer, msg, true);
     m_transport.flush();
 }
 
 void NetManager::setChunkManager(ChunkManager* cm) {
     m_chunkManager = cm;
     m_chunkSync.init(cm, this);
+    m_droppedSync.init(this);
 
     // host / join 都在此创建世界状态对象（固定 netId，两端一致才能收发 PROPERTY_SYNC）
     ensureWorldState();
@@ -930,35 +968,20 @@ void NetManager::setChunkManager(ChunkManager* cm) {
 // 方块修改同步
 // ============================================================================
 
-static inline void worldToChunkXZ(int32_t wx, int32_t wz, int& cx, int& cz) {
-    constexpr int W = 16;  // Chunk::WIDTH / DEPTH
-    cx = (wx >= 0) ? (wx / W) : -(((-wx) + W - 1) / W);
-    cz = (wz >= 0) ? (wz / W) : -(((-wz) + W - 1) / W);
-}
-
 void NetManager::requestBlockChange(int32_t worldX, int32_t worldY, int32_t worldZ,
                                     uint16_t blockStateBits) {
     if (!m_connected) return;
 
     if (m_isHost) {
-        // 服务端权威：直接应用到本地权威数据 + 广播给相关客户端（含 Host 自己已生效）
+        // 服务端权威：立即应用到本地权威数据（Host 自己马上看到），广播留到本 tick 末尾合并发送
         if (m_chunkManager) {
             m_chunkManager->applyBlockChange(glm::ivec3(worldX, worldY, worldZ),
                                              BlockState(blockStateBits));
         }
-        auto msg = NetMessage::blockChange(worldX, worldY, worldZ, blockStateBits);
-        std::vector<uint8_t> buf;
-        msg.encode(buf);
-        int cx, cz;
-        worldToChunkXZ(worldX, worldZ, cx, cz);
-        m_chunkSync.broadcastBlockChange(cx, cz, buf);
+        m_chunkSync.queueBlockChange(worldX, worldY, worldZ, blockStateBits);
     } else if (m_serverPeer) {
-        // 客户端：只发请求，不本地应用，等服务端广播回来
-        auto msg = NetMessage::blockChange(worldX, worldY, worldZ, blockStateBits);
-        std::vector<uint8_t> buf;
-        msg.encode(buf);
-        m_transport.sendReliable(m_serverPeer, buf.data(), buf.size());
-        m_transport.flush();
+        // 客户端：只记请求，不本地应用；tick 末尾合并成 BLOCK_CHANGE_BATCH 发给服务端，等广播回来
+        m_chunkSync.queueBlockChange(worldX, worldY, worldZ, blockStateBits);
     }
 }
 
@@ -980,13 +1003,8 @@ void NetManager::handleBlockChangeServer(ENetPeer* peer, MemoryStream& payload)
         }
     }
 
-    // 广播给所有相关客户端（含发起者，使其通过统一广播路径生效）
-    auto msg = NetMessage::blockChange(wx, wy, wz, bits);
-    std::vector<uint8_t> buf;
-    msg.encode(buf);
-    int cx, cz;
-    worldToChunkXZ(wx, wz, cx, cz);
-    m_chunkSync.broadcastBlockChange(cx, cz, buf);
+    // 记入广播批次，tick 末尾发给所有相关客户端（含发起者，使其通过统一广播路径生效）
+    m_chunkSync.queueBlockChange(wx, wy, wz, bits);
 }
 
 // ============================================================================
@@ -998,10 +1016,7 @@ void NetManager::sendWorldCmd(WorldCmdType type, float param, bool reliable) {
     NetMessage msg(NetMsgType::WORLD_CMD);
     msg.payload.writePod((uint8_t)type);
     msg.payload.writePod(param);
-    std::vector<uint8_t> buf;
-    msg.encode(buf);
-    if (reliable) m_transport.sendReliable(m_serverPeer, buf.data(), buf.size());
-    else          m_transport.sendUnreliable(m_serverPeer, buf.data(), buf.size());
+    m_transport.send(m_serverPeer, msg, reliable);
 }
 
 void NetManager::handleWorldCmd(MemoryStream& payload) {
@@ -1042,19 +1057,12 @@ bool NetManager::takeRestoredInventory(InventoryData& out) {
 // ============================================================================
 
 void NetManager::broadcast(NetMsgType type, MemoryStream& payload, bool reliable) {
-    NetMessage msg(type);
-    if (payload.size() > 0) msg.payload.writeBytes(payload.data(), payload.size());
-    sendToAll(msg, reliable);
+    m_transport.sendShared(remotePeers(), type, payload.data(), payload.size(), reliable);
 }
 
 void NetManager::sendToServer(NetMsgType type, MemoryStream& payload, bool reliable) {
     if (m_isHost || !m_serverPeer) return;
-    NetMessage msg(type);
-    if (payload.size() > 0) msg.payload.writeBytes(payload.data(), payload.size());
-    std::vector<uint8_t> buf;
-    msg.encode(buf);
-    if (reliable) m_transport.sendReliable(m_serverPeer, buf.data(), buf.size());
-    else          m_transport.sendUnreliable(m_serverPeer, buf.data(), buf.size());
+    m_transport.send(m_serverPeer, type, payload.data(), payload.size(), reliable);
 }
 
 void NetManager::handleBlockChangeClient(MemoryStream& payload) {
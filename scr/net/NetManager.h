@@ -5,6 +5,8 @@
 #include "NetPlayer.h"
 #include "NetMessage.h"
 #include "NetChunkSync.h"
+#include "NetDroppedSync.h"
+#include "NetMoveSync.h"
 #include <vector>
 #include <unordered_map>
 #include <memory>
@@ -95,11 +97,13 @@ public:
 
     // 客户端：向服务端发送方块修改"请求"（不本地应用，等服务端广播回来）。
     // 服务端（Host 玩家本地交互）：应用到权威数据并广播给相关客户端。
+    // 两端都不立即发包：改动按 chunk 攒到 update() 末尾合并成 BLOCK_CHANGE_BATCH。
     // 该方法内部按 netMode 分流，World/Player 只需无脑调它。
     void requestBlockChange(int32_t worldX, int32_t worldY, int32_t worldZ,
                             uint16_t blockStateBits);
 
     NetChunkSync& getChunkSync() { return m_chunkSync; }
+    NetDroppedSync& getDroppedSync() { return m_droppedSync; }
 
     // ---- 背包持久化（需求 2，仅 Host）----
     // persist：玩家断开/退出时把其背包写盘（World 实现，按玩家名存独立文件）。
@@ -155,6 +159,20 @@ private:
     ChunkManager* m_chunkManager = nullptr;
     NetChunkSync m_chunkSync;
 
+    // 掉落物状态同步（per-peer 兴趣管理 + 增量）
+    NetDroppedSync m_droppedSync;
+
+    // 玩家移动复制（量化快照 + 增量）
+    NetMoveSync m_moveSync;
+
+    // 通用属性同步批处理（每 tick 复用缓冲）+ 接收时逐条指向包内属性数据的视图
+    NetPropertyBatcher m_propBatch;
+    MemoryStream m_batchEntry;
+
+    // 服务端固定 tick（net_tick_rate）：移动快照与通用属性同步只在 tick 上发出
+    double m_nextServerTick = 0.0;
+    bool consumeServerTick();
+
     // 世界状态单例（host/join 都会创建并注册到 objManager，netId 固定）
     WorldState* m_worldState = nullptr;
     std::function<void(WorldCmdType, float)> m_worldCmdHandler;
@@ -189,10 +207,6 @@ private:
     void handleJoinRequest(ENetPeer* peer, MemoryStream& payload);
     void handlePropertySyncServer(ENetPeer* peer, MemoryStream& payload);
 
-    // 远程玩家插值：若 applied 含位置属性，把该玩家当前状态压入其插值缓冲（服务端/客户端共用）。
-    void pushInterpSnapshotIfMoved(uint16_t netObjId, NetObject* obj,
-                                   const std::vector<uint16_t>& applied);
-
     // Handlers (客户端)
     void handleJoinAccept(MemoryStream& payload);
     void handleJoinDeny(MemoryStream& payload);
@@ -200,6 +214,11 @@ private:
     void handlePlayerLeft(MemoryStream& payload);
     void handlePlayerList(MemoryStream& payload);
     void handlePropertySyncClient(MemoryStream& payload);
+    // PROPERTY_BATCH：双向，逐条转交下面两个应用函数
+    void handlePropertyBatch(MemoryStream& payload);
+    // PROPERTY_SYNC / PROPERTY_BATCH 共用：payload 为 netObjId 之后的属性数据
+    void applyPropertySyncServer(uint16_t netObjId, MemoryStream& payload);
+    void applyPropertySyncClient(uint16_t netObjId, MemoryStream& payload);
     void handleChunkData(MemoryStream& payload);
     void handleChunkRequest(ENetPeer* peer, MemoryStream& payload);
     void handleChunkResponse(MemoryStream& payload);
@@ -216,5 +235,8 @@ private:
 
     // P2P 辅助
     void sendToAll(ENetPeer* exclude, const NetMessage& msg, bool reliable);
+    // 当前所有远程 peer（排除 exclude），结果放在复用的 m_peerScratch 里，下次调用前有效
+    const std::vector<ENetPeer*>& remotePeers(ENetPeer* exclude = nullptr);
+    std::vector<ENetPeer*> m_peerScratch;
     void sendToAll(const NetMessage& msg, bool reliable);
 };
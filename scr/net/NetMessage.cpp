@@ -1,13 +1,20 @@
 ﻿#include "NetMessage.h"
 #include <cstring>
 
+void NetMessage::encodeHeader(uint8_t* out, NetMsgType type, size_t payloadLen) {
+    const uint16_t len16 = static_cast<uint16_t>(payloadLen);
+    out[0] = static_cast<uint8_t>(type);
+    out[1] = 0; // reserved
+    out[2] = static_cast<uint8_t>(len16 & 0xFF);
+    out[3] = static_cast<uint8_t>((len16 >> 8) & 0xFF);
+}
+
 void NetMessage::encode(std::vector<uint8_t>& out) const {
     uint16_t payloadLen = static_cast<uint16_t>(payload.size());
 
-    out.push_back(static_cast<uint8_t>(type));
-    out.push_back(0); // reserved
-    out.push_back(static_cast<uint8_t>(payloadLen & 0xFF));
-    out.push_back(static_cast<uint8_t>((payloadLen >> 8) & 0xFF));
+    const size_t base = out.size();
+    out.resize(base + NetMessageHeader::SIZE);
+    encodeHeader(out.data() + base, type, payloadLen);
 
     if (payloadLen > 0 && payload.data()) {
         out.insert(out.end(), payload.data(), payload.data() + payloadLen);
@@ -31,6 +38,20 @@ bool NetMessage::decode(const uint8_t* data, size_t len, NetMessage& out) {
     return true;
 }
 
+bool NetMessage::decodeView(const uint8_t* data, size_t len, NetMessage& out) {
+    if (!data || len < NetMessageHeader::SIZE) return false;
+
+    out.type = static_cast<NetMsgType>(data[0]);
+    // data[1] = reserved
+    uint16_t payloadLen = static_cast<uint16_t>(data[2])
+                        | (static_cast<uint16_t>(data[3]) << 8);
+
+    if (len < NetMessageHeader::SIZE + payloadLen) return false;
+
+    out.payload.setView(data + NetMessageHeader::SIZE, payloadLen);
+    return true;
+}
+
 // ---- 便捷工厂 ----
 
 NetMessage NetMessage::joinRequest(const std::string& playerName,
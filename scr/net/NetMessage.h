@@ -32,6 +32,11 @@ public:
     // 从二进制解码 (连续 buffer → header + payload)
     // 返回 true 表示成功
     static bool decode(const uint8_t* data, size_t len, NetMessage& out);
+    // 同 decode，但 payload 是指向 data 的只读视图（不拷贝），data 须在读完 payload 前有效
+    static bool decodeView(const uint8_t* data, size_t len, NetMessage& out);
+
+    // 往 out 写 4 字节消息头（NetTransport / 批处理直接在包缓冲里编码时用）
+    static void encodeHeader(uint8_t* out, NetMsgType type, size_t payloadLen);
 
     // ---- 便捷工厂 ----
     static NetMessage joinRequest(const std::string& playerName,
@@ -51,7 +56,8 @@ public:
     static NetMessage chunkData(const std::vector<uint8_t>& compressedChunks);
     static NetMessage chunkRequest(int32_t chunkX, int32_t chunkZ);
     static NetMessage chunkResponse(const std::vector<uint8_t>& compressedData);
-    // 单个方块修改（双向）：客户端→服务端为"请求"，服务端→客户端为"已生效广播"
+    // 单个方块修改（双向）：客户端→服务端为"请求"，服务端→客户端为"已生效广播"。
+    // 两端仍能解析；发送端已统一走按 chunk 合并的 BLOCK_CHANGE_BATCH（见 NetChunkSync::flushBlockChanges）。
     static NetMessage blockChange(int32_t worldX, int32_t worldY, int32_t worldZ,
                                   uint16_t blockStateBits);
 };
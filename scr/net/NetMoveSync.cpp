@@ -0,0 +1,258 @@
+﻿#include "NetMoveSync.h"
+#include "NetManager.h"
+#include "NetPlayer.h"
+#include "../chunk/ChunkDimensions.h"
+#include <algorithm>
+#include <cmath>
+
+// ============================================================================
+// PlayerMoveSnapshot：量化 / 增量 / 编解码
+// ============================================================================
+
+namespace {
+    uint16_t quantU16(float v) { return (uint16_t)std::clamp((int)std::lround(v), 0, 0xFFFF); }
+    int16_t  quantI16(float v) { return (int16_t)std::clamp((int)std::lround(v), -32767, 32767); }
+}
+
+PlayerMoveSnapshot PlayerMoveSnapshot::quantize(const PlayerNetState& s) {
+    using namespace PlayerMoveFormat;
+    PlayerMoveSnapshot q;
+    const glm::vec3& p = s.m_position;
+    const int cx = (int)std::floor(p.x / (float)ChunkConstants::CHUNK_WIDTH);
+    const int cz = (int)std::floor(p.z / (float)ChunkConstants::CHUNK_DEPTH);
+    q.chunkX = (int16_t)std::clamp(cx, -32768, 32767);
+    q.chunkZ = (int16_t)std::clamp(cz, -32768, 32767);
+    q.pos[0] = quantU16((p.x - (float)(q.chunkX * ChunkConstants::CHUNK_WIDTH)) * POS_XZ_SCALE);
+    q.pos[1] = quantU16((p.y + POS_Y_OFFSET) * POS_Y_SCALE);
+    q.pos[2] = quantU16((p.z - (float)(q.chunkZ * ChunkConstants::CHUNK_DEPTH)) * POS_XZ_SCALE);
+
+    float yaw = std::fmod(s.m_yaw, 360.0f);
+    if (yaw < 0.0f) yaw += 360.0f;
+    q.yaw = (uint16_t)((int)std::lround(yaw * (65536.0f / 360.0f)) & 0xFFFF);
+    q.pitch = quantI16(std::clamp(s.m_pitch, -90.0f, 90.0f) * (32767.0f / 90.0f));
+
+    for (int i = 0; i < 3; ++i) q.vel[i] = quantI16(s.m_velocity[i] * VEL_SCALE);
+    q.flags = s.m_flags;
+    return q;
+}
+
+uint8_t PlayerMoveSnapshot::diff(const PlayerMoveSnapshot* base) const {
+    using namespace PlayerMoveFormat;
+    if (!base) return MASK_ALL;
+    uint8_t mask = 0;
+    if (chunkX != base->chunkX || chunkZ != base->chunkZ ||
+        pos[0] != base->pos[0] || pos[1] != base->pos[1] || pos[2] != base->pos[2])
+        mask |= MASK_POS;
+    if (yaw != base->yaw) mask |= MASK_YAW;
+    if (pitch != base->pitch) mask |= MASK_PITCH;
+    if (vel[0] != base->vel[0] || vel[1] != base->vel[1] || vel[2] != base->vel[2])
+        mask |= MASK_VEL;
+    if (flags != base->flags) mask |= MASK_FLAGS;
+    return mask;
+}
+
+void PlayerMoveSnapshot::applyTo(PlayerNetState& s, uint8_t mask) const {
+    using namespace PlayerMoveFormat;
+    if (mask & MASK_POS) {
+        s.m_position = glm::vec3(
+            (float)(chunkX * ChunkConstants::CHUNK_WIDTH) + pos[0] / POS_XZ_SCALE,
+            pos[1] / POS_Y_SCALE - POS_Y_OFFSET,
+            (float)(chunkZ * ChunkConstants::CHUNK_DEPTH) + pos[2] / POS_XZ_SCALE);
+        s.OnRep_Position();
+    }
+    if (mask & (MASK_YAW | MASK_PITCH)) {
+        if (mask & MASK_YAW)   s.m_yaw = yaw * (360.0f / 65536.0f);
+        if (mask & MASK_PITCH) s.m_pitch = pitch * (90.0f / 32767.0f);
+        s.OnRep_Look();
+    }
+    if (mask & (MASK_VEL | MASK_FLAGS)) {
+        if (mask & MASK_VEL)
+            s.m_velocity = glm::vec3(vel[0], vel[1], vel[2]) / VEL_SCALE;
+        if (mask & MASK_FLAGS) s.m_flags = flags;
+        s.OnRep_Motion();
+    }
+}
+
+void PlayerMoveSnapshot::write(MemoryStream& out, uint16_t playerId, uint8_t mask) const {
+    using namespace PlayerMoveFormat;
+    out.writePod(playerId);
+    out.writePod(mask);
+    if (mask & MASK_POS) {
+        out.writePod(chunkX); out.writePod(chunkZ);
+        out.writePod(pos[0]); out.writePod(pos[1]); out.writePod(pos[2]);
+    }
+    if (mask & MASK_YAW)   out.writePod(yaw);
+    if (mask & MASK_PITCH) out.writePod(pitch);
+    if (mask & MASK_VEL) {
+        out.writePod(vel[0]); out.writePod(vel[1]); out.writePod(vel[2]);
+    }
+    if (mask & MASK_FLAGS) out.writePod(flags);
+}
+
+bool PlayerMoveSnapshot::read(MemoryStream& in, uint16_t& playerId, uint8_t& mask) {
+    using namespace PlayerMoveFormat;
+    if (in.remaining() < 3) return false;
+    playerId = in.readPod<uint16_t>();
+    mask = in.readPod<uint8_t>();
+    const size_t need = ((mask & MASK_POS) ? 10 : 0) + ((mask & MASK_YAW) ? 2 : 0) +
+                        ((mask & MASK_PITCH) ? 2 : 0) + ((mask & MASK_VEL) ? 6 : 0) +
+                        ((mask & MASK_FLAGS) ? 1 : 0);
+    if (in.remaining() < need) return false;
+    if (mask & MASK_POS) {
+        chunkX = in.readPod<int16_t>(); chunkZ = in.readPod<int16_t>();
+        pos[0] = in.readPod<uint16_t>(); pos[1] = in.readPod<uint16_t>(); pos[2] = in.readPod<uint16_t>();
+    }
+    if (mask & MASK_YAW)   yaw = in.readPod<uint16_t>();
+    if (mask & MASK_PITCH) pitch = in.readPod<int16_t>();
+    if (mask & MASK_VEL) {
+        vel[0] = in.readPod<int16_t>(); vel[1] = in.readPod<int16_t>(); vel[2] = in.readPod<int16_t>();
+    }
+    if (mask & MASK_FLAGS) flags = in.readPod<uint8_t>();
+    return true;
+}
+
+// ============================================================================
+// NetMoveSync
+// ============================================================================
+
+void NetMoveSync::shutdown() {
+    m_downstream.clear();
+    m_upstreamFilter.clear();
+    m_upstream.clear();
+    m_downstreamFilter.reset();
+}
+
+bool NetMoveSync::applyRecord(uint16_t playerId, const PlayerMoveSnapshot& snap, uint8_t mask) {
+    NetPlayer* player = m_netManager->getPlayer(playerId);
+    if (!player || !player->netState) return false;
+    PlayerNetState& ns = *player->netState;
+    snap.applyTo(ns, mask);
+    // 每条记录（含 mask == 0）都是对端的一次采样：压插值快照保持缓冲节奏。本地玩家不入缓冲。
+    if (playerId != m_netManager->getLocalPlayerId())
+        player->pushInterpSnapshot(ns.m_position, ns.m_yaw, ns.m_pitch, ns.m_velocity);
+    return true;
+}
+
+void NetMoveSync::sendAck(ENetPeer* peer, uint16_t seq) {
+    MemoryStream s;
+    s.writePod(seq);
+    if (peer) {
+        NetMessage msg(NetMsgType::PLAYER_MOVE_ACK);
+        msg.payload.writeBytes(s.data(), s.size());
+        m_netManager->getTransport().send(peer, msg, false);
+    } else {
+        m_netManager->sendToServer(NetMsgType::PLAYER_MOVE_ACK, s, false);
+    }
+}
+
+void NetMoveSync::onAck(ENetPeer* peer, MemoryStream& payload) {
+    if (!m_netManager || payload.remaining() < sizeof(uint16_t)) return;
+    const uint16_t seq = payload.readPod<uint16_t>();
+    if (m_netManager->isHosting()) {
+        auto it = m_downstream.find(peer);
+        if (it != m_downstream.end()) it->second.onAck(seq);
+    } else {
+        m_upstream.onAck(seq);
+    }
+}
+
+// ---- 服务端 ----
+
+void NetMoveSync::broadcast() {
+    if (!m_netManager) return;
+    NetTransport& transport = m_netManager->getTransport();
+    const auto& players = m_netManager->getPlayers();
+
+    MemoryStream body;
+    std::vector<std::pair<uint16_t, PlayerMoveSnapshot>> sent;
+    for (auto& [rid, recv] : players) {
+        if (!recv->peer) continue;  // 本地玩家
+        Tracker& tracker = m_downstream[recv->peer];
+
+        body.reset();
+        sent.clear();
+        uint8_t count = 0;
+        for (auto& [pid, p] : players) {
+            if (pid == rid || !p->netState) continue;  // 不给玩家回发自己
+            const PlayerNetState& ns = *p->netState;
+            PlayerMoveSnapshot snap = PlayerMoveSnapshot::quantize(ns);
+            const uint8_t mask = tracker.diffPending(pid, [&](const PlayerMoveSnapshot* base) { return snap.diff(base); });
+            if (mask == 0 && !ns.hasMovementDirty()) continue;
+            snap.write(body, pid, mask);
+            sent.emplace_back(pid, snap);
+            if (++count == 0xFF) break;
+        }
+        if (count == 0) continue;
+
+        const uint16_t seq = tracker.takeSeq();
+        NetMessage msg(NetMsgType::PLAYER_MOVE);
+        msg.payload.writePod(seq);
+        msg.payload.writePod(count);
+        msg.payload.writeBytes(body.data(), body.size());
+        transport.send(recv->peer, msg, false);
+        tracker.recordSent(seq, std::move(sent));
+        sent = {};
+    }
+}
+
+void NetMoveSync::onMoveFromClient(ENetPeer* peer, uint16_t playerId, MemoryStream& payload) {
+    if (!m_netManager || payload.remaining() < 3) return;
+    const uint16_t seq = payload.readPod<uint16_t>();
+    const uint8_t count = payload.readPod<uint8_t>();
+    if (!m_upstreamFilter[peer].accept(seq)) return;
+
+    for (uint8_t i = 0; i < count; ++i) {
+        PlayerMoveSnapshot snap;
+        uint16_t id = 0;
+        uint8_t mask = 0;
+        if (!snap.read(payload, id, mask)) return;
+        // 客户端只能移动自己：忽略包内 id，以连接对应的玩家为准
+        if (!applyRecord(playerId, snap, mask)) return;
+        // 下个 tick 作为新采样转发给其他 peer
+        m_netManager->getPlayer(playerId)->netState->markMovementDirty();
+    }
+    sendAck(peer, seq);
+}
+
+void NetMoveSync::onPeerDisconnected(ENetPeer* peer) {
+    m_downstream.erase(peer);
+    m_upstreamFilter.erase(peer);
+}
+
+void NetMoveSync::onPlayerLeft(uint16_t playerId) {
+    for (auto& [peer, tracker] : m_downstream) tracker.forget(playerId);
+}
+
+// ---- 客户端 ----
+
+void NetMoveSync::sendLocal(const PlayerNetState& local, uint16_t localId, ENetPeer* serverPeer) {
+    if (!m_netManager || !serverPeer) return;
+    PlayerMoveSnapshot snap = PlayerMoveSnapshot::quantize(local);
+    const uint8_t mask = m_upstream.diffPending(localId, [&](const PlayerMoveSnapshot* base) { return snap.diff(base); });
+
+    const uint16_t seq = m_upstream.takeSeq();
+    NetMessage msg(NetMsgType::PLAYER_MOVE);
+    msg.payload.writePod(seq);
+    msg.payload.writePod((uint8_t)1);
+    snap.write(msg.payload, localId, mask);
+    m_netManager->getTransport().send(serverPeer, msg, false);
+    m_upstream.recordSent(seq, { { localId, snap } });
+}
+
+void NetMoveSync::onMoveFromServer(MemoryStream& payload) {
+    if (!m_netManager || payload.remaining() < 3) return;
+    const uint16_t seq = payload.readPod<uint16_t>();
+    const uint8_t count = payload.readPod<uint8_t>();
+    if (!m_downstreamFilter.accept(seq)) return;
+
+    bool complete = true;
+    for (uint8_t i = 0; i < count; ++i) {
+        PlayerMoveSnapshot snap;
+        uint16_t id = 0;
+        uint8_t mask = 0;
+        if (!snap.read(payload, id, mask)) return;
+        if (!applyRecord(id, snap, mask)) complete = false;
+    }
+    // 有玩家本地还不存在（PLAYER_JOINED 走可靠通道，可能晚到）：不回执，服务端下个 tick 重发
+    if (complete) sendAck(nullptr, seq);
+}
@@ -0,0 +1,102 @@
+﻿#pragma once
+
+#include "NetCommon.h"
+#include "NetSerializer.h"
+#include "NetAckTracker.h"
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "../enet/enet.h"
+class NetManager;
+class PlayerNetState;
+
+// PLAYER_MOVE 消息格式常量
+namespace PlayerMoveFormat {
+    // PLAYER_MOVE（双向）：uint16 seq, uint8 count，每条记录：
+    //   uint16 playerId, uint8 mask, 再按 mask 依次：
+    constexpr uint8_t MASK_POS   = 0x01;  // int16 chunkX, int16 chunkZ, uint16 x, y, z（相对 chunk 原点）
+    constexpr uint8_t MASK_YAW   = 0x02;  // uint16（一圈 65536 份）
+    constexpr uint8_t MASK_PITCH = 0x04;  // int16（±90° → ±32767）
+    constexpr uint8_t MASK_VEL   = 0x08;  // int16 × 3（1/256 m/s）
+    constexpr uint8_t MASK_FLAGS = 0x10;  // uint8 PlayerFlagBits
+    constexpr uint8_t MASK_ALL   = 0x1F;
+    // mask == 0 的记录也会发：表示"本 tick 有一次采样但无变化"，接收端照常压插值快照。
+    // PLAYER_MOVE_ACK（双向）：uint16 seq
+
+    // 位置量化：x/z ∈ [0,16) 精度 1/2048，y ∈ [-64,960) 精度 1/64
+    constexpr float POS_XZ_SCALE = 2048.0f;
+    constexpr float POS_Y_SCALE  = 64.0f;
+    constexpr float POS_Y_OFFSET = 64.0f;
+    constexpr float VEL_SCALE    = 256.0f;
+}
+
+// 一个玩家的量化移动快照（逐字段比较即得增量 mask）
+struct PlayerMoveSnapshot {
+    int16_t  chunkX = 0, chunkZ = 0;
+    uint16_t pos[3] = { 0, 0, 0 };
+    uint16_t yaw = 0;
+    int16_t  pitch = 0;
+    int16_t  vel[3] = { 0, 0, 0 };
+    uint8_t  flags = 0;
+
+    static PlayerMoveSnapshot quantize(const PlayerNetState& s);
+    // 相对 base 变化的字段（base 为空 = 全量）
+    uint8_t diff(const PlayerMoveSnapshot* base) const;
+    // 按 mask 把字段写回 PlayerNetState 并触发对应 OnRep
+    void applyTo(PlayerNetState& s, uint8_t mask) const;
+
+    void write(MemoryStream& out, uint16_t playerId, uint8_t mask) const;
+    // 读一条记录；未在 mask 中的字段保持不变。长度不足返回 false
+    bool read(MemoryStream& in, uint16_t& playerId, uint8_t& mask);
+};
+
+// 玩家移动复制：替代 PlayerNetState 位置/朝向/速度/标志 4 个属性的通用 PROPERTY_SYNC。
+//  - 定点量化（位置相对 chunk、16 位角度、速度 int16），一条消息打包多个玩家
+//  - 每个方向按 NetAckTracker 记录对端已确认的快照与在途快照，只发相对两者有变化的字段；丢包自动重发
+//  - 服务端按固定 tick（NetManager 驱动）给每个 peer 发"除它自己以外"的玩家
+class NetMoveSync {
+public:
+    void init(NetManager* net) { m_netManager = net; }
+    void shutdown();
+
+    // ---- 服务端 ----
+
+    // 服务端 tick：给每个远程 peer 发本 tick 有新采样、或与其已确认 / 在途状态不同的玩家
+    void broadcast();
+    // 客户端上报的自身移动（playerId 由 peer 决定，不信任包内 id）
+    void onMoveFromClient(ENetPeer* peer, uint16_t playerId, MemoryStream& payload);
+    void onPeerDisconnected(ENetPeer* peer);
+    void onPlayerLeft(uint16_t playerId);
+
+    // ---- 客户端 ----
+
+    // 本地玩家移动属性被标脏（World 按 net_send_rate 采样）时调用：上报服务端
+    void sendLocal(const PlayerNetState& local, uint16_t localId, ENetPeer* serverPeer);
+    // 服务端下发的其他玩家移动
+    void onMoveFromServer(MemoryStream& payload);
+
+    // ---- 双向 ----
+
+    // PLAYER_MOVE_ACK：服务端收到 = 某 peer 确认了下行；客户端收到 = 服务端确认了上行
+    void onAck(ENetPeer* peer, MemoryStream& payload);
+
+private:
+    using Tracker = NetAckTracker<uint16_t, PlayerMoveSnapshot>;  // playerId → 对端已确认快照
+
+    NetManager* m_netManager = nullptr;
+
+    // 服务端：每个 peer 的下行基线 + 上行乱序过滤
+    std::unordered_map<ENetPeer*, Tracker> m_downstream;
+    std::unordered_map<ENetPeer*, NetSeqFilter> m_upstreamFilter;
+
+    // 客户端：上行基线 + 下行乱序过滤
+    Tracker m_upstream;
+    NetSeqFilter m_downstreamFilter;
+
+    // 应用一条记录到 playerId 对应的玩家，并压插值快照（本地玩家除外）
+    // 玩家不存在返回 false
+    bool applyRecord(uint16_t playerId, const PlayerMoveSnapshot& snap, uint8_t mask);
+    void sendAck(ENetPeer* peer, uint16_t seq);
+};
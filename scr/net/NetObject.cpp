@@ -27,6 +27,7 @@ void NetObject::serializeDirty(MemoryStream& s) {
     for (uint16_t propId : m_dirtyProps) {
         if (propId >= m_properties.size()) continue;
         auto& prop = m_properties[propId];
+        if (prop.hasFlag(PROP_CUSTOM_SYNC)) continue;
         s.writePod(propId);
         prop.serialize(this, prop.offset, s);
     }
@@ -37,6 +38,7 @@ void NetObject::serializeDirtySplit(MemoryStream& rel, MemoryStream& unrel,
     for (uint16_t propId : m_dirtyProps) {
         if (propId >= m_properties.size()) continue;
         auto& prop = m_properties[propId];
+        if (prop.hasFlag(PROP_CUSTOM_SYNC)) continue;
         if (skipNoRebroadcast && prop.hasFlag(PROP_NO_REBROADCAST)) continue;
         MemoryStream& s =
             (prop.reliability == NetReliability::Reliable) ? rel : unrel;
@@ -20,6 +20,9 @@ public:
     // NO_REBROADCAST：服务端收到 owner 客户端的该属性更新后，应用但**不**再广播给其他客户端。
     //   用于「只上报服务端」的数据（如整背包：服务端做持久化，别的客户端不需要）。
     static constexpr uint8_t PROP_NO_REBROADCAST = 0x01;
+    // CUSTOM_SYNC：由专用编码器同步（如玩家移动走 PLAYER_MOVE），通用 PROPERTY_SYNC 路径跳过；
+    //   脏标记照常维护，供专用编码器判断"本 tick 是否有新采样"。
+    static constexpr uint8_t PROP_CUSTOM_SYNC = 0x02;
 
     struct Property {
         uint16_t id;
@@ -61,7 +64,7 @@ public:
 
     // ---- 序列化 ----
 
-    // 将所有脏属性写入 MemoryStream（propId + value × N）
+    // 将所有脏属性写入 MemoryStream（propId + value × N），CUSTOM_SYNC 属性除外
     void serializeDirty(MemoryStream& s);
 
     // 将脏属性按可靠性拆进两条流（Reliable → rel，Unreliable → unrel）。
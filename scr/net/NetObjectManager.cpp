@@ -16,23 +16,32 @@ NetObject* NetObjectManager::addObject(uint16_t netId, std::unique_ptr<NetObject
     return ptr;
 }
 
-void NetObjectManager::collectDirty(std::vector<NetMessage>& outReliable,
-                                    std::vector<NetMessage>& outUnreliable) {
+void NetObjectManager::appendDirty(NetObject* obj, bool skipNoRebroadcast,
+                                   NetPropertyBatcher& out) {
+    // 按可靠性分流：同一个对象的脏属性，可靠和不可靠各成一个批次条目
+    m_relScratch.reset();
+    m_unrelScratch.reset();
+    obj->serializeDirtySplit(m_relScratch, m_unrelScratch, skipNoRebroadcast);
+
+    out.add(NetReliability::Reliable, obj->getNetId(),
+            m_relScratch.data(), m_relScratch.size());
+    out.add(NetReliability::Unreliable, obj->getNetId(),
+            m_unrelScratch.data(), m_unrelScratch.size());
+}
+
+void NetObjectManager::collectDirty(NetPropertyBatcher& out) {
     for (auto& pair : m_objects) {
         NetObject* obj = pair.second.get();
         if (!obj->isDirty()) continue;
-
-        // 按可靠性分流：同一个对象的脏属性，可靠和不可靠各打包为一条消息
-        MemoryStream relStream;
-        MemoryStream unrelStream;
         // 服务端广播：跳过 NO_REBROADCAST 属性（如整背包只上报不外发）
-        obj->serializeDirtySplit(relStream, unrelStream, /*skipNoRebroadcast=*/true);
+        appendDirty(obj, /*skipNoRebroadcast=*/true, out);
+    }
+}
 
-        if (relStream.size() > 0) {
-            outReliable.push_back(NetMessage::propertySync(obj->getNetId(), relStream));
-        }
-        if (unrelStream.size() > 0) {
-            outUnreliable.push_back(NetMessage::propertySync(obj->getNetId(), unrelStream));
-        }
+void NetObjectManager::collectOwnedDirty(uint16_t ownerId, NetPropertyBatcher& out) {
+    for (auto& pair : m_objects) {
+        NetObject* obj = pair.second.get();
+        if (obj->getOwnerId() != ownerId || !obj->isDirty()) continue;
+        appendDirty(obj, /*skipNoRebroadcast=*/false, out);
     }
 }
@@ -2,6 +2,7 @@
 
 #include "NetObject.h"
 #include "NetMessage.h"
+#include "NetPropertyBatch.h"
 #include <unordered_map>
 #include <memory>
 #include <vector>
@@ -20,9 +21,10 @@ public:
     void destroyObject(uint16_t netId);
     NetObject* findObject(uint16_t netId) const;
 
-    // 收集所有脏对象的属性，按可靠/不可靠分流打包
-    void collectDirty(std::vector<NetMessage>& outReliable,
-                      std::vector<NetMessage>& outUnreliable);
+    // 收集所有脏对象的属性，按可靠/不可靠分流追加进批次（服务端广播用，跳过 NO_REBROADCAST）
+    void collectDirty(NetPropertyBatcher& out);
+    // 只收集 owner == ownerId 的脏对象（客户端上报用）
+    void collectOwnedDirty(uint16_t ownerId, NetPropertyBatcher& out);
 
     // 创建对象后需手动分配 ID（或使用内部自增）
     NetObject* addObject(uint16_t netId, std::unique_ptr<NetObject> obj);
@@ -32,6 +34,11 @@ public:
 private:
     std::unordered_map<uint16_t, std::unique_ptr<NetObject>> m_objects;
     uint16_t m_nextNetId = 1;
+
+    // serializeDirtySplit 的暂存流，每个对象复用（只 reset 不释放容量）
+    MemoryStream m_relScratch;
+    MemoryStream m_unrelScratch;
+    void appendDirty(NetObject* obj, bool skipNoRebroadcast, NetPropertyBatcher& out);
 };
 
 // ---- 模板实现 ----
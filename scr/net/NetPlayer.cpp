@@ -82,11 +82,13 @@ bool NetPlayer::sampleInterpolated(double renderTime, InterpSample& out) const {
 
 PlayerNetState::PlayerNetState() {
     REGISTER_PROP_BEGIN(PlayerNetState);
-    REGISTER_PROP(m_position,     Unreliable, OnRep_Position);  // 0
-    REGISTER_PROP(m_yaw,          Unreliable, OnRep_Look);      // 1
-    REGISTER_PROP(m_pitch,        Unreliable, OnRep_Look);      // 2
-    REGISTER_PROP(m_velocity,     Unreliable, OnRep_Motion);    // 3
-    REGISTER_PROP(m_flags,        Unreliable, OnRep_Motion);    // 4
+    // 0~4 移动属性：由 NetMoveSync 量化 + 增量打包（PLAYER_MOVE），不走通用 PROPERTY_SYNC
+    const uint8_t MOVE = NetObject::PROP_CUSTOM_SYNC;
+    REGISTER_PROP_FLAGS(m_position, Unreliable, OnRep_Position, MOVE);  // 0
+    REGISTER_PROP_FLAGS(m_yaw,      Unreliable, OnRep_Look,     MOVE);  // 1
+    REGISTER_PROP_FLAGS(m_pitch,    Unreliable, OnRep_Look,     MOVE);  // 2
+    REGISTER_PROP_FLAGS(m_velocity, Unreliable, OnRep_Motion,   MOVE);  // 3
+    REGISTER_PROP_FLAGS(m_flags,    Unreliable, OnRep_Motion,   MOVE);  // 4
     REGISTER_PROP(m_swingCounter, Reliable,   OnRep_Swing);     // 5
     // 整背包：可靠 + NO_REBROADCAST（客户端上报服务端持久化，服务端不外发给其他客户端）
     REGISTER_PROP_NOREP_FLAGS(m_inventory, Reliable, NetObject::PROP_NO_REBROADCAST); // 6
@@ -114,6 +116,17 @@ void PlayerNetState::setMotion(const glm::vec3& velocity, uint8_t flags) {
     markDirty(4);  // m_flags
 }
 
+bool PlayerNetState::hasMovementDirty() const {
+    for (uint16_t id : m_dirtyProps) {
+        if (id <= 4) return true;  // m_position .. m_flags
+    }
+    return false;
+}
+
+void PlayerNetState::markMovementDirty() {
+    for (uint16_t id = 0; id <= 4; ++id) markDirty(id);
+}
+
 void PlayerNetState::setSwingCounter(uint8_t counter) {
     m_swingCounter = counter;
     markDirty(5);
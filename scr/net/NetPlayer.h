@@ -50,6 +50,10 @@ public:
     void setInventory(const InventoryData& inv);
     void setHeldItem(const std::string& id);
 
+    // 移动属性（0~4）是否有新采样 / 标记有新采样（NetMoveSync 用）
+    bool hasMovementDirty() const;
+    void markMovementDirty();
+
     // 设置所属 NetPlayer（OnRep 回调需要）
     void setOwner(NetPlayer* owner) { m_owner = owner; }
 
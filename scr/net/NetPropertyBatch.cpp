@@ -0,0 +1,48 @@
+﻿#include "NetPropertyBatch.h"
+
+using namespace PropertyBatchFormat;
+
+void NetPropertyBatcher::begin() {
+    for (auto& ch : m_channels) {
+        for (size_t i = 0; i < ch.used; ++i) ch.packets[i].clear();
+        ch.used = 0;
+    }
+}
+
+std::vector<uint8_t>& NetPropertyBatcher::packetFor(Channel& ch, size_t need) {
+    if (ch.used > 0) {
+        auto& cur = ch.packets[ch.used - 1];
+        // 当前包还放得下（或当前包只有消息头——超大条目也不值得再开一个空包）
+        if (cur.size() + need <= MAX_BATCH_BYTES || cur.size() == NetMessageHeader::SIZE)
+            return cur;
+    }
+    if (ch.used == ch.packets.size()) {
+        ch.packets.emplace_back();
+        ch.packets.back().reserve(MAX_BATCH_BYTES);
+    }
+    auto& pkt = ch.packets[ch.used++];
+    pkt.clear();
+    // 消息头占位，seal 时按最终 payload 长度写入
+    pkt.resize(NetMessageHeader::SIZE);
+    return pkt;
+}
+
+void NetPropertyBatcher::add(NetReliability rel, uint16_t netObjId,
+                             const uint8_t* props, size_t len) {
+    if (len == 0) return;
+    // 条目长度字段是 uint16；单对象属性超 64KB 在这里截不了，只能丢弃（实际不会出现）
+    if (len > NetConstants::MAX_MSG_PAYLOAD - ENTRY_HEADER_BYTES) return;
+
+    auto& pkt = packetFor(pick(m_channels, rel), ENTRY_HEADER_BYTES + len);
+    const uint16_t len16 = static_cast<uint16_t>(len);
+    const auto* id = reinterpret_cast<const uint8_t*>(&netObjId);
+    const auto* ln = reinterpret_cast<const uint8_t*>(&len16);
+    pkt.insert(pkt.end(), id, id + sizeof(uint16_t));
+    pkt.insert(pkt.end(), ln, ln + sizeof(uint16_t));
+    pkt.insert(pkt.end(), props, props + len);
+}
+
+void NetPropertyBatcher::seal(std::vector<uint8_t>& pkt) {
+    NetMessage::encodeHeader(pkt.data(), NetMsgType::PROPERTY_BATCH,
+                             pkt.size() - NetMessageHeader::SIZE);
+}
@@ -0,0 +1,68 @@
+﻿#pragma once
+
+#include "NetCommon.h"
+#include "NetMessage.h"
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// PROPERTY_BATCH 消息格式常量
+namespace PropertyBatchFormat {
+    // PROPERTY_BATCH：若干条目紧挨着，直到 payload 结束。每条：
+    //   uint16 netObjId, uint16 len, len 字节属性数据（与 PROPERTY_SYNC 的 netObjId 之后部分相同：
+    //   重复的 uint16 propId + 值）
+    constexpr size_t ENTRY_HEADER_BYTES = sizeof(uint16_t) * 2;
+
+    // 单包预算（含 4 字节消息头）：压在一个 MTU 内，不可靠通道的包不被 ENet 分片
+    constexpr size_t MAX_BATCH_BYTES = 1200;
+}
+
+// 通用属性同步批处理：把一个网络 tick 内所有脏 NetObject 的属性更新，按可靠/不可靠通道
+// 各自拼成尽量少的 PROPERTY_BATCH 包（每包不超过 MAX_BATCH_BYTES），代替原先
+// 「每个对象每个通道一条 PROPERTY_SYNC」——大量小包时 ENet 头开销与 enet_peer_send 次数都省掉。
+//  - 包缓冲是池化的：begin() 只把已用计数清零，vector 容量留给下一 tick 复用，稳态零分配
+//  - 每个包预先写好 4 字节消息头，flush 时回填 payloadLen，包内字节可直接交给 transport
+//  - 单个对象的属性超过预算时独占一个包（可靠通道由 ENet 分片；不可靠通道的大属性本就少见）
+// 批次内容与接收方无关，服务端一个 tick 组一次、对所有 peer 发同样的包。
+class NetPropertyBatcher {
+public:
+    // 开始新一批（保留缓冲容量）
+    void begin();
+
+    // 追加一个对象的属性数据（propId + 值 的序列，不含 netObjId）
+    void add(NetReliability rel, uint16_t netObjId, const uint8_t* props, size_t len);
+
+    bool empty() const { return m_channels[0].used == 0 && m_channels[1].used == 0; }
+
+    // 封包并逐个回调 send(reliable, data, len)。可靠包先于不可靠包发出。
+    template<typename SendFn>
+    void flush(SendFn&& send);
+
+private:
+    struct Channel {
+        std::vector<std::vector<uint8_t>> packets;  // 池：[0, used) 为本批次在用
+        size_t used = 0;
+    };
+    Channel m_channels[2];  // [0] 可靠 [1] 不可靠
+
+    static Channel& pick(Channel* chans, NetReliability rel) {
+        return chans[rel == NetReliability::Reliable ? 0 : 1];
+    }
+    // 取一个能容纳 need 字节的当前包；放不下则开新包
+    std::vector<uint8_t>& packetFor(Channel& ch, size_t need);
+    static void seal(std::vector<uint8_t>& pkt);
+};
+
+// ---- 模板实现 ----
+
+template<typename SendFn>
+void NetPropertyBatcher::flush(SendFn&& send) {
+    for (int c = 0; c < 2; ++c) {
+        Channel& ch = m_channels[c];
+        for (size_t i = 0; i < ch.used; ++i) {
+            auto& pkt = ch.packets[i];
+            seal(pkt);
+            send(c == 0, pkt.data(), pkt.size());
+        }
+    }
+}
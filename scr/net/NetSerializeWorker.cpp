@@ -175,8 +175,8 @@ void NetSerializeWorker::serialize(const Job& job, std::vector<uint8_t>& out) {
     std::vector<uint8_t> compressBuf(MAX_COMPRESSED);
 
     for (int sy = 0; sy < SECTION_COUNT; ++sy) {
-        if (!boxes[sy]) {
-            // 该 section 无数据，按全空气处理
+        if (!boxes[sy] || boxes[sy]->isSharedAir()) {
+            // 该 section 无数据 / 引用全空气哨兵，按全空气处理，不解码
             out.push_back(static_cast<uint8_t>(sy));
             out.push_back(0);
             ++numSections;
@@ -185,8 +185,8 @@ void NetSerializeWorker::serialize(const Job& job, std::vector<uint8_t>& out) {
         // 持读锁拷一份 section 数据（与玩家改方块的写锁互斥，与其他读共享）
         std::array<BlockState, SEC_VOL> snapshot;
         {
-            std::shared_lock<std::shared_mutex> lk(boxes[sy]->mutex);
-            snapshot = boxes[sy]->blocks;
+            auto lk = boxes[sy]->lockShared();
+            boxes[sy]->copyTo(snapshot.data());
         }
         const BlockState* sectionBlocks = snapshot.data();
 
@@ -75,6 +75,8 @@ public:
     size_t pendingCount() const;
 
 private:
+    friend class ChunkPipelineBench;  // 无头基准直接计时 serialize
+
     void workerMain();
 
     // 把一个 chunk 的 ChunkBoxes 序列化 + LZ4 压缩为裸 payload。
@@ -17,11 +17,20 @@ class MemoryStream {
 public:
     MemoryStream() = default;
 
-    void reset() { m_buffer.clear(); m_readPos = 0; }
+    void reset() { m_buffer.clear(); m_readPos = 0; m_view = nullptr; m_viewSize = 0; }
 
-    const uint8_t* data() const { return m_buffer.data(); }
-    size_t size() const { return m_buffer.size(); }
-    size_t remaining() const { return m_buffer.size() - m_readPos; }
+    // 只读视图：直接读外部字节（如收到的 ENetPacket），不拷贝；调用方保证读完前 data 有效。
+    // 视图上若再写入，先把内容拷进自有缓冲（写时复制）。
+    void setView(const uint8_t* data, size_t len) {
+        m_buffer.clear();
+        m_readPos = 0;
+        m_view = data;
+        m_viewSize = data ? len : 0;
+    }
+
+    const uint8_t* data() const { return m_view ? m_view : m_buffer.data(); }
+    size_t size() const { return m_view ? m_viewSize : m_buffer.size(); }
+    size_t remaining() const { return size() - m_readPos; }
 
     // ---- 写入 ----
 
@@ -29,11 +38,13 @@ public:
     void writePod(const T& val) {
         static_assert(std::is_trivially_copyable_v<T>,
             "writePod requires trivially copyable type");
+        detachView();
         const auto* src = reinterpret_cast<const uint8_t*>(&val);
         m_buffer.insert(m_buffer.end(), src, src + sizeof(T));
     }
 
     void writeBool(bool v) {
+        detachView();
         m_buffer.push_back(v ? 1 : 0);
     }
 
@@ -44,6 +55,7 @@ public:
     }
 
     void writeBytes(const void* data, size_t len) {
+        detachView();
         const auto* src = static_cast<const uint8_t*>(data);
         m_buffer.insert(m_buffer.end(), src, src + len);
     }
@@ -54,32 +66,40 @@ public:
     T readPod() {
         static_assert(std::is_trivially_copyable_v<T>,
             "readPod requires trivially copyable type");
-        assert(m_readPos + sizeof(T) <= m_buffer.size() && "MemoryStream read overflow");
+        assert(m_readPos + sizeof(T) <= size() && "MemoryStream read overflow");
         T val;
-        std::memcpy(&val, m_buffer.data() + m_readPos, sizeof(T));
+        std::memcpy(&val, data() + m_readPos, sizeof(T));
         m_readPos += sizeof(T);
         return val;
     }
 
     bool readBool() {
-        assert(m_readPos < m_buffer.size() && "MemoryStream read overflow");
-        return m_buffer[m_readPos++] != 0;
+        assert(m_readPos < size() && "MemoryStream read overflow");
+        return data()[m_readPos++] != 0;
     }
 
     std::string readString() {
         uint16_t len = readPod<uint16_t>();
-        assert(m_readPos + len <= m_buffer.size() && "MemoryStream read string overflow");
-        std::string result(reinterpret_cast<const char*>(m_buffer.data() + m_readPos), len);
+        assert(m_readPos + len <= size() && "MemoryStream read string overflow");
+        std::string result(reinterpret_cast<const char*>(data() + m_readPos), len);
         m_readPos += len;
         return result;
     }
 
     void readBytes(void* out, size_t len) {
-        assert(m_readPos + len <= m_buffer.size() && "MemoryStream read bytes overflow");
-        std::memcpy(out, m_buffer.data() + m_readPos, len);
+        assert(m_readPos + len <= size() && "MemoryStream read bytes overflow");
+        std::memcpy(out, data() + m_readPos, len);
         m_readPos += len;
     }
 
+    // 不拷贝地跳过 len 字节，返回其起始地址（下次写入前有效）
+    const uint8_t* readSpan(size_t len) {
+        assert(m_readPos + len <= size() && "MemoryStream read span overflow");
+        const uint8_t* p = data() + m_readPos;
+        m_readPos += len;
+        return p;
+    }
+
     // ---- 版本兼容 ----
 
     void writeVersion(uint8_t ver) { writePod(ver); }
@@ -88,6 +108,15 @@ public:
 private:
     std::vector<uint8_t> m_buffer;
     size_t m_readPos = 0;
+    const uint8_t* m_view = nullptr;
+    size_t m_viewSize = 0;
+
+    void detachView() {
+        if (!m_view) return;
+        m_buffer.assign(m_view, m_view + m_viewSize);
+        m_view = nullptr;
+        m_viewSize = 0;
+    }
 };
 
 // ============================================================================
@@ -1,4 +1,5 @@
 ﻿#include "NetTransport.h"
+#include "NetMessage.h"
 #include <cstdio>
 #include <cstring>
 #include <chrono>
@@ -152,10 +153,7 @@ void NetTransport::stopNetThread() {
     m_threadRunning.store(false);
 
     // 清空残留队列（线程已 join，无并发）
-    {
-        std::lock_guard<std::mutex> lk(m_outMutex);
-        m_outQueue.clear();
-    }
+    clearOutbound();
     {
         std::lock_guard<std::mutex> lk(m_inMutex);
         m_inQueue.clear();
@@ -168,9 +166,11 @@ void NetTransport::netThreadMain() {
     static constexpr uint32_t SERVICE_TIMEOUT_MS = 5;
 
     std::deque<OutboundMsg> outBatch;
+    std::vector<ENetPeer*> outPeers;
     while (!m_threadStop.load()) {
         // 1) 取走本轮出站消息
         outBatch.clear();
+        outPeers.clear();
         {
             std::unique_lock<std::mutex> lk(m_outMutex);
             // 没有出站消息时，等一小会（被新出站消息或停止信号唤醒），避免空转。
@@ -179,23 +179,25 @@ void NetTransport::netThreadMain() {
                     [this] { return m_threadStop.load() || !m_outQueue.empty(); });
             }
             outBatch.swap(m_outQueue);
+            outPeers.swap(m_outPeers);
         }
 
-        // 2) 发送（仅网络线程触碰 enet_peer_send / packet_create）
+        // 2) 发送（仅网络线程触碰 enet_peer_send 与包的引用计数）
         bool sentAny = false;
         for (auto& msg : outBatch) {
-            if (!msg.peer || msg.data.empty()) continue;
-            ENetPacket* pkt = enet_packet_create(
-                msg.data.data(), msg.data.size(),
-                msg.reliable ? ENET_PACKET_FLAG_RELIABLE : ENET_PACKET_FLAG_UNSEQUENCED);
+            ENetPacket* pkt = msg.packet;
             int ch = msg.reliable ? NetConstants::CHANNEL_RELIABLE
                                   : NetConstants::CHANNEL_UNRELIABLE;
-            if (enet_peer_send(msg.peer, ch, pkt) < 0) {
-                // peer 已断开/无效：enet_peer_send 失败时未入队，需手动销毁 packet
-                enet_packet_destroy(pkt);
+            if (msg.peer) {
+                if (enet_peer_send(msg.peer, ch, pkt) == 0) sentAny = true;
             } else {
-                sentAny = true;
+                for (uint32_t i = 0; i < msg.peerCount; ++i) {
+                    ENetPeer* p = outPeers[msg.peerBegin + i];
+                    if (p && enet_peer_send(p, ch, pkt) == 0) sentAny = true;
+                }
             }
+            // 没有任何 peer 接收（都已断开/无效）：send 失败时未加引用，需手动销毁
+            if (pkt->referenceCount == 0) enet_packet_destroy(pkt);
         }
 
         // 3) 收事件 + 驱动 ENet（service 内部含 flush 出站）
@@ -233,9 +235,8 @@ void NetTransport::serviceOnce(uint32_t timeoutMs) {
         case ENET_EVENT_TYPE_RECEIVE:
             netEv.type = NetEvent::Data;
             netEv.peer = ev.peer;
-            // 立即把 packet 字节拷进自持 vector，并销毁 packet（不跨线程传 ENetPacket）。
-            netEv.data.assign(ev.packet->data, ev.packet->data + ev.packet->dataLength);
-            enet_packet_destroy(ev.packet);
+            // 包原样移交主线程（不拷贝），由 NetEvent 析构时 destroy。
+            netEv.packet = ev.packet;
             break;
 
         default:
@@ -260,34 +261,111 @@ void NetTransport::drainInbound(std::vector<NetEvent>& outEvents) {
     }
 }
 
-void NetTransport::sendReliable(ENetPeer* peer, const void* data, size_t len) {
-    if (!peer || !data || len == 0) return;
+// ---- 出站包 ----
+
+ENetPacket* NetTransport::createPacket(size_t len, bool reliable) {
+    // data 传 nullptr：ENet 只分配（包头与数据同一块内存），由调用方直接写入
+    return enet_packet_create(nullptr, len,
+        reliable ? ENET_PACKET_FLAG_RELIABLE : ENET_PACKET_FLAG_UNSEQUENCED);
+}
+
+ENetPacket* NetTransport::createPacket(NetMsgType type, const void* payload, size_t len,
+                                       bool reliable) {
+    ENetPacket* pkt = createPacket(NetMessageHeader::SIZE + len, reliable);
+    if (!pkt) return nullptr;
+    NetMessage::encodeHeader(pkt->data, type, len);
+    if (len > 0) std::memcpy(pkt->data + NetMessageHeader::SIZE, payload, len);
+    m_bytesCopied.fetch_add(len, std::memory_order_relaxed);
+    return pkt;
+}
+
+void NetTransport::enqueue(ENetPacket* pkt, ENetPeer* peer, bool reliable) {
     OutboundMsg msg;
+    msg.packet = pkt;
     msg.peer = peer;
-    msg.reliable = true;
-    msg.data.assign(static_cast<const uint8_t*>(data),
-                    static_cast<const uint8_t*>(data) + len);
+    msg.reliable = reliable;
     {
         std::lock_guard<std::mutex> lk(m_outMutex);
-        m_outQueue.push_back(std::move(msg));
+        m_outQueue.push_back(msg);
     }
     m_outCV.notify_one();
 }
 
-void NetTransport::sendUnreliable(ENetPeer* peer, const void* data, size_t len) {
-    if (!peer || !data || len == 0) return;
+void NetTransport::enqueueShared(ENetPacket* pkt, const std::vector<ENetPeer*>& peers,
+                                 bool reliable) {
     OutboundMsg msg;
-    msg.peer = peer;
-    msg.reliable = false;
-    msg.data.assign(static_cast<const uint8_t*>(data),
-                    static_cast<const uint8_t*>(data) + len);
+    msg.packet = pkt;
+    msg.reliable = reliable;
+    msg.peerCount = static_cast<uint32_t>(peers.size());
     {
         std::lock_guard<std::mutex> lk(m_outMutex);
-        m_outQueue.push_back(std::move(msg));
+        msg.peerBegin = static_cast<uint32_t>(m_outPeers.size());
+        m_outPeers.insert(m_outPeers.end(), peers.begin(), peers.end());
+        m_outQueue.push_back(msg);
     }
     m_outCV.notify_one();
 }
 
+void NetTransport::clearOutbound() {
+    std::lock_guard<std::mutex> lk(m_outMutex);
+    for (auto& msg : m_outQueue) {
+        if (msg.packet) enet_packet_destroy(msg.packet);
+    }
+    m_outQueue.clear();
+    m_outPeers.clear();
+}
+
+void NetTransport::sendReliable(ENetPeer* peer, const void* data, size_t len) {
+    if (!peer || !data || len == 0) return;
+    ENetPacket* pkt = createPacket(len, true);
+    if (!pkt) return;
+    std::memcpy(pkt->data, data, len);
+    m_bytesCopied.fetch_add(len, std::memory_order_relaxed);
+    enqueue(pkt, peer, true);
+}
+
+void NetTransport::sendUnreliable(ENetPeer* peer, const void* data, size_t len) {
+    if (!peer || !data || len == 0) return;
+    ENetPacket* pkt = createPacket(len, false);
+    if (!pkt) return;
+    std::memcpy(pkt->data, data, len);
+    m_bytesCopied.fetch_add(len, std::memory_order_relaxed);
+    enqueue(pkt, peer, false);
+}
+
+void NetTransport::send(ENetPeer* peer, NetMsgType type, const void* payload, size_t len,
+                        bool reliable) {
+    if (!peer) return;
+    ENetPacket* pkt = createPacket(type, payload, len, reliable);
+    if (pkt) enqueue(pkt, peer, reliable);
+}
+
+void NetTransport::send(ENetPeer* peer, const NetMessage& msg, bool reliable) {
+    send(peer, msg.type, msg.payload.data(), msg.payload.size(), reliable);
+}
+
+void NetTransport::sendShared(const std::vector<ENetPeer*>& peers, const void* data, size_t len,
+                              bool reliable) {
+    if (peers.empty() || !data || len == 0) return;
+    ENetPacket* pkt = createPacket(len, reliable);
+    if (!pkt) return;
+    std::memcpy(pkt->data, data, len);
+    m_bytesCopied.fetch_add(len, std::memory_order_relaxed);
+    enqueueShared(pkt, peers, reliable);
+}
+
+void NetTransport::sendShared(const std::vector<ENetPeer*>& peers, NetMsgType type,
+                              const void* payload, size_t len, bool reliable) {
+    if (peers.empty()) return;
+    ENetPacket* pkt = createPacket(type, payload, len, reliable);
+    if (pkt) enqueueShared(pkt, peers, reliable);
+}
+
+void NetTransport::sendShared(const std::vector<ENetPeer*>& peers, const NetMessage& msg,
+                              bool reliable) {
+    sendShared(peers, msg.type, msg.payload.data(), msg.payload.size(), reliable);
+}
+
 void NetTransport::flush() {
     // 阶段 2：网络线程每轮自动 flush，这里只唤醒它尽快处理出站队列。
     m_outCV.notify_one();
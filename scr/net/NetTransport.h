@@ -10,13 +10,34 @@
 #include <condition_variable>
 #include <atomic>
 
-// 网络事件（阶段 2：data 由网络线程从 ENetPacket 拷贝进来并立即 destroy packet，
-// 故本结构【自持】数据，跨线程传递不依赖 ENetPacket 生命周期）。
+class NetMessage;
+
+// 网络事件。Data 事件直接持有网络线程收到的 ENetPacket（不拷贝字节），所有权随事件移动，
+// 事件析构时 destroy packet。主线程在事件存活期间原地读 data()。
+// 跨线程安全：ENet 把收到的包交给用户后 referenceCount 已为 0、不再被 host 引用，
+// enet_packet_destroy 只走分配器回调，可在任一线程调用。
 struct NetEvent {
     enum Type : uint8_t { None, Connected, Disconnected, Data };
     Type type = None;
     ENetPeer* peer = nullptr;          // 不透明 key：主线程不解引用，仅作 map key + 回传
-    std::vector<uint8_t> data;         // 仅 Data 事件有效，自持拷贝
+    ENetPacket* packet = nullptr;      // 仅 Data 事件有效，独占
+
+    NetEvent() = default;
+    ~NetEvent() { if (packet) enet_packet_destroy(packet); }
+    NetEvent(NetEvent&& o) noexcept : type(o.type), peer(o.peer), packet(o.packet) { o.packet = nullptr; }
+    NetEvent& operator=(NetEvent&& o) noexcept {
+        if (this != &o) {
+            if (packet) enet_packet_destroy(packet);
+            type = o.type; peer = o.peer; packet = o.packet;
+            o.packet = nullptr;
+        }
+        return *this;
+    }
+    NetEvent(const NetEvent&) = delete;
+    NetEvent& operator=(const NetEvent&) = delete;
+
+    const uint8_t* data() const { return packet ? packet->data : nullptr; }
+    size_t size() const { return packet ? packet->dataLength : 0; }
 };
 
 // ============================================================================
@@ -24,11 +45,18 @@ struct NetEvent {
 // ----------------------------------------------------------------------------
 // 阶段 2：ENetHost 及所有 enet_host_service/flush/peer_send/packet_* 调用都在专用网络
 // 线程上执行。主线程只通过两个加锁队列与之通信：
-//   - 出站队列 m_outQueue：主线程把「已编码消息 + 目标 peer + 通道/可靠性」塞进去，
+//   - 出站队列 m_outQueue：主线程把「已编码好的 ENetPacket + 目标 peer + 通道/可靠性」塞进去，
 //     网络线程取出做 enet_peer_send。
 //   - 入站队列 m_inQueue：网络线程 enet_host_service 收到的事件（连接/断开/数据）解析后
 //     塞进去，主线程 drainInbound 取走 dispatch。
 //
+// 零拷贝路径：
+//   - 出站：主线程用 enet_packet_create(nullptr, ...) 直接分配包缓冲，消息头 + payload 一次写进去，
+//     入队后主线程不再碰该包（ENet 的 referenceCount 非原子，只由网络线程增减）。
+//     发给多个 peer 时共享同一个包（enet_peer_send 各自加引用，与 enet_host_broadcast 同法）。
+//   - 入站：ENetPacket 原样随 NetEvent 交给主线程，NetMessage::decodeView 原地读 payload。
+//   拷贝字节数（调用方缓冲 → 包）累计在 m_bytesCopied，NetManager 每帧取走报给 Profiler。
+//
 // ENetPeer* 的生命周期由网络线程管（ENet 内部 host->peers[] 数组，host 销毁前不释放），
 // 主线程把它当不透明 key 传递，对已断开 peer 的 send 是安全 no-op。
 //
@@ -73,8 +101,17 @@ public:
     void drainInbound(std::vector<NetEvent>& outEvents);
 
     // ---- 发送（线程安全：入出站队列）----
+    // data 为完整编码的消息（含消息头），拷进包一次
     void sendReliable(ENetPeer* peer, const void* data, size_t len);
     void sendUnreliable(ENetPeer* peer, const void* data, size_t len);
+    // 消息头 + payload 直接写进包（不经中间 encode 缓冲）
+    void send(ENetPeer* peer, const NetMessage& msg, bool reliable);
+    void send(ENetPeer* peer, NetMsgType type, const void* payload, size_t len, bool reliable);
+    // 多个 peer 共享同一个包：字节只写一次
+    void sendShared(const std::vector<ENetPeer*>& peers, const void* data, size_t len, bool reliable);
+    void sendShared(const std::vector<ENetPeer*>& peers, const NetMessage& msg, bool reliable);
+    void sendShared(const std::vector<ENetPeer*>& peers, NetMsgType type,
+                    const void* payload, size_t len, bool reliable);
     void flush();  // 阶段 2：唤醒网络线程尽快发送（每轮自动 flush，故多为信号语义）
 
     // ---- 状态 ----
@@ -82,14 +119,28 @@ public:
     ENetHost* getHost() { return m_host; }
     bool isInitialized() const { return m_initialized; }
 
+    // 自上次调用以来拷进出站包的字节数（取走后清零）
+    uint64_t takeBytesCopied() { return m_bytesCopied.exchange(0, std::memory_order_relaxed); }
+
 private:
-    // 出站消息：主线程产，网络线程消费
+    // 出站消息：主线程产，网络线程消费。packet 由主线程创建、入队即移交网络线程。
+    // peer 为空时目标是 m_outPeers[peerBegin, peerBegin + peerCount)（共享包）。
     struct OutboundMsg {
+        ENetPacket* packet = nullptr;
         ENetPeer* peer = nullptr;
-        std::vector<uint8_t> data;
+        uint32_t peerBegin = 0;
+        uint32_t peerCount = 0;
         bool reliable = true;
     };
 
+    // 分配一个 len 字节（未初始化）的出站包；带 type 的版本写好消息头并拷入 payload
+    ENetPacket* createPacket(size_t len, bool reliable);
+    ENetPacket* createPacket(NetMsgType type, const void* payload, size_t len, bool reliable);
+    void enqueue(ENetPacket* pkt, ENetPeer* peer, bool reliable);
+    void enqueueShared(ENetPacket* pkt, const std::vector<ENetPeer*>& peers, bool reliable);
+    // 丢弃未发出的出站包（线程已停，无并发）
+    void clearOutbound();
+
     void netThreadMain();
     // 网络线程内：把就绪事件收进入站队列（持 m_inMutex）
     void serviceOnce(uint32_t timeoutMs);
@@ -107,6 +158,9 @@ private:
     std::mutex m_outMutex;
     std::condition_variable m_outCV;
     std::deque<OutboundMsg> m_outQueue;
+    std::vector<ENetPeer*> m_outPeers;  // 共享包的目标 peer 列表（与 m_outQueue 同锁）
+
+    std::atomic<uint64_t> m_bytesCopied{ 0 };
 
     // 入站队列
     std::mutex m_inMutex;
@@ -1853,12 +1853,15 @@ void RenderSystem::renderDroppedItems(const glm::mat4& view, const glm::mat4& pr
     // 各自只切一次 shader / 纹理绑定。
     bool blockShaderReady = false, extrudeShaderReady = false;
 
-    for (const auto& it : items->items()) {
-        const ItemDefinition* def = it.stack.def;
+    const DroppedItemStore& store = items->items();
+    for (size_t i = 0; i < store.size(); ++i) {
+        const ItemDefinition* def = store.stack[i].def;
         if (!def) continue;
 
-        float bob = 0.08f * std::sin(it.bob * 2.0f);
-        int layers = stackLayers(it.stack.count);
+        const glm::vec3& itemPos = store.pos[i];
+        const float spin = store.spin[i];
+        float bob = 0.08f * std::sin(store.bob[i] * 2.0f);
+        int layers = stackLayers(store.stack[i].count);
 
         if (def->isBlockItem() && m_blockTextureArray != 0 &&
             BlockItemModel::hasValidTextures(def->blockType)) {
@@ -1878,8 +1881,8 @@ void RenderSystem::renderDroppedItems(const glm::mat4& view, const glm::mat4& pr
                 glm::vec2 off = layerOffset(k);
                 glm::vec3 local(off.x * 0.16f, k * 0.09f, off.y * 0.16f);
                 glm::mat4 m(1.0f);
-                m = glm::translate(m, it.pos + glm::vec3(0.0f, 0.22f + bob, 0.0f));
-                m = glm::rotate(m, it.spin, glm::vec3(0.0f, 1.0f, 0.0f));
+                m = glm::translate(m, itemPos + glm::vec3(0.0f, 0.22f + bob, 0.0f));
+                m = glm::rotate(m, spin, glm::vec3(0.0f, 1.0f, 0.0f));
                 m = glm::translate(m, local);
                 m = glm::scale(m, glm::vec3(0.4f));
                 m_blockItemShader.setMat4("model", m);
@@ -1905,8 +1908,8 @@ void RenderSystem::renderDroppedItems(const glm::mat4& view, const glm::mat4& pr
                 float zc = (layers > 1) ? ((float)k - (layers - 1) * 0.5f) : 0.0f;
                 glm::vec3 local(off.x * 0.06f, off.y * 0.04f, zc * 0.12f);
                 glm::mat4 m(1.0f);
-                m = glm::translate(m, it.pos + glm::vec3(0.0f, 0.22f + bob, 0.0f));
-                m = glm::rotate(m, it.spin, glm::vec3(0.0f, 1.0f, 0.0f));
+                m = glm::translate(m, itemPos + glm::vec3(0.0f, 0.22f + bob, 0.0f));
+                m = glm::rotate(m, spin, glm::vec3(0.0f, 1.0f, 0.0f));
                 m = glm::translate(m, local);
                 m = glm::scale(m, glm::vec3(0.5f));
                 m_itemShader.setMat4("model", m);
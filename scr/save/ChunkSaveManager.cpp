@@ -1,5 +1,7 @@
 ﻿#include "ChunkSaveManager.h"
 #include <json/json.h>
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <sstream>
 #include <iostream>
@@ -9,6 +11,7 @@
 #include <direct.h>
 #define mkdir_impl(path) _mkdir(path)
 #else
+#include <dirent.h>
 #define mkdir_impl(path) mkdir(path, 0755)
 #endif
 
@@ -93,6 +96,57 @@ std::vector<WorldInfo> ChunkSaveManager::listWorlds(const std::string& savesRoot
     return result;
 }
 
+// ====================== 离线整理 ======================
+
+int ChunkSaveManager::compactWorld(const std::string& worldName, const std::string& savesRoot) {
+    std::string regionDir = savesRoot + "/" + worldName + "/region";
+    if (!dirExists(regionDir)) {
+        std::cerr << "[Save] world \"" << worldName << "\" not found\n";
+        return -1;
+    }
+
+    // 收集 r.<x>.<z>.mca
+    std::vector<std::string> files;
+    auto isRegionName = [](const std::string& n) {
+        return n.size() > 6 && n.compare(0, 2, "r.") == 0 &&
+               n.compare(n.size() - 4, 4, ".mca") == 0;
+    };
+#ifdef _MSC_VER
+    WIN32_FIND_DATAA fd;
+    HANDLE hFind = FindFirstFileA((regionDir + "\\*.mca").c_str(), &fd);
+    if (hFind != INVALID_HANDLE_VALUE) {
+        do {
+            if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) continue;
+            if (isRegionName(fd.cFileName)) files.push_back(regionDir + "/" + fd.cFileName);
+        } while (FindNextFileA(hFind, &fd));
+        FindClose(hFind);
+    }
+#else
+    if (DIR* d = opendir(regionDir.c_str())) {
+        while (dirent* ent = readdir(d)) {
+            if (isRegionName(ent->d_name)) files.push_back(regionDir + "/" + ent->d_name);
+        }
+        closedir(d);
+    }
+#endif
+
+    int compacted = 0;
+    uint64_t totalReclaimed = 0;
+    for (const auto& f : files) {
+        uint64_t reclaimed = 0;
+        if (RegionFile::compact(f, &reclaimed)) {
+            ++compacted;
+            totalReclaimed += reclaimed;
+        } else {
+            std::cerr << "[Save] compact failed: " << f << "\n";
+        }
+    }
+    std::cout << "[Save] compacted " << compacted << "/" << files.size()
+              << " regions of \"" << worldName << "\", reclaimed "
+              << (totalReclaimed / 1024) << " KB\n";
+    return compacted;
+}
+
 // ====================== 世界创建 / 打开 ======================
 
 bool ChunkSaveManager::createWorld(const std::string& worldName, uint64_t seed) {
@@ -119,6 +173,7 @@ bool ChunkSaveManager::createWorld(const std::string& worldName, uint64_t seed)
     m_worldName = worldName;
     m_seed = seed;
     m_worldOpen = true;
+    startWriter();
     std::cout << "[Save] created world \"" << worldName << "\" seed=" << seed << "\n";
     return true;
 }
@@ -147,11 +202,13 @@ bool ChunkSaveManager::openWorld(const std::string& worldName) {
 
     m_worldName = worldName;
     m_worldOpen = true;
+    startWriter();
     std::cout << "[Save] opened world \"" << worldName << "\" seed=" << m_seed << "\n";
     return true;
 }
 
 void ChunkSaveManager::closeWorld() {
+    stopWriter(); // 排空异步落盘队列
     std::lock_guard<std::mutex> lock(m_ioMutex);
     m_regions.clear(); // 关闭所有 region 文件
     m_worldOpen = false;
@@ -183,24 +240,37 @@ bool ChunkSaveManager::loadChunk(const glm::ivec2& chunkPos, BlockState* outBuf)
     int lx = chunkPos.x - rx * RegionFile::REGION_SIZE;
     int lz = chunkPos.y - rz * RegionFile::REGION_SIZE;
 
-    std::lock_guard<std::mutex> lock(m_ioMutex);
-
-    // 检查 region 文件是否存在（不创建）
-    std::string regionPath = m_worldPath + "/region/r." +
-        std::to_string(rx) + "." + std::to_string(rz) + ".mca";
-    if (!fileExists(regionPath)) return false;
+    // 没有 region 文件：只可能还在落盘队列里
+    std::shared_ptr<RegionSlot> slot = getRegionSlot(rx, rz, false);
+    if (!slot) {
+        ChunkBoxes pending;
+        if (!findPendingSave(chunkPos, pending)) return false;
+        boxesToChunkBuffer(pending, outBuf);
+        return true;
+    }
 
-    RegionFile rf(regionPath);
-    if (!rf.openForRead()) return false;
+    // 共享锁：同 region 的多个 worker 并行读；写线程写这个 region 时才互斥。
+    // 队列检查放在锁内：不在队列里的 chunk，其 header 与数据必已 flush，且持锁期间不会被改写。
+    std::shared_lock<std::shared_mutex> rlk(slot->rw);
+    {
+        ChunkBoxes pending;
+        if (findPendingSave(chunkPos, pending)) {  // 还没落盘的快照优先（卸载后很快又走回来的情形）
+            boxesToChunkBuffer(pending, outBuf);
+            return true;
+        }
+    }
 
-    std::vector<uint8_t> data;
-    if (!rf.readChunk(lx, lz, data)) return false;
+    std::shared_ptr<RegionMapping> mapping = slotMapping(*slot);
+    if (!mapping) return false;
 
-    rf.close();
+    static thread_local std::vector<uint8_t> s_scratch;  // LZ4 解压目标，worker 线程内复用
+    const uint8_t* data = nullptr;
+    size_t len = 0;
+    if (!mapping->readChunk(lx, lz, s_scratch, data, len)) return false;
 
     // 解码 TLV
     glm::ivec2 decodedPos;
-    if (!decodeChunkTLV(data, decodedPos, outBuf)) return false;
+    if (!decodeChunkTLV(data, len, decodedPos, outBuf)) return false;
 
     return true;
 }
@@ -217,14 +287,16 @@ void ChunkSaveManager::saveChunk(const glm::ivec2& chunkPos, const BlockState* b
     std::vector<uint8_t> tlvData;
     encodeChunkTLV(chunkPos, buf, tlvData);
 
-    std::lock_guard<std::mutex> lock(m_ioMutex);
-
-    RegionFile* rf = getOrOpenRegion(rx, rz);
+    std::shared_ptr<RegionSlot> slot = getRegionSlot(rx, rz, true);
+    std::unique_lock<std::shared_mutex> wlk(slot->rw);
+    RegionFile* rf = openSlotForWrite(*slot);
     if (!rf) {
         std::cerr << "[Save] failed to open region for save\n";
         return;
     }
-    rf->writeChunk(lx, lz, tlvData);
+    if (!rf->writeChunk(lx, lz, tlvData) || !rf->flush())
+        std::cerr << "[Save] failed to write chunk (" << chunkPos.x << ", " << chunkPos.y << ")\n";
+    std::atomic_store(&slot->mapping, std::shared_ptr<RegionMapping>());
 }
 
 bool ChunkSaveManager::chunkExists(const glm::ivec2& chunkPos) const {
@@ -235,42 +307,301 @@ bool ChunkSaveManager::chunkExists(const glm::ivec2& chunkPos) const {
     int lx = chunkPos.x - rx * RegionFile::REGION_SIZE;
     int lz = chunkPos.y - rz * RegionFile::REGION_SIZE;
 
-    std::lock_guard<std::mutex> lock(m_ioMutex);
+    ChunkBoxes pending;
+    if (findPendingSave(chunkPos, pending)) return true;
+
+    std::shared_ptr<RegionSlot> slot = getRegionSlot(rx, rz, false);
+    if (!slot) return false;
+    std::shared_lock<std::shared_mutex> rlk(slot->rw);
+    std::shared_ptr<RegionMapping> mapping = slotMapping(*slot);
+    return mapping && mapping->hasChunk(lx, lz);
+}
+
+bool ChunkSaveManager::findPendingSave(const glm::ivec2& chunkPos, ChunkBoxes& out) const {
+    std::lock_guard<std::mutex> qlk(m_saveQueueMutex);
+    auto it = m_pendingSaves.find(chunkKey(chunkPos));
+    if (it == m_pendingSaves.end()) return false;
+    out = it->second.boxes;
+    return true;
+}
+
+// ====================== 异步落盘 ======================
+
+void ChunkSaveManager::boxesToChunkBuffer(const ChunkBoxes& boxes, BlockState* outBuf) {
+    // section 内布局 (y*D+z)*W+x 与整 chunk 布局一致，第 sy 个 section 正好是连续的 4096 个
+    for (int sy = 0; sy < CHUNK_SECTION_COUNT; ++sy) {
+        BlockState* dst = outBuf + sy * BlockBox::VOLUME;
+        const auto& box = boxes[sy];
+        if (!box) {
+            std::fill(dst, dst + BlockBox::VOLUME, BlockState{});
+            continue;
+        }
+        auto lk = box->lockShared();
+        box->copyTo(dst);
+    }
+}
+
+void ChunkSaveManager::saveChunkAsync(const glm::ivec2& chunkPos, const ChunkBoxes& boxes) {
+    if (!m_worldOpen) return;
+    int64_t key = chunkKey(chunkPos);
+    {
+        std::lock_guard<std::mutex> lk(m_saveQueueMutex);
+        PendingSave& ps = m_pendingSaves[key];
+        ps.boxes = boxes;
+        ps.gen = ++m_saveGen;
+        if (ps.failed) {
+            ps.failed = false;  // 新快照重新排队，算作重试
+            --m_failedSaves;
+        }
+        if (!ps.queued) {
+            ps.queued = true;
+            m_saveQueue.push_back(key);
+        }
+    }
+    m_saveQueueCV.notify_one();
+}
+
+bool ChunkSaveManager::flush() {
+    std::unique_lock<std::mutex> lk(m_saveQueueMutex);
+    if (!m_writerThread.joinable()) return m_failedSaves == 0;
+    // 写失败的条目留在 m_pendingSaves 里（loadChunk 仍读得到最新数据），但不会再被写线程处理
+    m_saveDoneCV.wait(lk, [this] { return m_pendingSaves.size() == m_failedSaves; });
+    return m_failedSaves == 0;
+}
+
+size_t ChunkSaveManager::failedSaveCount() const {
+    std::lock_guard<std::mutex> lk(m_saveQueueMutex);
+    return m_failedSaves;
+}
+
+int ChunkSaveManager::pendingSaveCount() const {
+    std::lock_guard<std::mutex> lk(m_saveQueueMutex);
+    return (int)m_pendingSaves.size();
+}
+
+void ChunkSaveManager::startWriter() {
+    if (m_writerThread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lk(m_saveQueueMutex);
+        m_writerStop = false;
+    }
+    m_writerThread = std::thread(&ChunkSaveManager::writerMain, this);
+    {
+        std::lock_guard<std::mutex> lk(m_prefetchMutex);
+        m_prefetchStop = false;
+    }
+    m_prefetchThread = std::thread(&ChunkSaveManager::prefetchMain, this);
+}
+
+void ChunkSaveManager::stopWriter() {
+    if (!m_writerThread.joinable()) return;
+    // 预读只是优化：剩余请求直接丢弃
+    {
+        std::lock_guard<std::mutex> lk(m_prefetchMutex);
+        m_prefetchStop = true;
+        m_prefetchQueue.clear();
+    }
+    m_prefetchCV.notify_all();
+    if (m_prefetchThread.joinable()) m_prefetchThread.join();
+    {
+        std::lock_guard<std::mutex> lk(m_saveQueueMutex);
+        m_writerStop = true;
+    }
+    m_saveQueueCV.notify_all();
+    m_writerThread.join();  // writerMain 排空队列后才退出
+    // 剩下的只有写失败的快照（已由 flush() 报告）：世界要关了，不能留给下一个世界的 loadChunk
+    std::lock_guard<std::mutex> lk(m_saveQueueMutex);
+    m_pendingSaves.clear();
+    m_failedSaves = 0;
+}
+
+void ChunkSaveManager::writerMain() {
+    // 一批最多写这么多 chunk 再回写 header：既摊薄 header 回写，
+    // 又不让 worker 的 loadChunk 在 region 锁上等太久（锁按 chunk 粒度持有）。
+    static constexpr size_t kMaxBatch = 64;
+
+    struct Item {
+        int64_t    key;
+        uint64_t   gen;
+        ChunkBoxes boxes;
+        RegionSlot* slot = nullptr;  // 写入成功的 region；nullptr = 没写成
+    };
+    std::vector<Item> batch;
+    std::vector<std::shared_ptr<RegionSlot>> touched;
+    std::vector<RegionSlot*> failedSlots;
+    std::vector<uint8_t> tlvData;
+    auto buf = std::make_unique<BlockState[]>(ChunkConstants::CHUNK_VOLUME);
+
+    while (true) {
+        batch.clear();
+        {
+            std::unique_lock<std::mutex> lk(m_saveQueueMutex);
+            m_saveQueueCV.wait(lk, [this] { return m_writerStop || !m_saveQueue.empty(); });
+            if (m_saveQueue.empty()) return;  // m_writerStop 且已排空
+            while (!m_saveQueue.empty() && batch.size() < kMaxBatch) {
+                int64_t key = m_saveQueue.front();
+                m_saveQueue.pop_front();
+                PendingSave& ps = m_pendingSaves[key];
+                ps.queued = false;
+                batch.push_back({ key, ps.gen, ps.boxes, nullptr });
+            }
+        }
+
+        touched.clear();
+        failedSlots.clear();
+        for (Item& it : batch) {
+            glm::ivec2 pos((int32_t)(it.key >> 32), (int32_t)(it.key & 0xFFFFFFFFLL));
+            boxesToChunkBuffer(it.boxes, buf.get());
+            encodeChunkTLV(pos, buf.get(), tlvData);
+
+            int rx = floorDiv(pos.x, RegionFile::REGION_SIZE);
+            int rz = floorDiv(pos.y, RegionFile::REGION_SIZE);
+            std::shared_ptr<RegionSlot> slot = getRegionSlot(rx, rz, true);
+            std::unique_lock<std::shared_mutex> wlk(slot->rw);
+            RegionFile* rf = openSlotForWrite(*slot);
+            if (!rf) {
+                std::cerr << "[Save] failed to open region for save\n";
+                continue;
+            }
+            if (!rf->writeChunk(pos.x - rx * RegionFile::REGION_SIZE,
+                                pos.y - rz * RegionFile::REGION_SIZE, tlvData)) {
+                std::cerr << "[Save] failed to write chunk (" << pos.x << ", " << pos.y << ")\n";
+                continue;
+            }
+            it.slot = slot.get();
+            if (std::find(touched.begin(), touched.end(), slot) == touched.end())
+                touched.push_back(std::move(slot));
+        }
+        // 回写 header 后作废旧映射：文件可能变长，且映射与 fwrite 的一致性不做假设（Windows 不保证）
+        for (const auto& slot : touched) {
+            std::unique_lock<std::shared_mutex> wlk(slot->rw);
+            if (!slot->file->flush()) {
+                std::cerr << "[Save] failed to flush region header\n";
+                failedSlots.push_back(slot.get());
+            }
+            std::atomic_store(&slot->mapping, std::shared_ptr<RegionMapping>());
+        }
+
+        // header 已回写：出队（期间又被投递过的 gen 已变，保留等下一批）。
+        // 没写成的留在 m_pendingSaves 并标记失败，flush() 据此报告；再次投递时重试
+        {
+            std::lock_guard<std::mutex> lk(m_saveQueueMutex);
+            for (const Item& it : batch) {
+                auto pit = m_pendingSaves.find(it.key);
+                if (pit == m_pendingSaves.end() || pit->second.gen != it.gen) continue;
+                bool ok = it.slot &&
+                    std::find(failedSlots.begin(), failedSlots.end(), it.slot) == failedSlots.end();
+                if (ok) {
+                    m_pendingSaves.erase(pit);
+                } else if (!pit->second.failed) {
+                    pit->second.failed = true;
+                    ++m_failedSaves;
+                }
+            }
+        }
+        m_saveDoneCV.notify_all();
+    }
+}
 
-    std::string regionPath = m_worldPath + "/region/r." +
-        std::to_string(rx) + "." + std::to_string(rz) + ".mca";
-    if (!fileExists(regionPath)) return false;
+// ====================== 区域预读 ======================
 
-    RegionFile rf(regionPath);
-    if (!rf.openForRead()) return false;
-    bool exists = rf.hasChunk(lx, lz);
-    rf.close();
-    return exists;
+void ChunkSaveManager::prefetchChunks(const std::vector<glm::ivec2>& chunks) {
+    if (!m_worldOpen || chunks.empty()) return;
+    {
+        std::lock_guard<std::mutex> lk(m_prefetchMutex);
+        for (const auto& p : chunks) {
+            int rx = floorDiv(p.x, RegionFile::REGION_SIZE);
+            int rz = floorDiv(p.y, RegionFile::REGION_SIZE);
+            int lx = p.x - rx * RegionFile::REGION_SIZE;
+            int lz = p.y - rz * RegionFile::REGION_SIZE;
+            int64_t key = ((int64_t)(uint32_t)rx << 32) | (uint64_t)(uint32_t)rz;
+            m_prefetchQueue[key].set((size_t)(lz * RegionFile::REGION_SIZE + lx));
+        }
+    }
+    m_prefetchCV.notify_one();
+}
+
+void ChunkSaveManager::prefetchMain() {
+    std::vector<int> indices;
+    while (true) {
+        int64_t key;
+        std::bitset<RegionFile::MAX_CHUNKS> wanted;
+        {
+            std::unique_lock<std::mutex> lk(m_prefetchMutex);
+            m_prefetchCV.wait(lk, [this] { return m_prefetchStop || !m_prefetchQueue.empty(); });
+            if (m_prefetchStop) return;
+            auto it = m_prefetchQueue.begin();
+            key = it->first;
+            wanted = it->second;
+            m_prefetchQueue.erase(it);
+        }
+
+        std::shared_ptr<RegionSlot> slot = getRegionSlot((int32_t)(key >> 32), (int32_t)(key & 0xFFFFFFFFLL), false);
+        if (!slot) continue;
+        // 只在取映射时持共享锁；映射是 shared_ptr，写线程换掉它也不影响这里继续触页
+        std::shared_ptr<RegionMapping> mapping;
+        {
+            std::shared_lock<std::shared_mutex> rlk(slot->rw);
+            mapping = slotMapping(*slot);
+        }
+        if (!mapping) continue;
+
+        indices.clear();
+        for (int i = 0; i < RegionFile::MAX_CHUNKS; ++i) {
+            if (wanted.test((size_t)i)) indices.push_back(i);
+        }
+        m_prefetchedBytes.fetch_add((int64_t)mapping->prefetch(indices), std::memory_order_relaxed);
+    }
 }
 
 // ====================== Region 缓存 ======================
 
-RegionFile* ChunkSaveManager::getOrOpenRegion(int regionX, int regionZ) {
+std::shared_ptr<ChunkSaveManager::RegionSlot>
+ChunkSaveManager::getRegionSlot(int regionX, int regionZ, bool create) const {
     int64_t key = ((int64_t)(uint32_t)regionX << 32) | (uint64_t)(uint32_t)regionZ;
+    std::lock_guard<std::mutex> lock(m_ioMutex);
     auto it = m_regions.find(key);
     if (it != m_regions.end()) {
-        return it->second.get();
+        return it->second;
     }
 
-    // 确保目录存在
     std::string regionDir = m_worldPath + "/region";
-    if (!dirExists(regionDir)) {
+    std::string path = regionDir + "/r." +
+        std::to_string(regionX) + "." + std::to_string(regionZ) + ".mca";
+    if (!create) {
+        // 读路径不创建文件
+        if (!fileExists(path)) return nullptr;
+    } else if (!dirExists(regionDir)) {
+        // 确保目录存在
         makeDirRecursive(regionDir);
     }
 
-    std::string path = regionDir + "/r." +
-        std::to_string(regionX) + "." + std::to_string(regionZ) + ".mca";
+    auto slot = std::make_shared<RegionSlot>();
+    slot->path = std::move(path);
+    m_regions[key] = slot;
+    return slot;
+}
 
-    auto rf = std::make_unique<RegionFile>(path);
-    if (!rf->openForWrite()) return nullptr;
-    RegionFile* ptr = rf.get();
-    m_regions[key] = std::move(rf);
-    return ptr;
+RegionFile* ChunkSaveManager::openSlotForWrite(RegionSlot& slot) {
+    if (!slot.file) {
+        auto rf = std::make_unique<RegionFile>(slot.path);
+        if (!rf->openForWrite()) return nullptr;
+        slot.file = std::move(rf);
+    }
+    return slot.file.get();
+}
+
+std::shared_ptr<RegionMapping> ChunkSaveManager::slotMapping(RegionSlot& slot) {
+    std::shared_ptr<RegionMapping> m = std::atomic_load(&slot.mapping);
+    if (m) return m;
+    // 多个 reader 同时发现映射缺失：只让一个去建，其余等它
+    std::lock_guard<std::mutex> lk(slot.mapMutex);
+    m = std::atomic_load(&slot.mapping);
+    if (!m) {
+        m = RegionMapping::open(slot.path);
+        std::atomic_store(&slot.mapping, m);
+    }
+    return m;
 }
 
 // ====================== world.json I/O ======================
@@ -327,6 +658,23 @@ void ChunkSaveManager::writeWorldJson(uint64_t seed, const PlayerSaveData& playe
 
 // ====================== TLV 编解码 ======================
 
+// TLV tag：
+//   0x00 END
+//   0x01 CHUNK_HEADER     12B：cx, cz, flags
+//   0x10 SECTION_BLOCKS   旧格式：1B sy + 3B reserved + 4096 × BlockState 原始数据（仅读）
+//   0x11 SECTION_PALETTE  1B sy + 1B 索引宽度(1/2) + 2B paletteCount + paletteCount × BlockState
+//                         + 若干 run：2B runLen + 索引（1 或 2B），runLen 之和 = 4096
+// 地形 section 通常只有个位数种方块、按层成片，palette + RLE 后从 8KB 降到几百字节，
+// RegionFile 再整体套一层 LZ4。
+static constexpr uint8_t TLV_END             = 0x00;
+static constexpr uint8_t TLV_CHUNK_HEADER    = 0x01;
+static constexpr uint8_t TLV_SECTION_BLOCKS  = 0x10;
+static constexpr uint8_t TLV_SECTION_PALETTE = 0x11;
+
+static constexpr int SAVE_SEC_VOL = ChunkConstants::SECTION_HEIGHT *
+                                    ChunkConstants::CHUNK_DEPTH *
+                                    ChunkConstants::CHUNK_WIDTH; // 4096
+
 static void writeTLVEntry(std::vector<uint8_t>& out, uint8_t tag,
                           const uint8_t* data, uint32_t len) {
     out.push_back(tag);
@@ -334,10 +682,78 @@ static void writeTLVEntry(std::vector<uint8_t>& out, uint8_t tag,
     if (len > 0) out.insert(out.end(), data, data + len);
 }
 
+static void appendU16(std::vector<uint8_t>& out, uint16_t v) {
+    out.push_back((uint8_t)(v & 0xFF));
+    out.push_back((uint8_t)(v >> 8));
+}
+
+static uint16_t readU16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+// 把一个 section 编码成 SECTION_PALETTE 的 payload（不含 TLV 头）
+static void encodeSectionPalette(uint8_t sy, const BlockState* secBuf, std::vector<uint8_t>& out) {
+    // palette：出现顺序收集。同值连续段只查一次，线性查找在个位数 palette 下足够快
+    std::vector<BlockState> palette;
+    std::vector<uint16_t> runIdx;
+    std::vector<uint16_t> runLen;
+    int i = 0;
+    while (i < SAVE_SEC_VOL) {
+        BlockState s = secBuf[i];
+        int j = i + 1;
+        while (j < SAVE_SEC_VOL && secBuf[j] == s) ++j;
+
+        uint16_t pi = 0;
+        while (pi < palette.size() && palette[pi] != s) ++pi;
+        if (pi == palette.size()) palette.push_back(s);
+
+        runIdx.push_back(pi);
+        runLen.push_back((uint16_t)(j - i));
+        i = j;
+    }
+
+    uint8_t idxWidth = palette.size() <= 256 ? 1 : 2;
+    out.clear();
+    out.reserve(4 + palette.size() * 2 + runIdx.size() * (2 + idxWidth));
+    out.push_back(sy);
+    out.push_back(idxWidth);
+    appendU16(out, (uint16_t)palette.size());
+    for (const BlockState& s : palette) appendU16(out, s.bits);
+    for (size_t r = 0; r < runIdx.size(); ++r) {
+        appendU16(out, runLen[r]);
+        if (idxWidth == 1) out.push_back((uint8_t)runIdx[r]);
+        else appendU16(out, runIdx[r]);
+    }
+}
+
+// 解码 SECTION_PALETTE payload 到 dst（4096 个）。格式不合法返回 false
+static bool decodeSectionPalette(const uint8_t* p, uint32_t len, BlockState* dst) {
+    if (len < 4) return false;
+    uint8_t idxWidth = p[1];
+    uint16_t paletteCount = readU16(p + 2);
+    if ((idxWidth != 1 && idxWidth != 2) || paletteCount == 0) return false;
+    size_t off = 4;
+    if (off + (size_t)paletteCount * 2 > len) return false;
+    const uint8_t* pal = p + off;
+    off += (size_t)paletteCount * 2;
+
+    int filled = 0;
+    while (off + 2 + idxWidth <= len) {
+        uint16_t run = readU16(p + off);
+        uint16_t pi = (idxWidth == 1) ? p[off + 2] : readU16(p + off + 2);
+        off += 2 + idxWidth;
+        if (pi >= paletteCount || run == 0 || filled + run > SAVE_SEC_VOL) return false;
+        BlockState s(readU16(pal + (size_t)pi * 2));
+        std::fill(dst + filled, dst + filled + run, s);
+        filled += run;
+    }
+    return filled == SAVE_SEC_VOL;
+}
+
 void ChunkSaveManager::encodeChunkTLV(const glm::ivec2& pos,
     const BlockState* buf, std::vector<uint8_t>& out) {
     out.clear();
-    out.reserve(128 * 1024); // 典型未压缩大小
+    out.reserve(8 * 1024);
 
     // 0x01 CHUNK_HEADER
     {
@@ -347,14 +763,13 @@ void ChunkSaveManager::encodeChunkTLV(const glm::ivec2& pos,
         memcpy(hdr + 0, &cx, 4);
         memcpy(hdr + 4, &cz, 4);
         memcpy(hdr + 8, &flags, 4);
-        writeTLVEntry(out, 0x01, hdr, 12);
+        writeTLVEntry(out, TLV_CHUNK_HEADER, hdr, 12);
     }
 
-    // 0x10 SECTION_BLOCKS — 每个非空 section
+    // 0x11 SECTION_PALETTE — 每个非空 section
     constexpr int SY = ChunkConstants::CHUNK_HEIGHT / ChunkConstants::SECTION_HEIGHT; // 16
-    constexpr int SEC_VOL = ChunkConstants::SECTION_HEIGHT *
-                            ChunkConstants::CHUNK_DEPTH *
-                            ChunkConstants::CHUNK_WIDTH; // 4096
+    constexpr int SEC_VOL = SAVE_SEC_VOL;
+    std::vector<uint8_t> data;
     for (int sy = 0; sy < SY; ++sy) {
         const BlockState* secBuf = buf + sy * SEC_VOL;
 
@@ -368,18 +783,15 @@ void ChunkSaveManager::encodeChunkTLV(const glm::ivec2& pos,
         }
         if (empty) continue;
 
-        std::vector<uint8_t> data(4 + SEC_VOL * sizeof(BlockState));
-        data[0] = (uint8_t)sy;
-        data[1] = data[2] = data[3] = 0; // reserved
-        memcpy(data.data() + 4, secBuf, SEC_VOL * sizeof(BlockState));
-        writeTLVEntry(out, 0x10, data.data(), (uint32_t)data.size());
+        encodeSectionPalette((uint8_t)sy, secBuf, data);
+        writeTLVEntry(out, TLV_SECTION_PALETTE, data.data(), (uint32_t)data.size());
     }
 
     // 0x00 END
-    writeTLVEntry(out, 0x00, nullptr, 0);
+    writeTLVEntry(out, TLV_END, nullptr, 0);
 }
 
-bool ChunkSaveManager::decodeChunkTLV(const std::vector<uint8_t>& data,
+bool ChunkSaveManager::decodeChunkTLV(const uint8_t* data, size_t size,
     glm::ivec2& outPos, BlockState* outBuf) {
     // 初始化为全 AIR
     constexpr int VOL = ChunkConstants::CHUNK_VOLUME;
@@ -388,33 +800,41 @@ bool ChunkSaveManager::decodeChunkTLV(const std::vector<uint8_t>& data,
     size_t off = 0;
     bool gotHeader = false;
 
-    while (off + 5 <= data.size()) {
+    while (off + 5 <= size) {
         uint8_t tag = data[off];
         uint32_t len;
-        memcpy(&len, data.data() + off + 1, 4);
+        memcpy(&len, data + off + 1, 4);
         off += 5;
 
-        if (off + len > data.size()) return false; // 越界
+        if (off + len > size) return false; // 越界
 
         switch (tag) {
-        case 0x00: // END
+        case TLV_END:
             return gotHeader; // 正常结束
 
-        case 0x01: { // CHUNK_HEADER
+        case TLV_CHUNK_HEADER: {
             if (len < 12) return false;
-            memcpy(&outPos.x, data.data() + off, 4);
-            memcpy(&outPos.y, data.data() + off + 4, 4);
+            memcpy(&outPos.x, data + off, 4);
+            memcpy(&outPos.y, data + off + 4, 4);
             gotHeader = true;
             break;
         }
 
-        case 0x10: { // SECTION_BLOCKS
+        case TLV_SECTION_BLOCKS: { // 旧存档
             if (len < 4 + 4096 * sizeof(BlockState)) return false;
             uint8_t sectionY = data[off];
             if (sectionY >= 16) break; // 无效 sectionY，跳过
-            const BlockState* src = reinterpret_cast<const BlockState*>(data.data() + off + 4);
             BlockState* dst = outBuf + sectionY * 4096;
-            memcpy(dst, src, 4096 * sizeof(BlockState));
+            memcpy(dst, data + off + 4, 4096 * sizeof(BlockState)); // 源可能来自映射内存，未必 2 字节对齐
+            break;
+        }
+
+        case TLV_SECTION_PALETTE: {
+            if (len < 1) return false;
+            uint8_t sectionY = data[off];
+            if (sectionY >= 16) break; // 无效 sectionY，跳过
+            if (!decodeSectionPalette(data + off, len, outBuf + sectionY * SAVE_SEC_VOL))
+                return false;
             break;
         }
 
@@ -1,13 +1,20 @@
 ﻿#pragma once
 #include "../core.h"
 #include "../chunk/BlockType.h"
+#include "../chunk/BlockBox.h"   // ChunkBoxes
 #include "../chunk/ChunkDimensions.h"
 #include "RegionFile.h"
+#include <atomic>
+#include <bitset>
 #include <string>
 #include <vector>
+#include <deque>
 #include <memory>
 #include <unordered_map>
 #include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#include <thread>
 #include <glm/glm.hpp>
 
 class Player;
@@ -35,6 +42,11 @@ public:
     // ---- 世界列表 ----
     static std::vector<WorldInfo> listWorlds(const std::string& savesRoot = "saves");
 
+    // ---- 离线整理 ----
+    // 对某个世界的所有 region 文件执行 RegionFile::compact（回收反复改写留下的空洞）。
+    // 必须在该世界未被打开时调用（命令行 --compact-world）。返回成功整理的 region 数，世界不存在返回 -1。
+    static int compactWorld(const std::string& worldName, const std::string& savesRoot = "saves");
+
     // ---- 世界管理 ----
     bool createWorld(const std::string& worldName, uint64_t seed);
     bool openWorld(const std::string& worldName);
@@ -45,15 +57,41 @@ public:
     uint64_t getSeed() const { return m_seed; }
     const std::string& getSavesRoot() const { return m_savesRoot; }
 
-    // ---- 区块 I/O (线程安全, m_ioMutex 保护) ----
+    // ---- 区块 I/O (线程安全：每 region 一把读写锁，见 RegionSlot) ----
     // outBuf 大小必须 = ChunkConstants::CHUNK_VOLUME (65536)
+    // 该 chunk 若还在异步落盘队列里，直接从队列快照解码（磁盘上可能还是旧版本）。
     bool loadChunk(const glm::ivec2& chunkPos, BlockState* outBuf) const;
 
-    // buf 大小必须 = ChunkConstants::CHUNK_VOLUME
+    // 同步写盘。buf 大小必须 = ChunkConstants::CHUNK_VOLUME
+    // 游戏内存档走 saveChunkAsync；这里留给一次性工具路径，不与写线程队列协调。
     void saveChunk(const glm::ivec2& chunkPos, const BlockState* buf);
 
     bool chunkExists(const glm::ivec2& chunkPos) const;
 
+    // ---- 异步落盘（独立写线程，createWorld/openWorld 启动，closeWorld 排空后停止）----
+    // 主线程只拷 16 个 shared_ptr<BlockBox>（同 NetSerializeWorker）；解码 + 编码 + 压缩 + 写盘
+    // 全在写线程，持各 box 读锁 copyTo，与主线程改方块的写锁互斥。落盘前同一 chunk 重复投递
+    // 只保留最新快照；一批写完后每个 region 只回写一次 header + fflush。
+    void saveChunkAsync(const glm::ivec2& chunkPos, const ChunkBoxes& boxes);
+
+    // 屏障：阻塞到此前投递的所有快照都已写入 region 且 header 已回写（或已写失败）。
+    // 有快照写失败返回 false；失败的快照留在队列里，loadChunk 仍能读到，再次投递时重试
+    bool flush();
+
+    // 尚未完成落盘的 chunk 数（含写线程手上正在写的、以及写失败的）
+    int pendingSaveCount() const;
+
+    // 写失败、尚未重新投递的 chunk 数
+    size_t failedSaveCount() const;
+
+    // ---- 区域预读（独立预读线程，生命周期同写线程）----
+    // 加载中心移动时，ChunkManager 把即将需要的 chunk 交过来；预读线程按 region 分组，
+    // 对映射做合并后的顺序预读（RegionMapping::prefetch），随后 Task 1 的 loadChunk 直接命中页缓存，
+    // 不再是多个 worker 各自随机缺页。不存在的 region / chunk 自动忽略。
+    void prefetchChunks(const std::vector<glm::ivec2>& chunks);
+    // 自上次调用以来预读覆盖的字节数（主线程取走后清零，供 Profiler）
+    int64_t takePrefetchedBytes() { return m_prefetchedBytes.exchange(0, std::memory_order_relaxed); }
+
     // ---- 玩家状态 ----
     bool loadPlayerState(PlayerSaveData& outData);
     void savePlayerState(const PlayerSaveData& data);
@@ -69,12 +107,70 @@ private:
     uint64_t    m_seed = 0;
     bool        m_worldOpen = false;
 
-    // region 缓存: key = ((int64_t)rx << 32) | (uint32_t)rz
+    // 每个 region 一个槽位：写句柄 + 只读映射 + 读写锁。
+    //   读（worker 的 loadChunk / chunkExists）：持 rw 共享锁在映射上解码，同 region 多个 worker 并行；
+    //   写（写线程 / 同步 saveChunk）：持 rw 独占锁 writeChunk；flush 后作废映射，下次读时重新映射。
+    struct RegionSlot {
+        std::string path;
+        std::shared_mutex rw;
+        std::unique_ptr<RegionFile> file;        // 写句柄，首次写时打开
+        std::shared_ptr<RegionMapping> mapping;  // 只读映射，首次读时建立；经 std::atomic_load/store 访问
+        std::mutex mapMutex;                     // 只串行化"建立映射"
+    };
+
+    // region 缓存: key = ((int64_t)rx << 32) | (uint32_t)rz。m_ioMutex 只保护这张表本身。
+    // 值是 shared_ptr：closeWorld 清表时，手上还拿着 slot 的线程不会悬挂。
     // mutable — loadChunk/chunkExists 是 const 但仍需持锁
-    mutable std::unordered_map<int64_t, std::unique_ptr<RegionFile>> m_regions;
+    mutable std::unordered_map<int64_t, std::shared_ptr<RegionSlot>> m_regions;
     mutable std::mutex m_ioMutex;
 
-    RegionFile* getOrOpenRegion(int regionX, int regionZ);
+    // create=false：region 文件不存在时返回 nullptr（读路径不创建文件）
+    std::shared_ptr<RegionSlot> getRegionSlot(int regionX, int regionZ, bool create) const;
+    // 持 slot.rw 独占锁调用：按需打开写句柄
+    static RegionFile* openSlotForWrite(RegionSlot& slot);
+    // 持 slot.rw 共享锁调用：取映射，缺失则建立
+    static std::shared_ptr<RegionMapping> slotMapping(RegionSlot& slot);
+
+    // ---- 写线程 ----
+    struct PendingSave {
+        ChunkBoxes boxes;
+        uint64_t   gen = 0;       // 每次投递递增；写完时 gen 未变才出队（期间被覆盖则留着再写）
+        bool       queued = false; // 是否已在 m_saveQueue 中等待写线程取走
+        bool       failed = false; // 上次写盘失败（留在表里，不在队列中）
+    };
+    // key = ((int64_t)cx << 32) | (uint32_t)cz。写完且 header 回写后才移除，
+    // 因此 loadChunk 在这段窗口内始终能从这里拿到最新数据。
+    std::unordered_map<int64_t, PendingSave> m_pendingSaves;
+    std::deque<int64_t> m_saveQueue;   // 待写 key（投递顺序，已去重）
+    mutable std::mutex m_saveQueueMutex;
+    std::condition_variable m_saveQueueCV;   // 写线程等新任务
+    std::condition_variable m_saveDoneCV;    // flush() 等队列排空
+    uint64_t m_saveGen = 0;
+    size_t   m_failedSaves = 0;   // m_pendingSaves 中 failed 的条目数
+    bool m_writerStop = false;
+    std::thread m_writerThread;
+
+    void startWriter();
+    void stopWriter();     // 先排空队列再 join
+    void writerMain();
+
+    // ---- 预读线程 ----
+    // region key → 待预读的 local index 集合（同 region 的多次请求在此合并）
+    std::unordered_map<int64_t, std::bitset<RegionFile::MAX_CHUNKS>> m_prefetchQueue;
+    std::mutex m_prefetchMutex;
+    std::condition_variable m_prefetchCV;
+    bool m_prefetchStop = false;
+    std::thread m_prefetchThread;
+    std::atomic<int64_t> m_prefetchedBytes{ 0 };
+    void prefetchMain();
+
+    static int64_t chunkKey(const glm::ivec2& p) {
+        return ((int64_t)(uint32_t)p.x << 32) | (uint64_t)(uint32_t)p.y;
+    }
+    // 16 个 box（nullptr = 全空气）按 section 顺序拼成整 chunk 平铺数组
+    static void boxesToChunkBuffer(const ChunkBoxes& boxes, BlockState* outBuf);
+    // chunk 是否还在落盘队列里（是则拷出快照指针）
+    bool findPendingSave(const glm::ivec2& chunkPos, ChunkBoxes& out) const;
 
     // 世界元数据 I/O
     bool readWorldJson(uint64_t& outSeed, PlayerSaveData& outPlayer);
@@ -83,7 +179,8 @@ private:
     // TLV 编解码
     static void encodeChunkTLV(const glm::ivec2& pos, const BlockState* buf,
                                std::vector<uint8_t>& out);
-    static bool decodeChunkTLV(const std::vector<uint8_t>& data,
+    // data 可直接指向 region 映射内存（未压缩时零拷贝）
+    static bool decodeChunkTLV(const uint8_t* data, size_t size,
                                glm::ivec2& outPos, BlockState* outBuf);
 
     static inline int floorDiv(int a, int b) {
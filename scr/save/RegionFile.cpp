@@ -1,11 +1,20 @@
 ﻿#include "RegionFile.h"
+#include "../net/lz4.h"
 #include <algorithm>
+#include <atomic>
 #include <cstring>
+#include <iterator>
 
 #ifdef _MSC_VER
+#include <io.h>
 #include <sys/utime.h>
+#include <windows.h>
 #else
 #include <utime.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #endif
 
 RegionFile::RegionFile(const std::string& path) : m_path(path) {}
@@ -52,11 +61,14 @@ bool RegionFile::openForWrite() {
     } else {
         readHeader();
     }
+    m_deferredFree.clear();
+    rebuildFreeIndex();
     return true;
 }
 
 void RegionFile::close() {
     if (m_file) {
+        flush();
         fclose(m_file);
         m_file = nullptr;
     }
@@ -69,12 +81,27 @@ void RegionFile::readHeader() {
     fread(m_timestamps.data(), sizeof(uint32_t), MAX_CHUNKS, m_file);
 }
 
-void RegionFile::writeHeader() {
-    if (!m_file) return;
+bool RegionFile::writeHeader() {
+    if (!m_file) return false;
     fseek(m_file, 0, SEEK_SET);
-    fwrite(m_offsets.data(), sizeof(uint32_t), MAX_CHUNKS, m_file);
-    fwrite(m_timestamps.data(), sizeof(uint32_t), MAX_CHUNKS, m_file);
-    fflush(m_file);
+    bool ok = fwrite(m_offsets.data(), sizeof(uint32_t), MAX_CHUNKS, m_file) == (size_t)MAX_CHUNKS;
+    ok = fwrite(m_timestamps.data(), sizeof(uint32_t), MAX_CHUNKS, m_file) == (size_t)MAX_CHUNKS && ok;
+    ok = fflush(m_file) == 0 && ok;
+    if (ok) m_headerDirty = false;
+    return ok;
+}
+
+bool RegionFile::flush() {
+    if (!m_file) return false;
+    if (m_headerDirty) {
+        if (!writeHeader()) return false;  // 新 header 没落盘：旧 sector 继续扣着
+    } else if (fflush(m_file) != 0) {
+        return false;
+    }
+    // 新 header 已落盘，磁盘上不再有指向旧 sector 的引用，此时才允许复用
+    for (const auto& [start, count] : m_deferredFree) freeSectors(start, count);
+    m_deferredFree.clear();
+    return true;
 }
 
 bool RegionFile::hasChunk(int localX, int localZ) const {
@@ -100,132 +127,419 @@ bool RegionFile::readChunk(int localX, int localZ, std::vector<uint8_t>& outData
 
     if (uncompSize == 0 || uncompSize > 128 * 1024 * 1024) return false; // 防损坏
 
-    std::vector<uint8_t> compressed;
     // sectorCount 个 sector 的总字节数，减去 5 字节前缀
     size_t storedLen = (size_t)sectorCount * SECTOR_SIZE - 5;
     if (storedLen > 128 * 1024 * 1024) return false;
 
     if (compType == COMPRESS_NONE) {
+        if (uncompSize > storedLen) return false;
         outData.resize(uncompSize);
         if (fread(outData.data(), 1, uncompSize, m_file) != uncompSize) return false;
-    } else if (compType == COMPRESS_ZLIB) {
-        compressed.resize(storedLen);
-        size_t rd = fread(compressed.data(), 1, storedLen, m_file);
-        // zlib 解压暂不支持，预留
-        return false;
+    } else if (compType == COMPRESS_LZ4) {
+        uint32_t compSize = 0;
+        if (fread(&compSize, 4, 1, m_file) != 1) return false;
+        if (compSize == 0 || compSize > storedLen - 4) return false;
+        m_ioBuf.resize(compSize);
+        if (fread(m_ioBuf.data(), 1, compSize, m_file) != compSize) return false;
+        outData.resize(uncompSize);
+        int n = LZ4_decompress_safe(reinterpret_cast<const char*>(m_ioBuf.data()),
+                                    reinterpret_cast<char*>(outData.data()),
+                                    (int)compSize, (int)uncompSize);
+        if (n != (int)uncompSize) return false;
     } else {
-        return false; // 未知压缩类型
+        return false; // ZLIB（预留、从未写出）或未知压缩类型
     }
     return true;
 }
 
-void RegionFile::writeChunk(int localX, int localZ, const std::vector<uint8_t>& data) {
-    if (!m_file) return;
+bool RegionFile::writeChunk(int localX, int localZ, const std::vector<uint8_t>& data) {
+    if (!m_file) return false;
     int idx = index(localX, localZ);
     uint32_t oldEntry = m_offsets[idx];
 
-    // 计算所需 sector 数（5 字节前缀 + 数据，按 4KB 取整）
-    uint32_t totalBytes = 5 + (uint32_t)data.size();
+    // LZ4 压缩；压不小（极少见）则原样存 COMPRESS_NONE
+    const uint8_t* payload = data.data();
+    uint32_t payloadLen = (uint32_t)data.size();
+    uint8_t  compType = COMPRESS_NONE;
+    uint32_t compSize = 0;
+    if (!data.empty()) {
+        m_ioBuf.resize(LZ4_compressBound((int)data.size()));
+        int n = LZ4_compress_default(reinterpret_cast<const char*>(data.data()),
+                                     reinterpret_cast<char*>(m_ioBuf.data()),
+                                     (int)data.size(), (int)m_ioBuf.size());
+        if (n > 0 && (uint32_t)n + 4 < data.size()) {
+            compType = COMPRESS_LZ4;
+            compSize = (uint32_t)n;
+            payload = m_ioBuf.data();
+            payloadLen = compSize;
+        }
+    }
+    uint32_t prefixBytes = (compType == COMPRESS_LZ4) ? 9u : 5u;
+
+    // 计算所需 sector 数（前缀 + 数据，按 4KB 取整）
+    uint32_t totalBytes = prefixBytes + payloadLen;
     uint8_t sectorCount = (uint8_t)((totalBytes + SECTOR_SIZE - 1) / SECTOR_SIZE);
     if (sectorCount == 0) sectorCount = 1;
 
     // 分配空间
+    const size_t deferredBefore = m_deferredFree.size();
     uint32_t sectorStart = allocateSectors(sectorCount, oldEntry);
     uint32_t newEntry = sectorStart | ((uint32_t)sectorCount << 24);
 
     // 写入数据
-    fseek(m_file, sectorStart * (long long)SECTOR_SIZE, SEEK_SET);
+    bool ok = fseek(m_file, sectorStart * (long long)SECTOR_SIZE, SEEK_SET) == 0;
 
     uint32_t uncompSize = (uint32_t)data.size();
-    uint8_t  compType = COMPRESS_NONE; // 暂不压缩
-    fwrite(&uncompSize, 4, 1, m_file);
-    fwrite(&compType, 1, 1, m_file);
-    fwrite(data.data(), 1, data.size(), m_file);
+    ok = ok && fwrite(&uncompSize, 4, 1, m_file) == 1;
+    ok = ok && fwrite(&compType, 1, 1, m_file) == 1;
+    if (compType == COMPRESS_LZ4) ok = ok && fwrite(&compSize, 4, 1, m_file) == 1;
+    ok = ok && fwrite(payload, 1, payloadLen, m_file) == payloadLen;
 
     // 填充剩余 sector 空间为零
-    uint32_t written = 5 + (uint32_t)data.size();
+    uint32_t written = totalBytes;
     uint32_t padded  = sectorCount * SECTOR_SIZE;
-    if (padded > written) {
+    if (ok && padded > written) {
         std::vector<uint8_t> zeros(padded - written, 0);
-        fwrite(zeros.data(), 1, zeros.size(), m_file);
+        ok = fwrite(zeros.data(), 1, zeros.size(), m_file) == zeros.size();
+    }
+    if (!ok) {
+        // header 仍指向旧数据：新 sector 从未被引用，立即归还；旧 sector 不再延迟释放
+        m_deferredFree.resize(deferredBefore);
+        freeSectors(sectorStart, sectorCount);
+        return false;
     }
 
-    // 更新时间戳
+    // 更新 offset + 时间戳（仅内存，flush() 时整块回写 header）
+    m_offsets[idx] = newEntry;
     m_timestamps[idx] = (uint32_t)std::time(nullptr);
-
-    // 更新 header（仅当 offset 变更时才写 header）
-    if (newEntry != oldEntry) {
-        m_offsets[idx] = newEntry;
-        writeHeader();
-    } else {
-        // 只写 timestamp 行
-        fseek(m_file, HEADER_BYTES / 2 + idx * sizeof(uint32_t), SEEK_SET);
-        fwrite(&m_timestamps[idx], sizeof(uint32_t), 1, m_file);
-    }
-    fflush(m_file);
+    m_headerDirty = true;
+    return true;
 }
 
-uint32_t RegionFile::allocateSectors(uint8_t needed, uint32_t oldOffset) {
-    // 收集已用区间（起始 sector, 结束 sector）
+void RegionFile::rebuildFreeIndex() {
     struct Range {
         uint32_t start;
         uint32_t end;   // 不含
     };
     std::vector<Range> used;
-    uint32_t oldSectorStart = 0;
-    if (oldOffset != 0) {
-        oldSectorStart = oldOffset & 0x00FFFFFFu;
-    }
-
+    used.reserve(MAX_CHUNKS);
     for (int i = 0; i < MAX_CHUNKS; ++i) {
         uint32_t e = m_offsets[i];
-        if (e == 0 || e == oldOffset) continue; // 跳过空位和自身旧位
+        if (e == 0) continue;
         uint32_t s = e & 0x00FFFFFFu;
         uint8_t  c = (uint8_t)((e >> 24) & 0xFFu);
         if (c == 0) continue;
         used.push_back({s, s + c});
     }
-
-    // 按起始 sector 排序
     std::sort(used.begin(), used.end(),
         [](const Range& a, const Range& b) { return a.start < b.start; });
 
-    // 获取文件末尾（按 sector 对齐）
-    fseek(m_file, 0, SEEK_END);
-    long fileEnd = ftell(m_file);
-    uint32_t fileEndSectors = (uint32_t)((fileEnd + SECTOR_SIZE - 1) / SECTOR_SIZE);
+    m_freeRuns.clear();
+    uint32_t cursor = 2; // 数据从 sector 2 开始（0-1 是 header）
+    for (const auto& r : used) {
+        if (r.start > cursor) m_freeRuns[cursor] = r.start - cursor;
+        cursor = (std::max)(cursor, r.end);
+    }
+    m_endSector = cursor;
+}
 
-    // 找 best-fit 间隙
-    uint32_t bestGapStart = 0;
-    uint32_t bestGapSize  = 0xFFFFFFFFu;
+void RegionFile::freeSectors(uint32_t start, uint32_t count) {
+    if (count == 0 || start < 2) return;
+    uint32_t end = start + count;
 
-    uint32_t cursor = 2; // 数据从 sector 2 开始（0-1 是 header）
+    // 与后继空洞合并
+    auto next = m_freeRuns.lower_bound(start);
+    if (next != m_freeRuns.end() && next->first == end) {
+        end += next->second;
+        next = m_freeRuns.erase(next);
+    }
+    // 与前驱空洞合并
+    if (next != m_freeRuns.begin()) {
+        auto prev = std::prev(next);
+        if (prev->first + prev->second == start) {
+            start = prev->first;
+            m_freeRuns.erase(prev);
+        }
+    }
 
-    for (const auto& r : used) {
-        if (r.start > cursor) {
-            uint32_t gapSize = r.start - cursor;
-            if (gapSize >= needed && gapSize < bestGapSize) {
-                bestGapStart = cursor;
-                bestGapSize  = gapSize;
-            }
+    if (end >= m_endSector) {
+        m_endSector = start;  // 尾部空闲不记空洞，直接回退末尾
+    } else {
+        m_freeRuns[start] = end - start;
+    }
+}
+
+uint32_t RegionFile::allocateSectors(uint8_t needed, uint32_t oldOffset) {
+    // 旧位不能马上复用：磁盘上的 header 在 flush() 前仍指向它，此时被别的 chunk（或自己）覆盖，
+    // 中途崩溃就会读到错位的数据。记下来，header 落盘后再归还
+    if (oldOffset != 0 && ((oldOffset >> 24) & 0xFFu) != 0) {
+        m_deferredFree.emplace_back(oldOffset & 0x00FFFFFFu, (oldOffset >> 24) & 0xFFu);
+    }
+
+    // best-fit：空洞一般只有个位数，线性遍历即可；恰好相等直接用
+    auto best = m_freeRuns.end();
+    for (auto it = m_freeRuns.begin(); it != m_freeRuns.end(); ++it) {
+        if (it->second < needed) continue;
+        if (best == m_freeRuns.end() || it->second < best->second) {
+            best = it;
+            if (it->second == needed) break;
         }
-        cursor = (std::max)(cursor, r.end);
     }
+    if (best != m_freeRuns.end()) {
+        uint32_t start = best->first;
+        uint32_t len = best->second;
+        m_freeRuns.erase(best);
+        if (len > needed) m_freeRuns[start + needed] = len - needed;
+        return start;
+    }
+
+    // 退回到数据末尾
+    uint32_t start = m_endSector;
+    m_endSector += needed;
+    return start;
+}
 
-    // 文件末尾之后的空间
-    if (fileEndSectors >= cursor) {
-        uint32_t gapSize = 0xFFFFFFFFu - cursor; // 理论上无限
-        if (gapSize >= needed && gapSize < bestGapSize) {
-            bestGapStart = cursor;
-            bestGapSize  = gapSize;
+bool RegionFile::compact(const std::string& path, uint64_t* reclaimedBytes) {
+    RegionFile src(path);
+    if (!src.openForRead()) return false;
+    fseek(src.m_file, 0, SEEK_END);
+    long long oldSize = ftell(src.m_file);
+
+    std::string tmpPath = path + ".compact";
+    FILE* out = nullptr;
+#ifdef _MSC_VER
+    fopen_s(&out, tmpPath.c_str(), "wb");
+#else
+    out = fopen(tmpPath.c_str(), "wb");
+#endif
+    if (!out) return false;
+
+    // 按旧偏移顺序搬运，保持原有的磁盘局部性
+    std::vector<int> order;
+    for (int i = 0; i < MAX_CHUNKS; ++i) {
+        if ((src.m_offsets[i] >> 24) != 0) order.push_back(i);
+    }
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        return (src.m_offsets[a] & 0x00FFFFFFu) < (src.m_offsets[b] & 0x00FFFFFFu);
+    });
+
+    std::array<uint32_t, MAX_CHUNKS> newOffsets{};
+    std::vector<uint8_t> blob;
+    std::vector<uint8_t> header(HEADER_BYTES, 0);
+    bool ok = fwrite(header.data(), 1, header.size(), out) == header.size(); // 占位，最后回填
+    uint32_t cursor = 2;
+    for (int idx : order) {
+        if (!ok) break;
+        uint32_t e = src.m_offsets[idx];
+        uint32_t start = e & 0x00FFFFFFu;
+        uint32_t count = (e >> 24) & 0xFFu;
+        // 原样搬运整段 sector（已压缩的 payload 不解不压）；文件尾不足的部分补零，
+        // 但文件里实际存在的字节必须读全，否则宁可放弃整理也不写出截断的 chunk
+        const long long begin = start * (long long)SECTOR_SIZE;
+        const size_t onDisk = begin >= oldSize ? 0
+            : (size_t)(std::min)((long long)count * SECTOR_SIZE, oldSize - begin);
+        if (onDisk == 0) { ok = false; break; }
+        blob.assign((size_t)count * SECTOR_SIZE, 0);
+        if (fseek(src.m_file, begin, SEEK_SET) != 0
+            || fread(blob.data(), 1, onDisk, src.m_file) != onDisk) {
+            ok = false;
+            break;
         }
+        ok = fwrite(blob.data(), 1, blob.size(), out) == blob.size();
+        newOffsets[idx] = cursor | (count << 24);
+        cursor += count;
+    }
+    if (ok) {
+        fseek(out, 0, SEEK_SET);
+        ok = fwrite(newOffsets.data(), sizeof(uint32_t), MAX_CHUNKS, out) == (size_t)MAX_CHUNKS
+          && fwrite(src.m_timestamps.data(), sizeof(uint32_t), MAX_CHUNKS, out) == (size_t)MAX_CHUNKS;
+    }
+    // 改名前先把临时文件刷到磁盘：否则掉电时目录项已指向新文件，内容却还在页缓存里
+    ok = ok && fflush(out) == 0;
+#ifdef _MSC_VER
+    ok = ok && _commit(_fileno(out)) == 0;
+#else
+    ok = ok && fsync(fileno(out)) == 0;
+#endif
+    ok = (fclose(out) == 0) && ok;
+    src.close();
+    if (!ok) {
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+
+    // 原子替换：任何时刻磁盘上要么是旧文件、要么是整理后的新文件。
+    // MSVC 的 rename 不覆盖已有文件，用 MoveFileEx；POSIX rename 本身就是原子覆盖
+#ifdef _MSC_VER
+    if (!MoveFileExA(tmpPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+#else
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+#endif
+
+    if (reclaimedBytes) {
+        long long newSize = (long long)cursor * SECTOR_SIZE;
+        *reclaimedBytes = oldSize > newSize ? (uint64_t)(oldSize - newSize) : 0;
+    }
+    return true;
+}
+
+// ====================== RegionMapping ======================
+
+namespace {
+// prefetch 顺序触页读到的字节汇总后存到这里，编译器不能把触页读当死代码删掉
+std::atomic<uint8_t> g_prefetchSink{ 0 };
+}
+
+std::shared_ptr<RegionMapping> RegionMapping::open(const std::string& path) {
+    std::shared_ptr<RegionMapping> m(new RegionMapping());
+#ifdef _MSC_VER
+    // 共享读写：写线程仍持有 fopen 的写句柄
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return nullptr;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart < RegionFile::HEADER_BYTES) {
+        CloseHandle(file);
+        return nullptr;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        CloseHandle(file);
+        return nullptr;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return nullptr;
     }
+    m->m_fileHandle = file;
+    m->m_mapHandle = mapping;
+    m->m_data = static_cast<const uint8_t*>(view);
+    m->m_size = (size_t)size.QuadPart;
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return nullptr;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < RegionFile::HEADER_BYTES) {
+        ::close(fd);
+        return nullptr;
+    }
+    void* view = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);  // 映射建立后 fd 可关
+    if (view == MAP_FAILED) return nullptr;
+    m->m_data = static_cast<const uint8_t*>(view);
+    m->m_size = (size_t)st.st_size;
+#endif
+    return m;
+}
+
+RegionMapping::~RegionMapping() {
+#ifdef _MSC_VER
+    if (m_data) UnmapViewOfFile(m_data);
+    if (m_mapHandle) CloseHandle(m_mapHandle);
+    if (m_fileHandle) CloseHandle(m_fileHandle);
+#else
+    if (m_data) munmap(const_cast<uint8_t*>(m_data), m_size);
+#endif
+}
+
+uint32_t RegionMapping::offsetEntry(int localX, int localZ) const {
+    uint32_t e;
+    memcpy(&e, m_data + RegionFile::index(localX, localZ) * sizeof(uint32_t), sizeof(e));
+    return e;
+}
 
-    // 如果找到了合适间隙，使用它
-    if (bestGapSize != 0xFFFFFFFFu) {
-        return bestGapStart;
+bool RegionMapping::hasChunk(int localX, int localZ) const {
+    return offsetEntry(localX, localZ) != 0;
+}
+
+bool RegionMapping::readChunk(int localX, int localZ, std::vector<uint8_t>& scratch,
+                              const uint8_t*& outData, size_t& outLen) const {
+    uint32_t entry = offsetEntry(localX, localZ);
+    if (entry == 0) return false;
+
+    uint32_t sectorStart = entry & 0x00FFFFFFu;
+    uint32_t sectorCount = (entry >> 24) & 0xFFu;
+    if (sectorCount == 0) return false;
+
+    // 与 RegionFile::readChunk 同样的前缀校验，区别只在于数据来自映射内存
+    size_t base = (size_t)sectorStart * RegionFile::SECTOR_SIZE;
+    size_t storedLen = (size_t)sectorCount * RegionFile::SECTOR_SIZE - 5;
+    if (base + 5 > m_size) return false;
+    uint32_t uncompSize;
+    memcpy(&uncompSize, m_data + base, 4);
+    uint8_t compType = m_data[base + 4];
+    if (uncompSize == 0 || uncompSize > 128 * 1024 * 1024) return false; // 防损坏
+    const uint8_t* p = m_data + base + 5;
+    size_t avail = m_size - (base + 5);   // 文件末 sector 未必补满
+
+    if (compType == RegionFile::COMPRESS_NONE) {
+        if (uncompSize > storedLen || uncompSize > avail) return false;
+        outData = p;
+        outLen = uncompSize;
+    } else if (compType == RegionFile::COMPRESS_LZ4) {
+        if (avail < 4) return false;
+        uint32_t compSize;
+        memcpy(&compSize, p, 4);
+        if (compSize == 0 || compSize > storedLen - 4 || compSize > avail - 4) return false;
+        scratch.resize(uncompSize);
+        int n = LZ4_decompress_safe(reinterpret_cast<const char*>(p + 4),
+                                    reinterpret_cast<char*>(scratch.data()),
+                                    (int)compSize, (int)uncompSize);
+        if (n != (int)uncompSize) return false;
+        outData = scratch.data();
+        outLen = uncompSize;
+    } else {
+        return false; // ZLIB（预留、从未写出）或未知压缩类型
     }
+    return true;
+}
 
-    // 退回到文件末尾
-    return (std::max)(cursor, fileEndSectors);
+size_t RegionMapping::prefetch(const std::vector<int>& localIndices) const {
+    // 相邻段间隙小于此值就一起读：多读几十 KB 远比多一次寻道便宜
+    static constexpr size_t kMergeGap = 64 * 1024;
+    static constexpr size_t kPage = 4096;
+
+    struct Span { size_t begin, end; };
+    std::vector<Span> spans;
+    spans.reserve(localIndices.size());
+    for (int idx : localIndices) {
+        uint32_t e;
+        memcpy(&e, m_data + (size_t)(idx & (RegionFile::MAX_CHUNKS - 1)) * sizeof(uint32_t), sizeof(e));
+        uint32_t count = (e >> 24) & 0xFFu;
+        if (count == 0) continue;
+        size_t b = (size_t)(e & 0x00FFFFFFu) * RegionFile::SECTOR_SIZE;
+        size_t en = (std::min)(b + (size_t)count * RegionFile::SECTOR_SIZE, m_size);
+        if (b < en) spans.push_back({ b, en });
+    }
+    if (spans.empty()) return 0;
+    std::sort(spans.begin(), spans.end(), [](const Span& a, const Span& b) { return a.begin < b.begin; });
+
+    size_t total = 0;
+    uint8_t sink = 0;
+    size_t i = 0;
+    while (i < spans.size()) {
+        Span cur = spans[i++];
+        while (i < spans.size() && spans[i].begin <= cur.end + kMergeGap) {
+            cur.end = (std::max)(cur.end, spans[i].end);
+            ++i;
+        }
+        size_t begin = cur.begin & ~(kPage - 1);
+#ifndef _MSC_VER
+        madvise(const_cast<uint8_t*>(m_data) + begin, cur.end - begin, MADV_WILLNEED);
+#endif
+        // 顺序触页：提示不可用（Windows）或被忽略时，顺序缺页也会触发系统的顺序预读
+        for (size_t off = begin; off < cur.end; off += kPage) sink ^= m_data[off];
+        total += cur.end - begin;
+    }
+    g_prefetchSink.store(sink, std::memory_order_relaxed);
+    return total;
 }
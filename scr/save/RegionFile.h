@@ -2,7 +2,10 @@
 #include <cstdint>
 #include <cstdio>
 #include <array>
+#include <map>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 #include <ctime>
 
@@ -10,8 +13,11 @@
 //   - 32×32 chunk 一片 region，文件命名 r.<regionX>.<regionZ>.mca
 //   - Header 8KB：1024 个 offset (3B sector offset + 1B sector count) + 1024 个 timestamp
 //   - Chunk 数据：4B uncompressed_size + 1B compression + N B data，按 4KB 对齐
+//     compression = COMPRESS_LZ4 时 data = 4B compressed_size + LZ4 块（sector 尾部有零填充，
+//     LZ4 解压需要精确的压缩长度，故单独记录）
 //
-// 线程安全：本类不锁。调用方 (ChunkSaveManager) 用 m_ioMutex 串行化所有 I/O。
+// 线程安全：本类不锁。调用方 (ChunkSaveManager) 持对应 region 的独占锁串行化写入；
+// 读盘走下方的 RegionMapping。
 class RegionFile {
 public:
     static constexpr int REGION_SIZE   = 32;
@@ -22,7 +28,8 @@ public:
     // 压缩类型
     enum CompressType : uint8_t {
         COMPRESS_NONE = 0,
-        COMPRESS_ZLIB = 1,
+        COMPRESS_ZLIB = 1,   // 预留值：从未写出过，读到视为损坏
+        COMPRESS_LZ4  = 2,   // 默认：复用 net/lz4，解压远快于 zlib
     };
 
     explicit RegionFile(const std::string& path);
@@ -37,24 +44,91 @@ public:
     bool readChunk(int localX, int localZ, std::vector<uint8_t>& outData);
 
     // 写入 chunk（未压缩的 TLV 流，内部自动压缩）。
-    void writeChunk(int localX, int localZ, const std::vector<uint8_t>& data);
+    // header 只在内存里更新并标脏，不 fflush —— 一批 chunk 写完后调一次 flush() 统一回写。
+    // 被替换的旧 sector 在 flush() 之前不会被复用，中途崩溃时磁盘上的旧 header 仍指向完好的旧数据。
+    // 写失败返回 false，header 不变（仍指向旧数据）。
+    bool writeChunk(int localX, int localZ, const std::vector<uint8_t>& data);
+
+    // 回写脏 header 并 fflush。close() 时自动调用。header 没能落盘返回 false。
+    bool flush();
 
     // chunk 在 header 中是否有非零 offset
     bool hasChunk(int localX, int localZ) const;
 
+    // 离线整理：把所有 chunk 按原顺序紧密重排到 header 之后，消除空洞并截掉尾部空闲。
+    // 调用时该文件不能被任何 RegionFile / RegionMapping 打开（先写临时文件，再原子替换原文件）。
+    // reclaimedBytes 非空时返回省下的字节数。
+    static bool compact(const std::string& path, uint64_t* reclaimedBytes = nullptr);
+
 private:
+    friend class RegionMapping;  // 共用 index() 与 header 布局
     static int index(int lx, int lz) { return ((lz & 31) << 5) | (lx & 31); }
 
     void readHeader();
-    void writeHeader();
+    bool writeHeader();  // 全部写出并 fflush 成功才清脏标记
 
-    // 在 header 中扫描 best-fit 空闲区间，或分配在文件末尾。返回 sector 偏移。
+    // 在空闲索引里 best-fit，没有合适空洞则接在数据末尾。返回 sector 偏移。
+    // oldOffset 占的 sector 记入 m_deferredFree，等新 header 落盘（flush）后才归还。
     uint32_t allocateSectors(uint8_t sectorCount, uint32_t oldOffset);
 
+    // 由 m_offsets 重建空闲索引（打开文件时一次）
+    void rebuildFreeIndex();
+    // 归还一段 sector：与相邻空洞合并；落在数据末尾则直接回退 m_endSector
+    void freeSectors(uint32_t start, uint32_t count);
+
     std::string   m_path;
     FILE*         m_file = nullptr;
 
+    // LZ4 压缩/解压中转缓冲（调用方已串行化，复用避免每 chunk 分配）
+    std::vector<uint8_t> m_ioBuf;
+
     // offset: 低 24bit = sector 起始偏移，高 8bit = sector 个数。0 = 未使用。
     std::array<uint32_t, MAX_CHUNKS> m_offsets{};
     std::array<uint32_t, MAX_CHUNKS> m_timestamps{};
+    bool m_headerDirty = false;
+
+    // 空闲 sector 索引：header 之后、m_endSector 之前的空洞（起始 sector → 长度），相邻空洞始终已合并。
+    // 与 m_offsets 同步增量维护，分配只需遍历空洞，不再每次从 1024 个 header 项重建排序。
+    std::map<uint32_t, uint32_t> m_freeRuns;
+    uint32_t m_endSector = 2;   // 已用数据的末尾 sector（其后全部空闲；0-1 是 header）
+    // 本批被替换下来的旧 sector（起始, 个数）：磁盘上的旧 header 仍引用它们，flush 写完 header 后才并入 m_freeRuns
+    std::vector<std::pair<uint32_t, uint32_t>> m_deferredFree;
+};
+
+// region 文件的只读内存映射（Task 1 读盘路径）。
+//   - 映射建立后对象本身不可变，任意多线程可同时 readChunk，无锁、无 fseek/fread。
+//   - header / chunk 前缀直接从映射内存解析；COMPRESS_NONE 的 payload 直接返回映射内指针，
+//     LZ4 从映射内存直接解压到调用方的 scratch，省掉一次"先读进 vector 再解压"的拷贝。
+//   - 不感知写入：写方（RegionFile）改动同一文件后，调用方须丢弃旧映射、重新 open
+//     （ChunkSaveManager 用每 region 一把读写锁协调，见 RegionSlot）。
+class RegionMapping {
+public:
+    // 文件不存在 / 小于 header / 映射失败返回 nullptr
+    static std::shared_ptr<RegionMapping> open(const std::string& path);
+    ~RegionMapping();
+
+    RegionMapping(const RegionMapping&) = delete;
+    RegionMapping& operator=(const RegionMapping&) = delete;
+
+    bool hasChunk(int localX, int localZ) const;
+
+    // 取 chunk 的（解压后）TLV 流：outData/outLen 指向映射内存或 scratch。chunk 不存在 / 损坏返回 false。
+    // 返回的指针在本映射存活且 scratch 未被改动期间有效。
+    bool readChunk(int localX, int localZ, std::vector<uint8_t>& scratch,
+                   const uint8_t*& outData, size_t& outLen) const;
+
+    // 预读：把 localIndices（index = lz*32+lx）对应的 sector 按文件顺序合并成大段，
+    // 发 readahead 提示后顺序触页，把它们提前拉进页缓存。返回覆盖的字节数。
+    size_t prefetch(const std::vector<int>& localIndices) const;
+
+private:
+    RegionMapping() = default;
+    uint32_t offsetEntry(int localX, int localZ) const;
+
+    const uint8_t* m_data = nullptr;
+    size_t         m_size = 0;
+#ifdef _MSC_VER
+    void*          m_fileHandle = nullptr;   // HANDLE
+    void*          m_mapHandle = nullptr;    // HANDLE
+#endif
 };
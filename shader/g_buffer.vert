@@ -3,7 +3,7 @@
 layout(location = 0) in vec3 aPos;
 layout(location = 1) in vec3 aNormal;
 layout(location = 2) in vec2 aTexCoord;
-layout(location = 5) in uint aPacked;        // x4|y4|z4|face3|orient4|reserved13
+layout(location = 5) in uint aPacked;        // x4|y4|z4|face3|orient4|quadW4|quadH4|reserved5
 layout(location = 7) in uint aBlockType;     // 16-bit
 layout(location = 8) in uint aTextureLayer;  // 16-bit
 
@@ -74,6 +74,9 @@ void main() {
     int lz     = int((aPacked >> 8)  & 0xFu);
     int face   = int((aPacked >> 12) & 0x7u);
     int orient = int((aPacked >> 15) & 0xFu);
+    // 贪心合并矩形尺寸（单位面 = 1×1）
+    float quadW = float(((aPacked >> 19) & 0xFu) + 1u);
+    float quadH = float(((aPacked >> 23) & 0xFu) + 1u);
 
     // 还原方块中心世界坐标：sectionBase + 局部 + 0.5
     vec3 sectionBase = sectionBases[gl_DrawID].xyz;
@@ -84,13 +87,18 @@ void main() {
     translation[3] = vec4(blockPos, 1.0);
     mat4 model = translation * faceMatrix;
 
-    vWorldPos = (model * vec4(aPos, 1.0)).xyz;
+    // 单位 quad 以锚点格为起点沿面局部 +X / +Y 拉伸 quadW / quadH 格
+    vec3 quadPos = vec3(aPos.x * quadW + 0.5 * (quadW - 1.0),
+                        aPos.y * quadH + 0.5 * (quadH - 1.0),
+                        aPos.z);
+    vWorldPos = (model * vec4(quadPos, 1.0)).xyz;
     vNormal = mat3(faceMatrix) * aNormal;
 
+    // UV 同步放大，靠纹理数组的 GL_REPEAT 让每格各铺一遍贴图（与未合并时逐格一致）。
     // 按朝向旋转 UV：横躺原木的侧面木纹要顺着主轴 X / Z 而非默认竖直。
-    vec2 uv = aTexCoord;
+    vec2 uv = aTexCoord * vec2(quadW, quadH);
     if (shouldRotateUV(face, orient)) {
-        // 绕 (0.5, 0.5) 旋转 90°：x' = y, y' = 1 - x
+        // 绕 (0.5, 0.5) 旋转 90°：x' = y, y' = 1 - x（放大后的 UV 取小数部分同样成立）
         uv = vec2(uv.y, 1.0 - uv.x);
     }
     vTexCoord = uv;
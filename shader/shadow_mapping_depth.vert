@@ -2,7 +2,7 @@
 
 uniform mat4 lightSpaceMatrix;
 layout(location = 0) in vec3 aPos;
-layout(location = 5) in uint aPacked;        // x4|y4|z4|face3|orient4|reserved13
+layout(location = 5) in uint aPacked;        // x4|y4|z4|face3|orient4|quadW4|quadH4|reserved5
 layout(location = 7) in uint aBlockType;     // 16-bit
 
 layout(std430, binding = 0) readonly buffer SectionBases {
@@ -33,6 +33,8 @@ void main() {
     int ly   = int((aPacked >> 4)  & 0xFu);
     int lz   = int((aPacked >> 8)  & 0xFu);
     int face = int((aPacked >> 12) & 0x7u);
+    float quadW = float(((aPacked >> 19) & 0xFu) + 1u);
+    float quadH = float(((aPacked >> 23) & 0xFu) + 1u);
 
     vec3 sectionBase = sectionBases[gl_DrawID].xyz;
     vec3 blockPos = sectionBase + vec3(float(lx), float(ly), float(lz)) + vec3(0.5);
@@ -41,5 +43,9 @@ void main() {
     mat4 translation = mat4(1.0);
     translation[3] = vec4(blockPos, 1.0);
     mat4 model = translation * faceMatrix;
-    gl_Position = lightSpaceMatrix * model * vec4(aPos, 1.0);
+    // 贪心合并矩形：与 g_buffer.vert 同样以锚点格为起点沿面局部 +X / +Y 拉伸
+    vec3 quadPos = vec3(aPos.x * quadW + 0.5 * (quadW - 1.0),
+                        aPos.y * quadH + 0.5 * (quadH - 1.0),
+                        aPos.z);
+    gl_Position = lightSpaceMatrix * model * vec4(quadPos, 1.0);
 }